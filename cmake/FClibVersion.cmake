@@ -36,7 +36,7 @@ set(PACKAGE_VERSION ${${PACKAGE_NAME}_version})
 # If any interfaces have been removed since the last public release, then set
 # age to 0.
 
-set(SO_current 0)
+set(SO_current 1)
 set(SO_revision 0)
 set(SO_age 0)
 
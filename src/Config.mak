@@ -34,6 +34,12 @@ SUITESPARSE_DIR = /usr/include/suitesparse
 SUITESPARSE_OBJ =
 SUITESPARSE_LIB = -lcxsparse
 
+#
+# OpenMP flag for the parallel sparse kernels (leave empty for a serial build)
+#
+
+OPENMP = -fopenmp
+
 #
 # fclib options
 #
@@ -0,0 +1,38 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+
+
+/*!\file H5Zfclib.c
+ * ----------------------------------------------
+ * HDF5 plugin of the fclib index filter (FCLIB_FILTER_INDEX), so that programs other
+ * than fclib (h5dump, h5py, ...) read the files written with FCLIB_WRITE_INDEX_CODEC
+ * when the directory of this module is in HDF5_PLUGIN_PATH
+ */
+
+#include "fclib_index.h"
+#include <H5PLextern.h>
+
+H5PL_type_t H5PLget_plugin_type (void)
+{
+  return H5PL_TYPE_FILTER;
+}
+
+const void* H5PLget_plugin_info (void)
+{
+  return &index_filter_class;
+}
@@ -0,0 +1,127 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_generate.c
+ * ----------------------------------------------
+ * synthetic problem generator benchmark
+ *
+ * usage: fcbench_generate [-c contacts] [-s scene] [-m] [-k]
+ *
+ * For every scene (or the one given by -s: 0 spheres, 1 boxes, 2 granular
+ * column) and thread counts 1, 2, 4, ... the global problem of about
+ * 'contacts' contacts (default 1000000) is streamed to generated_problem.hdf5
+ * with fclib_generate_write_global; with -m it is also generated in memory.
+ * The file is read back once per scene to check its sizes, and removed unless
+ * -k is given.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "fclib.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define PATH "generated_problem.hdf5"
+
+/* wall clock time in seconds */
+static double wtime (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+int main (int argc, char **argv)
+{
+  const char *scenes [3] = {"spheres", "boxes", "column"};
+  struct fclib_generator_options options = {0, 1000000, 0.0, 0.0, 0.0, 1, 0};
+  struct fclib_global *problem;
+  int first = 0, last = 2, memory = 0, keep = 0, maxthreads = 1, threads, contacts = 0, j;
+  struct stat st;
+  double t;
+
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-c") == 0 && j+1 < argc) options.contacts = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-s") == 0 && j+1 < argc) first = last = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-m") == 0) memory = 1;
+    else if (strcmp (argv [j], "-k") == 0) keep = 1;
+  }
+  ASSERT (first >= 0 && first <= 2, "ERROR: unknown scene => %d", first);
+
+#ifdef _OPENMP
+  maxthreads = omp_get_max_threads ();
+#endif
+
+  printf ("%-8s %10s %10s %-7s %4s %10s %12s %10s\n", "scene", "bodies", "contacts", "target", "thr", "time [s]", "contacts/s", "MB");
+
+  for (options.scene = first; options.scene <= last; options.scene ++)
+  {
+    for (threads = 1; threads <= maxthreads; threads = (threads < maxthreads && 2*threads > maxthreads ? maxthreads : 2*threads))
+    {
+      options.threads = threads;
+
+      if (memory)
+      {
+        t = wtime ();
+        problem = fclib_generate_global (&options);
+        t = wtime () - t;
+        ASSERT (problem, "ERROR: generating scene %s failed", scenes [options.scene]);
+        contacts = problem->H->n / 3;
+        printf ("%-8s %10d %10d %-7s %4d %10.3f %12.3e %10s\n", scenes [options.scene], problem->M->n / 6, contacts,
+                "memory", threads, t, contacts / t, "-");
+        fclib_delete_global (problem);
+        free (problem);
+      }
+
+      t = wtime ();
+      ASSERT (fclib_generate_write_global (&options, PATH), "ERROR: streaming scene %s failed", scenes [options.scene]);
+      t = wtime () - t;
+      ASSERT (stat (PATH, &st) == 0, "ERROR: %s was not written", PATH);
+
+      if (threads == 1) /* read back once */
+      {
+        problem = fclib_read_global (PATH);
+        ASSERT (problem && problem->spacedim == 3 && problem->H->m == problem->M->n, "ERROR: reading %s failed", PATH);
+        contacts = problem->H->n / 3;
+        printf ("%-8s %10d %10d %-7s %4d %10.3f %12.3e %10.1f\n", scenes [options.scene], problem->M->n / 6, contacts,
+                "file", threads, t, contacts / t, st.st_size / 1e6);
+        fclib_delete_global (problem);
+        free (problem);
+      }
+      else printf ("%-8s %10s %10d %-7s %4d %10.3f %12.3e %10.1f\n", scenes [options.scene], "", contacts,
+                   "file", threads, t, contacts / t, st.st_size / 1e6);
+    }
+  }
+
+  if (!keep) remove (PATH);
+
+  return 0;
+}
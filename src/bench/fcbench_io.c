@@ -0,0 +1,665 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_io.c
+ * ----------------------------------------------
+ * input/output benchmark: latency and throughput of every fclib_write_* and
+ * fclib_read_* entry point on generated problems of controlled size
+ *
+ * usage: fcbench_io [-c contacts] [-d spacedim] [-z nnz_per_row] [-e equalities]
+ *                   [-g guesses] [-r repeats] [-f file] [-j report.json]
+ *
+ *  -c  number of contacts (default 10000)
+ *  -d  space dimension at contacts, 2 or 3 (default 3); rolling problems use 3 or 5
+ *  -z  entries per row of the generated matrices (default 20)
+ *  -e  number of equality constraints, i.e. columns of G and size of R (default 0)
+ *  -g  number of guesses (default 4)
+ *  -r  number of timed repetitions of each call (default 5)
+ *  -f  scratch HDF5 file (default fcbench_io.hdf5, removed on exit)
+ *  -j  also write the results as JSON to the given file ("-" for stdout)
+ *
+ * The MatrixMarket export and import of W are timed as well, with the text
+ * file as payload, and so are the compressed write (FCLIB_WRITE_COMPRESS, alone
+ * and with FCLIB_WRITE_INDEX_CODEC) and read of the global problem, next to HDF5
+ * writing the arrays of H through its own single threaded shuffle and deflate
+ * pipeline.
+ *
+ * Reads are timed with a warm page cache (the file was just read) and, where
+ * the system allows it, with a cold one: the file is synced and its pages are
+ * dropped with posix_fadvise before every cold read. Writes are timed until
+ * the call returns, so they may end in the page cache. Throughput is reported
+ * for the payload (indices and values) of the objects written or read.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <hdf5.h>
+#include "fclib.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+
+/* benchmark settings */
+static int contacts = 10000, spacedim = 3, row_nnz = 20, equalities = 0, guesses = 4, repeats = 5;
+static const char *path = "fcbench_io.hdf5";
+
+/* one timed entry point */
+struct result
+{
+  char entry [64];
+  char problem [16];
+  const char *cache;
+  double bytes;
+  double min, mean, max;
+};
+
+static struct result results [64];
+static int nresults = 0;
+
+/* wall clock time in seconds */
+static double wtime (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+/* uniform random number in [-1, 1] */
+static double urand (void)
+{
+  return 2.0 * (double) rand () / (double) RAND_MAX - 1.0;
+}
+
+/* random vector */
+static double* random_vector (int n)
+{
+  double *v;
+  int j;
+
+  MM (v = (double*)malloc (sizeof(double)*(n > 0 ? n : 1)));
+  for (j = 0; j < n; j ++) v [j] = urand ();
+
+  return v;
+}
+
+/* compressed row matrix with nnz entries per row (fewer when there are fewer columns) */
+static struct fclib_matrix* random_matrix (int m, int n, int nnz)
+{
+  struct fclib_matrix *mat;
+  int j, k;
+
+  if (nnz > n) nnz = n;
+  MM (mat = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  mat->m = m;
+  mat->n = n;
+  mat->nz = -2;
+  mat->nzmax = m*nnz;
+  MM (mat->p = (int*)malloc (sizeof(int)*(m+1)));
+  MM (mat->i = (int*)malloc (sizeof(int)*(mat->nzmax > 0 ? mat->nzmax : 1)));
+  MM (mat->x = (double*)malloc (sizeof(double)*(mat->nzmax > 0 ? mat->nzmax : 1)));
+  for (mat->p [0] = j = 0; j < m; j ++)
+  {
+    mat->p [j+1] = mat->p [j] + nnz;
+    for (k = 0; k < nnz; k ++)
+    {
+      mat->i [mat->p [j] + k] = (j + k*(n/nnz > 0 ? n/nnz : 1)) % n; /* spread, distinct columns */
+      mat->x [mat->p [j] + k] = urand ();
+    }
+  }
+
+  return mat;
+}
+
+/* payload of a matrix in bytes */
+static double matrix_bytes (struct fclib_matrix *mat)
+{
+  int nnz;
+
+  if (!mat) return 0.0;
+  if (mat->nz >= 0) return (double) mat->nz * (2*sizeof(int) + sizeof(double));
+  nnz = mat->p [mat->nz == -2 ? mat->m : mat->n];
+  return (double) nnz * (sizeof(int) + sizeof(double)) + (double) ((mat->nz == -2 ? mat->m : mat->n) + 1) * sizeof(int);
+}
+
+/* payload of a solution in bytes */
+static double solution_bytes (int nv, int nr, int nl)
+{
+  return (double) (nv + 2*nr + nl) * sizeof(double);
+}
+
+/* generated global problem; rolling problems get 5 (3d) or 3 (2d) components per contact */
+static struct fclib_global* generate_global (int rolling)
+{
+  struct fclib_global *problem;
+  int sd = (rolling ? (spacedim == 3 ? 5 : 3) : spacedim), n = 6 * (contacts/2 > 0 ? contacts/2 : 1);
+
+  MM (problem = (struct fclib_global*)calloc (1, sizeof (struct fclib_global)));
+  problem->spacedim = sd;
+  problem->M = random_matrix (n, n, row_nnz);
+  problem->H = random_matrix (n, sd*contacts, row_nnz);
+  if (equalities > 0)
+  {
+    problem->G = random_matrix (n, equalities, row_nnz);
+    problem->b = random_vector (equalities);
+  }
+  problem->mu = random_vector (contacts);
+  problem->f = random_vector (n);
+  problem->w = random_vector (sd*contacts);
+
+  return problem;
+}
+
+/* rolling problem sharing the arrays of a generated global one */
+static struct fclib_global_rolling rolling_view (struct fclib_global *problem)
+{
+  struct fclib_global_rolling rolling;
+
+  rolling.M = problem->M;
+  rolling.H = problem->H;
+  rolling.G = problem->G;
+  rolling.mu = problem->mu;
+  rolling.mu_r = problem->mu;
+  rolling.f = problem->f;
+  rolling.b = problem->b;
+  rolling.w = problem->w;
+  rolling.spacedim = problem->spacedim;
+  rolling.info = NULL;
+
+  return rolling;
+}
+
+/* generated local problem */
+static struct fclib_local* generate_local (void)
+{
+  struct fclib_local *problem;
+  int m = spacedim*contacts;
+
+  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  problem->spacedim = spacedim;
+  problem->W = random_matrix (m, m, row_nnz);
+  if (equalities > 0)
+  {
+    problem->V = random_matrix (m, equalities, row_nnz);
+    problem->R = random_matrix (equalities, equalities, row_nnz);
+    problem->s = random_vector (equalities);
+  }
+  problem->mu = random_vector (contacts);
+  problem->q = random_vector (m);
+
+  return problem;
+}
+
+/* generated solutions or guesses */
+static struct fclib_solution* generate_solutions (int nv, int nr, int nl, int count)
+{
+  struct fclib_solution *sol;
+  int k;
+
+  MM (sol = (struct fclib_solution*)malloc (sizeof (struct fclib_solution)*(count > 0 ? count : 1)));
+  for (k = 0; k < count; k ++)
+  {
+    sol [k].v = (nv ? random_vector (nv) : NULL);
+    sol [k].u = random_vector (nr);
+    sol [k].r = random_vector (nr);
+    sol [k].l = (nl ? random_vector (nl) : NULL);
+  }
+
+  return sol;
+}
+
+/* flush a scratch file to disk and drop its pages from the page cache; returns 0 if not supported */
+static int drop_cache (const char *file)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+  int fd = open (file, O_RDONLY), ok;
+
+  if (fd < 0) return 0;
+  fsync (fd);
+  ok = (posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED) == 0);
+  close (fd);
+
+  return ok;
+#else
+  return 0;
+#endif
+}
+
+/* record the timings of an entry point */
+static void record (const char *entry, const char *problem, const char *cache, double bytes, double *t)
+{
+  struct result *r;
+  int k;
+
+  ASSERT (nresults < (int)(sizeof (results) / sizeof (results [0])), "ERROR: too many results");
+  r = results + nresults ++;
+  strncpy (r->entry, entry, sizeof (r->entry) - 1);
+  r->entry [sizeof (r->entry) - 1] = '\0';
+  strncpy (r->problem, problem, sizeof (r->problem) - 1);
+  r->problem [sizeof (r->problem) - 1] = '\0';
+  r->cache = cache;
+  r->bytes = bytes;
+  r->min = r->max = r->mean = t [0];
+  for (k = 1; k < repeats; k ++)
+  {
+    if (t [k] < r->min) r->min = t [k];
+    if (t [k] > r->max) r->max = t [k];
+    r->mean += t [k];
+  }
+  r->mean /= repeats;
+
+  printf ("%-40s %-8s %-5s %12.0f %12.6f %12.6f %12.6f %10.1f\n", r->entry, r->problem, r->cache, r->bytes,
+          r->min, r->mean, r->max, r->min > 0.0 ? r->bytes / r->min / 1e6 : 0.0);
+}
+
+/* kinds of stored problems */
+enum kind {GLOBAL, LOCAL, ROLLING};
+
+/* write the problem of a kind to a fresh scratch file */
+static void write_problem (enum kind kind, struct fclib_global *global, struct fclib_local *local)
+{
+  struct fclib_global_rolling rolling;
+
+  remove (path);
+  if (kind == GLOBAL) ASSERT (fclib_write_global (global, path), "ERROR: writing a global problem failed");
+  else if (kind == LOCAL) ASSERT (fclib_write_local (local, path), "ERROR: writing a local problem failed");
+  else
+  {
+    rolling = rolling_view (global);
+    ASSERT (fclib_write_global_rolling (&rolling, path), "ERROR: writing a rolling problem failed");
+  }
+}
+
+/* read the problem of a kind from the scratch file and delete it */
+static void read_problem (enum kind kind, int flags)
+{
+  struct fclib_global *global;
+  struct fclib_local *local;
+  struct fclib_global_rolling *rolling;
+
+  if (kind == GLOBAL)
+  {
+    global = (flags ? fclib_read_global_with_flags (path, flags) : fclib_read_global (path));
+    ASSERT (global, "ERROR: reading a global problem failed");
+    fclib_delete_global (global);
+    free (global);
+  }
+  else if (kind == LOCAL)
+  {
+    local = (flags ? fclib_read_local_with_flags (path, flags) : fclib_read_local (path));
+    ASSERT (local, "ERROR: reading a local problem failed");
+    fclib_delete_local (local);
+    free (local);
+  }
+  else
+  {
+    rolling = (flags ? fclib_read_global_rolling_with_flags (path, flags) : fclib_read_global_rolling (path));
+    ASSERT (rolling, "ERROR: reading a rolling problem failed");
+    fclib_delete_global_rolling (rolling);
+    free (rolling);
+  }
+}
+
+/* time all entry points for one kind of problem */
+static void bench (enum kind kind, struct fclib_global *global, struct fclib_local *local)
+{
+  const char *name [3] = {"global", "local", "rolling"};
+  const char *write_entry [3] = {"fclib_write_global", "fclib_write_local", "fclib_write_global_rolling"};
+  const char *read_entry [3] = {"fclib_read_global", "fclib_read_local", "fclib_read_global_rolling"};
+  const char *read_suffix [3] = {"", "_with_flags", " (validate)"};
+  int read_flags [3] = {0, FCLIB_READ_EXPAND_SYMMETRIC, FCLIB_READ_VALIDATE};
+  char entry [64];
+  struct fclib_solution *solution, *guess, *s;
+  double *t, bytes, start;
+  int nv, nr, nl, cold, flags, n, k;
+
+  if (kind == LOCAL)
+  {
+    nv = 0;
+    nr = local->W->n;
+    nl = (local->R ? local->R->n : 0);
+    bytes = matrix_bytes (local->W) + matrix_bytes (local->V) + matrix_bytes (local->R) +
+            (double) (local->W->m + contacts + nl) * sizeof(double);
+  }
+  else
+  {
+    nv = global->M->n;
+    nr = global->H->n;
+    nl = (global->G ? global->G->n : 0);
+    bytes = matrix_bytes (global->M) + matrix_bytes (global->H) + matrix_bytes (global->G) +
+            (double) (nv + nr + (kind == ROLLING ? 2 : 1)*contacts + nl) * sizeof(double);
+  }
+  solution = generate_solutions (nv, nr, nl, 1);
+  guess = generate_solutions (nv, nr, nl, guesses);
+  MM (t = (double*)malloc (sizeof(double)*repeats));
+
+  for (k = 0; k < repeats; k ++) /* problem */
+  {
+    remove (path);
+    start = wtime ();
+    write_problem (kind, global, local);
+    t [k] = wtime () - start;
+  }
+  record (write_entry [kind], name [kind], "-", bytes, t);
+
+  for (cold = 0; cold < 2; cold ++)
+    for (n = 0; n < 3; n ++) /* plain, expanded and validated reads */
+    {
+      flags = read_flags [n];
+      read_problem (kind, 0);
+      for (k = 0; k < repeats; k ++)
+      {
+        if (cold && !drop_cache (path)) break;
+        start = wtime ();
+        read_problem (kind, flags);
+        t [k] = wtime () - start;
+      }
+      if (k < repeats) continue; /* cold cache not available */
+      sprintf (entry, "%s%s", read_entry [kind], read_suffix [n]);
+      record (entry, name [kind], cold ? "cold" : "warm", bytes, t);
+    }
+
+  for (k = 0; k < repeats; k ++) /* solution */
+  {
+    write_problem (kind, global, local);
+    start = wtime ();
+    ASSERT (fclib_write_solution (solution, path), "ERROR: writing a solution failed");
+    t [k] = wtime () - start;
+  }
+  record ("fclib_write_solution", name [kind], "-", solution_bytes (nv, nr, nl), t);
+
+  for (k = 0; k < repeats; k ++)
+  {
+    start = wtime ();
+    ASSERT (fclib_replace_solution (solution, path), "ERROR: replacing a solution failed");
+    t [k] = wtime () - start;
+  }
+  record ("fclib_replace_solution", name [kind], "-", solution_bytes (nv, nr, nl), t);
+
+  for (cold = 0; cold < 2; cold ++)
+  {
+    for (k = 0; k < repeats; k ++)
+    {
+      if (cold && !drop_cache (path)) break;
+      start = wtime ();
+      ASSERT ((s = fclib_read_solution (path)), "ERROR: reading a solution failed");
+      t [k] = wtime () - start;
+      fclib_delete_solutions (s, 1);
+    }
+    if (k == repeats) record ("fclib_read_solution", name [kind], cold ? "cold" : "warm", solution_bytes (nv, nr, nl), t);
+  }
+
+  for (k = 0; k < repeats; k ++) /* guesses */
+  {
+    write_problem (kind, global, local);
+    start = wtime ();
+    ASSERT (fclib_write_guesses (guesses, guess, path), "ERROR: writing guesses failed");
+    t [k] = wtime () - start;
+  }
+  record ("fclib_write_guesses", name [kind], "-", guesses * solution_bytes (nv, nr, nl), t);
+
+  for (cold = 0; cold < 2; cold ++)
+  {
+    for (k = 0; k < repeats; k ++)
+    {
+      if (cold && !drop_cache (path)) break;
+      start = wtime ();
+      ASSERT ((s = fclib_read_guesses (path, &n)), "ERROR: reading guesses failed");
+      t [k] = wtime () - start;
+      fclib_delete_solutions (s, n);
+    }
+    if (k == repeats) record ("fclib_read_guesses", name [kind], cold ? "cold" : "warm", guesses * solution_bytes (nv, nr, nl), t);
+
+    for (k = 0; k < repeats; k ++)
+    {
+      if (cold && !drop_cache (path)) break;
+      start = wtime ();
+      ASSERT ((s = fclib_read_guess (path, k % guesses)), "ERROR: reading a guess failed");
+      t [k] = wtime () - start;
+      fclib_delete_solutions (s, 1);
+    }
+    if (k == repeats) record ("fclib_read_guess", name [kind], cold ? "cold" : "warm", solution_bytes (nv, nr, nl), t);
+  }
+
+  for (k = 0; k < repeats; k ++)
+  {
+    start = wtime ();
+    ASSERT (fclib_append_guess (solution, path), "ERROR: appending a guess failed");
+    t [k] = wtime () - start;
+  }
+  record ("fclib_append_guess", name [kind], "-", solution_bytes (nv, nr, nl), t);
+
+  for (k = 0; k < repeats; k ++)
+  {
+    start = wtime ();
+    ASSERT (fclib_append_guesses (guesses, guess, path), "ERROR: appending guesses failed");
+    t [k] = wtime () - start;
+  }
+  record ("fclib_append_guesses", name [kind], "-", guesses * solution_bytes (nv, nr, nl), t);
+
+  free (t);
+  fclib_delete_solutions (solution, 1);
+  fclib_delete_solutions (guess, guesses);
+}
+
+/* time the MatrixMarket export and import of W; throughput is reported for the text file */
+static void bench_mtx (struct fclib_local *local)
+{
+  struct fclib_matrix *mat;
+  char mtx [256];
+  double *t, bytes, start;
+  FILE *f;
+  int cold, k;
+
+  snprintf (mtx, sizeof (mtx), "%s.mtx", path);
+  MM (t = (double*)malloc (sizeof(double)*repeats));
+
+  for (k = 0; k < repeats; k ++)
+  {
+    remove (mtx);
+    start = wtime ();
+    ASSERT (fclib_matrix_write_mtx (local->W, mtx), "ERROR: writing a MatrixMarket file failed");
+    t [k] = wtime () - start;
+  }
+  ASSERT ((f = fopen (mtx, "rb")) && fseek (f, 0, SEEK_END) == 0, "ERROR: opening %s failed", mtx);
+  bytes = (double) ftell (f);
+  fclose (f);
+  record ("fclib_matrix_write_mtx", "W", "-", bytes, t);
+
+  for (cold = 0; cold < 2; cold ++)
+  {
+    for (k = 0; k < repeats; k ++)
+    {
+      if (cold && !drop_cache (mtx)) break;
+      start = wtime ();
+      ASSERT ((mat = fclib_matrix_read_mtx (mtx, FCLIB_CSR)), "ERROR: reading a MatrixMarket file failed");
+      t [k] = wtime () - start;
+      fclib_delete_matrix (mat);
+    }
+    if (k == repeats) record ("fclib_matrix_read_mtx", "W", cold ? "cold" : "warm", bytes, t);
+  }
+
+  remove (mtx);
+  free (t);
+}
+
+/* write the arrays of a compressed row matrix through the shuffle and deflate filters of HDF5,
+ * in the chunks of FCLIB_WRITE_COMPRESS */
+static void pipeline_write (struct fclib_matrix *mat)
+{
+  const char *name [3] = {"p", "i", "x"};
+  const void *data [3] = {mat->p, mat->i, mat->x};
+  hsize_t count [3] = {(hsize_t) mat->m + 1, (hsize_t) mat->nzmax, (hsize_t) mat->nzmax};
+  hid_t file_id, space_id, plist_id, dataset_id, type;
+  int k;
+
+  remove (path);
+  ASSERT ((file_id = H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) >= 0, "ERROR: creating %s failed", path);
+  for (k = 0; k < 3; k ++)
+  {
+    hsize_t chunk = (count [k] < FCLIB_WRITE_CHUNK ? count [k] : FCLIB_WRITE_CHUNK);
+
+    type = (k < 2 ? H5T_NATIVE_INT : H5T_NATIVE_DOUBLE);
+    space_id = H5Screate_simple (1, &count [k], NULL);
+    plist_id = H5Pcreate (H5P_DATASET_CREATE);
+    H5Pset_chunk (plist_id, 1, &chunk);
+    H5Pset_shuffle (plist_id);
+    H5Pset_deflate (plist_id, FCLIB_DEFLATE_LEVEL);
+    dataset_id = H5Dcreate (file_id, name [k], type, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
+    ASSERT (dataset_id >= 0 && H5Dwrite (dataset_id, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data [k]) >= 0,
+            "ERROR: writing %s failed", name [k]);
+    H5Dclose (dataset_id);
+    H5Pclose (plist_id);
+    H5Sclose (space_id);
+  }
+  H5Fclose (file_id);
+}
+
+/* time the compressed write and read of a global problem, and the HDF5 filter pipeline on H;
+ * throughput is reported for the payload */
+static void bench_compressed (struct fclib_global *global)
+{
+  int flags [2] = {FCLIB_WRITE_COMPRESS, FCLIB_WRITE_COMPRESS|FCLIB_WRITE_INDEX_CODEC};
+  double *t, bytes, start;
+  int cold, k, f;
+
+  bytes = matrix_bytes (global->M) + matrix_bytes (global->H) + matrix_bytes (global->G) +
+          (double) (global->M->n + global->H->n + contacts + (global->G ? global->G->n : 0)) * sizeof(double);
+  MM (t = (double*)malloc (sizeof(double)*repeats));
+
+  for (k = 0; k < repeats; k ++)
+  {
+    start = wtime ();
+    pipeline_write (global->H);
+    t [k] = wtime () - start;
+  }
+  record ("HDF5 shuffle+deflate pipeline", "H", "-", matrix_bytes (global->H), t);
+
+  for (f = 0; f < 2; f ++) /* deflated, and with the indices index filtered first */
+  {
+    for (k = 0; k < repeats; k ++)
+    {
+      remove (path);
+      start = wtime ();
+      ASSERT (fclib_write_global_with_flags (global, path, flags [f]), "ERROR: writing a compressed problem failed");
+      t [k] = wtime () - start;
+    }
+    record (f ? "fclib_write_global (index codec)" : "fclib_write_global_with_flags", "global", "-", bytes, t);
+
+    for (cold = 0; cold < 2; cold ++)
+    {
+      read_problem (GLOBAL, 0);
+      for (k = 0; k < repeats; k ++)
+      {
+        if (cold && !drop_cache (path)) break;
+        start = wtime ();
+        read_problem (GLOBAL, 0);
+        t [k] = wtime () - start;
+      }
+      if (k == repeats) record (f ? "fclib_read_global (index codec)" : "fclib_read_global (compressed)", "global",
+                                cold ? "cold" : "warm", bytes, t);
+    }
+  }
+
+  free (t);
+}
+
+/* write the results as JSON */
+static void write_json (const char *json)
+{
+  FILE *f = (strcmp (json, "-") == 0 ? stdout : fopen (json, "w"));
+  int k;
+
+  ASSERT (f, "ERROR: opening %s failed", json);
+  fprintf (f, "{\n  \"benchmark\": \"fcbench_io\",\n");
+  fprintf (f, "  \"settings\": {\"contacts\": %d, \"spacedim\": %d, \"nnz_per_row\": %d, \"equalities\": %d, \"guesses\": %d, \"repeats\": %d},\n",
+           contacts, spacedim, row_nnz, equalities, guesses, repeats);
+  fprintf (f, "  \"results\": [\n");
+  for (k = 0; k < nresults; k ++)
+  {
+    struct result *r = results + k;
+    fprintf (f, "    {\"entry\": \"%s\", \"problem\": \"%s\", \"cache\": \"%s\", \"bytes\": %.0f, "
+             "\"latency_min\": %.9f, \"latency_mean\": %.9f, \"latency_max\": %.9f, \"mb_per_s\": %.3f}%s\n",
+             r->entry, r->problem, strcmp (r->cache, "-") == 0 ? "none" : r->cache, r->bytes, r->min, r->mean, r->max,
+             r->min > 0.0 ? r->bytes / r->min / 1e6 : 0.0, k+1 < nresults ? "," : "");
+  }
+  fprintf (f, "  ]\n}\n");
+  if (f != stdout) fclose (f);
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_global *global;
+  struct fclib_local *local;
+  const char *json = NULL;
+  int j;
+
+  srand (1);
+  for (j = 1; j < argc; j ++)
+  {
+    if (j+1 >= argc) ASSERT (0, "ERROR: missing value of option %s", argv [j]);
+    else if (strcmp (argv [j], "-c") == 0) contacts = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-d") == 0) spacedim = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-z") == 0) row_nnz = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-e") == 0) equalities = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-g") == 0) guesses = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-r") == 0) repeats = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-f") == 0) path = argv [++ j];
+    else if (strcmp (argv [j], "-j") == 0) json = argv [++ j];
+    else ASSERT (0, "ERROR: unknown option %s", argv [j]);
+  }
+  ASSERT (contacts > 0 && (spacedim == 2 || spacedim == 3) && row_nnz > 0 && equalities >= 0 && guesses > 0 && repeats > 0,
+          "ERROR: invalid settings");
+
+  printf ("%-40s %-8s %-5s %12s %12s %12s %12s %10s\n", "entry", "problem", "cache", "bytes", "min [s]", "mean [s]", "max [s]", "MB/s");
+
+  global = generate_global (0);
+  bench (GLOBAL, global, NULL);
+  bench_compressed (global);
+  fclib_delete_global (global);
+  free (global);
+
+  local = generate_local ();
+  bench (LOCAL, NULL, local);
+  bench_mtx (local);
+  fclib_delete_local (local);
+  free (local);
+
+  global = generate_global (1);
+  bench (ROLLING, global, NULL);
+  fclib_delete_global (global);
+  free (global);
+
+  remove (path);
+  if (json) write_json (json);
+
+  return 0;
+}
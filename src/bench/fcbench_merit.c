@@ -0,0 +1,416 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_merit.c
+ * ----------------------------------------------
+ * merit function and SpMV micro-benchmarks with roofline-style reporting
+ *
+ * usage: fcbench_merit [-c contacts] [-r repeats] [local_problem.hdf5 ...]
+ *
+ * For every problem (the shipped local test problem when it is found in the
+ * current directory, a generated grid problem and the given files of the
+ * FClib collection) the benchmark times
+ *
+ *  - y += W x with fclib_matrix_gaxpy for W stored as triplets, compressed
+ *    columns, compressed rows, 3x3 block compressed rows and upper triangle,
+ *  - the cone projections of the merit function, i.e. fclib_merit_local
+ *    with W = 0, in contacts per second,
+ *  - fclib_merit_local end to end for every storage of W.
+ *
+ * Times are the best of the repetitions. Achieved GB/s and GFLOP/s follow a
+ * compulsory traffic model (every stored index and value, x, y or the merit
+ * vectors touched once) and are compared with the bandwidth of a STREAM triad
+ * measured at startup. Every product and merit value is checked against the
+ * CXSparse path, cs_gaxpy on compressed columns.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "fclib.h"
+#include "cs.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+
+static int repeats = 10;
+static double stream = 0.0; /* measured triad bandwidth in bytes/s */
+
+/* wall clock time in seconds */
+static double wtime (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+/* random number in [0, 1] */
+static double urand (void)
+{
+  return (double) rand () / (double) RAND_MAX;
+}
+
+/* best of the repetitions of a STREAM triad a = b + s c on arrays larger than the caches; returns bytes/s */
+static double triad_bandwidth (void)
+{
+  int n = 1 << 23, j, k;
+  double *a, *b, *c, t, best = 1e30;
+
+  MM (a = (double*)malloc (sizeof(double)*n));
+  MM (b = (double*)malloc (sizeof(double)*n));
+  MM (c = (double*)malloc (sizeof(double)*n));
+#pragma omp parallel for
+  for (j = 0; j < n; j ++) a [j] = 0.0, b [j] = 1.0, c [j] = 2.0;
+
+  for (k = 0; k < 5; k ++)
+  {
+    t = wtime ();
+#pragma omp parallel for
+    for (j = 0; j < n; j ++) a [j] = b [j] + 3.0 * c [j];
+    t = wtime () - t;
+    if (t < best) best = t;
+  }
+  ASSERT (a [n/2] == 7.0, "ERROR: triad failed");
+
+  free (a);
+  free (b);
+  free (c);
+
+  return 3.0 * sizeof(double) * n / best;
+}
+
+/* 3d local problem of contacts on a grid, each coupled to its grid neighbours; W is symmetric */
+static struct fclib_local* grid_problem (int contacts)
+{
+  struct fclib_local *problem;
+  struct fclib_matrix *W;
+  int n = 3*contacts, side = (int) sqrt ((double) contacts), c, d, r, e, l, k;
+
+  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  problem->spacedim = 3;
+  MM (problem->mu = (double*)malloc (sizeof(double)*contacts));
+  MM (problem->q = (double*)malloc (sizeof(double)*n));
+  for (c = 0; c < contacts; c ++)
+  {
+    problem->mu [c] = 0.3 + 0.5 * urand ();
+    for (r = 0; r < 3; r ++) problem->q [3*c+r] = urand () - 0.5;
+  }
+
+  MM (W = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  W->m = W->n = n;
+  W->nzmax = 9*5*contacts;
+  MM (W->p = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->i = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->x = (double*)malloc (sizeof(double)*W->nzmax));
+  for (k = c = 0; c < contacts; c ++)
+  {
+    int neighbour [5] = {c, c-1, c+1, c-side, c+side};
+
+    for (l = 0; l < 5; l ++)
+    {
+      d = neighbour [l];
+      if (d < 0 || d >= contacts) continue;
+      for (r = 0; r < 3; r ++)
+        for (e = 0; e < 3; e ++, k ++)
+        {
+          W->p [k] = 3*c+r;
+          W->i [k] = 3*d+e;
+          W->x [k] = (l == 0 ? (r == e ? 1.0 : 0.05) : -0.2 / (1.0 + r + e));
+        }
+    }
+  }
+  W->nz = k;
+  problem->W = W;
+
+  return problem;
+}
+
+/* number of stored entries (of blocks for block compressed rows) */
+static int stored (struct fclib_matrix *mat)
+{
+  if (mat->nz >= 0) return mat->nz;
+  if (mat->nz == -2) return mat->p [mat->m];
+  if (mat->nz == -3) return mat->p [mat->m / mat->bs];
+  return mat->p [mat->n];
+}
+
+/* floating point operations of y += A x */
+static double spmv_flops (struct fclib_matrix *mat)
+{
+  int j, k, diag = 0;
+
+  if (mat->nz == -3) return 2.0 * stored (mat) * mat->bs * mat->bs;
+  if (mat->nz != -4) return 2.0 * stored (mat);
+
+  for (j = 0; j < mat->n; j ++) /* each stored off-diagonal value serves two products */
+    for (k = mat->p [j]; k < mat->p [j+1]; k ++) diag += (mat->i [k] == j);
+
+  return 2.0 * (2.0 * stored (mat) - diag);
+}
+
+/* compulsory memory traffic of y += A x: indices, pointers and values once, x once, y read and written */
+static double spmv_bytes (struct fclib_matrix *mat)
+{
+  double vectors = sizeof(double) * (mat->n + 2.0 * mat->m);
+  int nnz = stored (mat);
+
+  if (mat->nz >= 0) return nnz * (2.0 * sizeof(int) + sizeof(double)) + vectors;
+  if (mat->nz == -2) return nnz * (sizeof(int) + sizeof(double)) + (mat->m + 1.0) * sizeof(int) + vectors;
+  if (mat->nz == -3) return nnz * (sizeof(int) + mat->bs * mat->bs * sizeof(double)) + (mat->m / mat->bs + 1.0) * sizeof(int) + vectors;
+  return nnz * (sizeof(int) + sizeof(double)) + (mat->n + 1.0) * sizeof(int) + vectors;
+}
+
+/* print a roofline line */
+static void report (const char *name, const char *what, const char *format, double nnz, double t, double flops, double bytes, double error)
+{
+  printf ("%-22s %-8s %-10s %10.0f %12.6f %8.2f %8.2f %6.3f %6.1f %10.2e\n", name, what, format, nnz, t,
+          bytes / t / 1e9, flops / t / 1e9, flops / bytes, 100.0 * bytes / t / stream, error);
+}
+
+/* relative difference of two vectors in the max norm */
+static double difference (const double *a, const double *b, int n)
+{
+  double diff = 0.0, norm = 0.0;
+  int j;
+
+  for (j = 0; j < n; j ++)
+  {
+    if (fabs (a [j] - b [j]) > diff) diff = fabs (a [j] - b [j]);
+    if (fabs (b [j]) > norm) norm = fabs (b [j]);
+  }
+
+  return diff / (norm > 0.0 ? norm : 1.0);
+}
+
+/* merit function MERIT_1 of a local problem without equality constraints, with u = W r + q computed by CXSparse */
+static double reference_merit (struct fclib_local *problem, struct fclib_matrix *csc, const double *r)
+{
+  int n = problem->W->n, c, k;
+  double *u, error = 0.0, qnorm = 0.0;
+
+  MM (u = (double*)malloc (sizeof(double)*n));
+  memcpy (u, problem->q, sizeof(double)*n);
+  cs_gaxpy ((cs*)csc, r, u);
+
+  for (c = 0; c < n/3; c ++) /* || r - P_C (r - (u + mu ||u_T|| e_N)) ||^2 */
+  {
+    const double *rc = r + 3*c, *uc = u + 3*c;
+    double mu = problem->mu [c], t [3], normT;
+
+    t [0] = rc [0] - (uc [0] + mu * hypot (uc [1], uc [2]));
+    t [1] = rc [1] - uc [1];
+    t [2] = rc [2] - uc [2];
+    normT = hypot (t [1], t [2]);
+    if (mu * normT <= -t [0]) t [0] = t [1] = t [2] = 0.0;
+    else if (normT > mu * t [0])
+    {
+      t [0] = (mu * normT + t [0]) / (mu * mu + 1.0);
+      t [1] = mu * t [0] * t [1] / normT;
+      t [2] = mu * t [0] * t [2] / normT;
+    }
+    for (k = 0; k < 3; k ++) error += (rc [k] - t [k]) * (rc [k] - t [k]);
+  }
+  for (k = 0; k < n; k ++) qnorm += problem->q [k] * problem->q [k];
+
+  free (u);
+
+  return sqrt (error) / (1.0 + sqrt (sqrt (qnorm)));
+}
+
+/* time SpMV, cone projections and the merit function of a problem */
+static void bench (const char *name, struct fclib_local *problem)
+{
+  const char *formats [5] = {"triplet", "csc", "csr", "bsr3x3", "symmetric"};
+  struct fclib_matrix *csc, *W [5], *mat, empty;
+  struct fclib_solution solution;
+  double *x, *y, *yref, t, best, ref, value, bytes, flops;
+  int n, nc, f, k;
+
+  if (problem->spacedim != 3 || (problem->R && problem->R->n > 0))
+  {
+    printf ("%-22s skipped (2d or equality constraints)\n", name);
+    return;
+  }
+
+  n = problem->W->n;
+  nc = n / 3;
+  MM (x = (double*)malloc (sizeof(double)*n));
+  MM (y = (double*)malloc (sizeof(double)*n));
+  MM (yref = (double*)calloc (n, sizeof(double)));
+  for (k = 0; k < n; k ++) x [k] = urand () - 0.3;
+
+  csc = fclib_matrix_convert (problem->W, -1);
+  ASSERT (csc, "ERROR: conversion of W failed");
+  cs_gaxpy ((cs*)csc, x, yref);
+
+  W [0] = fclib_matrix_convert (problem->W, 0);
+  W [1] = fclib_matrix_convert (problem->W, -1);
+  W [2] = fclib_matrix_convert (problem->W, -2);
+  W [3] = fclib_matrix_to_bsr (problem->W, 3);
+  W [4] = fclib_matrix_to_symmetric (problem->W);
+
+  for (f = 0; f < 5; f ++) /* SpMV */
+  {
+    mat = W [f];
+    ASSERT (mat, "ERROR: conversion of W to %s failed", formats [f]);
+    for (best = 1e30, k = 0; k < repeats; k ++)
+    {
+      memset (y, 0, sizeof(double)*n);
+      t = wtime ();
+      fclib_matrix_gaxpy (mat, x, y);
+      t = wtime () - t;
+      if (t < best) best = t;
+    }
+    value = difference (y, yref, n);
+    if (f == 4 && value > 1e-12)
+    {
+      printf ("%-22s %-8s %-10s skipped (W is not symmetric)\n", name, "spmv", formats [f]);
+      fclib_delete_matrix (W [4]);
+      W [4] = NULL;
+      continue;
+    }
+    ASSERT (value <= 1e-12, "ERROR: %s product differs from CXSparse => %g", formats [f], value);
+    report (name, "spmv", formats [f], stored (mat), best, spmv_flops (mat), spmv_bytes (mat), value);
+  }
+
+  /* cone projections: merit function with W = 0, traffic of r, q, mu and the work vector */
+  memset (&empty, 0, sizeof (empty));
+  empty.m = empty.n = n;
+  empty.nz = -2;
+  MM (empty.p = (int*)calloc (n+1, sizeof(int)));
+  MM (empty.i = (int*)malloc (sizeof(int)));
+  MM (empty.x = (double*)malloc (sizeof(double)));
+  mat = problem->W;
+  problem->W = &empty;
+  solution.r = x;
+  solution.u = solution.v = solution.l = NULL;
+  ref = reference_merit (problem, &empty, x);
+  for (best = 1e30, k = 0; k < repeats; k ++)
+  {
+    t = wtime ();
+    value = fclib_merit_local (problem, MERIT_1, &solution);
+    t = wtime () - t;
+    if (t < best) best = t;
+  }
+  problem->W = mat;
+  free (empty.p);
+  free (empty.i);
+  free (empty.x);
+  value = fabs (value - ref) / (fabs (ref) > 0.0 ? fabs (ref) : 1.0);
+  ASSERT (value <= 1e-10, "ERROR: cone projections differ from the reference => %g", value);
+  bytes = sizeof(double) * (5.0 * n + nc);
+  flops = 40.0 * nc; /* two norms, projection and squared distance per contact */
+  report (name, "cones", "-", nc, best, flops, bytes, value);
+  printf ("%-22s %-8s %-10s %10.3e contacts/s\n", name, "cones", "-", nc / best);
+
+  ref = reference_merit (problem, csc, x); /* end to end merit function */
+  for (f = 0; f < 5; f ++)
+  {
+    if (!W [f]) continue;
+    mat = problem->W;
+    problem->W = W [f];
+    for (best = 1e30, k = 0; k < repeats; k ++)
+    {
+      t = wtime ();
+      value = fclib_merit_local (problem, MERIT_1, &solution);
+      t = wtime () - t;
+      if (t < best) best = t;
+    }
+    problem->W = mat;
+    value = fabs (value - ref) / (fabs (ref) > 0.0 ? fabs (ref) : 1.0);
+    ASSERT (value <= 1e-10, "ERROR: merit function with %s storage differs from the reference => %g", formats [f], value);
+    report (name, "merit", formats [f], stored (W [f]), best, spmv_flops (W [f]) + 40.0 * nc,
+            spmv_bytes (W [f]) + sizeof(double) * (3.0 * n + nc), value);
+  }
+
+  for (f = 0; f < 5; f ++) if (W [f]) fclib_delete_matrix (W [f]);
+  fclib_delete_matrix (csc);
+  free (x);
+  free (y);
+  free (yref);
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_local *problem;
+  int contacts = 100000, j;
+  char name [64];
+  FILE *f;
+
+  srand (1);
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-r") == 0 && j+1 < argc) repeats = atoi (argv [++ j]);
+    else if (strcmp (argv [j], "-c") == 0 && j+1 < argc) contacts = atoi (argv [++ j]);
+  }
+  if (repeats < 1) repeats = 1;
+
+  stream = triad_bandwidth ();
+  printf ("STREAM triad bandwidth: %.2f GB/s", stream / 1e9);
+#ifdef _OPENMP
+  printf (" (%d threads)", omp_get_max_threads ());
+#endif
+  printf ("\n%-22s %-8s %-10s %10s %12s %8s %8s %6s %6s %10s\n", "problem", "kernel", "storage", "stored",
+          "time [s]", "GB/s", "GFLOP/s", "AI", "%bw", "rel. error");
+
+  if ((f = fopen ("local_problem_test.hdf5", "r")))
+  {
+    fclose (f);
+    problem = fclib_read_local ("local_problem_test.hdf5");
+    bench ("local_problem_test", problem);
+    fclib_delete_local (problem);
+    free (problem);
+  }
+
+  if (contacts > 0)
+  {
+    problem = grid_problem (contacts);
+    sprintf (name, "grid_%d", contacts);
+    bench (name, problem);
+    fclib_delete_local (problem);
+    free (problem);
+  }
+
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-r") == 0 || strcmp (argv [j], "-c") == 0)
+    {
+      j ++;
+      continue;
+    }
+    problem = fclib_read_local (argv [j]);
+    ASSERT (problem, "ERROR: reading %s failed", argv [j]);
+    bench (argv [j], problem);
+    fclib_delete_local (problem);
+    free (problem);
+  }
+
+  return 0;
+}
@@ -0,0 +1,264 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_reduction.c
+ * ----------------------------------------------
+ * global to local reduction benchmark
+ *
+ * usage: fcbench_reduction [global_problem.hdf5 ...]
+ *
+ * Without arguments, generated multibody problems and the synthetic scenes of
+ * fclib_generate_global are reduced, and so is the global problem M = W + I,
+ * H = I built from the shipped local test problem when local_problem_test.hdf5
+ * is found in the current directory.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "fclib.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+
+/* wall clock time in seconds */
+static double wtime (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+/* uniform random number in [-1, 1] */
+static double urand (void)
+{
+  return 2.0 * (double) rand () / (double) RAND_MAX - 1.0;
+}
+
+/* empty triplet matrix */
+static struct fclib_matrix* triplet_matrix (int m, int n, int nzmax)
+{
+  struct fclib_matrix *mat;
+
+  MM (mat = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  mat->m = m;
+  mat->n = n;
+  mat->nzmax = nzmax;
+  mat->nz = 0;
+  MM (mat->p = (int*)malloc (sizeof(int)*(nzmax > 0 ? nzmax : 1)));
+  MM (mat->i = (int*)malloc (sizeof(int)*(nzmax > 0 ? nzmax : 1)));
+  MM (mat->x = (double*)malloc (sizeof(double)*(nzmax > 0 ? nzmax : 1)));
+
+  return mat;
+}
+
+/* add an entry to a triplet matrix */
+static void triplet_add (struct fclib_matrix *mat, int r, int c, double x)
+{
+  mat->p [mat->nz] = r;
+  mat->i [mat->nz] = c;
+  mat->x [mat->nz ++] = x;
+}
+
+/* random vector */
+static double* random_vector (int n)
+{
+  double *v;
+  int j;
+
+  MM (v = (double*)malloc (sizeof(double)*(n > 0 ? n : 1)));
+  for (j = 0; j < n; j ++) v [j] = urand ();
+
+  return v;
+}
+
+/* multibody problem: bodies with 6x6 mass blocks and 3d contacts between random pairs of bodies */
+static struct fclib_global* multibody_problem (int bodies, int contacts)
+{
+  struct fclib_global *problem;
+  double a [36];
+  int b, c, r, k, l;
+
+  MM (problem = (struct fclib_global*)calloc (1, sizeof (struct fclib_global)));
+  problem->spacedim = 3;
+  problem->M = triplet_matrix (6*bodies, 6*bodies, 36*bodies);
+  problem->H = triplet_matrix (6*bodies, 3*contacts, 36*contacts);
+
+  for (b = 0; b < bodies; b ++) /* M_b = A^T A + I */
+  {
+    for (k = 0; k < 36; k ++) a [k] = urand ();
+    for (r = 0; r < 6; r ++)
+      for (c = 0; c < 6; c ++)
+      {
+        double sum = (r == c ? 1.0 : 0.0);
+        for (k = 0; k < 6; k ++) sum += a [k*6+r] * a [k*6+c];
+        triplet_add (problem->M, 6*b+r, 6*b+c, sum);
+      }
+  }
+
+  for (c = 0; c < contacts; c ++) /* two bodies, each seen through a 6x3 block */
+  {
+    int body [2];
+    body [0] = rand () % bodies;
+    body [1] = (bodies > 1 ? (body [0] + 1 + rand () % (bodies - 1)) % bodies : body [0]);
+    for (l = 0; l < (bodies > 1 ? 2 : 1); l ++)
+      for (r = 0; r < 6; r ++)
+        for (k = 0; k < 3; k ++) triplet_add (problem->H, 6*body [l]+r, 3*c+k, urand ());
+  }
+
+  problem->mu = random_vector (contacts);
+  problem->f = random_vector (6*bodies);
+  problem->w = random_vector (3*contacts);
+
+  return problem;
+}
+
+/* global problem built from a local one: M = W + I and H = I */
+static struct fclib_global* problem_from_local (struct fclib_local *local)
+{
+  struct fclib_global *problem;
+  struct fclib_matrix *W;
+  int n = local->W->n, j, k;
+
+  W = fclib_matrix_convert (local->W, -1);
+  ASSERT (W, "ERROR: conversion of W failed");
+  MM (problem = (struct fclib_global*)calloc (1, sizeof (struct fclib_global)));
+  problem->spacedim = local->spacedim;
+  problem->M = triplet_matrix (n, n, W->p [n] + n);
+  problem->H = triplet_matrix (n, n, n);
+  for (j = 0; j < n; j ++)
+  {
+    for (k = W->p [j]; k < W->p [j+1]; k ++) triplet_add (problem->M, W->i [k], j, W->x [k]);
+    triplet_add (problem->M, j, j, 1.0);
+    triplet_add (problem->H, j, j, 1.0);
+  }
+  fclib_delete_matrix (W);
+
+  problem->mu = random_vector (n / problem->spacedim);
+  problem->f = random_vector (n);
+  problem->w = random_vector (n);
+
+  return problem;
+}
+
+/* time the reduction of a problem for thread counts 1, 2, 4, ... and both factorizations */
+static void bench (const char *name, struct fclib_global *problem)
+{
+  struct fclib_reduction_options options = {0, 0, 0, NULL};
+  struct fclib_local *local;
+  int threads, maxthreads = 1, sparse;
+  double t;
+
+#ifdef _OPENMP
+  maxthreads = omp_get_max_threads ();
+#endif
+
+  for (sparse = 0; sparse < 2; sparse ++)
+    for (threads = 1; threads <= maxthreads; threads = (threads < maxthreads && 2*threads > maxthreads ? maxthreads : 2*threads))
+    {
+      options.threads = threads;
+      options.max_block_size = (sparse ? 1 : 0);
+      t = wtime ();
+      local = fclib_global_to_local (problem, &options);
+      t = wtime () - t;
+      ASSERT (local, "ERROR: reduction of %s failed", name);
+      printf ("%-24s %9d %9d %11d %-9s %4d %10.4f\n", name, problem->M->n, problem->H->n,
+              local->W->p [local->W->n], sparse ? "sparse" : "default", threads, t);
+      fclib_delete_local (local);
+      free (local);
+    }
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_global *problem;
+  struct fclib_local *local;
+  FILE *f;
+  int j;
+
+  srand (1);
+  printf ("%-24s %9s %9s %11s %-9s %4s %10s\n", "problem", "n", "m", "nnz(W)", "factor", "thr", "time [s]");
+
+  if (argc == 1 && (f = fopen ("local_problem_test.hdf5", "r")))
+  {
+    fclose (f);
+    local = fclib_read_local ("local_problem_test.hdf5");
+    problem = problem_from_local (local);
+    bench ("local_problem_test", problem);
+    fclib_delete_local (local);
+    free (local);
+    fclib_delete_global (problem);
+    free (problem);
+  }
+
+  for (j = 1; j < argc; j ++)
+  {
+    problem = fclib_read_global (argv [j]);
+    ASSERT (problem, "ERROR: reading %s failed", argv [j]);
+    bench (argv [j], problem);
+    fclib_delete_global (problem);
+    free (problem);
+  }
+
+  if (argc == 1)
+  {
+    int bodies [3] = {1000, 10000, 100000};
+    char name [64];
+
+    for (j = 0; j < 3; j ++)
+    {
+      problem = multibody_problem (bodies [j], 2*bodies [j]);
+      sprintf (name, "multibody_%d", bodies [j]);
+      bench (name, problem);
+      fclib_delete_global (problem);
+      free (problem);
+    }
+
+    for (j = 0; j < 3; j ++) /* synthetic scenes of 10^4 and 10^5 contacts */
+    {
+      const char *scenes [3] = {"spheres", "boxes", "column"};
+      struct fclib_generator_options options = {0, 0, 0.0, 0.0, 0.0, 1, 0};
+      int size;
+
+      for (options.scene = j, size = 10000; size <= 100000; size *= 10)
+      {
+        options.contacts = size;
+        problem = fclib_generate_global (&options);
+        ASSERT (problem, "ERROR: generating scene %s failed", scenes [j]);
+        sprintf (name, "%s_%d", scenes [j], problem->H->n / 3);
+        bench (name, problem);
+        fclib_delete_global (problem);
+        free (problem);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,293 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_reorder.c
+ * ----------------------------------------------
+ * contact reordering benchmark: SpMV with W and merit function evaluation
+ * in the original, reverse Cuthill-McKee and nested dissection orders
+ *
+ * usage: fcbench_reorder [-r repeats] [local_problem.hdf5 ...]
+ *
+ * Without problem files, the shipped local test problem (when found in the
+ * current directory) and generated grid problems with randomly numbered
+ * contacts are used. The merit function is timed when fclib is built with
+ * merit functions.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "fclib.h"
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+
+static int repeats = 20;
+
+/* wall clock time in seconds */
+static double wtime (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+/* random number in [0, 1] */
+static double urand (void)
+{
+  return (double) rand () / (double) RAND_MAX;
+}
+
+/* 3d local problem of contacts on a grid, each coupled to its grid neighbours, numbered in a random order */
+static struct fclib_local* shuffled_grid_problem (int contacts)
+{
+  struct fclib_local *problem;
+  struct fclib_matrix *W;
+  int n = 3*contacts, side = (int) sqrt ((double) contacts), *id, c, d, r, e, l, k;
+
+  MM (id = (int*)malloc (sizeof(int)*contacts));
+  for (c = 0; c < contacts; c ++) id [c] = c;
+  for (c = contacts-1; c > 0; c --)
+  {
+    d = rand () % (c+1);
+    k = id [c], id [c] = id [d], id [d] = k;
+  }
+
+  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  problem->spacedim = 3;
+  MM (problem->mu = (double*)malloc (sizeof(double)*contacts));
+  MM (problem->q = (double*)malloc (sizeof(double)*n));
+  for (c = 0; c < contacts; c ++)
+  {
+    problem->mu [c] = 0.3 + 0.5 * urand ();
+    for (r = 0; r < 3; r ++) problem->q [3*c+r] = urand () - 0.5;
+  }
+
+  MM (W = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  W->m = W->n = n;
+  W->nzmax = 9*5*contacts;
+  MM (W->p = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->i = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->x = (double*)malloc (sizeof(double)*W->nzmax));
+  for (k = c = 0; c < contacts; c ++)
+  {
+    int neighbour [5] = {c, c-1, c+1, c-side, c+side};
+
+    for (l = 0; l < 5; l ++)
+    {
+      d = neighbour [l];
+      if (d < 0 || d >= contacts) continue;
+      for (r = 0; r < 3; r ++)
+        for (e = 0; e < 3; e ++, k ++)
+        {
+          W->p [k] = 3*id [c]+r;
+          W->i [k] = 3*id [d]+e;
+          W->x [k] = (l == 0 ? (r == e ? 1.0 : 0.05) : -0.2 * urand ());
+        }
+    }
+  }
+  W->nz = k;
+  problem->W = W;
+  free (id);
+
+  return problem;
+}
+
+/* average block bandwidth of a compressed row matrix: mean distance of the coupled contacts */
+static double block_bandwidth (struct fclib_matrix *csr, int sd)
+{
+  double sum = 0.0;
+  int j, k;
+
+  for (j = 0; j < csr->m; j ++)
+    for (k = csr->p [j]; k < csr->p [j+1]; k ++) sum += abs (csr->i [k]/sd - j/sd);
+
+  return csr->p [csr->m] > 0 ? sum / csr->p [csr->m] : 0.0;
+}
+
+/* time y = W x with W in compressed rows; returns seconds per product */
+static double spmv_time (struct fclib_matrix *csr)
+{
+  double *x, *y, t;
+  int j, k, l;
+
+  MM (x = (double*)malloc (sizeof(double)*csr->n));
+  MM (y = (double*)malloc (sizeof(double)*csr->m));
+  for (j = 0; j < csr->n; j ++) x [j] = urand ();
+
+  t = wtime ();
+  for (l = 0; l < repeats; l ++)
+  {
+#pragma omp parallel for private(k)
+    for (j = 0; j < csr->m; j ++)
+    {
+      double sum = 0.0;
+      for (k = csr->p [j]; k < csr->p [j+1]; k ++) sum += csr->x [k] * x [csr->i [k]];
+      y [j] = sum;
+    }
+    x [l % csr->n] += y [l % csr->m] * 1e-300; /* keep the products alive */
+  }
+  t = (wtime () - t) / repeats;
+
+  free (x);
+  free (y);
+
+  return t;
+}
+
+/* time the merit function; returns seconds per evaluation, or 0 without merit functions */
+static double merit_time (struct fclib_local *problem)
+{
+  double t = 0.0;
+#ifdef FCLIB_WITH_MERIT_FUNCTIONS
+  struct fclib_solution solution;
+  int j, l, n = problem->W->n;
+
+  MM (solution.r = (double*)malloc (sizeof(double)*n));
+  for (j = 0; j < n; j ++) solution.r [j] = urand ();
+  solution.u = solution.v = solution.l = NULL;
+
+  t = wtime ();
+  for (l = 0; l < (repeats+9)/10; l ++) fclib_merit_local (problem, MERIT_1, &solution);
+  t = (wtime () - t) / ((repeats+9)/10);
+
+  free (solution.r);
+#else
+  (void) problem;
+#endif
+
+  return t;
+}
+
+/* time SpMV and the merit function in the original and the reordered contact orders;
+ * the problem is reordered on copies of W, q and mu */
+static void bench (const char *name, struct fclib_local *problem)
+{
+  const char *orders [3] = {"original", "rcm", "nd"};
+  struct fclib_local copy;
+  struct fclib_matrix *csr;
+  double t, spmv, merit, base [2] = {0.0, 0.0};
+  int method, nc = problem->W->n / problem->spacedim, *perm;
+
+  for (method = -1; method <= FCLIB_ORDERING_ND; method ++)
+  {
+    copy = *problem;
+    t = 0.0;
+    if (method >= 0)
+    {
+      copy.W = fclib_matrix_convert (problem->W, problem->W->nz);
+      ASSERT (copy.W, "ERROR: copy of W failed");
+      if (problem->V) copy.V = fclib_matrix_convert (problem->V, problem->V->nz);
+      MM (copy.q = (double*)malloc (sizeof(double)*problem->W->n));
+      MM (copy.mu = (double*)malloc (sizeof(double)*nc));
+      memcpy (copy.q, problem->q, sizeof(double)*problem->W->n);
+      memcpy (copy.mu, problem->mu, sizeof(double)*nc);
+
+      t = wtime ();
+      perm = fclib_local_ordering (&copy, method);
+      ASSERT (perm && fclib_local_permute (&copy, perm), "ERROR: reordering %s failed", name);
+      t = wtime () - t;
+      free (perm);
+    }
+
+    csr = fclib_matrix_convert (copy.W, -2);
+    ASSERT (csr, "ERROR: conversion of W failed");
+    spmv = spmv_time (csr);
+    merit = merit_time (&copy);
+    if (method < 0) base [0] = spmv, base [1] = merit;
+    printf ("%-24s %9d %-9s %10.4f %9.1f %12.6f %8.2f %12.6f %8.2f\n", name, nc, orders [method+1], t,
+            block_bandwidth (csr, problem->spacedim), spmv, spmv > 0.0 ? base [0] / spmv : 0.0,
+            merit, merit > 0.0 ? base [1] / merit : 0.0);
+    fclib_delete_matrix (csr);
+
+    if (method >= 0)
+    {
+      fclib_delete_matrix (copy.W);
+      if (copy.V) fclib_delete_matrix (copy.V);
+      free (copy.q);
+      free (copy.mu);
+    }
+  }
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_local *problem;
+  int files = 0, j;
+  FILE *f;
+
+  srand (1);
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-r") == 0 && j+1 < argc) repeats = atoi (argv [++ j]);
+    else files ++;
+  }
+  if (repeats < 1) repeats = 1;
+
+  printf ("%-24s %9s %-9s %10s %9s %12s %8s %12s %8s\n", "problem", "contacts", "order", "order [s]", "band",
+          "spmv [s]", "speedup", "merit [s]", "speedup");
+
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-r") == 0)
+    {
+      j ++;
+      continue;
+    }
+    problem = fclib_read_local (argv [j]);
+    ASSERT (problem, "ERROR: reading %s failed", argv [j]);
+    bench (argv [j], problem);
+    fclib_delete_local (problem);
+    free (problem);
+  }
+
+  if (files == 0)
+  {
+    int contacts [3] = {10000, 100000, 1000000};
+    char name [64];
+
+    if ((f = fopen ("local_problem_test.hdf5", "r")))
+    {
+      fclose (f);
+      problem = fclib_read_local ("local_problem_test.hdf5");
+      bench ("local_problem_test", problem);
+      fclib_delete_local (problem);
+      free (problem);
+    }
+
+    for (j = 0; j < 3; j ++)
+    {
+      problem = shuffled_grid_problem (contacts [j]);
+      sprintf (name, "shuffled_grid_%d", contacts [j]);
+      bench (name, problem);
+      fclib_delete_local (problem);
+      free (problem);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,210 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fcbench_solver.c
+ * ----------------------------------------------
+ * projected Gauss-Seidel benchmark: serial, colored and asynchronous sweeps
+ *
+ * usage: fcbench_solver [-v] [-t tolerance] [-i max_iterations] [local_problem.hdf5 ...]
+ *
+ * Without problem files, the shipped local test problem (when found in the
+ * current directory) and generated problems are solved. Files of the FClib
+ * collection can be given on the command line; problems with equality
+ * constraints or in 2d are skipped. With -v the merit function is printed
+ * after every sweep.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include "fclib.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+
+static int verbose = 0;
+static double tolerance = 1e-6;
+static int max_iterations = 1000;
+
+/* random number in [0, 1] */
+static double urand (void)
+{
+  return (double) rand () / (double) RAND_MAX;
+}
+
+/* 3d local problem of contacts on a grid of bodies: every contact is coupled to its neighbours on the grid */
+static struct fclib_local* grid_problem (int contacts)
+{
+  struct fclib_local *problem;
+  struct fclib_matrix *W;
+  int n = 3*contacts, side = (int) sqrt ((double) contacts), c, d, r, l, k;
+
+  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  problem->spacedim = 3;
+  MM (problem->mu = (double*)malloc (sizeof(double)*contacts));
+  MM (problem->q = (double*)malloc (sizeof(double)*n));
+  for (c = 0; c < contacts; c ++)
+  {
+    problem->mu [c] = 0.3 + 0.5 * urand ();
+    problem->q [3*c] = urand () - 0.7;
+    problem->q [3*c+1] = urand () - 0.5;
+    problem->q [3*c+2] = urand () - 0.5;
+  }
+
+  MM (W = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  W->m = W->n = n;
+  W->nzmax = 9*5*contacts;
+  MM (W->p = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->i = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->x = (double*)malloc (sizeof(double)*W->nzmax));
+  for (k = c = 0; c < contacts; c ++)
+  {
+    int neighbour [5] = {c, c-1, c+1, c-side, c+side};
+
+    for (l = 0; l < 5; l ++)
+    {
+      d = neighbour [l];
+      if (d < 0 || d >= contacts) continue;
+      for (r = 0; r < 3; r ++)
+      {
+        int e;
+        for (e = 0; e < 3; e ++, k ++)
+        {
+          W->p [k] = 3*c+r;
+          W->i [k] = 3*d+e;
+          W->x [k] = (l == 0 ? (r == e ? 1.0 : 0.05) : (r == e ? -0.2 : 0.0)); /* diagonally dominant */
+        }
+      }
+    }
+  }
+  W->nz = k;
+  problem->W = W;
+
+  return problem;
+}
+
+/* solve a problem in the three modes, starting from zero reactions */
+static void bench (const char *name, struct fclib_local *problem)
+{
+  const char *modes [3] = {"serial", "colored", "asynchronous"};
+  struct fclib_solver_options options = {max_iterations, tolerance, 1, 0, 0};
+  struct fclib_solver_info info;
+  struct fclib_solution solution;
+  double serial = 0.0;
+  int threads = 1, mode, k;
+
+#ifdef _OPENMP
+  threads = omp_get_max_threads ();
+#endif
+
+  if (problem->spacedim != 3 || (problem->R && problem->R->n > 0))
+  {
+    printf ("%-24s skipped (2d or equality constraints)\n", name);
+    return;
+  }
+
+  MM (solution.r = (double*)malloc (sizeof(double)*problem->W->n));
+  solution.u = solution.v = solution.l = NULL;
+
+  for (mode = FCLIB_SOLVER_SERIAL; mode <= FCLIB_SOLVER_ASYNCHRONOUS; mode ++)
+  {
+    memset (solution.r, 0, sizeof(double)*problem->W->n);
+    options.mode = mode;
+    fclib_solve_local (problem, &solution, &options, &info);
+    if (mode == FCLIB_SOLVER_SERIAL) serial = info.time;
+    printf ("%-24s %9d %-13s %4d %6d %6d %12.4e %10.4f %10.6f %8.2f\n", name, problem->W->n/3, modes [mode],
+            mode == FCLIB_SOLVER_SERIAL ? 1 : threads, info.colors, info.iterations, info.error, info.time,
+            info.time / info.iterations, info.time > 0.0 ? serial / info.time : 0.0);
+    if (verbose)
+      for (k = 0; k < info.checks; k ++) printf ("  sweep %6d %12.4e %10.4f\n", k+1, info.history_error [k], info.history_time [k]);
+    free (info.history_error);
+    free (info.history_time);
+  }
+
+  free (solution.r);
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_local *problem;
+  int files = 0, j;
+  FILE *f;
+
+  srand (1);
+  for (j = 1; j < argc; j ++)
+  {
+    if (strcmp (argv [j], "-v") == 0) verbose = 1;
+    else if (strcmp (argv [j], "-t") == 0 && j+1 < argc) tolerance = atof (argv [++ j]);
+    else if (strcmp (argv [j], "-i") == 0 && j+1 < argc) max_iterations = atoi (argv [++ j]);
+    else files ++;
+  }
+
+  printf ("%-24s %9s %-13s %4s %6s %6s %12s %10s %10s %8s\n", "problem", "contacts", "mode", "thr", "colors",
+          "sweeps", "error", "time [s]", "s/sweep", "speedup");
+
+  for (j = 1; j < argc; j ++)
+  {
+    if (argv [j][0] == '-')
+    {
+      if (strcmp (argv [j], "-v") != 0) j ++;
+      continue;
+    }
+    problem = fclib_read_local (argv [j]);
+    ASSERT (problem, "ERROR: reading %s failed", argv [j]);
+    bench (argv [j], problem);
+    fclib_delete_local (problem);
+    free (problem);
+  }
+
+  if (files == 0)
+  {
+    int contacts [3] = {10000, 100000, 1000000};
+    char name [64];
+
+    if ((f = fopen ("local_problem_test.hdf5", "r")))
+    {
+      fclose (f);
+      problem = fclib_read_local ("local_problem_test.hdf5");
+      bench ("local_problem_test", problem);
+      fclib_delete_local (problem);
+      free (problem);
+    }
+
+    for (j = 0; j < 3; j ++)
+    {
+      problem = grid_problem (contacts [j]);
+      sprintf (name, "grid_%d", contacts [j]);
+      bench (name, problem);
+      fclib_delete_local (problem);
+      free (problem);
+    }
+  }
+
+  return 0;
+}
@@ -103,6 +103,8 @@
 
 /*@@*/
 
+#include <stddef.h> /* size_t of the file image calls */
+
 /* choose api version */
 #define H5Gcreate_vers 2
 #define H5Gopen_vers 2
@@ -132,14 +134,15 @@ struct FCLIB_APICOMPILE fclib_matrix_info  /* matrix information */
   char *comment;
   /** conditioning*/
   double conditioning;
-  /** determinant */
+  /** determinant; only its absolute value |det A| when estimated by fclib_matrix_estimate_info,
+   *  since the sign is lost in A A^T */
   double determinant;
   /** rank */
   int rank;
 };
 
 /**\struct  fclib_matrix fclib.h
- * matrix in compressed row/column or triplet form
+ * matrix in compressed row/column, block compressed row or triplet form
  */
 struct FCLIB_APICOMPILE fclib_matrix   /*  */
 {
@@ -155,10 +158,96 @@ struct FCLIB_APICOMPILE fclib_matrix   /*  */
   int *i ;
   /** numerical values, size nzmax */
   double *x ;
-  /** # of entries in triplet matrix,   -1 for compressed columns,  -2 for compressed rows    */
+  /** # of entries in triplet matrix,   -1 for compressed columns,  -2 for compressed rows,
+   *  -3 for block compressed rows: p (size m/bs+1) are block row pointers, i (size nzmax/(bs*bs))
+   *  block column indices and x stores the bs x bs blocks one after the other in row major order,
+   *  -4 for symmetric matrices of which only the upper triangle is stored in compressed columns */
   int nz ;
   /** info for this matrix */
   struct fclib_matrix_info *info;
+  /** block size, only used for block compressed rows (nz = -3) */
+  int bs ;
+};
+
+/** storage kinds of a fclib_matrix, as given by fclib_matrix::nz (any nz >= 0 is a triplet matrix) */
+enum FCLIB_APICOMPILE fclib_storage {FCLIB_TRIPLET = 0, FCLIB_CSC = -1, FCLIB_CSR = -2, FCLIB_BSR = -3, FCLIB_SYMMETRIC = -4};
+
+/** flags of the fclib_read_*_with_flags functions */
+enum FCLIB_APICOMPILE fclib_read_flags
+{
+  /** expand symmetric matrices (nz = -4) stored as one triangle to full compressed columns */
+  FCLIB_READ_EXPAND_SYMMETRIC = 1,
+
+  /** check every matrix read with fclib_matrix_validate, and that its datasets hold all of its
+   *  entries; the read fails with FCLIB_ERROR_INVALID on a corrupt matrix */
+  FCLIB_READ_VALIDATE = 2
+};
+
+/** structure of the indices of a matrix, as found by fclib_matrix_validate */
+enum FCLIB_APICOMPILE fclib_matrix_structure
+{
+  /** indices nondecreasing within each column, row or block row; triplets ordered by rows, then columns */
+  FCLIB_MATRIX_SORTED = 1,
+
+  /** sorted, without duplicate entries */
+  FCLIB_MATRIX_UNIQUE = 2
+};
+
+/** flags of the fclib_write_*_with_flags functions */
+enum FCLIB_APICOMPILE fclib_write_flags
+{
+  /** store the arrays of the matrices and vectors in chunks of FCLIB_WRITE_CHUNK elements
+   *  filtered by shuffle and deflate (level FCLIB_DEFLATE_LEVEL), which any HDF5 with zlib
+   *  reads; the chunks are compressed in parallel */
+  FCLIB_WRITE_COMPRESS = 1,
+
+  /** store the integer arrays (indices and permutations) in chunks of FCLIB_WRITE_CHUNK elements
+   *  encoded by the fclib index filter (FCLIB_FILTER_INDEX): differences of consecutive values
+   *  in 1 to 4 bytes each; HDF5 programs other than fclib read them with the H5Zfclib plugin
+   *  in HDF5_PLUGIN_PATH; combined with FCLIB_WRITE_COMPRESS the other arrays are deflated */
+  FCLIB_WRITE_INDEX_CODEC = 2,
+
+  /** compute the structural statistics of a local or global problem (fclib_problem_stats)
+   *  and store them as attributes of its "stats" group, for fclib_read_problem_stats */
+  FCLIB_WRITE_STATS = 4
+};
+
+/** identifier of the fclib index filter, in the range 256-511 that HDF5 leaves for testing:
+ *  the filter is not registered with The HDF Group, whose range 32768-65535 is assigned */
+#define FCLIB_FILTER_INDEX 305
+
+#ifndef FCLIB_WRITE_CHUNK
+#define FCLIB_WRITE_CHUNK (1 << 16)
+#endif
+#ifndef FCLIB_DEFLATE_LEVEL
+#define FCLIB_DEFLATE_LEVEL 4
+#endif
+
+/**
+   Block-diagonal structure of a square matrix, as found by fclib_matrix_analyze.
+
+   The matrix is split into the largest number of diagonal blocks such that no entry
+   couples two blocks; a matrix that is not block-diagonal is a single block. When the
+   blocks are small, they are also kept as dense row major blocks together with their
+   explicit inverses, which are used by the block kernels of the merit functions and
+   of fclib_global_to_local.
+*/
+struct FCLIB_APICOMPILE fclib_block_diagonal
+{
+  /** number of diagonal blocks */
+  int nblocks;
+  /** first row of each block, size nblocks+1 (start [nblocks] is the dimension) */
+  int *start;
+  /** common size of the blocks, 0 if they differ */
+  int bs;
+  /** size of the largest block */
+  int maxbs;
+  /** offset of each dense block in blocks and inverse, size nblocks+1; NULL when the blocks are not kept */
+  int *offset;
+  /** dense blocks, row major, one after another; NULL when the blocks are not kept */
+  double *blocks;
+  /** explicit inverses of the blocks, same layout; NULL when the blocks are not kept or not positive definite */
+  double *inverse;
 };
 
 /**
@@ -365,6 +454,223 @@ struct FCLIB_APICOMPILE fclib_solution /* solution data */
  */
 enum FCLIB_APICOMPILE fclib_merit {MERIT_1, MERIT_2} ; /* merit functions */
 
+/** contact orderings of fclib_local_ordering and fclib_global_ordering */
+enum FCLIB_APICOMPILE fclib_ordering
+{
+  /** reverse Cuthill-McKee: small bandwidth of the contact graph */
+  FCLIB_ORDERING_RCM = 0,
+  /** nested dissection by level structure separators: contacts of each part are
+   *  contiguous and the separators come after the parts they split */
+  FCLIB_ORDERING_ND = 1
+};
+
+/** bins of the histograms of fclib_problem_stats */
+#define FCLIB_PROBLEM_STATS_BINS 16
+
+/** structural statistics of a problem: of W and of its contact graph for a local problem, of H and
+ *  of the contact graph of H^T H for a global one. Histograms count 0 in bin 0, 2^(b-1) to 2^b - 1 in
+ *  bin b and anything larger in the last bin */
+struct FCLIB_APICOMPILE fclib_problem_stats
+{
+  /** 1 for a global problem (of H), 0 for a local one (of W) */
+  int global;
+  /** rows, columns and entries of the matrix */
+  int rows;
+  int cols;
+  int nnz;
+  /** fewest, most and mean entries of a row, and the histogram of the entries of the rows */
+  int row_min;
+  int row_max;
+  double row_mean;
+  int row_histogram [FCLIB_PROBLEM_STATS_BINS];
+  /** largest |row - column| of an entry */
+  int bandwidth;
+  /** spacedim x spacedim blocks holding entries, and the share of their entries stored:
+   *  nnz / (blocks spacedim^2), near 1 for a matrix worth storing by blocks */
+  int blocks;
+  double block_fill;
+  /** contacts and edges of the contact graph */
+  int contacts;
+  int edges;
+  /** fewest, most and mean neighbours of a contact, and their histogram */
+  int degree_min;
+  int degree_max;
+  double degree_mean;
+  int degree_histogram [FCLIB_PROBLEM_STATS_BINS];
+  /** connected components of the contact graph (isolated contacts included) and contacts of the largest */
+  int components;
+  int largest_component;
+  /** share of the contacts without friction (mu == 0) */
+  double frictionless;
+};
+
+/** options of fclib_global_to_local; a NULL pointer selects the defaults (all zero) */
+struct FCLIB_APICOMPILE fclib_reduction_options
+{
+  /** store W as its upper triangle (nz = -4) instead of full compressed columns (nz = -1) */
+  int symmetric;
+  /** largest diagonal block of a block-diagonal M factorized as a dense block (0 for 64);
+   *  larger blocks go through the general sparse Cholesky factorization */
+  int max_block_size;
+  /** number of threads (0 for the OpenMP default) */
+  int threads;
+  /** structure of M from fclib_matrix_analyze, reused across reductions of problems
+   *  sharing M; NULL to analyze M on each call */
+  struct fclib_block_diagonal *M_blocks;
+};
+
+/** sweep orderings of fclib_solve_local */
+enum FCLIB_APICOMPILE fclib_solver_mode
+{
+  /** serial sweeps in the contact order */
+  FCLIB_SOLVER_SERIAL = 0,
+  /** contacts are colored so that no two contacts of a color are coupled by W;
+   *  the contacts of a color are updated in parallel, the colors one after another */
+  FCLIB_SOLVER_COLORED = 1,
+  /** all contacts are updated in parallel without synchronization (Hogwild-style):
+   *  a contact may see the old or the new reactions of a coupled contact, each
+   *  component being read and written atomically */
+  FCLIB_SOLVER_ASYNCHRONOUS = 2
+};
+
+/** options of fclib_solve_local; a NULL pointer or zero fields select the defaults */
+struct FCLIB_APICOMPILE fclib_solver_options
+{
+  /** maximal number of Gauss-Seidel sweeps (0 for 1000) */
+  int max_iterations;
+  /** tolerance on the merit function MERIT_1 (0 for 1e-8) */
+  double tolerance;
+  /** number of sweeps between two evaluations of the merit function (0 for 1) */
+  int check_interval;
+  /** sweep ordering, one of fclib_solver_mode */
+  int mode;
+  /** number of threads of the parallel modes (0 for the OpenMP default) */
+  int threads;
+};
+
+/** outcome of fclib_solve_local */
+struct FCLIB_APICOMPILE fclib_solver_info
+{
+  /** number of sweeps done */
+  int iterations;
+  /** last value of the merit function MERIT_1 */
+  double error;
+  /** 1 when the tolerance was reached */
+  int converged;
+  /** wall clock time of the solve in seconds, including the setup */
+  double time;
+  /** number of colors (FCLIB_SOLVER_COLORED only) */
+  int colors;
+  /** number of evaluations of the merit function */
+  int checks;
+  /** merit function and elapsed time at each evaluation, size checks;
+   *  allocated by fclib_solve_local, to be released with free () */
+  double *history_error;
+  double *history_time;
+};
+
+/** dataset classes of the I/O statistics */
+enum FCLIB_APICOMPILE fclib_stats_class
+{
+  /** pointers, indices and values of matrices */
+  FCLIB_STATS_MATRIX = 0,
+  /** problem vectors: f, w, b, mu, mu_r, q, s and perm */
+  FCLIB_STATS_VECTOR = 1,
+  /** solutions and guesses: v, u, r and l */
+  FCLIB_STATS_SOLUTION = 2,
+  /** sizes, counts and info strings */
+  FCLIB_STATS_META = 3,
+  FCLIB_STATS_CLASSES = 4
+};
+
+/** statistics gathered when fclib is built with FCLIB_WITH_STATS, see fclib_stats_get */
+struct FCLIB_APICOMPILE fclib_stats
+{
+  /** bytes read from and written to datasets, per fclib_stats_class */
+  long long bytes_read [FCLIB_STATS_CLASSES];
+  long long bytes_written [FCLIB_STATS_CLASSES];
+  /** number of HDF5 calls and seconds spent in them */
+  long long io_calls;
+  double io_time;
+  /** number of allocations, bytes requested and seconds spent in the allocator
+   *  by the allocations of 64 KiB or more (smaller ones are not timed) */
+  long long allocations;
+  long long bytes_allocated;
+  double alloc_time;
+  /** number of merit function evaluations (including those of fclib_solve_local) and seconds spent in them */
+  long long merit_calls;
+  double merit_time;
+};
+
+/** scenes of the synthetic problem generator */
+enum FCLIB_APICOMPILE fclib_scene
+{
+  /** spheres on a jittered cubic lattice, each resting on the ground or touching its
+   *  lower neighbours along x, y and z */
+  FCLIB_SCENE_SPHERES = 0,
+  /** separate stacks of twisted boxes, each resting on four corner contacts */
+  FCLIB_SCENE_BOXES = 1,
+  /** granular column of spheres in hexagonal close packing: each sphere rests in the
+   *  pocket of three spheres of the layer below and touches three neighbours of its layer */
+  FCLIB_SCENE_COLUMN = 2
+};
+
+/** options of fclib_generate_global, fclib_generate_local and fclib_generate_write_global;
+ *  a NULL pointer or zero fields select the defaults */
+struct FCLIB_APICOMPILE fclib_generator_options
+{
+  /** scene, one of fclib_scene */
+  int scene;
+  /** approximate number of contacts (0 for 1000) */
+  int contacts;
+  /** coefficient of friction (0 for 0.3) */
+  double mu;
+  /** time step (0 for 0.01) */
+  double step;
+  /** contact compliance added to the diagonal of W by fclib_generate_local, relative to the
+   *  mean diagonal of H^T M^-1 H (0 for 1e-6, negative for none); it keeps W positive
+   *  definite when the contacts of a body outnumber its degrees of freedom */
+  double compliance;
+  /** seed of the perturbations; a seed gives the same problem for any number of threads */
+  unsigned int seed;
+  /** number of threads (0 for the OpenMP default) */
+  int threads;
+};
+
+/** options of fclib_matrix_estimate_info; a NULL pointer or zero fields select the defaults */
+struct FCLIB_APICOMPILE fclib_estimate_options
+{
+  /** Lanczos steps per probe (0 for 100); singular values are resolved down to about the largest
+   *  one divided by this many */
+  int iterations;
+  /** random probes (0 for 16); a matrix whose smaller dimension is at most this many is probed
+   *  along every unit vector instead, which makes the traces exact */
+  int probes;
+  /** wall clock budget in seconds (0 for none); the estimates use the steps done by then */
+  double time;
+  /** singular values below tolerance times the largest one count as zero in the rank (0 for 1e-6) */
+  double tolerance;
+  /** seed of the probes; without a time budget, a seed gives the same estimates for any number of threads */
+  unsigned int seed;
+  /** number of threads (0 for the OpenMP default) */
+  int threads;
+};
+
+/** error codes of fclib_last_error */
+enum FCLIB_APICOMPILE fclib_error
+{
+  /** no call failed since the start or the last fclib_clear_error */
+  FCLIB_ERROR_NONE = 0,
+  /** a file could not be opened or created */
+  FCLIB_ERROR_FILE = 1,
+  /** an HDF5 call failed, e.g. on a missing dataset of a truncated or corrupt file */
+  FCLIB_ERROR_HDF5 = 2,
+  /** an allocation failed */
+  FCLIB_ERROR_MEMORY = 3,
+  /** invalid or inconsistent input */
+  FCLIB_ERROR_INVALID = 4
+};
+
 
 #if defined(__cplusplus)
 extern "C"
@@ -390,19 +696,87 @@ FCLIB_STATIC int fclib_write_local (struct fclib_local *problem,
 FCLIB_STATIC int fclib_write_global_rolling (struct fclib_global_rolling *problem,
                                              const char *path);
 
+/** write global problem; flags are a combination of fclib_write_flags
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_global_with_flags (struct fclib_global *problem,
+                                                const char *path,
+                                                int flags);
+
+/** write local problem; flags are a combination of fclib_write_flags
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_local_with_flags (struct fclib_local *problem,
+                                               const char *path,
+                                               int flags);
+
+/** write global rolling problem; flags are a combination of fclib_write_flags
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_global_rolling_with_flags (struct fclib_global_rolling *problem,
+                                                        const char *path,
+                                                        int flags);
+
 /** write solution
  *
  *  \return 1 on success, 0 on failure */
 FCLIB_STATIC int fclib_write_solution (struct fclib_solution *solution,
                                        const char *path);
 
-/** write initial guesses
+/** write initial guesses; they are stored row-wise in the
+ *  [number_of_guesses x n] datasets /guesses/r, /guesses/u, /guesses/v and /guesses/l
  *
  *  \return 1 on success, 0 on failure */
 FCLIB_STATIC int fclib_write_guesses (int number_of_guesses,
                                       struct fclib_solution *guesses,
                                       const char *path);
 
+/** append initial guesses; the guess datasets are extended in place
+ *  and are created when no guesses have been written yet
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_append_guesses (int number_of_guesses,
+                                       struct fclib_solution *guesses,
+                                       const char *path);
+
+/** append a single initial guess without rewriting the existing ones
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_append_guess (struct fclib_solution *guess,
+                                     const char *path);
+
+/** replace the stored solution; the vectors are overwritten in place
+ *  and must have the sizes of the stored ones. The solution is written
+ *  if none has been stored yet.
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_replace_solution (struct fclib_solution *solution,
+                                         const char *path);
+
+/** write global problem into an in-memory HDF5 file image, without touching the
+ *  filesystem; on success *buffer holds the *size bytes of the image and must be
+ *  released with free (). The image is a complete fclib file: saved to disk,
+ *  it can be read with fclib_read_global.
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_global_to_buffer (struct fclib_global *problem,
+                                               void **buffer,
+                                               size_t *size);
+
+/** write local problem into an in-memory HDF5 file image, see fclib_write_global_to_buffer
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_local_to_buffer (struct fclib_local *problem,
+                                              void **buffer,
+                                              size_t *size);
+
+/** write global rolling problem into an in-memory HDF5 file image, see fclib_write_global_to_buffer
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_global_rolling_to_buffer (struct fclib_global_rolling *problem,
+                                                       void **buffer,
+                                                       size_t *size);
+
 
 /** read global problem
  *
@@ -419,6 +793,47 @@ FCLIB_STATIC struct fclib_local* fclib_read_local (const char *path);
  *  \return problem on success; NULL on failure */
 FCLIB_STATIC struct fclib_global_rolling* fclib_read_global_rolling (const char *path);
 
+/** read global problem; flags are a combination of fclib_read_flags
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_global* fclib_read_global_with_flags (const char *path,
+                                                                int flags);
+
+/** read local problem; flags are a combination of fclib_read_flags
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_local* fclib_read_local_with_flags (const char *path,
+                                                              int flags);
+
+/** read global rolling problem; flags are a combination of fclib_read_flags
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_global_rolling* fclib_read_global_rolling_with_flags (const char *path,
+                                                                                int flags);
+
+/** read global problem from the HDF5 file image of 'size' bytes at 'buffer', e.g. written
+ *  by fclib_write_global_to_buffer or loaded from a file; the buffer is neither copied nor
+ *  modified and remains owned by the caller. flags are a combination of fclib_read_flags
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_global* fclib_read_global_from_buffer (const void *buffer,
+                                                                 size_t size,
+                                                                 int flags);
+
+/** read local problem from an HDF5 file image, see fclib_read_global_from_buffer
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_local* fclib_read_local_from_buffer (const void *buffer,
+                                                               size_t size,
+                                                               int flags);
+
+/** read global rolling problem from an HDF5 file image, see fclib_read_global_from_buffer
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_global_rolling* fclib_read_global_rolling_from_buffer (const void *buffer,
+                                                                                 size_t size,
+                                                                                 int flags);
+
 
 /** read solution
  *
@@ -432,16 +847,48 @@ FCLIB_STATIC struct fclib_solution* fclib_read_solution (const char *path);
 FCLIB_STATIC struct fclib_solution* fclib_read_guesses (const char *path,
                                                         int *number_of_guesses);
 
+/** read a single initial guess; 'index' counts from 0
+ *
+ *  \return guess on success; NULL on failure */
+FCLIB_STATIC struct fclib_solution* fclib_read_guess (const char *path,
+                                                      int index);
+
 #ifdef FCLIB_WITH_MERIT_FUNCTIONS
-/** calculate merit function for a global problem */
+/** calculate merit function for a global problem
+ *
+ *  \return merit value; -1 on failure */
 FCLIB_STATIC double fclib_merit_global (struct fclib_global *problem,
                                         enum fclib_merit merit,
                                         struct fclib_solution *solution);
 
-/** calculate merit function for a local problem */
+/** calculate merit function for a global problem, with the dense blocks of M_blocks
+ *  (from fclib_matrix_analyze on problem->M) when they are kept; M_blocks may be NULL
+ *
+ *  \return merit value; -1 on failure */
+FCLIB_STATIC double fclib_merit_global_blocks (struct fclib_global *problem,
+                                               struct fclib_block_diagonal *M_blocks,
+                                               enum fclib_merit merit,
+                                               struct fclib_solution *solution);
+
+/** calculate merit function for a local problem
+ *
+ *  \return merit value; -1 on failure */
 FCLIB_STATIC double fclib_merit_local (struct fclib_local *problem,
                                        enum fclib_merit merit,
                                        struct fclib_solution *solution);
+
+/** solve a 3d local problem without equality constraints by projected
+ *  (nonsmooth) Gauss-Seidel sweeps over the contacts, serial or in parallel
+ *  (see fclib_solver_mode); solution->r holds the initial guess on entry
+ *  (zeros or e.g. a guess from fclib_read_guesses) and the reactions on exit;
+ *  solution->u, when not NULL, receives the local velocities. Options and
+ *  info may be NULL
+ *
+ *  \return 1 when the tolerance is reached, 0 otherwise or on failure */
+FCLIB_STATIC int fclib_solve_local (struct fclib_local *problem,
+                                    struct fclib_solution *solution,
+                                    struct fclib_solver_options *options,
+                                    struct fclib_solver_info *info);
 #endif
 
 /** delete global problem */
@@ -458,6 +905,293 @@ FCLIB_STATIC void fclib_delete_global_rolling (struct fclib_global_rolling *prob
 FCLIB_STATIC void fclib_delete_solutions (struct fclib_solution *data,
                                           int count);
 
+/** convert a matrix to block compressed rows with bs x bs blocks (nz = -3);
+ *  duplicate entries are summed
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_to_bsr (struct fclib_matrix *mat,
+                                                       int bs);
+
+/** convert a block compressed row matrix to triplet (nz >= 0), compressed
+ *  column (nz = -1) or compressed row (nz = -2) form
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_from_bsr (struct fclib_matrix *mat,
+                                                         int nz);
+
+/** keep the upper triangle of a symmetric matrix, stored in compressed
+ *  columns (nz = -4); the strictly lower triangle is ignored
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_to_symmetric (struct fclib_matrix *mat);
+
+/** expand a symmetric matrix stored as its upper triangle (nz = -4)
+ *  to full compressed columns (nz = -1)
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_expand_symmetric (struct fclib_matrix *mat);
+
+/** convert a matrix to triplet (nz >= 0), compressed column (nz = -1), compressed
+ *  row (nz = -2), block compressed row (nz = -3, keeping the block size of a
+ *  block matrix) or symmetric (nz = -4) form; compressed outputs have sorted
+ *  indices and duplicate entries are kept. The conversion runs in parallel
+ *  when fclib is built with OpenMP
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_convert (struct fclib_matrix *mat,
+                                                        int nz);
+
+/** convert a matrix in place, reusing its index and value arrays; conversions
+ *  between triplet, compressed column and compressed row form need at most one
+ *  extra index array, other conversions go through a copy
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_matrix_convert_inplace (struct fclib_matrix *mat,
+                                               int nz);
+
+/** put a matrix in canonical form, in place: indices sorted within each
+ *  column, row or block row, duplicate entries summed and explicit zeros
+ *  (or all-zero blocks) removed; a triplet matrix is sorted by rows
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_matrix_canonicalize (struct fclib_matrix *mat);
+
+/** check the structure of a matrix in a single pass over its indices, at a small fraction of
+ *  the cost of reading it: dimensions and block size, pointers starting at 0, nondecreasing and
+ *  within nzmax, indices within the dimensions (on or above the diagonal for nz = -4), without
+ *  which the products read and write out of bounds; structure, when not NULL, receives a
+ *  combination of fclib_matrix_structure
+ *
+ *  \return 1 for a valid matrix, 0 otherwise (FCLIB_ERROR_INVALID, with the first defect) */
+FCLIB_STATIC int fclib_matrix_validate (struct fclib_matrix *mat,
+                                        int *structure);
+
+/** y += A x for a matrix in any storage; compressed rows run in parallel
+ *  when fclib is built with OpenMP */
+FCLIB_STATIC void fclib_matrix_gaxpy (struct fclib_matrix *A,
+                                      const double *x,
+                                      double *y);
+
+/** add to error the squared natural map residual |r - P_C (r - u - mu |u_T| e_N)|^2 of one
+ *  contact of dimension spacedim (2 or 3), normal component first, where P_C projects onto
+ *  the friction cone of coefficient mu: the term of MERIT_1 for each contact, also available
+ *  without FCLIB_WITH_MERIT_FUNCTIONS */
+FCLIB_STATIC void fclib_merit_contact (int spacedim,
+                                       const double *r,
+                                       const double *u,
+                                       double mu,
+                                       double *error);
+
+/** read a MatrixMarket coordinate file (real, integer or pattern field; general,
+ *  symmetric or skew-symmetric) into triplet (nz = 0), compressed column (nz = -1),
+ *  compressed row (nz = -2) or symmetric (nz = -4) form; symmetric files are expanded
+ *  unless nz = -4, and a general file read with nz = -4 must hold a symmetric matrix.
+ *  The file is memory-mapped and parsed in parallel when fclib is built with OpenMP
+ *
+ *  \return new matrix on success; NULL on failure */
+FCLIB_STATIC struct fclib_matrix* fclib_matrix_read_mtx (const char *path,
+                                                         int nz);
+
+/** write a matrix in any storage to a MatrixMarket coordinate file, streamed in
+ *  storage order; a symmetric matrix (nz = -4) is written as a symmetric file
+ *  holding its lower triangle. Values are printed with 17 significant digits,
+ *  so that they read back exactly
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_matrix_write_mtx (struct fclib_matrix *mat,
+                                         const char *path);
+
+/** estimate the conditioning, rank and determinant of a matrix in any storage, and store them in
+ *  mat->info (created when NULL, keeping the comment otherwise); the matrix is only multiplied by
+ *  vectors, in Golub-Kahan-Lanczos bidiagonalizations started at random probes run in parallel:
+ *  the conditioning is the ratio of the extreme Ritz singular values (a lower bound of the 2-norm
+ *  conditioning, HUGE_VAL when the rank is deficient), the rank and the log-determinant are the
+ *  stochastic Lanczos quadratures of the traces of a step and of the logarithm of A A^T (or A^T A,
+ *  of the smaller dimension). The determinant stored is |det A|, without its sign, 0 when the rank
+ *  is deficient or the matrix is not square, and saturates to HUGE_VAL (or 0) when out of range.
+ *  Options may be NULL
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_matrix_estimate_info (struct fclib_matrix *mat,
+                                             struct fclib_estimate_options *options);
+
+/** find the block-diagonal structure of a square matrix; the dense blocks and their
+ *  inverses are kept when no block is larger than max_block_size (0 for 64)
+ *
+ *  \return structure on success; NULL on failure */
+FCLIB_STATIC struct fclib_block_diagonal* fclib_matrix_analyze (struct fclib_matrix *mat,
+                                                                int max_block_size);
+
+/** delete a block-diagonal structure, including the structure itself */
+FCLIB_STATIC void fclib_delete_block_diagonal (struct fclib_block_diagonal *bd);
+
+/** reduce a global problem to a local one by eliminating the global velocity:
+ *  W = H^T M^-1 H, V = H^T M^-1 G, R = G^T M^-1 G, q = H^T M^-1 f + w and
+ *  s = G^T M^-1 f + b. When M is block-diagonal with small blocks, the explicit
+ *  block inverses are applied (those of options->M_blocks if any);
+ *  otherwise M is factorized by a sparse Cholesky factorization. W is formed
+ *  on its structural pattern only. Options may be NULL
+ *
+ *  \return local problem on success; NULL on failure (e.g. M not positive definite) */
+FCLIB_STATIC struct fclib_local* fclib_global_to_local (struct fclib_global *problem,
+                                                        struct fclib_reduction_options *options);
+
+/** compute a contact ordering (one of fclib_ordering) of a local problem from the
+ *  contact graph given by the block sparsity of W
+ *
+ *  \return permutation of size W->m / spacedim on success, to be released with free (); NULL on failure */
+FCLIB_STATIC int* fclib_local_ordering (struct fclib_local *problem,
+                                        int method);
+
+/** compute a contact ordering (one of fclib_ordering) of a global problem from the
+ *  contact graph of H^T H: two contacts are coupled when they act on a common global
+ *  degree of freedom
+ *
+ *  \return permutation of size H->n / spacedim on success, to be released with free (); NULL on failure */
+FCLIB_STATIC int* fclib_global_ordering (struct fclib_global *problem,
+                                         int method);
+
+/** compute the structural statistics of a local problem: sparsity of W by rows and by spacedim blocks,
+ *  and the contact graph given by the block sparsity of W
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_local_problem_stats (struct fclib_local *problem,
+                                            struct fclib_problem_stats *stats);
+
+/** compute the structural statistics of a global problem: sparsity of H by rows and by spacedim blocks,
+ *  and the contact graph of H^T H; the contacts of a row of H with more than 32 contacts are chained
+ *  rather than all coupled, as for fclib_global_ordering, which lowers their degrees
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_global_problem_stats (struct fclib_global *problem,
+                                             struct fclib_problem_stats *stats);
+
+/** store statistics as attributes of the "stats" group of the local (stats->global == 0) or
+ *  global problem of a file, replacing those stored before
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_write_problem_stats (const char *path,
+                                            struct fclib_problem_stats *stats);
+
+/** read the statistics stored with the local (global == 0) or global problem of a file,
+ *  without reading the problem
+ *
+ *  \return 1 on success, 0 on failure (e.g. no statistics stored) */
+FCLIB_STATIC int fclib_read_problem_stats (const char *path,
+                                           int global,
+                                           struct fclib_problem_stats *stats);
+
+/** reorder the contacts of a local problem in place so that contact k becomes
+ *  contact perm [k] of the current order: the rows and columns of W, the rows of V,
+ *  q and mu are permuted (R and s do not depend on the contacts); perm is kept by the
+ *  caller, e.g. to store it with fclib_write_permutation
+ *
+ *  \return 1 on success, 0 on failure (e.g. perm is not a permutation) */
+FCLIB_STATIC int fclib_local_permute (struct fclib_local *problem,
+                                      const int *perm);
+
+/** reorder the contacts of a global problem in place so that contact k becomes
+ *  contact perm [k] of the current order: the columns of H, w and mu are permuted
+ *  (M, G, f and b do not depend on the contacts); perm is kept by the caller, e.g.
+ *  to store it with fclib_write_permutation
+ *
+ *  \return 1 on success, 0 on failure (e.g. perm is not a permutation) */
+FCLIB_STATIC int fclib_global_permute (struct fclib_global *problem,
+                                       const int *perm);
+
+/** permute the contact vectors u and r of solutions or guesses: with inverse = 0
+ *  they follow a problem permuted by perm, with inverse = 1 they are mapped back,
+ *  e.g. with fclib_read_permutation to the original contact order; v and l are unchanged
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_permute_solutions (int spacedim,
+                                          int contacts,
+                                          const int *perm,
+                                          int inverse,
+                                          struct fclib_solution *solutions,
+                                          int count);
+
+/** store the contact permutation of the local (global == 0) or global problem of a file,
+ *  replacing the one stored before: contact k of the stored problem is contact perm [k]
+ *  of the original order; flags are a combination of fclib_write_flags. The solution
+ *  and guesses stored with the problem, taken in the order of the permutation stored
+ *  before (the original order when none), are reordered to follow the new one, so that
+ *  fclib_permute_solutions with the stored permutation maps them back
+ *
+ *  \return 1 on success, 0 on failure (e.g. perm is not a permutation of the stored contacts) */
+FCLIB_STATIC int fclib_write_permutation (const char *path,
+                                          int global,
+                                          const int *perm,
+                                          int flags);
+
+/** read the contact permutation stored with the local (global == 0) or global problem of a file
+ *
+ *  \return permutation of the stored contacts, to be released with free (); NULL on failure
+ *  (e.g. no permutation stored) */
+FCLIB_STATIC int* fclib_read_permutation (const char *path,
+                                          int global);
+
+/** generate a 3d global problem of rigid bodies (one of fclib_scene): M is block-diagonal
+ *  with a 6x6 block of mass and inertia per body, H maps body velocities to relative contact
+ *  velocities in local frames (normal first), f holds the previous velocities and gravity
+ *  over a time step and w the normal gaps over the time step. Options may be NULL
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_global* fclib_generate_global (struct fclib_generator_options *options);
+
+/** generate a 3d local problem by reducing a generated global problem; W = H^T M^-1 H
+ *  plus the contact compliance on its diagonal is symmetric positive definite
+ *
+ *  \return problem on success; NULL on failure */
+FCLIB_STATIC struct fclib_local* fclib_generate_local (struct fclib_generator_options *options);
+
+/** generate a global problem as fclib_generate_global does and write it to a new file
+ *  (an existing file is truncated) slab of bodies by slab of bodies, without holding
+ *  the problem in memory; the file reads back with fclib_read_global
+ *
+ *  \return 1 on success, 0 on failure */
+FCLIB_STATIC int fclib_generate_write_global (struct fclib_generator_options *options,
+                                              const char *path);
+
+/** copy the statistics gathered since the start or the last fclib_stats_reset; they are
+ *  only gathered when fclib is built with FCLIB_WITH_STATS and sum up the calls of all threads
+ *
+ *  \return 1 when statistics are gathered, 0 otherwise (stats is zeroed) */
+FCLIB_STATIC int fclib_stats_get (struct fclib_stats *stats);
+
+/** reset the statistics */
+FCLIB_STATIC void fclib_stats_reset (void);
+
+/** with a path, start recording the HDF5 calls and the merit function evaluations as
+ *  Chrome trace events (for chrome://tracing or Perfetto), one track per thread; with
+ *  NULL, stop recording and write the events to the path given at the start
+ *
+ *  \return 1 on success, 0 on failure or when statistics are not gathered */
+FCLIB_STATIC int fclib_stats_trace (const char *path);
+
+/** last error of an fclib call of the calling thread that returned 0, NULL (or -1 for the
+ *  merit functions); every call recovers from any failure, memory exhaustion included: it
+ *  closes its file and releases its partial results before returning. The error is kept
+ *  until the next failure or fclib_clear_error, and is printed to stderr as it happens only
+ *  when fclib is built with FCLIB_PRINT_ERRORS
+ *
+ *  The calls may run concurrently from several threads on distinct problems and files
+ *  (concurrent reads of one file are fine). When HDF5 is not built thread-safe (see
+ *  H5_HAVE_THREADSAFE), or when FCLIB_HDF5_LOCK is defined, each HDF5 call is serialized
+ *  through a lock of fclib, shared by the library and every translation unit of a header
+ *  only build (with GCC, Clang or MSVC; with other compilers, header only builds are only
+ *  safe when a single translation unit includes the implementation).
+ *
+ *  \param message if not NULL, receives the message of the error ("" if none)
+ *  \return error code, one of fclib_error */
+FCLIB_STATIC int fclib_last_error (const char **message);
+
+/** reset the last error to FCLIB_ERROR_NONE */
+FCLIB_STATIC void fclib_clear_error (void);
+
+/** delete a matrix, including the structure itself */
+FCLIB_STATIC void fclib_delete_matrix (struct fclib_matrix *mat);
+
 /** create and set attributes of tyoe int in info */
 FCLIB_STATIC int fclib_create_int_attributes_in_info(const char *path,
                                                const char * attr_name,
@@ -475,396 +1209,812 @@ FCLIB_STATIC int fclib_create_int_attributes_in_info(const char *path,
 #ifdef FCLIB_IMPLEMENTATION
 
 #include <string.h>
+#include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <time.h>
+#include <stdarg.h>
+#include <setjmp.h>
 #include <hdf5.h>
 #include <hdf5_hl.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef FCLIB_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#endif
 
 /* useful macros */
+#define FAIL(Code, ...) error_raise (Code, __FILE__, __LINE__, __VA_ARGS__)
+
 #define ASSERT(Test, ...)\
   do {\
-  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
-    fprintf (stderr, __VA_ARGS__);\
-    fprintf (stderr, "\n"); exit (1); } } while (0)
+  if (! (Test)) FAIL (FCLIB_ERROR_INVALID, __VA_ARGS__); } while (0)
 
-#define IO(Call) ASSERT ((Call) >= 0, "ERROR: HDF5 call failed")
-#define MM(Call) ASSERT ((Call), "ERROR: out of memory")
+#define IO(Call) do { if (H5 (Call) < 0) FAIL (FCLIB_ERROR_HDF5, "ERROR: HDF5 call failed => %s", #Call); } while (0)
+#define MM(Call) do { if (! (Call)) FAIL (FCLIB_ERROR_MEMORY, "ERROR: out of memory"); } while (0)
 
+/* state of the calls in progress is kept per thread */
+#if defined(__cplusplus)
+#define FCLIB_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define FCLIB_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define FCLIB_THREAD_LOCAL _Thread_local
+#else
+#define FCLIB_THREAD_LOCAL __thread
+#endif
 
-/* make group */
-static hid_t H5Gmake (hid_t loc_id, const char *name)
-{
-  hid_t id;
+#ifdef _WIN32
+typedef SRWLOCK fclib_mutex;
+#define FCLIB_MUTEX_INIT SRWLOCK_INIT
+#define mutex_init(Mutex) InitializeSRWLock (Mutex)
+#define mutex_lock(Mutex) AcquireSRWLockExclusive (Mutex)
+#define mutex_unlock(Mutex) ReleaseSRWLockExclusive (Mutex)
+#else
+typedef pthread_mutex_t fclib_mutex;
+#define FCLIB_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define mutex_init(Mutex) pthread_mutex_init (Mutex, NULL)
+#define mutex_lock(Mutex) pthread_mutex_lock (Mutex)
+#define mutex_unlock(Mutex) pthread_mutex_unlock (Mutex)
+#endif
 
-  if (H5Lexists (loc_id, name, H5P_DEFAULT))
-  {
-    id = H5Gopen (loc_id, name, H5P_DEFAULT);
-  }
-  else return H5Gcreate (loc_id, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+/* every HDF5 call goes through H5 (Call), which holds a lock for the duration of the call
+ * when the HDF5 library is not thread-safe (or FCLIB_HDF5_LOCK is defined); allocations,
+ * conversions and checks run between the calls, outside of the lock; the lock is not
+ * recursive, so that wrapped calls must not nest */
+#if !defined(H5_HAVE_THREADSAFE) && !defined(FCLIB_HDF5_LOCK)
+#define FCLIB_HDF5_LOCK
+#endif
 
-  return id;
+/* HDF5 is shared by the whole program, and so is its lock: every translation unit compiled
+ * with the implementation (header only builds) defines it, and the linker keeps one definition */
+#ifdef FCLIB_HDF5_LOCK
+#if defined(_MSC_VER)
+__declspec(selectany) fclib_mutex fclib_hdf5_mutex = FCLIB_MUTEX_INIT;
+#elif defined(__GNUC__)
+__attribute__((weak)) fclib_mutex fclib_hdf5_mutex = FCLIB_MUTEX_INIT;
+#else
+static fclib_mutex fclib_hdf5_mutex = FCLIB_MUTEX_INIT; /* one per translation unit */
+#endif
+#define HDF5_LOCK() mutex_lock (&fclib_hdf5_mutex)
+#define HDF5_UNLOCK() mutex_unlock (&fclib_hdf5_mutex)
+#else
+#define HDF5_LOCK() (void) 0
+#define HDF5_UNLOCK() (void) 0
+#endif
+
+/* release the HDF5 lock and pass the result of the call through */
+static long long hdf5_unlock (long long result)
+{
+  HDF5_UNLOCK ();
+  return result;
 }
 
+#define H5(Call) (HDF5_LOCK (), hdf5_unlock ((long long) (Call)))
 
-/* write matrix */
-static void write_matrix (hid_t id, struct fclib_matrix *mat)
+/* error context of a public call: a failing FAIL, ASSERT, IO or MM jumps back to the call,
+ * which closes the objects left open in its file, releases the partial results registered
+ * with error_keep and returns failure; outside of any context the program is terminated */
+#define FCLIB_ERROR_KEEP 8 /* partial results registered without allocating */
+
+/* partial result registered with error_keep */
+struct error_kept
 {
-  hsize_t dim = 1;
+  void *ptr;
+  void (*release) (void *ptr, int count);
+  int count;
+};
 
-  IO (H5LTmake_dataset_int (id, "nzmax", 1, &dim, &mat->nzmax));
-  IO (H5LTmake_dataset_int (id, "m", 1, &dim, &mat->m));
-  IO (H5LTmake_dataset_int (id, "n", 1, &dim, &mat->n));
-  IO (H5LTmake_dataset_int (id, "nz", 1, &dim, &mat->nz));
+struct error_context
+{
+  jmp_buf env;
+  hid_t file_id; /* file of the call, -1 until it is opened */
+  struct error_kept first [FCLIB_ERROR_KEEP];
+  struct error_kept *keep; /* first, or an allocated array once more are registered */
+  int nkeep, maxkeep;
+  struct error_context *outer; /* context of an enclosing call */
+};
 
-  if (mat->nz >= 0) /* triplet */
-  {
-    dim = mat->nz;
-    IO (H5LTmake_dataset_int (id, "p", 1, &dim, mat->p));
-    IO (H5LTmake_dataset_int (id, "i", 1, &dim, mat->i));
-    IO (H5LTmake_dataset_double (id, "x", 1, &dim, mat->x));
-  }
-  else if (mat->nz == -1) /* csc */
-  {
-    dim = mat->n+1;
-    IO (H5LTmake_dataset_int (id, "p", 1, &dim, mat->p));
-    dim = mat->nzmax;
-    IO (H5LTmake_dataset_int (id, "i", 1, &dim, mat->i));
-    IO (H5LTmake_dataset_double (id, "x", 1, &dim, mat->x));
-  }
-  else if (mat->nz == -2) /* csr */
-  {
-    dim = mat->m+1;
-    IO (H5LTmake_dataset_int (id, "p", 1, &dim, mat->p));
-    dim = mat->nzmax;
-    IO (H5LTmake_dataset_int (id, "i", 1, &dim, mat->i));
-    IO (H5LTmake_dataset_double (id, "x", 1, &dim, mat->x));
-  }
-  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", mat->nz);
+static FCLIB_THREAD_LOCAL struct error_context *error_active; /* innermost context or NULL */
+static FCLIB_THREAD_LOCAL int error_code;
+static FCLIB_THREAD_LOCAL char error_message [512];
 
-  if (mat->info)
+/* record an error, and print it when FCLIB_PRINT_ERRORS is defined */
+static void error_record (int code, const char *file, int line, const char *format, va_list args)
+{
+  int n = 0;
+
+  if (file)
   {
-    dim = 1;
-    if (mat->info->comment) IO (H5LTmake_dataset_string (id, "comment", mat->info->comment));
-    IO (H5LTmake_dataset_double (id, "conditioning", 1, &dim, &mat->info->conditioning));
-    IO (H5LTmake_dataset_double (id, "determinant", 1, &dim, &mat->info->determinant));
-    IO (H5LTmake_dataset_int (id, "rank", 1, &dim, &mat->info->rank));
+    n = snprintf (error_message, sizeof (error_message), "%s: %d => ", file, line);
+    if (n < 0 || n >= (int) sizeof (error_message)) n = 0;
   }
+  vsnprintf (error_message + n, sizeof (error_message) - n, format, args);
+  n = (int) strlen (error_message);
+  if (n && error_message [n-1] == '\n') error_message [n-1] = '\0';
+  error_code = code;
+#ifdef FCLIB_PRINT_ERRORS
+  fprintf (stderr, "%s\n", error_message);
+#endif
 }
 
-/* read matrix */
-static struct fclib_matrix* read_matrix (hid_t id)
+/* record an error and jump back to the innermost context */
+static void error_raise (int code, const char *file, int line, const char *format, ...)
 {
-  struct fclib_matrix *mat;
+  va_list args;
 
-  MM (mat = (struct fclib_matrix*)malloc (sizeof (struct fclib_matrix)));
+  va_start (args, format);
+  error_record (code, file, line, format, args);
+  va_end (args);
 
-  IO (H5LTread_dataset_int (id, "nzmax", &mat->nzmax));
-  IO (H5LTread_dataset_int (id, "m", &mat->m));
-  IO (H5LTread_dataset_int (id, "n", &mat->n));
-  IO (H5LTread_dataset_int (id, "nz", &mat->nz));
+  if (error_active) longjmp (error_active->env, 1);
+  fprintf (stderr, "%s\n", error_message); /* a failure outside of any public call */
+  exit (1);
+}
 
-  if (mat->nz >= 0) /* triplet */
-  {
-    MM (mat->p = (int*)malloc (sizeof(int) * mat->nz));
-    MM (mat->i = (int*)malloc (sizeof(int) * mat->nz));
-    IO (H5LTread_dataset_int (id, "p", mat->p));
-    IO (H5LTread_dataset_int (id, "i", mat->i));
-  }
-  else if (mat->nz == -1) /* csc */
-  {
-    MM (mat->p = (int*)malloc (sizeof(int)*(mat->n+1)));
-    MM (mat->i = (int*)malloc (sizeof(int)*mat->nzmax));
-    IO (H5LTread_dataset_int (id, "p", mat->p));
-    IO (H5LTread_dataset_int (id, "i", mat->i));
-  }
-  else if (mat->nz == -2) /* csr */
-  {
-    MM (mat->p = (int*)malloc (sizeof(int)*(mat->m+1)));
-    MM (mat->i = (int*)malloc (sizeof(int)*mat->nzmax));
-    IO (H5LTread_dataset_int (id, "p", mat->p));
-    IO (H5LTread_dataset_int (id, "i", mat->i));
-  }
-  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", mat->nz);
+/* record an error of a call that fails without a context */
+static void error_report (int code, const char *format, ...)
+{
+  va_list args;
 
-  MM (mat->x = (double*)malloc (sizeof(double)*mat->nzmax));
-  IO (H5LTread_dataset_double (id, "x", mat->x));
+  va_start (args, format);
+  error_record (code, NULL, 0, format, args);
+  va_end (args);
+}
 
-  if (H5LTfind_dataset (id, "conditioning"))
-  {
-    H5T_class_t class_id;
-    hsize_t dim;
-    size_t size;
+/* enter a context; the caller continues with 'if (setjmp (ctx.env))' and error_catch */
+static void error_enter (struct error_context *ctx)
+{
+  ctx->file_id = -1;
+  ctx->keep = ctx->first;
+  ctx->nkeep = 0;
+  ctx->maxkeep = FCLIB_ERROR_KEEP;
+  ctx->outer = error_active;
+  error_active = ctx;
+}
 
-    MM (mat->info = (struct fclib_matrix_info*)malloc (sizeof (struct fclib_matrix_info)));
-    if (H5LTfind_dataset (id, "comment"))
-    {
-      IO (H5LTget_dataset_info  (id, "comment", &dim, &class_id, &size));
-      MM (mat->info->comment = (char*)malloc (sizeof(char)*size));
-      IO (H5LTread_dataset_string (id, "comment", mat->info->comment));
-    }
-    else mat->info->comment = NULL;
-    IO (H5LTread_dataset_double (id, "conditioning", &mat->info->conditioning));
-    IO (H5LTread_dataset_double (id, "determinant", &mat->info->determinant));
-    IO (H5LTread_dataset_int (id, "rank", &mat->info->rank));
-  }
-  else
-  {
-    mat->info = NULL;
-  }
+/* leave the innermost context */
+static void error_pop (void)
+{
+  struct error_context *ctx = error_active;
 
-  return mat;
+  error_active = ctx->outer;
+  if (ctx->keep != ctx->first) free (ctx->keep);
 }
 
-/* write global vectors */
-static void write_global_vectors (hid_t id, struct fclib_global *problem)
+/* leave the innermost context after success */
+static void error_leave (void)
 {
-  hsize_t dim;
+  error_pop ();
+}
 
-  dim = (hsize_t)problem->M->m;
-  ASSERT (problem->f, "ERROR: f must be given");
-  IO (H5LTmake_dataset_double (id, "f", 1, &dim, problem->f));
+/* register the file of the innermost context */
+static void error_file (hid_t file_id)
+{
+  if (error_active) error_active->file_id = file_id;
+}
 
-  dim = (hsize_t)problem->H->n;
-  ASSERT (problem->w && problem->mu, "ERROR: w and mu must be given");
-  IO (H5LTmake_dataset_double (id, "w", 1, &dim, problem->w));
-  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
-  dim /= (hsize_t)problem->spacedim;
-  IO (H5LTmake_dataset_double (id, "mu", 1, &dim, problem->mu));
+/* register a partial result to be released on failure; when the registrations outgrow their
+ * array and a larger one cannot be allocated, the result is released and the call fails */
+static void error_keep (void *ptr, void (*release) (void*, int), int count)
+{
+  struct error_context *ctx = error_active;
 
-  if (problem->G)
+  if (!ctx) return;
+
+  if (ctx->nkeep == ctx->maxkeep)
   {
-    dim = (hsize_t)problem->G->n;
-    ASSERT (problem->b, "ERROR: b must be given if G is present");
-    IO (H5LTmake_dataset_double (id, "b", 1, &dim, problem->b));
+    struct error_kept *keep = (struct error_kept*)malloc (sizeof (struct error_kept)*2*ctx->maxkeep);
+
+    if (!keep)
+    {
+      release (ptr, count);
+      FAIL (FCLIB_ERROR_MEMORY, "ERROR: out of memory");
+    }
+    memcpy (keep, ctx->keep, sizeof (struct error_kept)*ctx->nkeep);
+    if (ctx->keep != ctx->first) free (ctx->keep);
+    ctx->keep = keep;
+    ctx->maxkeep *= 2;
   }
+
+  ctx->keep [ctx->nkeep].ptr = ptr;
+  ctx->keep [ctx->nkeep].release = release;
+  ctx->keep [ctx->nkeep ++].count = count;
 }
 
-/* read global vectors */
-static void read_global_vectors (hid_t id, struct fclib_global *problem)
+/* unregister a partial result once it is returned or attached to a registered one */
+static void error_drop (void *ptr)
 {
-  MM (problem->f = (double*)malloc (sizeof(double)*problem->M->m));
-  IO (H5LTread_dataset_double (id, "f", problem->f));
+  struct error_context *ctx = error_active;
+  int k;
 
-  ASSERT (problem->H->n % problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
-  MM (problem->w = (double*)malloc (sizeof(double)*problem->H->n));
-  MM (problem->mu = (double*)malloc (sizeof(double)*(problem->H->n / problem->spacedim)));
-  IO (H5LTread_dataset_double (id, "w", problem->w));
-  IO (H5LTread_dataset_double (id, "mu", problem->mu));
-
-  if (problem->G)
+  if (ctx) for (k = ctx->nkeep-1; k >= 0; k --)
   {
-    MM (problem->b = (double*)malloc (sizeof(double)*problem->G->n));
-    IO (H5LTread_dataset_double (id, "b", problem->b));
+    if (ctx->keep [k].ptr == ptr)
+    {
+      memmove (ctx->keep + k, ctx->keep + k+1, sizeof (struct error_kept)*(ctx->nkeep-1 - k));
+      ctx->nkeep --;
+      break;
+    }
   }
 }
-/* write global vectors */
-static void write_global_rolling_vectors (hid_t id, struct fclib_global_rolling *problem)
+
+/* close a file together with the groups, datasets, datatypes and attributes left open in it */
+static void error_close (hid_t file_id)
 {
-  hsize_t dim;
+  unsigned types = H5F_OBJ_DATASET | H5F_OBJ_GROUP | H5F_OBJ_DATATYPE | H5F_OBJ_ATTR | H5F_OBJ_LOCAL;
+  hid_t ids [64];
+  ssize_t n, k;
+  int closed = 1;
 
-  dim = (hsize_t)problem->M->m;
-  ASSERT (problem->f, "ERROR: f must be given");
-  IO (H5LTmake_dataset_double (id, "f", 1, &dim, problem->f));
+  HDF5_LOCK ();
+  H5E_BEGIN_TRY
+  {
+    while (closed && (n = H5Fget_obj_ids (file_id, types, 64, ids)) > 0) /* stop when nothing closes */
+    {
+      for (k = 0, closed = 0; k < n; k ++)
+      {
+        if (H5Iget_type (ids [k]) == H5I_ATTR) closed += (H5Aclose (ids [k]) >= 0);
+        else closed += (H5Oclose (ids [k]) >= 0);
+      }
+    }
+    H5Fclose (file_id);
+  }
+  H5E_END_TRY;
+  HDF5_UNLOCK ();
+}
 
-  dim = (hsize_t)problem->H->n;
-  ASSERT (problem->w && problem->mu, "ERROR: w and mu must be given");
-  IO (H5LTmake_dataset_double (id, "w", 1, &dim, problem->w));
-  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
-  dim /= (hsize_t)problem->spacedim;
-  IO (H5LTmake_dataset_double (id, "mu", 1, &dim, problem->mu));
-  IO (H5LTmake_dataset_double (id, "mu_r", 1, &dim, problem->mu_r));
+/* leave the innermost context after a failure: release its partial results and close its file;
+ * return 0 */
+static int error_catch (void)
+{
+  struct error_context *ctx = error_active;
 
-  if (problem->G)
+  while (ctx->nkeep > 0)
   {
-    dim = (hsize_t)problem->G->n;
-    ASSERT (problem->b, "ERROR: b must be given if G is present");
-    IO (H5LTmake_dataset_double (id, "b", 1, &dim, problem->b));
+    ctx->nkeep --;
+    ctx->keep [ctx->nkeep].release (ctx->keep [ctx->nkeep].ptr, ctx->keep [ctx->nkeep].count);
   }
+  error_pop ();
+  if (ctx->file_id >= 0) error_close (ctx->file_id);
+  H5 (H5Eclear2 (H5E_DEFAULT)); /* printed already, and kept by HDF5 after the thread exits */
+
+  return 0;
 }
 
-/* read global vectors */
-static void read_global_rolling_vectors (hid_t id, struct fclib_global_rolling *problem)
+#ifdef FCLIB_WITH_STATS
+/* I/O, allocation and merit function statistics; see fclib_stats_get. Each thread accumulates
+ * in a block of its own, under a lock of its own that is otherwise taken only to sum, reset or
+ * trace; the blocks outlive their threads and are chained in a list which, as the HDF5 lock, is
+ * shared by every translation unit compiled with the implementation */
+
+/* trace event of an HDF5 call or of a merit function evaluation */
+struct stats_event
 {
-  MM (problem->f = (double*)malloc (sizeof(double)*problem->M->m));
-  IO (H5LTread_dataset_double (id, "f", problem->f));
+  char name [32];
+  const char *cat;
+  double ts, dur;
+  long long bytes;
+  int tid;
+};
 
-  ASSERT (problem->H->n % problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
-  MM (problem->w = (double*)malloc (sizeof(double)*problem->H->n));
-  MM (problem->mu = (double*)malloc (sizeof(double)*(problem->H->n / problem->spacedim)));
-  MM (problem->mu_r = (double*)malloc (sizeof(double)*(problem->H->n / problem->spacedim)));
-  IO (H5LTread_dataset_double (id, "w", problem->w));
-  IO (H5LTread_dataset_double (id, "mu", problem->mu));
-  IO (H5LTread_dataset_double (id, "mu_r", problem->mu_r));
+/* statistics of a thread */
+struct stats_thread
+{
+  fclib_mutex mutex; /* guards the fields below */
+  struct fclib_stats total;
+  int tid;           /* thread number in the trace */
+  int tracing;       /* events are recorded from 'origin' on */
+  double origin;
+  struct stats_event *events;
+  int nevents, maxevents;
+  struct stats_thread *next;
+};
 
-  if (problem->G)
-  {
-    MM (problem->b = (double*)malloc (sizeof(double)*problem->G->n));
-    IO (H5LTread_dataset_double (id, "b", problem->b));
-  }
+/* statistics of all threads */
+struct stats_shared
+{
+  fclib_mutex mutex; /* guards the fields below */
+  struct stats_thread *threads;
+  int nthreads;
+  char *trace_path;  /* NULL when not tracing */
+  double trace_origin;
+};
+
+#if defined(_MSC_VER)
+__declspec(selectany) struct stats_shared fclib_stats_shared = {FCLIB_MUTEX_INIT, NULL, 0, NULL, 0.0};
+#elif defined(__GNUC__)
+__attribute__((weak)) struct stats_shared fclib_stats_shared = {FCLIB_MUTEX_INIT, NULL, 0, NULL, 0.0};
+#else
+static struct stats_shared fclib_stats_shared = {FCLIB_MUTEX_INIT, NULL, 0, NULL, 0.0}; /* one per translation unit */
+#endif
+
+static FCLIB_THREAD_LOCAL struct stats_thread *stats_self;   /* block of the calling thread */
+static FCLIB_THREAD_LOCAL double stats_call_start;           /* start of the current HDF5 call */
+static FCLIB_THREAD_LOCAL long long stats_call_bytes;        /* bytes moved by the current HDF5 call */
+static FCLIB_THREAD_LOCAL const char *stats_call_name;       /* HDF5 function of the current call, if known */
+
+/* allocations of fewer bytes are counted but not timed: reading the clock would cost more than them */
+#define STATS_TIMED_ALLOC (1 << 16)
+
+/* wall clock time in seconds */
+static double stats_now (void)
+{
+  struct timespec t;
+
+  timespec_get (&t, TIME_UTC);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
 }
-/* write local vectors */
-static void write_local_vectors (hid_t id, struct fclib_local *problem)
+
+/* block of the calling thread, locked; NULL when it cannot be allocated */
+static struct stats_thread* stats_lock (void)
 {
-  hsize_t dim;
+  struct stats_thread *t = stats_self;
 
-  dim = (hsize_t)problem->W->m;
-  ASSERT (problem->q, "ERROR: q must be given");
-  IO (H5LTmake_dataset_double (id, "q", 1, &dim, problem->q));
+  if (!t)
+  {
+    if (!(t = (struct stats_thread*)calloc (1, sizeof (struct stats_thread)))) return NULL;
+    mutex_init (&t->mutex);
+    mutex_lock (&fclib_stats_shared.mutex);
+    t->tid = ++ fclib_stats_shared.nthreads;
+    t->tracing = (fclib_stats_shared.trace_path != NULL);
+    t->origin = fclib_stats_shared.trace_origin;
+    t->next = fclib_stats_shared.threads;
+    fclib_stats_shared.threads = t;
+    mutex_unlock (&fclib_stats_shared.mutex);
+    stats_self = t;
+  }
+  mutex_lock (&t->mutex);
 
-  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of W rows is not divisble by the spatial dimension");
-  dim /= (hsize_t)problem->spacedim;
-  IO (H5LTmake_dataset_double (id, "mu", 1, &dim, problem->mu));
+  return t;
+}
 
-  if (problem->V)
+/* record a trace event in the locked block t */
+static void stats_event (struct stats_thread *t, const char *name, int length, const char *cat, double start, double end, long long bytes)
+{
+  struct stats_event *e;
+
+  if (!t->tracing) return;
+  if (t->nevents == t->maxevents)
   {
-    dim = (hsize_t)problem->R->m;
-    ASSERT (problem->s, "ERROR: s must be given if R is present");
-    IO (H5LTmake_dataset_double (id, "s", 1, &dim, problem->s));
+    int size = (t->maxevents ? 2*t->maxevents : 1024);
+    if (!(e = (struct stats_event*)realloc (t->events, sizeof (struct stats_event)*size))) return; /* drop the event */
+    t->events = e;
+    t->maxevents = size;
   }
+  e = &t->events [t->nevents ++];
+  if (length > 31) length = 31;
+  memcpy (e->name, name, length);
+  e->name [length] = '\0';
+  e->cat = cat;
+  e->ts = 1e6 * (start - t->origin);
+  e->dur = 1e6 * (end - start);
+  e->bytes = bytes;
+  e->tid = t->tid;
 }
 
-/* read local vectors */
-static void read_local_vectors (hid_t id, struct fclib_local *problem)
+/* start of an HDF5 call */
+static void stats_io_begin (void)
 {
-  MM (problem->q = (double*)malloc (sizeof(double)*problem->W->m));
-  IO (H5LTread_dataset_double (id, "q", problem->q));
+  stats_call_bytes = 0;
+  stats_call_name = NULL;
+  stats_call_start = stats_now ();
+}
 
-  ASSERT (problem->W->m % problem->spacedim == 0, "ERROR: number of W rows is not divisble by the spatial dimension");
-  MM (problem->mu = (double*)malloc (sizeof(double)*(problem->W->m / problem->spacedim)));
-  IO (H5LTread_dataset_double (id, "mu", problem->mu));
+/* end of the HDF5 call 'call' (the text of the wrapped expression) with result 'result' */
+static long long stats_io_end (const char *call, long long result)
+{
+  double end = stats_now ();
+  struct stats_thread *t;
 
-  if (problem->R)
+  if (!(t = stats_lock ())) return result;
+  t->total.io_calls ++;
+  t->total.io_time += end - stats_call_start;
+  if (t->tracing)
   {
-    MM (problem->s = (double*)malloc (sizeof(double)*problem->R->m));
-    IO (H5LTread_dataset_double (id, "s", problem->s));
+    const char *name = (stats_call_name ? stats_call_name : strstr (call, "H5")); /* function name of 'id = H5Fopen (...)' */
+    int length = 0;
+
+    if (!name) name = call;
+    while (name [length] && name [length] != ' ' && name [length] != '(') length ++;
+    stats_event (t, name, length, "hdf5", stats_call_start, end, stats_call_bytes);
   }
+  mutex_unlock (&t->mutex);
+
+  return result;
 }
 
-/* write problem info */
-static void write_problem_info (hid_t id, struct fclib_info *info)
+/* class of a dataset from its name or path */
+static int stats_class (const char *name)
 {
-  if (info->title) IO (H5LTmake_dataset_string (id, "title", info->title));
-  if (info->description) IO (H5LTmake_dataset_string (id, "description", info->description));
-  if (info->math_info) IO (H5LTmake_dataset_string (id, "math_info", info->math_info));
+  const char *matrix [] = {"p", "i", "x", NULL}, *vector [] = {"f", "w", "b", "mu", "mu_r", "q", "s", "perm", NULL},
+    *solution [] = {"v", "u", "r", "l", NULL}, *base = strrchr (name, '/');
+  int k;
+
+  base = (base ? base + 1 : name);
+  for (k = 0; matrix [k]; k ++) if (strcmp (base, matrix [k]) == 0) return FCLIB_STATS_MATRIX;
+  for (k = 0; vector [k]; k ++) if (strcmp (base, vector [k]) == 0) return FCLIB_STATS_VECTOR;
+  for (k = 0; solution [k]; k ++) if (strcmp (base, solution [k]) == 0) return FCLIB_STATS_SOLUTION;
+
+  return FCLIB_STATS_META;
 }
 
-/* read problem info */
-static struct fclib_info* read_problem_info (hid_t id)
+/* account bytes read (write = 0) or written (write = 1) to dataset 'name' */
+static void stats_bytes (const char *name, int write, long long bytes)
 {
-  struct fclib_info *info;
-  H5T_class_t class_id;
-  hsize_t dim;
+  int c = stats_class (name);
+  struct stats_thread *t;
+
+  stats_call_bytes += bytes;
+  if (!(t = stats_lock ())) return;
+  if (write) t->total.bytes_written [c] += bytes;
+  else t->total.bytes_read [c] += bytes;
+  mutex_unlock (&t->mutex);
+}
+
+/* number of elements of a dataset read by an H5LT call */
+static long long stats_elements (hid_t loc_id, const char *name, size_t *size)
+{
+  hsize_t dims [32];
+  long long count = 1;
+  int rank, k;
+
+  if (H5LTget_dataset_ndims (loc_id, name, &rank) < 0 || rank > 32 ||
+      H5LTget_dataset_info (loc_id, name, dims, NULL, size) < 0) return 0;
+  for (k = 0; k < rank; k ++) count *= (long long) dims [k];
+
+  return count;
+}
+
+static herr_t stats_make_dataset_int (hid_t loc_id, const char *name, int rank, const hsize_t *dims, const int *data)
+{
+  herr_t status = H5LTmake_dataset_int (loc_id, name, rank, dims, data);
+  long long count = 1;
+  int k;
+
+  stats_call_name = "H5LTmake_dataset_int";
+  for (k = 0; k < rank; k ++) count *= (long long) dims [k];
+  if (status >= 0) stats_bytes (name, 1, count * (long long) sizeof (int));
+  return status;
+}
+
+static herr_t stats_make_dataset_double (hid_t loc_id, const char *name, int rank, const hsize_t *dims, const double *data)
+{
+  herr_t status = H5LTmake_dataset_double (loc_id, name, rank, dims, data);
+  long long count = 1;
+  int k;
+
+  stats_call_name = "H5LTmake_dataset_double";
+  for (k = 0; k < rank; k ++) count *= (long long) dims [k];
+  if (status >= 0) stats_bytes (name, 1, count * (long long) sizeof (double));
+  return status;
+}
+
+static herr_t stats_make_dataset_string (hid_t loc_id, const char *name, const char *data)
+{
+  herr_t status = H5LTmake_dataset_string (loc_id, name, data);
+
+  stats_call_name = "H5LTmake_dataset_string";
+  if (status >= 0) stats_bytes (name, 1, (long long) strlen (data) + 1);
+  return status;
+}
+
+static herr_t stats_read_dataset_int (hid_t loc_id, const char *name, int *data)
+{
+  herr_t status = H5LTread_dataset_int (loc_id, name, data);
   size_t size;
 
-  MM (info = (struct fclib_info*)malloc (sizeof (struct fclib_info)));
+  stats_call_name = "H5LTread_dataset_int";
+  if (status >= 0) stats_bytes (name, 0, stats_elements (loc_id, name, &size) * (long long) sizeof (int));
+  return status;
+}
 
-  if (H5LTfind_dataset (id, "title"))
-  {
-    IO (H5LTget_dataset_info  (id, "title", &dim, &class_id, &size));
-    MM (info->title = (char*)malloc (sizeof(char)*size));
-    IO (H5LTread_dataset_string (id, "title", info->title));
-  }
-  else info->title = NULL;
+static herr_t stats_read_dataset_double (hid_t loc_id, const char *name, double *data)
+{
+  herr_t status = H5LTread_dataset_double (loc_id, name, data);
+  size_t size;
 
-  if (H5LTfind_dataset (id, "description"))
-  {
-    IO (H5LTget_dataset_info  (id, "description", &dim, &class_id, &size));
-    MM (info->description = (char*)malloc (sizeof(char)*size));
-    IO (H5LTread_dataset_string (id, "description", info->description));
-  }
-  else info->description = NULL;
+  stats_call_name = "H5LTread_dataset_double";
+  if (status >= 0) stats_bytes (name, 0, stats_elements (loc_id, name, &size) * (long long) sizeof (double));
+  return status;
+}
+
+static herr_t stats_read_dataset_string (hid_t loc_id, const char *name, char *data)
+{
+  herr_t status = H5LTread_dataset_string (loc_id, name, data);
+  size_t size = 0;
 
-  if (H5LTfind_dataset (id, "math_info"))
+  stats_call_name = "H5LTread_dataset_string";
+  if (status >= 0 && stats_elements (loc_id, name, &size) > 0) stats_bytes (name, 0, (long long) size);
+  return status;
+}
+
+/* bytes selected by an H5Dread or H5Dwrite */
+static void stats_transfer (hid_t dataset_id, hid_t type_id, hid_t memspace_id, hid_t filespace_id, int write)
+{
+  char name [256];
+  hssize_t count;
+
+  if (memspace_id != H5S_ALL) count = H5Sget_select_npoints (memspace_id);
+  else if (filespace_id != H5S_ALL) count = H5Sget_select_npoints (filespace_id);
+  else
   {
-    IO (H5LTget_dataset_info  (id, "math_info", &dim, &class_id, &size));
-    MM (info->math_info = (char*)malloc (sizeof(char)*size));
-    IO (H5LTread_dataset_string (id, "math_info", info->math_info));
+    hid_t space_id = H5Dget_space (dataset_id);
+    count = H5Sget_simple_extent_npoints (space_id);
+    H5Sclose (space_id);
   }
-  else info->math_info = NULL;
+  if (H5Iget_name (dataset_id, name, sizeof (name)) < 0) name [0] = '\0';
+  if (count > 0) stats_bytes (name, write, (long long) count * (long long) H5Tget_size (type_id));
+}
 
-  return info;
+static herr_t stats_dread (hid_t dataset_id, hid_t type_id, hid_t memspace_id, hid_t filespace_id, hid_t plist_id, void *data)
+{
+  herr_t status = H5Dread (dataset_id, type_id, memspace_id, filespace_id, plist_id, data);
+
+  stats_call_name = "H5Dread";
+  if (status >= 0) stats_transfer (dataset_id, type_id, memspace_id, filespace_id, 0);
+  return status;
 }
 
-/* write solution */
-static void write_solution (hid_t id, struct fclib_solution *solution, int nv, int nr, int nl)
+static herr_t stats_dwrite (hid_t dataset_id, hid_t type_id, hid_t memspace_id, hid_t filespace_id, hid_t plist_id, const void *data)
 {
-  hsize_t nv_t = (hsize_t)nv;
-  hsize_t nl_t = (hsize_t)nl;
-  hsize_t nr_t = (hsize_t)nr;
-  if (nv) IO (H5LTmake_dataset_double (id, "v", 1, &nv_t, solution->v));
-  if (nl) IO (H5LTmake_dataset_double (id, "l", 1, &nl_t, solution->l));
+  herr_t status = H5Dwrite (dataset_id, type_id, memspace_id, filespace_id, plist_id, data);
 
-  ASSERT (nr, "ERROR: contact constraints must be present");
-  IO (H5LTmake_dataset_double (id, "u", 1, &nr_t, solution->u));
-  IO (H5LTmake_dataset_double (id, "r", 1, &nr_t, solution->r));
+  stats_call_name = "H5Dwrite";
+  if (status >= 0) stats_transfer (dataset_id, type_id, memspace_id, filespace_id, 1);
+  return status;
 }
 
-/* read solution */
-static void read_solution (hid_t id, int nv, int nr, int nl, struct fclib_solution *solution)
+/* account an allocation of 'size' bytes started at 'start' (timed only from STATS_TIMED_ALLOC bytes on) */
+static void* stats_alloc (void *ptr, size_t size, double start)
 {
-  if (nv)
+  double time = (size >= STATS_TIMED_ALLOC ? stats_now () - start : 0.0);
+  struct stats_thread *t;
+
+  if (!(t = stats_lock ())) return ptr;
+  t->total.allocations ++;
+  t->total.bytes_allocated += (long long) size;
+  t->total.alloc_time += time;
+  mutex_unlock (&t->mutex);
+  return ptr;
+}
+
+static void* stats_malloc (size_t size)
+{
+  double start = (size >= STATS_TIMED_ALLOC ? stats_now () : 0.0);
+  return stats_alloc (malloc (size), size, start);
+}
+
+static void* stats_calloc (size_t count, size_t size)
+{
+  double start = (count*size >= STATS_TIMED_ALLOC ? stats_now () : 0.0);
+  return stats_alloc (calloc (count, size), count*size, start);
+}
+
+static void* stats_realloc (void *ptr, size_t size)
+{
+  double start = (size >= STATS_TIMED_ALLOC ? stats_now () : 0.0);
+  return stats_alloc (realloc (ptr, size), size, start);
+}
+
+/* end of a merit function evaluation started at 'start' */
+static void stats_merit (const char *name, double start)
+{
+  double end = stats_now ();
+  struct stats_thread *t;
+
+  if (!(t = stats_lock ())) return;
+  t->total.merit_calls ++;
+  t->total.merit_time += end - start;
+  stats_event (t, name, (int) strlen (name), "merit", start, end, 0);
+  mutex_unlock (&t->mutex);
+}
+
+/* route the HDF5 calls, the dataset transfers and the allocations of the implementation through the counters */
+#undef IO
+#define IO(Call) do { if (stats_io_end (#Call, (stats_io_begin (), H5 (Call))) < 0)\
+  FAIL (FCLIB_ERROR_HDF5, "ERROR: HDF5 call failed => %s", #Call); } while (0)
+#define FCLIB_H5LTMAKE_DATASET_INT stats_make_dataset_int
+#define FCLIB_H5LTMAKE_DATASET_DOUBLE stats_make_dataset_double
+#define FCLIB_H5LTMAKE_DATASET_STRING stats_make_dataset_string
+#define FCLIB_H5LTREAD_DATASET_INT stats_read_dataset_int
+#define FCLIB_H5LTREAD_DATASET_DOUBLE stats_read_dataset_double
+#define FCLIB_H5LTREAD_DATASET_STRING stats_read_dataset_string
+#define FCLIB_H5DREAD stats_dread
+#define FCLIB_H5DWRITE stats_dwrite
+#define FCLIB_MALLOC stats_malloc
+#define FCLIB_CALLOC stats_calloc
+#define FCLIB_REALLOC stats_realloc
+#define STATS_START(Start) double Start = stats_now ()
+#define STATS_MERIT(Name, Start) stats_merit (Name, Start)
+#else
+#define FCLIB_H5LTMAKE_DATASET_INT H5LTmake_dataset_int
+#define FCLIB_H5LTMAKE_DATASET_DOUBLE H5LTmake_dataset_double
+#define FCLIB_H5LTMAKE_DATASET_STRING H5LTmake_dataset_string
+#define FCLIB_H5LTREAD_DATASET_INT H5LTread_dataset_int
+#define FCLIB_H5LTREAD_DATASET_DOUBLE H5LTread_dataset_double
+#define FCLIB_H5LTREAD_DATASET_STRING H5LTread_dataset_string
+#define FCLIB_H5DREAD H5Dread
+#define FCLIB_H5DWRITE H5Dwrite
+#define FCLIB_MALLOC malloc
+#define FCLIB_CALLOC calloc
+#define FCLIB_REALLOC realloc
+#define STATS_START(Start)
+#define STATS_MERIT(Name, Start)
+#endif
+
+#ifdef FCLIB_WITH_STATS
+/* add the statistics x to sum */
+static void stats_add (struct fclib_stats *sum, const struct fclib_stats *x)
+{
+  int k;
+
+  for (k = 0; k < FCLIB_STATS_CLASSES; k ++)
   {
-    MM (solution->v = (double*)malloc (sizeof(double)*nv));
-    IO (H5LTread_dataset_double (id, "v", solution->v));
+    sum->bytes_read [k] += x->bytes_read [k];
+    sum->bytes_written [k] += x->bytes_written [k];
   }
-  else solution->v = NULL;
+  sum->io_calls += x->io_calls;
+  sum->io_time += x->io_time;
+  sum->allocations += x->allocations;
+  sum->bytes_allocated += x->bytes_allocated;
+  sum->alloc_time += x->alloc_time;
+  sum->merit_calls += x->merit_calls;
+  sum->merit_time += x->merit_time;
+}
+#endif
 
-  if (nl)
+/* copy the statistics, summed over the threads */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_stats_get (struct fclib_stats *stats)
+{
+  memset (stats, 0, sizeof (struct fclib_stats));
+#ifdef FCLIB_WITH_STATS
   {
-    MM (solution->l = (double*)malloc (sizeof(double)*nl));
-    IO (H5LTread_dataset_double (id, "l", solution->l));
+    struct stats_thread *t;
+
+    mutex_lock (&fclib_stats_shared.mutex);
+    for (t = fclib_stats_shared.threads; t; t = t->next)
+    {
+      mutex_lock (&t->mutex);
+      stats_add (stats, &t->total);
+      mutex_unlock (&t->mutex);
+    }
+    mutex_unlock (&fclib_stats_shared.mutex);
   }
-  else solution->l = NULL;
+  return 1;
+#else
+  return 0;
+#endif
+}
 
-  ASSERT (nr, "ERROR: contact constraints must be present");
-  MM (solution->u = (double*)malloc (sizeof(double)*nr));
-  IO (H5LTread_dataset_double (id, "u", solution->u));
-  MM (solution->r = (double*)malloc (sizeof(double)*nr));
-  IO (H5LTread_dataset_double (id, "r", solution->r));
+/* reset the statistics */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_stats_reset (void)
+{
+#ifdef FCLIB_WITH_STATS
+  struct stats_thread *t;
+
+  mutex_lock (&fclib_stats_shared.mutex);
+  for (t = fclib_stats_shared.threads; t; t = t->next)
+  {
+    mutex_lock (&t->mutex);
+    memset (&t->total, 0, sizeof (struct fclib_stats));
+    mutex_unlock (&t->mutex);
+  }
+  mutex_unlock (&fclib_stats_shared.mutex);
+#endif
 }
 
-/* read solution sizes */
-static int read_nvnunrnl (hid_t file_id, int *nv, int *nr, int *nl)
+/* start recording trace events, or stop and write them */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_stats_trace (const char *path)
 {
-  if (H5Lexists (file_id, "/fclib_global", H5P_DEFAULT))
+#ifdef FCLIB_WITH_STATS
+  struct stats_event *events = NULL, *e;
+  struct stats_thread *t;
+  char *trace_path;
+  FILE *f;
+  int k, n = 0, ok;
+
+  if (path) /* start */
   {
-    IO (H5LTread_dataset_int (file_id, "/fclib_global/M/n", nv));
-    IO (H5LTread_dataset_int (file_id, "/fclib_global/H/n", nr));
-    if (H5Lexists (file_id, "/fclib_global/G", H5P_DEFAULT))
+    char *copy;
+    double origin = stats_now ();
+
+    if (!(copy = (char*)malloc (strlen (path) + 1))) return 0;
+    strcpy (copy, path);
+    mutex_lock (&fclib_stats_shared.mutex);
+    trace_path = fclib_stats_shared.trace_path;
+    fclib_stats_shared.trace_path = copy;
+    fclib_stats_shared.trace_origin = origin;
+    for (t = fclib_stats_shared.threads; t; t = t->next)
     {
-      IO (H5LTread_dataset_int (file_id, "/fclib_global/G/n", nl));
+      mutex_lock (&t->mutex);
+      t->tracing = 1;
+      t->origin = origin;
+      t->nevents = 0;
+      mutex_unlock (&t->mutex);
     }
-    else *nl = 0;
+    mutex_unlock (&fclib_stats_shared.mutex);
+    free (trace_path);
+    return 1;
   }
-  else if (H5Lexists (file_id, "/fclib_local", H5P_DEFAULT))
+
+  mutex_lock (&fclib_stats_shared.mutex); /* take the events of all threads over, then write them outside of the locks */
+  trace_path = fclib_stats_shared.trace_path;
+  fclib_stats_shared.trace_path = NULL;
+  for (t = fclib_stats_shared.threads; t; t = t->next)
   {
-    *nv = 0;
-    IO (H5LTread_dataset_int (file_id, "/fclib_local/W/n", nr));
-    if (H5Lexists (file_id, "/fclib_local/R", H5P_DEFAULT))
+    mutex_lock (&t->mutex);
+    if (t->nevents > 0 && (e = (struct stats_event*)realloc (events, sizeof (struct stats_event)*(n + t->nevents))))
     {
-      IO (H5LTread_dataset_int (file_id, "/fclib_local/R/n", nl));
+      events = e;
+      memcpy (events + n, t->events, sizeof (struct stats_event)*t->nevents);
+      n += t->nevents;
     }
-    else *nl = 0;
+    free (t->events);
+    t->events = NULL;
+    t->nevents = t->maxevents = 0;
+    t->tracing = 0;
+    mutex_unlock (&t->mutex);
+  }
+  mutex_unlock (&fclib_stats_shared.mutex);
+
+  if (!trace_path)
+  {
+    free (events);
+    return 0;
   }
-  else if (H5Lexists (file_id, "/fclib_global_rolling", H5P_DEFAULT))
+  if ((f = fopen (trace_path, "w")))
   {
-    IO (H5LTread_dataset_int (file_id, "/fclib_global_rolling/M/n", nv));
-    IO (H5LTread_dataset_int (file_id, "/fclib_global_rolling/H/n", nr));
-    if (H5Lexists (file_id, "/fclib_global_rolling/G", H5P_DEFAULT))
+    fprintf (f, "{\"traceEvents\": [\n");
+    for (k = 0; k < n; k ++)
     {
-      IO (H5LTread_dataset_int (file_id, "/fclib_global_rolling/G/n", nl));
+      e = &events [k];
+      fprintf (f, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 0, \"tid\": %d, \"args\": {\"bytes\": %lld}}%s\n",
+               e->name, e->cat, e->ts, e->dur, e->tid, e->bytes, k+1 < n ? "," : "");
     }
-    else *nl = 0;
+    fprintf (f, "],\n\"displayTimeUnit\": \"ms\"}\n");
+    ok = (fclose (f) == 0);
   }
-  else
+  else ok = 0;
+
+  free (trace_path);
+  free (events);
+
+  return ok;
+#else
+  (void) path;
+  return 0;
+#endif
+}
+
+/* make group; called within IO */
+static hid_t H5Gmake (hid_t loc_id, const char *name)
+{
+  hid_t id;
+
+  if (H5Lexists (loc_id, name, H5P_DEFAULT))
   {
-    fprintf (stderr, "ERROR: neither global nor local problem has been stored. Global or local have to be stored before solutions or guesses\n");
-    return 0;
+    id = H5Gopen (loc_id, name, H5P_DEFAULT);
   }
+  else return H5Gcreate (loc_id, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
-  return 1;
+  return id;
 }
 
+
 /* delete matrix info */
 static void delete_matrix_info (struct fclib_matrix_info *info)
 {
@@ -900,770 +2050,7403 @@ static void delete_info (struct fclib_info *info)
   }
 }
 
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_create_int_attributes_in_info(const char *path, const char * attr_name,
-                                        int attr_value)
+/* release partial results of a failed call, see error_keep */
+static void release_matrix (void *ptr, int count)
 {
-  hid_t  file_id = -1, id, dataspace_id, attr_id;
-  hsize_t     dims[1];
-  FILE *f;
-
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
-  {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
-    {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
-    }
-  }
+  (void) count;
+  delete_matrix ((struct fclib_matrix*) ptr);
+}
 
-  if (H5Lexists (file_id, "/fclib_local/info", H5P_DEFAULT))
-  {
-    IO (id = H5Gopen (file_id, "/fclib_local/info", H5P_DEFAULT));
-    dims[0]=1;
-    dataspace_id = H5Screate_simple(1, dims, NULL);
-    attr_id = H5Acreate (id, attr_name, H5T_NATIVE_INT, dataspace_id,
-                         H5P_DEFAULT, H5P_DEFAULT);
-    IO(H5Awrite(attr_id, H5T_NATIVE_INT , &attr_value ));
-    IO(H5Aclose (attr_id));
-    IO (H5Gclose (id));
-  }
-  else
-  {
-    IO (id = H5Gmake (file_id, "/fclib_local/info"));
-    dims[0]=1;
-    dataspace_id = H5Screate_simple(1, dims, NULL);
-    attr_id = H5Acreate (id, attr_name, H5T_NATIVE_INT, dataspace_id,
-                         H5P_DEFAULT, H5P_DEFAULT);
-    IO(H5Awrite(attr_id, H5T_NATIVE_INT , &attr_value ));
-    IO(H5Aclose (attr_id));
-    IO (H5Gclose (id));
-  }
-  IO (H5Fclose (file_id));
+static void release_info (void *ptr, int count)
+{
+  (void) count;
+  delete_info ((struct fclib_info*) ptr);
+}
 
-  return 1;
+static void release_global (void *ptr, int count)
+{
+  (void) count;
+  fclib_delete_global ((struct fclib_global*) ptr);
+  free (ptr);
 }
 
-/* =========================== interface ============================ */
+static void release_global_rolling (void *ptr, int count)
+{
+  (void) count;
+  fclib_delete_global_rolling ((struct fclib_global_rolling*) ptr);
+  free (ptr);
+}
 
-/* write global problem;
- * return 1 on success, 0 on failure */
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global (struct fclib_global *problem, const char *path)
+static void release_local (void *ptr, int count)
 {
-  hid_t  file_id, main_id, id;
-  hsize_t dim = 1;
-  FILE *f;
-
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
-  {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
-    {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
-    }
+  (void) count;
+  fclib_delete_local ((struct fclib_local*) ptr);
+  free (ptr);
+}
 
-    if (H5Lexists (file_id, "/fclib_global", H5P_DEFAULT)) /* cannot overwrite existing datasets */
-    {
-      fprintf (stderr, "ERROR: a global problem has already been written to this file\n");
-      return 0;
-    }
-  }
-  else if ((file_id = H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) < 0) /* cerate */
-  {
-    fprintf (stderr, "ERROR: creating file failed\n");
-    return 0;
-  }
+static void release_solutions (void *ptr, int count)
+{
+  fclib_delete_solutions ((struct fclib_solution*) ptr, count);
+}
 
-  IO (main_id = H5Gmake (file_id, "/fclib_global"));
+static void release_block_diagonal (void *ptr, int count)
+{
+  (void) count;
+  fclib_delete_block_diagonal ((struct fclib_block_diagonal*) ptr);
+}
 
-  ASSERT (problem->spacedim == 2 || problem->spacedim == 3, "ERROR: space dimension must be 2 or 3");
-  IO (H5LTmake_dataset_int (file_id, "/fclib_global/spacedim", 1, &dim, &problem->spacedim));
+static void release_memory (void *ptr, int count)
+{
+  (void) count;
+  free (ptr);
+}
 
-  ASSERT (problem->M, "ERROR: M must be given");
-  IO (id = H5Gmake (file_id, "/fclib_global/M"));
-  write_matrix (id, problem->M);
-  IO (H5Gclose (id));
+/* modes of file_open */
+enum {FILE_READ, FILE_UPDATE, FILE_CREATE};
 
-  ASSERT (problem->H, "ERROR: H must be given");
-  IO (id = H5Gmake (file_id, "/fclib_global/H"));
-  write_matrix (id, problem->H);
-  IO (H5Gclose (id));
+/* open the file of a public call and register it with the error context: FILE_READ opens
+ * it read-only, FILE_UPDATE read-write and FILE_CREATE also creates it when missing */
+static hid_t file_open (const char *path, int mode)
+{
+  hid_t file_id = -1;
+  FILE *f;
 
-  if (problem->G)
+  if (mode == FILE_READ) file_id = H5 (H5Fopen (path, H5F_ACC_RDONLY, H5P_DEFAULT));
+  else if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
   {
-    IO (id = H5Gmake (file_id, "/fclib_global/G"));
-    write_matrix (id, problem->G);
-    IO (H5Gclose (id));
+    fclose (f);
+    file_id = H5 (H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT));
   }
-
-  IO (id = H5Gmake (file_id, "/fclib_global/vectors"));
-  write_global_vectors (id, problem);
-  IO (H5Gclose (id));
-
-  if (problem->info)
+  else if (mode == FILE_CREATE)
   {
-    IO (id = H5Gmake (file_id, "/fclib_global/info"));
-    write_problem_info (id, problem->info);
-    IO (H5Gclose (id));
+    if ((file_id = H5 (H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT))) < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: creating file %s failed", path);
   }
 
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
+  if (file_id < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: opening file %s failed", path);
+  error_file (file_id);
 
-  return 1;
+  return file_id;
 }
 
-/* write global problem rolling;
- * return 1 on success, 0 on failure */
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_rolling (struct fclib_global_rolling *problem, const char *path)
+/* initial size and growth of the in-memory files written by the *_to_buffer calls */
+#define FCLIB_IMAGE_INCREMENT (1 << 16)
+
+/* create an in-memory file without backing store and register it with the error context */
+static hid_t image_create (void)
 {
-  hid_t  file_id, main_id, id;
-  hsize_t dim = 1;
-  FILE *f;
+  static FCLIB_THREAD_LOCAL unsigned count = 0;
+  hid_t fapl_id, file_id = -1;
+  char name [64];
 
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
-  {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
-    {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
-    }
+  /* open core files are told apart by name, and the counter address by thread */
+  snprintf (name, 64, "fclib_image_%p_%u", (void*) &count, count ++);
+  IO (fapl_id = H5Pcreate (H5P_FILE_ACCESS));
+  if (H5 (H5Pset_fapl_core (fapl_id, FCLIB_IMAGE_INCREMENT, 0)) >= 0)
+    file_id = H5 (H5Fcreate (name, H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id));
+  H5 (H5Pclose (fapl_id));
 
-    if (H5Lexists (file_id, "/fclib_global_rolling", H5P_DEFAULT)) /* cannot overwrite existing datasets */
-    {
-      fprintf (stderr, "ERROR: a global problem has already been written to this file\n");
-      return 0;
-    }
-  }
-  else if ((file_id = H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) < 0) /* cerate */
-  {
-    fprintf (stderr, "ERROR: creating file failed\n");
-    return 0;
-  }
+  if (file_id < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: creating a file image failed");
+  error_file (file_id);
 
-  IO (main_id = H5Gmake (file_id, "/fclib_global_rolling"));
+  return file_id;
+}
 
-  ASSERT (problem->spacedim == 3 || problem->spacedim == 5, "ERROR: space dimension must be 3 or 5");
-  IO (H5LTmake_dataset_int (file_id, "/fclib_global_rolling/spacedim", 1, &dim, &problem->spacedim));
+/* file image callbacks lending a read-only buffer, passed as user data, to the core driver:
+ * every "allocation" is the buffer itself, so that nothing is copied or released */
+static void* image_lend (size_t size, H5FD_file_image_op_t op, void *udata)
+{
+  (void) size;
+  (void) op;
+  return udata;
+}
 
-  ASSERT (problem->M, "ERROR: M must be given");
-  IO (id = H5Gmake (file_id, "/fclib_global_rolling/M"));
-  write_matrix (id, problem->M);
-  IO (H5Gclose (id));
+static void* image_same (void *dest, const void *src, size_t size, H5FD_file_image_op_t op, void *udata)
+{
+  (void) size;
+  (void) op;
+  (void) udata;
+  return dest == src ? dest : NULL;
+}
 
-  ASSERT (problem->H, "ERROR: H must be given");
-  IO (id = H5Gmake (file_id, "/fclib_global_rolling/H"));
-  write_matrix (id, problem->H);
-  IO (H5Gclose (id));
+static void* image_grow (void *ptr, size_t size, H5FD_file_image_op_t op, void *udata)
+{
+  (void) ptr;
+  (void) size;
+  (void) op;
+  (void) udata;
+  return NULL; /* opened read-only */
+}
 
-  if (problem->G)
-  {
-    IO (id = H5Gmake (file_id, "/fclib_global_rolling/G"));
-    write_matrix (id, problem->G);
-    IO (H5Gclose (id));
-  }
+static herr_t image_keep (void *ptr, H5FD_file_image_op_t op, void *udata)
+{
+  (void) ptr;
+  (void) op;
+  (void) udata;
+  return 0;
+}
 
-  IO (id = H5Gmake (file_id, "/fclib_global_rolling/vectors"));
-  write_global_rolling_vectors (id, problem);
-  IO (H5Gclose (id));
+static void* image_udata_copy (void *udata)
+{
+  return udata;
+}
 
-  if (problem->info)
-  {
-    IO (id = H5Gmake (file_id, "/fclib_global_rolling/info"));
-    write_problem_info (id, problem->info);
-    IO (H5Gclose (id));
-  }
+static herr_t image_udata_free (void *udata)
+{
+  (void) udata;
+  return 0;
+}
 
-  IO (H5Gclose (main_id));
+/* open a file image read-only, without copying it, and register it with the error context;
+ * this is H5LTopen_file_image with H5LT_FILE_IMAGE_DONT_COPY, which leaks its own user data */
+static hid_t image_open (const void *buffer, size_t size)
+{
+  static FCLIB_THREAD_LOCAL unsigned count = 0;
+  H5FD_file_image_callbacks_t callbacks = {image_lend, image_same, image_grow, image_keep,
+                                           image_udata_copy, image_udata_free, (void*) buffer};
+  hid_t fapl_id, file_id = -1;
+  char name [64];
+
+  ASSERT (buffer && size > 0, "ERROR: empty file image");
+  snprintf (name, 64, "fclib_image_%p_%p_%u", buffer, (void*) &count, count ++);
+  IO (fapl_id = H5Pcreate (H5P_FILE_ACCESS));
+  if (H5 (H5Pset_fapl_core (fapl_id, FCLIB_IMAGE_INCREMENT, 0)) >= 0 &&
+      H5 (H5Pset_file_image_callbacks (fapl_id, &callbacks)) >= 0 &&
+      H5 (H5Pset_file_image (fapl_id, (void*) buffer, size)) >= 0) file_id = H5 (H5Fopen (name, H5F_ACC_RDONLY, fapl_id));
+  H5 (H5Pclose (fapl_id));
+
+  if (file_id < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: opening a file image of %zu bytes failed", size);
+  error_file (file_id);
+
+  return file_id;
+}
+
+/* copy an in-memory file into a new buffer, to be released with free (), and close it */
+static void image_close (hid_t file_id, void **buffer, size_t *size)
+{
+  ssize_t length;
+  void *image;
+
+  IO (H5Fflush (file_id, H5F_SCOPE_LOCAL)); /* write cached object headers into the image */
+  IO (length = H5Fget_file_image (file_id, NULL, 0));
+  MM (image = FCLIB_MALLOC (length));
+  error_keep (image, release_memory, 1);
+  IO (H5Fget_file_image (file_id, image, length));
   IO (H5Fclose (file_id));
+  error_drop (image);
 
-  return 1;
+  *buffer = image;
+  *size = length;
+}
+
+/* allocate matrix arrays for the given storage */
+static struct fclib_matrix* matrix_alloc (int m, int n, int nzmax, int nz, int bs)
+{
+  struct fclib_matrix *mat;
+  int np, ni;
+
+  MM (mat = (struct fclib_matrix*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix)));
+  error_keep (mat, release_matrix, 1);
+  mat->m = m;
+  mat->n = n;
+  mat->nzmax = nzmax;
+  mat->nz = nz;
+  mat->bs = bs;
+
+  if (nz >= 0) np = ni = nzmax; /* triplet */
+  else if (nz == -1) np = n+1, ni = nzmax; /* csc */
+  else if (nz == -2) np = m+1, ni = nzmax; /* csr */
+  else if (nz == -3) np = m/bs+1, ni = nzmax/(bs*bs); /* bsr */
+  else if (nz == -4) np = n+1, ni = nzmax; /* symmetric, upper triangle in csc */
+  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", nz);
+
+  MM (mat->p = (int*)FCLIB_MALLOC (sizeof(int)*(np > 0 ? np : 1)));
+  MM (mat->i = (int*)FCLIB_MALLOC (sizeof(int)*(ni > 0 ? ni : 1)));
+  MM (mat->x = (double*)FCLIB_MALLOC (sizeof(double)*(nzmax > 0 ? nzmax : 1)));
+  error_drop (mat);
+
+  return mat;
 }
 
+/* copy matrix info */
+static struct fclib_matrix_info* matrix_info_copy (struct fclib_matrix_info *info)
+{
+  struct fclib_matrix_info *copy;
 
+  if (!info) return NULL;
 
+  MM (copy = (struct fclib_matrix_info*)FCLIB_MALLOC (sizeof (struct fclib_matrix_info)));
+  *copy = *info;
+  if (info->comment)
+  {
+    MM (copy->comment = (char*)FCLIB_MALLOC (strlen (info->comment) + 1));
+    strcpy (copy->comment, info->comment);
+  }
 
+  return copy;
+}
 
+/* number of entries above which the sparse kernels run in parallel */
+#define FCLIB_PARALLEL_MIN 50000
 
-/* write local problem;
- * return 1 on success, 0 on failure */
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_local (struct fclib_local *problem, const char *path)
+/* exclusive prefix sum: on exit w [j] = w [0] + ... + w [j-1] for j = 0..n */
+static void cumsum (int *w, int n)
 {
-  hid_t  file_id, main_id, id;
-  hsize_t dim = 1;
-  FILE *f;
+  int j, sum = 0;
 
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
+#ifdef _OPENMP
+  if (n > FCLIB_PARALLEL_MIN && omp_get_max_threads () > 1)
   {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
-    {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
-    }
+    int *part;
+
+    MM (part = (int*)FCLIB_CALLOC (omp_get_max_threads () + 1, sizeof(int)));
 
-    if (H5Lexists (file_id, "/fclib_local", H5P_DEFAULT)) /* cannot overwrite existing datasets */
+#pragma omp parallel private(j, sum)
     {
-      fprintf (stderr, "ERROR: a local problem has already been written to this file\n");
-      return 0;
+      int t = omp_get_thread_num (), nt = omp_get_num_threads ();
+      int lo = (int)((long long)n*t/nt), hi = (int)((long long)n*(t+1)/nt);
+
+      for (sum = 0, j = lo; j < hi; j ++) sum += w [j];
+      part [t+1] = sum;
+#pragma omp barrier
+#pragma omp single
+      for (j = 0; j < nt; j ++) part [j+1] += part [j];
+
+      for (sum = part [t], j = lo; j < hi; j ++)
+      {
+        int v = w [j];
+        w [j] = sum;
+        sum += v;
+      }
+#pragma omp single
+      w [n] = part [nt];
     }
+
+    free (part);
+    return;
   }
-  else if ((file_id = H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT)) < 0) /* cerate */
+#endif
+
+  for (j = 0; j < n; j ++)
   {
-    fprintf (stderr, "ERROR: creating file failed\n");
-    return 0;
+    int v = w [j];
+    w [j] = sum;
+    sum += v;
   }
+  w [n] = sum;
+}
 
-  IO (main_id = H5Gmake (file_id, "/fclib_local"));
-
-  ASSERT (problem->spacedim == 2 || problem->spacedim == 3, "ERROR: space dimension must be 2 or 3");
-  IO (H5LTmake_dataset_int (file_id, "/fclib_local/spacedim", 1, &dim, &problem->spacedim));
-
-  ASSERT (problem->W, "ERROR: W must be given");
-  IO (id = H5Gmake (file_id, "/fclib_local/W"));
-  write_matrix (id, problem->W);
-  IO (H5Gclose (id));
+/* sort keys in increasing order */
+static void sort_keys (unsigned long long *a, int n)
+{
+  unsigned long long pivot, t;
+  int lo, hi;
 
-  if (problem->V && problem->R)
+  while (n > 16) /* quicksort, recursing into the smaller part */
   {
-    IO (id = H5Gmake (file_id, "/fclib_local/V"));
-    write_matrix (id, problem->V);
-    IO (H5Gclose (id));
-
-    IO (id = H5Gmake (file_id, "/fclib_local/R"));
-    write_matrix (id, problem->R);
-    IO (H5Gclose (id));
+    pivot = a [n/2];
+    if ((a [0] < pivot) != (pivot < a [n-1])) pivot = ((a [0] < a [n-1]) == (a [0] < pivot) ? a [n-1] : a [0]);
+    for (lo = 0, hi = n-1; lo <= hi; lo ++, hi --)
+    {
+      while (a [lo] < pivot) lo ++;
+      while (a [hi] > pivot) hi --;
+      if (lo > hi) break;
+      t = a [lo]; a [lo] = a [hi]; a [hi] = t;
+    }
+    if (hi+1 < n-lo)
+    {
+      sort_keys (a, hi+1);
+      a += lo;
+      n -= lo;
+    }
+    else
+    {
+      sort_keys (a+lo, n-lo);
+      n = hi+1;
+    }
   }
-  else ASSERT (!problem->V && !problem->R, "ERROR: V and R must be defined at the same time");
 
-  IO (id = H5Gmake (file_id, "/fclib_local/vectors"));
-  write_local_vectors (id, problem);
-  IO (H5Gclose (id));
-
-  if (problem->info)
+  for (lo = 1; lo < n; lo ++) /* insertion sort */
   {
-    IO (id = H5Gmake (file_id, "/fclib_local/info"));
-    write_problem_info (id, problem->info);
-    IO (H5Gclose (id));
+    for (t = a [lo], hi = lo; hi > 0 && a [hi-1] > t; hi --) a [hi] = a [hi-1];
+    a [hi] = t;
   }
-
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
-
-  return 1;
 }
 
-/* write solution;
- * return 1 on success, 0 on failure */
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_solution (struct fclib_solution *solution, const char *path)
+/* sort index/value pairs by increasing index */
+static void sort_pairs (int *idx, double *x, int n)
 {
-  hid_t  file_id, id;
-  int nv, nr, nl;
-  FILE *f;
+  int pivot, t, lo, hi;
+  double v;
 
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
+  while (n > 16) /* quicksort, recursing into the smaller part */
   {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
+    pivot = idx [n/2];
+    if ((idx [0] < pivot) != (pivot < idx [n-1])) pivot = ((idx [0] < idx [n-1]) == (idx [0] < pivot) ? idx [n-1] : idx [0]);
+    for (lo = 0, hi = n-1; lo <= hi; lo ++, hi --)
     {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
+      while (idx [lo] < pivot) lo ++;
+      while (idx [hi] > pivot) hi --;
+      if (lo > hi) break;
+      t = idx [lo]; idx [lo] = idx [hi]; idx [hi] = t;
+      v = x [lo]; x [lo] = x [hi]; x [hi] = v;
     }
-
-    if (H5Lexists (file_id, "/solution", H5P_DEFAULT)) /* cannot overwrite existing datasets */
+    if (hi+1 < n-lo)
     {
-      fprintf (stderr, "ERROR: a solution has already been written to this file\n");
-      return 0;
+      sort_pairs (idx, x, hi+1);
+      idx += lo;
+      x += lo;
+      n -= lo;
+    }
+    else
+    {
+      sort_pairs (idx+lo, x+lo, n-lo);
+      n = hi+1;
     }
   }
-  else
+
+  for (lo = 1; lo < n; lo ++) /* insertion sort */
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
-    return 0;
+    for (t = idx [lo], v = x [lo], hi = lo; hi > 0 && idx [hi-1] > t; hi --)
+    {
+      idx [hi] = idx [hi-1];
+      x [hi] = x [hi-1];
+    }
+    idx [hi] = t;
+    x [hi] = v;
   }
-
-  if (! read_nvnunrnl (file_id, &nv, &nr, &nl)) return 0;
-
-  IO (id = H5Gmake (file_id, "/solution"));
-  write_solution (id, solution, nv, nr, nl);
-  IO (H5Gclose (id));
-
-  IO (H5Fclose (file_id));
-
-  return 1;
 }
 
-/* write initial guesses;
- * return 1 on success, 0 on failure */
-FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_guesses (int number_of_guesses,  struct fclib_solution *guesses, const char *path)
+/* compress a triplet, compressed column or compressed row matrix into a new compressed column (nz = -1)
+ * or compressed row (nz = -2) matrix with sorted indices; duplicates are kept in their original order.
+ * Entries are counted and scattered in parallel as (inner index, source position) keys, so that
+ * sorting the keys of each compressed column or row gives the same result for any number of threads */
+static struct fclib_matrix* matrix_compress (struct fclib_matrix *mat, int nz)
 {
-  hid_t  file_id, main_id, id;
-  int nv, nr, nl, i;
-  hsize_t dim = 1;
-  char num [128];
-  FILE *f;
-
-  if ((f = fopen (path, "r"))) /* HDF5 outputs lots of warnings when file does not exist */
+  struct fclib_matrix *out;
+  unsigned long long *key;
+  int nnz, outer, *w, j, k;
+
+  ASSERT (nz == -1 || nz == -2, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", nz);
+  ASSERT (mat->nz >= -2, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", mat->nz);
+
+  nnz = (mat->nz >= 0 ? mat->nz : mat->p [mat->nz == -1 ? mat->n : mat->m]);
+  outer = (nz == -1 ? mat->n : mat->m);
+  out = matrix_alloc (mat->m, mat->n, nnz, nz, 0);
+  error_keep (out, release_matrix, 1);
+  MM (w = (int*)FCLIB_CALLOC (outer+1, sizeof(int)));
+  error_keep (w, release_memory, 1);
+  MM (key = (unsigned long long*)FCLIB_MALLOC (sizeof(unsigned long long)*(nnz > 0 ? nnz : 1)));
+  error_keep (key, release_memory, 1);
+
+  if (mat->nz >= 0) /* triplet: p are row and i column indices */
   {
-    fclose (f);
-    if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)
+    int *o = (nz == -2 ? mat->p : mat->i), *in = (nz == -2 ? mat->i : mat->p);
+
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++)
     {
-      fprintf (stderr, "ERROR: opening file failed\n");
-      return 0;
+#pragma omp atomic
+      w [o [k]] ++;
     }
+    cumsum (w, outer);
+    memcpy (out->p, w, sizeof(int)*(outer+1));
 
-    if (H5Lexists (file_id, "/guesses", H5P_DEFAULT)) /* cannot overwrite existing datasets */
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++)
     {
-      fprintf (stderr, "ERROR: some guesses have already been written to this file\n");
-      return 0;
+      int l;
+#pragma omp atomic capture
+      l = w [o [k]] ++;
+      key [l] = ((unsigned long long)in [k] << 32) | (unsigned)k;
     }
   }
-  else
+  else if (mat->nz == nz) /* same orientation: the pointers are kept */
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
-    return 0;
+    memcpy (out->p, mat->p, sizeof(int)*(outer+1));
+
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++) key [k] = ((unsigned long long)mat->i [k] << 32) | (unsigned)k;
   }
+  else /* transposed orientation */
+  {
+    int source = (mat->nz == -1 ? mat->n : mat->m);
 
-  if (! read_nvnunrnl (file_id, &nv, &nr, &nl)) return 0;
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++)
+    {
+#pragma omp atomic
+      w [mat->i [k]] ++;
+    }
+    cumsum (w, outer);
+    memcpy (out->p, w, sizeof(int)*(outer+1));
+
+#pragma omp parallel for private(k) schedule(dynamic, 256) if (nnz > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < source; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      {
+        int l;
+#pragma omp atomic capture
+        l = w [mat->i [k]] ++;
+        key [l] = ((unsigned long long)j << 32) | (unsigned)k;
+      }
+  }
 
-  IO (main_id = H5Gmake (file_id, "/guesses"));
-  IO (H5LTmake_dataset_int (file_id, "/guesses/number_of_guesses", 1, &dim, &number_of_guesses));
+#pragma omp parallel for schedule(dynamic, 256) if (nnz > FCLIB_PARALLEL_MIN)
+  for (j = 0; j < outer; j ++) sort_keys (key + out->p [j], out->p [j+1] - out->p [j]);
 
-  for (i = 0; i < number_of_guesses; i ++)
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+  for (k = 0; k < nnz; k ++)
   {
-    snprintf (num, 128, "%d", i+1);
-    IO (id = H5Gmake (main_id, num));
-    write_solution (id, &guesses [i], nv, nr, nl);
-    IO (H5Gclose (id));
+    out->i [k] = (int)(key [k] >> 32);
+    out->x [k] = mat->x [key [k] & 0xffffffffu];
   }
 
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
+  error_drop (key);
+  error_drop (w);
+  free (key);
+  free (w);
+  out->info = matrix_info_copy (mat->info);
+  error_drop (out);
 
-  return 1;
+  return out;
 }
 
-/* read global problem;
- * return problem on success; NULL on failure */
-FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global* fclib_read_global (const char *path)
+/* sort the entries of a triplet matrix in place by outer index o, then by inner index in;
+ * on exit ptr [0..outer] point to the first entry of each outer index */
+static void triplet_sort_inplace (int *o, int *in, double *x, int nnz, int outer, int *ptr)
 {
-  struct fclib_global *problem;
-  hid_t  file_id, main_id, id;
+  int *next, j, k, l, t;
+  double v;
 
-  if ((file_id = H5Fopen (path, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
+  memset (ptr, 0, sizeof(int)*(outer+1));
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+  for (k = 0; k < nnz; k ++)
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
-    return NULL;
+#pragma omp atomic
+    ptr [o [k]] ++;
   }
+  cumsum (ptr, outer);
 
-  MM (problem = (struct fclib_global*)calloc (1, sizeof (struct fclib_global)));
-
-  IO (main_id = H5Gopen (file_id, "/fclib_global", H5P_DEFAULT));
-  IO (H5LTread_dataset_int (file_id, "/fclib_global/spacedim", &problem->spacedim));
+  /* move every entry into its bucket by swaps (American flag sort) */
+  MM (next = (int*)FCLIB_MALLOC (sizeof(int)*(outer+1)));
+  memcpy (next, ptr, sizeof(int)*(outer+1));
+  for (j = 0; j < outer; j ++)
+    while (next [j] < ptr [j+1])
+    {
+      k = next [j];
+      if (o [k] == j) next [j] ++;
+      else
+      {
+        l = next [o [k]] ++;
+        t = o [k]; o [k] = o [l]; o [l] = t;
+        t = in [k]; in [k] = in [l]; in [l] = t;
+        v = x [k]; x [k] = x [l]; x [l] = v;
+      }
+    }
+  free (next);
 
-  IO (id = H5Gopen (file_id, "/fclib_global/M", H5P_DEFAULT));
-  problem->M = read_matrix (id);
-  IO (H5Gclose (id));
+#pragma omp parallel for schedule(dynamic, 256) if (nnz > FCLIB_PARALLEL_MIN)
+  for (j = 0; j < outer; j ++) sort_pairs (in + ptr [j], x + ptr [j], ptr [j+1] - ptr [j]);
+}
 
-  IO (id = H5Gopen (file_id, "/fclib_global/H", H5P_DEFAULT));
-  problem->H = read_matrix (id);
-  IO (H5Gclose (id));
+/* convert any matrix into a new compressed row matrix; duplicates are kept */
+static struct fclib_matrix* matrix_csr (struct fclib_matrix *mat)
+{
+  struct fclib_matrix *csr;
+  int *w, j, k, l, r, c;
 
-  if (H5Lexists (file_id, "/fclib_global/G", H5P_DEFAULT))
+  if (mat->nz == -3) /* bsr: rows of a block row are laid out block after block */
   {
-    IO (id = H5Gopen (file_id, "/fclib_global/G", H5P_DEFAULT));
-    problem->G = read_matrix (id);
-    IO (H5Gclose (id));
-  }
-
-  IO (id = H5Gopen (file_id, "/fclib_global/vectors", H5P_DEFAULT));
-  read_global_vectors (id, problem);
-  IO (H5Gclose (id));
+    int bs = mat->bs, bs2 = bs*bs, mb = mat->m/bs;
 
-  if (H5Lexists (file_id, "/fclib_global/info", H5P_DEFAULT))
+    csr = matrix_alloc (mat->m, mat->n, mat->nzmax, -2, 0);
+    csr->p [0] = 0;
+    for (j = 0; j < mb; j ++)
+    {
+      int nb = mat->p [j+1] - mat->p [j];
+      for (r = 0; r < bs; r ++)
+      {
+        int row = j*bs + r, pos = csr->p [row];
+        for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+          for (c = 0; c < bs; c ++, pos ++)
+          {
+            csr->i [pos] = mat->i [k]*bs + c;
+            csr->x [pos] = mat->x [k*bs2 + r*bs + c];
+          }
+        csr->p [row+1] = csr->p [row] + nb*bs;
+      }
+    }
+  }
+  else if (mat->nz == -4) /* symmetric: (r, j) with r <= j is also stored as (j, r) */
   {
-    IO (id = H5Gopen (file_id, "/fclib_global/info", H5P_DEFAULT));
-    problem->info = read_problem_info (id);
-    IO (H5Gclose (id));
+    int nnz = mat->p [mat->n];
+
+    MM (w = (int*)FCLIB_CALLOC (mat->m+1, sizeof(int)));
+    error_keep (w, release_memory, 1);
+    for (j = 0, l = 0; j < mat->n; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      {
+        w [mat->i [k]] ++;
+        if (mat->i [k] != j) w [j] ++, l ++;
+      }
+
+    csr = matrix_alloc (mat->m, mat->n, nnz+l, -2, 0);
+    for (csr->p [0] = j = 0; j < mat->m; j ++)
+    {
+      csr->p [j+1] = csr->p [j] + w [j];
+      w [j] = csr->p [j];
+    }
+
+    for (j = 0; j < mat->n; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      {
+        r = mat->i [k];
+        l = w [r] ++;
+        csr->i [l] = j;
+        csr->x [l] = mat->x [k];
+        if (r != j)
+        {
+          l = w [j] ++;
+          csr->i [l] = r;
+          csr->x [l] = mat->x [k];
+        }
+      }
+
+    error_drop (w);
+    free (w);
   }
+  else return matrix_compress (mat, -2); /* triplet, csc or csr */
 
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
+  csr->info = matrix_info_copy (mat->info);
 
-  return problem;
+  return csr;
 }
-/* read global problem;
- * return problem on success; NULL on failure */
+
+/* convert a compressed row matrix into a new triplet, compressed column or compressed row matrix */
+static struct fclib_matrix* matrix_from_csr (struct fclib_matrix *csr, int nz)
+{
+  struct fclib_matrix *mat;
+  int nnz = csr->p [csr->m], j, k;
+
+  if (nz < 0) return matrix_compress (csr, nz);
+
+  mat = matrix_alloc (csr->m, csr->n, nnz, nnz, 0); /* triplet */
+#pragma omp parallel for private(k) if (nnz > FCLIB_PARALLEL_MIN)
+  for (j = 0; j < csr->m; j ++)
+    for (k = csr->p [j]; k < csr->p [j+1]; k ++) mat->p [k] = j;
+  memcpy (mat->i, csr->i, sizeof(int)*nnz);
+  memcpy (mat->x, csr->x, sizeof(double)*nnz);
+  mat->info = matrix_info_copy (csr->info);
+
+  return mat;
+}
+
+/* y += A x */
+static void matrix_gaxpy (const struct fclib_matrix *A, const double *x, double *y)
+{
+  const int *p = A->p, *i = A->i;
+  const double *a = A->x;
+  int j, k;
+
+  if (A->nz >= 0) /* triplet */
+  {
+    for (k = 0; k < A->nz; k ++) y [p [k]] += a [k] * x [i [k]];
+  }
+  else if (A->nz == -1) /* csc */
+  {
+    for (j = 0; j < A->n; j ++)
+      for (k = p [j]; k < p [j+1]; k ++) y [i [k]] += a [k] * x [j];
+  }
+  else if (A->nz == -2) /* csr */
+  {
+#pragma omp parallel for private(k) if (p [A->m] > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < A->m; j ++)
+    {
+      double yj = 0.0;
+#pragma omp simd reduction(+:yj)
+      for (k = p [j]; k < p [j+1]; k ++) yj += a [k] * x [i [k]];
+      y [j] += yj;
+    }
+  }
+  else if (A->nz == -3 && A->bs == 3) /* bsr, 3x3 blocks kept in registers */
+  {
+    for (j = 0; j < A->m/3; j ++)
+    {
+      double y0 = 0.0, y1 = 0.0, y2 = 0.0;
+      for (k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + 9*k, *xk = x + 3*i [k];
+        double x0 = xk [0], x1 = xk [1], x2 = xk [2];
+        y0 += b [0]*x0 + b [1]*x1 + b [2]*x2;
+        y1 += b [3]*x0 + b [4]*x1 + b [5]*x2;
+        y2 += b [6]*x0 + b [7]*x1 + b [8]*x2;
+      }
+      y [3*j] += y0;
+      y [3*j+1] += y1;
+      y [3*j+2] += y2;
+    }
+  }
+  else if (A->nz == -3 && A->bs == 2) /* bsr, 2x2 blocks kept in registers */
+  {
+    for (j = 0; j < A->m/2; j ++)
+    {
+      double y0 = 0.0, y1 = 0.0;
+      for (k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + 4*k, *xk = x + 2*i [k];
+        y0 += b [0]*xk [0] + b [1]*xk [1];
+        y1 += b [2]*xk [0] + b [3]*xk [1];
+      }
+      y [2*j] += y0;
+      y [2*j+1] += y1;
+    }
+  }
+  else if (A->nz == -3) /* bsr, any block size */
+  {
+    int bs = A->bs, r, c;
+    for (j = 0; j < A->m/bs; j ++)
+      for (k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + bs*bs*k, *xk = x + bs*i [k];
+        for (r = 0; r < bs; r ++)
+          for (c = 0; c < bs; c ++) y [bs*j+r] += b [r*bs+c] * xk [c];
+      }
+  }
+  else if (A->nz == -4) /* symmetric: each stored off-diagonal value serves two products */
+  {
+    for (j = 0; j < A->n; j ++)
+    {
+      double xj = x [j], yj = 0.0;
+      for (k = p [j]; k < p [j+1]; k ++)
+      {
+        int r = i [k];
+        y [r] += a [k] * xj;
+        if (r != j) yj += a [k] * x [r];
+      }
+      y [j] += yj;
+    }
+  }
+  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", A->nz);
+}
+
+#ifdef FCLIB_WITH_MERIT_FUNCTIONS
+/* y += A^T x, for the merit functions */
+static void matrix_gatxpy (const struct fclib_matrix *A, const double *x, double *y)
+{
+  const int *p = A->p, *i = A->i;
+  const double *a = A->x;
+  int j, k;
+
+  if (A->nz >= 0) /* triplet */
+  {
+    for (k = 0; k < A->nz; k ++) y [i [k]] += a [k] * x [p [k]];
+  }
+  else if (A->nz == -1) /* csc */
+  {
+    for (j = 0; j < A->n; j ++)
+    {
+      double yj = 0.0;
+#pragma omp simd reduction(+:yj)
+      for (k = p [j]; k < p [j+1]; k ++) yj += a [k] * x [i [k]];
+      y [j] += yj;
+    }
+  }
+  else if (A->nz == -2) /* csr */
+  {
+    for (j = 0; j < A->m; j ++)
+      for (k = p [j]; k < p [j+1]; k ++) y [i [k]] += a [k] * x [j];
+  }
+  else if (A->nz == -3) /* bsr */
+  {
+    int bs = A->bs, r, c;
+    for (j = 0; j < A->m/bs; j ++)
+      for (k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + bs*bs*k, *xj = x + bs*j;
+        double *yk = y + bs*i [k];
+        for (r = 0; r < bs; r ++)
+          for (c = 0; c < bs; c ++) yk [c] += b [r*bs+c] * xj [r];
+      }
+  }
+  else if (A->nz == -4) /* symmetric */
+  {
+    matrix_gaxpy (A, x, y);
+  }
+  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", A->nz);
+}
+#endif /* FCLIB_WITH_MERIT_FUNCTIONS */
+
+/* record why a matrix is invalid in the 'size' bytes at reason; return 0 */
+static int matrix_invalid (char *reason, size_t size, const char *format, ...)
+{
+  va_list args;
+
+  va_start (args, format);
+  vsnprintf (reason, size, format, args);
+  va_end (args);
+
+  return 0;
+}
+
+/* check the dimensions, storage and block size of a matrix, before its arrays */
+static int matrix_check_shape (const struct fclib_matrix *mat, char *reason, size_t size)
+{
+  if (mat->m < 0 || mat->n < 0 || mat->nzmax < 0)
+    return matrix_invalid (reason, size, "negative dimensions => %d x %d, nzmax = %d", mat->m, mat->n, mat->nzmax);
+  if (mat->nz < -4) return matrix_invalid (reason, size, "unknown sparse matrix type => nz = %d", mat->nz);
+  if (mat->nz > mat->nzmax) return matrix_invalid (reason, size, "%d triplets, room for %d", mat->nz, mat->nzmax);
+  if (mat->nz == -4 && mat->m != mat->n) return matrix_invalid (reason, size, "a symmetric matrix must be square => %d x %d", mat->m, mat->n);
+  if (mat->nz == -3 && (mat->bs <= 0 || mat->m % mat->bs || mat->n % mat->bs || mat->nzmax % ((long long) mat->bs * mat->bs)))
+    return matrix_invalid (reason, size, "%d x %d with nzmax = %d is not made of blocks of size %d", mat->m, mat->n, mat->nzmax, mat->bs);
+
+  return 1;
+}
+
+/* check the structure of a matrix with a pass over its pointers and one over its indices, counting
+ * defects without branches in simd loops (run in parallel on large matrices): the
+ * pointers start at 0, do not decrease and stay within nzmax, the indices lie within the dimensions
+ * (on or above the diagonal for nz = -4); *structure receives FCLIB_MATRIX_SORTED and FCLIB_MATRIX_UNIQUE
+ * from the count of decreasing and repeated indices; return 0 with the reason in the 'size' bytes at
+ * reason on the first defect */
+static int matrix_validate (const struct fclib_matrix *mat, int *structure, char *reason, size_t size)
+{
+  const int *p = mat->p, *i = mat->i;
+  int nnz, k, j, out = 0, down = 0, same = 0;
+
+  *structure = 0;
+  if (!matrix_check_shape (mat, reason, size)) return 0;
+
+  if (mat->nz >= 0) /* triplet: rows in p, columns in i, ordered by rows, then columns */
+  {
+    unsigned m = (unsigned) mat->m, n = (unsigned) mat->n;
+
+    nnz = mat->nz;
+    if (nnz > 0 && (!p || !i)) return matrix_invalid (reason, size, "missing indices of %d triplets", nnz);
+
+#pragma omp parallel for simd reduction(+:out) if (parallel: nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++) out += ((unsigned) p [k] >= m) | ((unsigned) i [k] >= n);
+    if (out)
+      for (k = 0; k < nnz; k ++)
+        if ((unsigned) p [k] >= m || (unsigned) i [k] >= n)
+          return matrix_invalid (reason, size, "triplet %d => (%d, %d) out of %d x %d", k, p [k], i [k], mat->m, mat->n);
+
+#pragma omp parallel for simd reduction(+:down,same) if (parallel: nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz-1; k ++)
+    {
+      int row = (p [k+1] == p [k]);
+
+      down += (p [k+1] < p [k]) | (row & (i [k+1] < i [k]));
+      same += row & (i [k+1] == i [k]);
+    }
+  }
+  else
+  {
+    int bs = (mat->nz == -3 ? mat->bs : 1), rows = (mat->nz == -2 || mat->nz == -3);
+    int outer = (rows ? mat->m : mat->n) / bs, capacity = (int) (mat->nzmax / ((long long) bs * bs));
+    unsigned inner = (unsigned) ((rows ? mat->n : mat->m) / bs);
+
+    if (!p || (capacity > 0 && !i)) return matrix_invalid (reason, size, "missing pointers or indices");
+    if (p [0] != 0) return matrix_invalid (reason, size, "p [0] = %d, not 0", p [0]);
+
+#pragma omp parallel for simd reduction(+:down) if (parallel: outer > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < outer; j ++) down += (p [j+1] < p [j]);
+    if (down)
+      for (j = 0; j < outer; j ++)
+        if (p [j+1] < p [j]) return matrix_invalid (reason, size, "p [%d] = %d < p [%d] = %d", j+1, p [j+1], j, p [j]);
+    nnz = p [outer];
+    if (nnz > capacity) return matrix_invalid (reason, size, "p [%d] = %d entries, room for %d", outer, nnz, capacity);
+
+#pragma omp parallel for simd reduction(+:out) if (parallel: nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz; k ++) out += ((unsigned) i [k] >= inner);
+    if (out)
+      for (k = 0; k < nnz; k ++)
+        if ((unsigned) i [k] >= inner) return matrix_invalid (reason, size, "i [%d] = %d out of [0, %u)", k, i [k], inner);
+
+    if (mat->nz == -4) /* upper triangle: row <= column */
+    {
+#pragma omp parallel for private(k) reduction(+:out) if (nnz > FCLIB_PARALLEL_MIN)
+      for (j = 0; j < outer; j ++)
+        for (k = p [j]; k < p [j+1]; k ++) out += (i [k] > j);
+      if (out)
+        for (j = 0; j < outer; j ++)
+          for (k = p [j]; k < p [j+1]; k ++)
+            if (i [k] > j) return matrix_invalid (reason, size, "entry (%d, %d) below the diagonal of a symmetric matrix", i [k], j);
+    }
+
+#pragma omp parallel for simd reduction(+:down,same) if (parallel: nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < nnz-1; k ++)
+    {
+      down += (i [k+1] < i [k]);
+      same += (i [k+1] == i [k]);
+    }
+#pragma omp parallel for reduction(+:down,same) if (outer > FCLIB_PARALLEL_MIN)
+    for (j = 1; j < outer; j ++) /* not counted across the start of a nonempty column, row or block row */
+      if (p [j] > 0 && p [j] < p [j+1])
+      {
+        down -= (i [p [j]] < i [p [j]-1]);
+        same -= (i [p [j]] == i [p [j]-1]);
+      }
+  }
+
+  *structure = (down == 0 ? FCLIB_MATRIX_SORTED : 0) | (down == 0 && same == 0 ? FCLIB_MATRIX_UNIQUE : 0);
+
+  return 1;
+}
+
+#include "fclib_index.h"
+
+/* register the index filter with HDF5, unless it is available already (e.g. as the plugin) */
+static void index_register (void)
+{
+  if (H5 (H5Zfilter_avail (FCLIB_FILTER_INDEX)) <= 0) IO (H5Zregister (&index_filter_class));
+}
+
+/* chunks filtered by fclib are decoded and encoded by fclib, in parallel, when HDF5 has direct
+ * chunk reads and writes: deflated chunks when zlib is available, index filtered chunks always */
+#if H5_VERSION_GE(1,10,3)
+#define FCLIB_DIRECT_CHUNKS
+#endif
+
+#ifdef FCLIB_DIRECT_CHUNKS
+/* raw chunk of a dataset: 'size' bytes at 'offset' of the raw buffer, filters skipped in 'mask' */
+struct raw_chunk
+{
+  size_t offset, size;
+  unsigned mask;
+};
+
+/* filters of a chunk pipeline, by their index in it, or -1 */
+struct chunk_filters
+{
+  int shuffle, deflate, index;
+};
+
+/* pipeline of the chunks of a 1d dataset with 'count' elements; return the number of chunks when
+ * they can be decoded by fclib, 0 otherwise; these are index filtered, then possibly deflated, or
+ * shuffled and deflated */
+static hsize_t chunk_pipeline (hid_t dataset_id, hsize_t count, hsize_t *chunk, struct chunk_filters *f)
+{
+  hid_t plist_id;
+  hsize_t nchunks = 0;
+  int nfilters, k;
+
+  IO (plist_id = H5Dget_create_plist (dataset_id));
+  f->shuffle = f->deflate = f->index = -1;
+  if (H5 (H5Pget_layout (plist_id)) == H5D_CHUNKED && H5 (H5Pget_chunk (plist_id, 1, chunk)) == 1 &&
+      (nfilters = (int) H5 (H5Pget_nfilters (plist_id))) > 0)
+  {
+    for (k = 0; k < nfilters; k ++)
+    {
+      unsigned flags, config;
+      size_t nvalues = 0;
+      H5Z_filter_t filter = (H5Z_filter_t) H5 (H5Pget_filter2 (plist_id, (unsigned) k, &flags, &nvalues, NULL, 0, NULL, &config));
+
+      if (filter == FCLIB_FILTER_INDEX && k == 0) f->index = k;
+#ifdef FCLIB_WITH_ZLIB
+      else if (filter == H5Z_FILTER_SHUFFLE && k == 0) f->shuffle = k; /* shuffled, then deflated */
+      else if (filter == H5Z_FILTER_DEFLATE && f->deflate < 0) f->deflate = k;
+#endif
+      else break;
+    }
+    if (k == nfilters && (f->deflate >= 0 || (f->index >= 0 && f->shuffle < 0)) && chunk [0] > 0)
+      nchunks = (count + chunk [0] - 1) / chunk [0];
+  }
+  IO (H5Pclose (plist_id));
+
+  return nchunks;
+}
+
+/* decode chunk k of 'chunk' elements of 'size' bytes into the 'count' elements of data;
+ * return 0 on a corrupt chunk or when out of memory */
+static int chunk_decode (unsigned char *raw, struct raw_chunk *c, hsize_t k, hsize_t chunk, hsize_t count,
+                         size_t size, struct chunk_filters *f, unsigned char *data)
+{
+  size_t bytes = (size_t) chunk * size, valid = (size_t) ((count - k*chunk < chunk ? count - k*chunk : chunk)), length = c->size;
+  unsigned char *dest = data + (size_t) (k*chunk) * size, *src = raw + c->offset, *tmp = NULL;
+  int unshuffle = (f->shuffle >= 0 && !(c->mask & (1u << f->shuffle)) && size > 1);
+  int index = (f->index >= 0 && !(c->mask & (1u << f->index)));
+
+#ifdef FCLIB_WITH_ZLIB
+  if (f->deflate >= 0 && !(c->mask & (1u << f->deflate)))
+  {
+    size_t limit = (index ? index_bound ((size_t) chunk) : bytes);
+    uLongf inflated = (uLongf) limit;
+    unsigned char *out = dest;
+
+    if (unshuffle || index || valid < chunk) /* through a chunk of its own */
+    {
+      if (!(tmp = (unsigned char*)FCLIB_MALLOC (limit))) return 0;
+      out = tmp;
+    }
+    if (uncompress (out, &inflated, src, (uLong) c->size) != Z_OK || (!index && inflated != bytes))
+    {
+      free (tmp);
+      return 0;
+    }
+    src = out;
+    length = (size_t) inflated;
+  }
+  else
+#endif
+  if (!index && c->size != bytes) return 0;
+
+  if (index) /* 4 bytes a value, straight into data */
+  {
+    int ok = length >= INDEX_HEADER && index_count (src) == (size_t) chunk && index_decode (src, length, (uint32_t*) dest, valid);
+
+    free (tmp);
+    return ok;
+  }
+  else if (unshuffle) /* byte b of element e is at b*chunk + e */
+  {
+    size_t e, b;
+
+    for (e = 0; e < valid; e ++)
+      for (b = 0; b < size; b ++) dest [e*size + b] = src [b*chunk + e];
+  }
+  else if (src != dest) memcpy (dest, src, valid * size);
+
+  free (tmp);
+  return 1;
+}
+
+/* read the raw chunks of a dataset, each HDF5 call on its own so that other threads may
+ * interleave theirs, and decode them in parallel; return 0 when a chunk is missing */
+static int chunk_read (hid_t dataset_id, const char *name, hsize_t nchunks, hsize_t chunk, hsize_t count,
+                       size_t size, struct chunk_filters *f, void *data)
+{
+  struct raw_chunk *chunks;
+  unsigned char *raw;
+  size_t total = 0;
+  long long k;
+  int failed = 0;
+
+  MM (chunks = (struct raw_chunk*)FCLIB_MALLOC (sizeof (struct raw_chunk) * nchunks));
+  error_keep (chunks, release_memory, 1);
+  for (k = 0; k < (long long) nchunks; k ++)
+  {
+    hsize_t offset = (hsize_t) k * chunk, bytes;
+
+    IO (H5Dget_chunk_storage_size (dataset_id, &offset, &bytes));
+    if (bytes == 0) /* not allocated: filled in by H5Dread */
+    {
+      error_drop (chunks);
+      free (chunks);
+      return 0;
+    }
+    chunks [k].offset = total;
+    chunks [k].size = (size_t) bytes;
+    total += (size_t) bytes;
+  }
+
+  MM (raw = (unsigned char*)FCLIB_MALLOC (total));
+  error_keep (raw, release_memory, 1);
+  for (k = 0; k < (long long) nchunks; k ++)
+  {
+    hsize_t offset = (hsize_t) k * chunk;
+    uint32_t mask = 0;
+
+    IO (H5Dread_chunk (dataset_id, H5P_DEFAULT, &offset, &mask, raw + chunks [k].offset));
+    chunks [k].mask = mask;
+  }
+
+#pragma omp parallel for schedule(dynamic) reduction(+:failed) if (nchunks > 1)
+  for (k = 0; k < (long long) nchunks; k ++)
+    failed += !chunk_decode (raw, &chunks [k], (hsize_t) k, chunk, count, size, f, (unsigned char*) data);
+
+  error_drop (raw);
+  error_drop (chunks);
+  free (raw);
+  free (chunks);
+  ASSERT (!failed, "ERROR: corrupt chunk or out of memory while decoding dataset %s", name);
+#ifdef FCLIB_WITH_STATS
+  stats_bytes (name, 0, (long long) count * (long long) size);
+#endif
+
+  return 1;
+}
+
+/* chunks encoded at once by chunk_write */
+#define FCLIB_CHUNK_BATCH 64
+
+/* bytes of an encoded chunk of 'chunk' elements of 'size' bytes, at most */
+static size_t chunk_bound (hsize_t chunk, size_t size, struct chunk_filters *f)
+{
+  size_t bound = (f->index >= 0 ? index_bound ((size_t) chunk) : (size_t) chunk * size);
+
+#ifdef FCLIB_WITH_ZLIB
+  if (f->deflate >= 0) bound = (size_t) compressBound ((uLong) bound);
+#endif
+
+  return bound;
+}
+
+/* deflate the 'bytes' at in into the 'bound' bytes at out; return the size, 0 when it fails */
+static size_t chunk_deflate (const unsigned char *in, size_t bytes, unsigned char *out, size_t bound)
+{
+#ifdef FCLIB_WITH_ZLIB
+  uLongf length = (uLongf) bound;
+
+  return (compress2 (out, &length, in, (uLong) bytes, FCLIB_DEFLATE_LEVEL) == Z_OK ? (size_t) length : 0);
+#else
+  return 0; /* only index filtered chunks are encoded without zlib */
+#endif
+}
+
+/* encode chunk k of 'chunk' elements of 'size' bytes, padded with zeros past the 'count' elements
+ * of data, into the 'bound' bytes at out: index filtered, shuffled, then deflated, as given by the
+ * pipeline; return 0 when out of memory */
+static int chunk_encode (const unsigned char *data, hsize_t k, hsize_t chunk, hsize_t count, size_t size,
+                         struct chunk_filters *f, unsigned char *out, size_t bound, struct raw_chunk *c)
+{
+  size_t bytes = (size_t) chunk * size, valid = (size_t) ((count - k*chunk < chunk ? count - k*chunk : chunk)), e, b;
+  const unsigned char *src = data + (size_t) (k*chunk) * size;
+  unsigned char *tmp;
+
+  if (f->index >= 0 && f->deflate < 0) /* straight into out */
+  {
+    c->size = index_encode ((const uint32_t*) src, valid, (size_t) chunk, out);
+    return 1;
+  }
+
+  if (f->index >= 0)
+  {
+    if (!(tmp = (unsigned char*)FCLIB_MALLOC (index_bound ((size_t) chunk)))) return 0;
+    bytes = index_encode ((const uint32_t*) src, valid, (size_t) chunk, tmp);
+  }
+  else
+  {
+    if (!(tmp = (unsigned char*)FCLIB_CALLOC (bytes, 1))) return 0;
+    if (f->shuffle >= 0)
+      for (e = 0; e < valid; e ++) /* byte b of element e goes to b*chunk + e */
+        for (b = 0; b < size; b ++) tmp [b*chunk + e] = src [e*size + b];
+    else memcpy (tmp, src, valid * size);
+  }
+  c->size = chunk_deflate (tmp, bytes, out, bound);
+  free (tmp);
+
+  return c->size > 0;
+}
+
+/* encode the chunks of a dataset created with the pipeline f, a batch at a time in parallel,
+ * and write them raw, each HDF5 call on its own */
+static void chunk_write (hid_t dataset_id, const char *name, hsize_t chunk, hsize_t count, size_t size,
+                         struct chunk_filters *f, const void *data)
+{
+  hsize_t nchunks = (count + chunk - 1) / chunk, k0;
+  size_t bound = chunk_bound (chunk, size, f);
+  struct raw_chunk *chunks;
+  unsigned char *raw;
+  long long k;
+  int failed = 0;
+
+  MM (chunks = (struct raw_chunk*)FCLIB_MALLOC (sizeof (struct raw_chunk) * FCLIB_CHUNK_BATCH));
+  error_keep (chunks, release_memory, 1);
+  MM (raw = (unsigned char*)FCLIB_MALLOC (bound * FCLIB_CHUNK_BATCH));
+  error_keep (raw, release_memory, 1);
+
+  for (k0 = 0; k0 < nchunks; k0 += FCLIB_CHUNK_BATCH)
+  {
+    long long n = (long long) (nchunks - k0 < FCLIB_CHUNK_BATCH ? nchunks - k0 : FCLIB_CHUNK_BATCH);
+
+#pragma omp parallel for schedule(dynamic) reduction(+:failed) if (n > 1)
+    for (k = 0; k < n; k ++)
+      failed += !chunk_encode ((const unsigned char*) data, k0 + (hsize_t) k, chunk, count, size, f, raw + k*bound, bound, &chunks [k]);
+    ASSERT (!failed, "ERROR: out of memory while compressing dataset %s", name);
+
+    for (k = 0; k < n; k ++)
+    {
+      hsize_t offset = (k0 + (hsize_t) k) * chunk;
+
+      IO (H5Dwrite_chunk (dataset_id, H5P_DEFAULT, 0, &offset, chunks [k].size, raw + k*bound));
+    }
+  }
+
+  error_drop (raw);
+  error_drop (chunks);
+  free (raw);
+  free (chunks);
+#ifdef FCLIB_WITH_STATS
+  stats_bytes (name, 1, (long long) count * (long long) size);
+#endif
+}
+#endif
+
+/* write the 1d dataset 'name' of loc_id from the 'count' elements of native type 'type' at data;
+ * with FCLIB_WRITE_INDEX_CODEC integers are chunked and index filtered, with FCLIB_WRITE_COMPRESS
+ * chunks are deflated, after the index filter or shuffled; datasets with several chunks are
+ * encoded in parallel */
+static void write_dataset (hid_t loc_id, const char *name, hid_t type, hsize_t count, const void *data, int flags)
+{
+  hsize_t chunk = (count < FCLIB_WRITE_CHUNK ? count : FCLIB_WRITE_CHUNK);
+  hid_t space_id, plist_id, dataset_id;
+  int index = ((flags & FCLIB_WRITE_INDEX_CODEC) && type == H5T_NATIVE_INT), compress = (flags & FCLIB_WRITE_COMPRESS);
+#ifdef FCLIB_DIRECT_CHUNKS
+  struct chunk_filters filters = {index ? -1 : 0, compress ? 1 : -1, index ? 0 : -1};
+#endif
+
+  if (!(index || compress) || count == 0)
+  {
+    if (type == H5T_NATIVE_INT) IO (FCLIB_H5LTMAKE_DATASET_INT (loc_id, name, 1, &count, (const int*) data));
+    else IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (loc_id, name, 1, &count, (const double*) data));
+    return;
+  }
+
+  if (index) index_register ();
+  IO (space_id = H5Screate_simple (1, &count, NULL));
+  IO (plist_id = H5Pcreate (H5P_DATASET_CREATE));
+  IO (H5Pset_chunk (plist_id, 1, &chunk));
+  if (index) IO (H5Pset_filter (plist_id, FCLIB_FILTER_INDEX, H5Z_FLAG_MANDATORY, 0, NULL));
+  else IO (H5Pset_shuffle (plist_id));
+  if (compress) IO (H5Pset_deflate (plist_id, FCLIB_DEFLATE_LEVEL));
+  IO (dataset_id = H5Dcreate (loc_id, name, type, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT));
+  IO (H5Pclose (plist_id));
+  IO (H5Sclose (space_id));
+
+#ifdef FCLIB_DIRECT_CHUNKS
+#ifdef FCLIB_WITH_ZLIB
+  if (count > chunk) chunk_write (dataset_id, name, chunk, count, H5 (H5Tget_size (type)), &filters, data);
+#else
+  if (count > chunk && !compress) chunk_write (dataset_id, name, chunk, count, H5 (H5Tget_size (type)), &filters, data);
+#endif
+  else
+#endif
+  IO (FCLIB_H5DWRITE (dataset_id, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data));
+  IO (H5Dclose (dataset_id));
+}
+
+/* read a whole dataset 'name' of loc_id into the room for 'capacity' elements of the native type
+ * 'type' at data, failing on a larger dataset; return the number of elements read; compressed or
+ * index filtered 1d datasets with several chunks are decoded in parallel, others go through H5Dread */
+static hsize_t read_dataset (hid_t loc_id, const char *name, hid_t type, hsize_t capacity, void *data)
+{
+  hid_t dataset_id, space_id;
+  hssize_t count;
+#ifdef FCLIB_DIRECT_CHUNKS
+  hid_t file_type;
+  hsize_t chunk, nchunks = 0;
+  size_t size = H5 (H5Tget_size (type));
+  struct chunk_filters filters;
+  int same, rank;
+#endif
+
+  index_register (); /* for H5Dread */
+  if ((dataset_id = H5 (H5Dopen (loc_id, name, H5P_DEFAULT))) < 0) /* named in the message */
+    FAIL (FCLIB_ERROR_HDF5, "ERROR: HDF5 call failed => H5Dopen (loc_id, \"%s\", H5P_DEFAULT)", name);
+
+  IO (space_id = H5Dget_space (dataset_id));
+  IO (count = H5Sget_simple_extent_npoints (space_id));
+#ifdef FCLIB_DIRECT_CHUNKS
+  IO (rank = (int) H5Sget_simple_extent_ndims (space_id));
+#endif
+  IO (H5Sclose (space_id));
+  ASSERT ((hsize_t) count <= capacity, "ERROR: dataset %s has %lld elements, room for %lld", name, (long long) count, (long long) capacity);
+
+#ifdef FCLIB_DIRECT_CHUNKS
+  IO (file_type = H5Dget_type (dataset_id));
+  IO (same = (int) H5Tequal (file_type, type));
+  IO (H5Tclose (file_type));
+
+  if (same && rank == 1 && count > 0 && (nchunks = chunk_pipeline (dataset_id, (hsize_t) count, &chunk, &filters)) > 1 &&
+      chunk_read (dataset_id, name, nchunks, chunk, (hsize_t) count, size, &filters, data))
+  {
+    IO (H5Dclose (dataset_id));
+    return (hsize_t) count;
+  }
+#endif
+
+  IO (FCLIB_H5DREAD (dataset_id, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data));
+  IO (H5Dclose (dataset_id));
+
+  return (hsize_t) count;
+}
+
+/* write matrix; flags are a combination of fclib_write_flags */
+static void write_matrix (hid_t id, struct fclib_matrix *mat, int flags)
+{
+  hsize_t dim = 1;
+
+  IO (FCLIB_H5LTMAKE_DATASET_INT (id, "nzmax", 1, &dim, &mat->nzmax));
+  IO (FCLIB_H5LTMAKE_DATASET_INT (id, "m", 1, &dim, &mat->m));
+  IO (FCLIB_H5LTMAKE_DATASET_INT (id, "n", 1, &dim, &mat->n));
+  IO (FCLIB_H5LTMAKE_DATASET_INT (id, "nz", 1, &dim, &mat->nz));
+
+  if (mat->nz >= 0) /* triplet */
+  {
+    dim = mat->nz;
+    write_dataset (id, "p", H5T_NATIVE_INT, dim, mat->p, flags);
+    write_dataset (id, "i", H5T_NATIVE_INT, dim, mat->i, flags);
+    write_dataset (id, "x", H5T_NATIVE_DOUBLE, dim, mat->x, flags);
+  }
+  else if (mat->nz == -1 || mat->nz == -4) /* csc or upper triangle in csc */
+  {
+    dim = mat->n+1;
+    write_dataset (id, "p", H5T_NATIVE_INT, dim, mat->p, flags);
+    dim = mat->nzmax;
+    write_dataset (id, "i", H5T_NATIVE_INT, dim, mat->i, flags);
+    write_dataset (id, "x", H5T_NATIVE_DOUBLE, dim, mat->x, flags);
+  }
+  else if (mat->nz == -2) /* csr */
+  {
+    dim = mat->m+1;
+    write_dataset (id, "p", H5T_NATIVE_INT, dim, mat->p, flags);
+    dim = mat->nzmax;
+    write_dataset (id, "i", H5T_NATIVE_INT, dim, mat->i, flags);
+    write_dataset (id, "x", H5T_NATIVE_DOUBLE, dim, mat->x, flags);
+  }
+  else if (mat->nz == -3) /* bsr */
+  {
+    ASSERT (mat->bs > 0 && mat->m % mat->bs == 0 && mat->n % mat->bs == 0, "ERROR: matrix dimensions are not divisible by the block size %d", mat->bs);
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id, "bs", 1, &dim, &mat->bs));
+    dim = mat->m/mat->bs+1;
+    write_dataset (id, "p", H5T_NATIVE_INT, dim, mat->p, flags);
+    dim = mat->nzmax/(mat->bs*mat->bs);
+    write_dataset (id, "i", H5T_NATIVE_INT, dim, mat->i, flags);
+    dim = mat->nzmax;
+    write_dataset (id, "x", H5T_NATIVE_DOUBLE, dim, mat->x, flags);
+  }
+  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", mat->nz);
+
+  if (mat->info)
+  {
+    dim = 1;
+    if (mat->info->comment) IO (FCLIB_H5LTMAKE_DATASET_STRING (id, "comment", mat->info->comment));
+    IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "conditioning", 1, &dim, &mat->info->conditioning));
+    IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "determinant", 1, &dim, &mat->info->determinant));
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id, "rank", 1, &dim, &mat->info->rank));
+  }
+}
+
+/* read matrix; with FCLIB_READ_VALIDATE its shape is checked before its arrays are allocated, and
+ * its structure and the extent of its datasets after they are read */
+static struct fclib_matrix* read_matrix (hid_t id, int flags)
+{
+  struct fclib_matrix *mat;
+  hsize_t np, ni, nx, nnz;
+  char reason [256];
+  int structure;
+
+  MM (mat = (struct fclib_matrix*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix)));
+  error_keep (mat, release_matrix, 1);
+
+  IO (FCLIB_H5LTREAD_DATASET_INT (id, "nzmax", &mat->nzmax));
+  IO (FCLIB_H5LTREAD_DATASET_INT (id, "m", &mat->m));
+  IO (FCLIB_H5LTREAD_DATASET_INT (id, "n", &mat->n));
+  IO (FCLIB_H5LTREAD_DATASET_INT (id, "nz", &mat->nz));
+  if (mat->nz == -3) IO (FCLIB_H5LTREAD_DATASET_INT (id, "bs", &mat->bs));
+  if ((flags & FCLIB_READ_VALIDATE) && !matrix_check_shape (mat, reason, sizeof (reason)))
+    FAIL (FCLIB_ERROR_INVALID, "ERROR: corrupt matrix => %s", reason);
+
+  if (mat->nz >= 0) /* triplet */
+  {
+    MM (mat->p = (int*)FCLIB_MALLOC (sizeof(int) * mat->nz));
+    MM (mat->i = (int*)FCLIB_MALLOC (sizeof(int) * mat->nz));
+    np = read_dataset (id, "p", H5T_NATIVE_INT, mat->nz, mat->p);
+    ni = read_dataset (id, "i", H5T_NATIVE_INT, mat->nz, mat->i);
+  }
+  else if (mat->nz == -1 || mat->nz == -4) /* csc or upper triangle in csc */
+  {
+    MM (mat->p = (int*)FCLIB_MALLOC (sizeof(int)*(mat->n+1)));
+    MM (mat->i = (int*)FCLIB_MALLOC (sizeof(int)*mat->nzmax));
+    np = read_dataset (id, "p", H5T_NATIVE_INT, mat->n+1, mat->p);
+    ni = read_dataset (id, "i", H5T_NATIVE_INT, mat->nzmax, mat->i);
+  }
+  else if (mat->nz == -2) /* csr */
+  {
+    MM (mat->p = (int*)FCLIB_MALLOC (sizeof(int)*(mat->m+1)));
+    MM (mat->i = (int*)FCLIB_MALLOC (sizeof(int)*mat->nzmax));
+    np = read_dataset (id, "p", H5T_NATIVE_INT, mat->m+1, mat->p);
+    ni = read_dataset (id, "i", H5T_NATIVE_INT, mat->nzmax, mat->i);
+  }
+  else if (mat->nz == -3) /* bsr */
+  {
+    ASSERT (mat->bs > 0 && mat->m % mat->bs == 0, "ERROR: matrix dimensions are not divisible by the block size %d", mat->bs);
+    MM (mat->p = (int*)FCLIB_MALLOC (sizeof(int)*(mat->m/mat->bs+1)));
+    MM (mat->i = (int*)FCLIB_MALLOC (sizeof(int)*(mat->nzmax/(mat->bs*mat->bs))));
+    np = read_dataset (id, "p", H5T_NATIVE_INT, mat->m/mat->bs+1, mat->p);
+    ni = read_dataset (id, "i", H5T_NATIVE_INT, mat->nzmax/(mat->bs*mat->bs), mat->i);
+  }
+  else ASSERT (0, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d\n", mat->nz);
+
+  MM (mat->x = (double*)FCLIB_MALLOC (sizeof(double)*mat->nzmax));
+  nx = read_dataset (id, "x", H5T_NATIVE_DOUBLE, mat->nzmax, mat->x);
+
+  if (flags & FCLIB_READ_VALIDATE) /* all pointers (or triplets), then the entries they point to */
+  {
+    int outer = (mat->nz == -1 || mat->nz == -4 ? mat->n : mat->m / (mat->nz == -3 ? mat->bs : 1));
+    hsize_t bs2 = (mat->nz == -3 ? (hsize_t) mat->bs * mat->bs : 1);
+
+    ASSERT (mat->nz >= 0 ? np >= (hsize_t) mat->nz && ni >= (hsize_t) mat->nz : np == (hsize_t) outer + 1,
+            "ERROR: corrupt matrix => %lld pointers or columns and %lld indices stored", (long long) np, (long long) ni);
+    if (!matrix_validate (mat, &structure, reason, sizeof (reason))) FAIL (FCLIB_ERROR_INVALID, "ERROR: corrupt matrix => %s", reason);
+    nnz = (hsize_t) (mat->nz >= 0 ? mat->nz : mat->p [outer]);
+    ASSERT ((mat->nz >= 0 || ni >= nnz) && nx >= nnz * bs2, "ERROR: corrupt matrix => %lld entries, %lld indices and %lld values stored",
+            (long long) nnz, (long long) ni, (long long) nx);
+  }
+
+  if (H5 (H5LTfind_dataset (id, "conditioning")))
+  {
+    H5T_class_t class_id;
+    hsize_t dim;
+    size_t size;
+
+    MM (mat->info = (struct fclib_matrix_info*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix_info)));
+    if (H5 (H5LTfind_dataset (id, "comment")))
+    {
+      IO (H5LTget_dataset_info  (id, "comment", &dim, &class_id, &size));
+      MM (mat->info->comment = (char*)FCLIB_MALLOC (sizeof(char)*size));
+      IO (FCLIB_H5LTREAD_DATASET_STRING (id, "comment", mat->info->comment));
+    }
+    else mat->info->comment = NULL;
+    IO (FCLIB_H5LTREAD_DATASET_DOUBLE (id, "conditioning", &mat->info->conditioning));
+    IO (FCLIB_H5LTREAD_DATASET_DOUBLE (id, "determinant", &mat->info->determinant));
+    IO (FCLIB_H5LTREAD_DATASET_INT (id, "rank", &mat->info->rank));
+  }
+  else
+  {
+    mat->info = NULL;
+  }
+
+  if (mat->nz == -4 && (flags & FCLIB_READ_EXPAND_SYMMETRIC))
+  {
+    struct fclib_matrix *csr = matrix_csr (mat);
+    error_drop (mat);
+    delete_matrix (mat);
+    error_keep (csr, release_matrix, 1);
+    mat = matrix_from_csr (csr, -1);
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  else error_drop (mat);
+
+  return mat;
+}
+
+/* write global vectors */
+static void write_global_vectors (hid_t id, struct fclib_global *problem, int flags)
+{
+  hsize_t dim;
+
+  dim = (hsize_t)problem->M->m;
+  ASSERT (problem->f, "ERROR: f must be given");
+  write_dataset (id, "f", H5T_NATIVE_DOUBLE, dim, problem->f, flags);
+
+  dim = (hsize_t)problem->H->n;
+  ASSERT (problem->w && problem->mu, "ERROR: w and mu must be given");
+  write_dataset (id, "w", H5T_NATIVE_DOUBLE, dim, problem->w, flags);
+  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
+  dim /= (hsize_t)problem->spacedim;
+  write_dataset (id, "mu", H5T_NATIVE_DOUBLE, dim, problem->mu, flags);
+
+  if (problem->G)
+  {
+    dim = (hsize_t)problem->G->n;
+    ASSERT (problem->b, "ERROR: b must be given if G is present");
+    write_dataset (id, "b", H5T_NATIVE_DOUBLE, dim, problem->b, flags);
+  }
+}
+
+/* read global vectors */
+static void read_global_vectors (hid_t id, struct fclib_global *problem)
+{
+  MM (problem->f = (double*)FCLIB_MALLOC (sizeof(double)*problem->M->m));
+  read_dataset (id, "f", H5T_NATIVE_DOUBLE, problem->M->m, problem->f);
+
+  ASSERT (problem->H->n % problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
+  MM (problem->w = (double*)FCLIB_MALLOC (sizeof(double)*problem->H->n));
+  MM (problem->mu = (double*)FCLIB_MALLOC (sizeof(double)*(problem->H->n / problem->spacedim)));
+  read_dataset (id, "w", H5T_NATIVE_DOUBLE, problem->H->n, problem->w);
+  read_dataset (id, "mu", H5T_NATIVE_DOUBLE, problem->H->n / problem->spacedim, problem->mu);
+
+  if (problem->G)
+  {
+    MM (problem->b = (double*)FCLIB_MALLOC (sizeof(double)*problem->G->n));
+    read_dataset (id, "b", H5T_NATIVE_DOUBLE, problem->G->n, problem->b);
+  }
+}
+/* write global vectors */
+static void write_global_rolling_vectors (hid_t id, struct fclib_global_rolling *problem, int flags)
+{
+  hsize_t dim;
+
+  dim = (hsize_t)problem->M->m;
+  ASSERT (problem->f, "ERROR: f must be given");
+  write_dataset (id, "f", H5T_NATIVE_DOUBLE, dim, problem->f, flags);
+
+  dim = (hsize_t)problem->H->n;
+  ASSERT (problem->w && problem->mu, "ERROR: w and mu must be given");
+  write_dataset (id, "w", H5T_NATIVE_DOUBLE, dim, problem->w, flags);
+  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
+  dim /= (hsize_t)problem->spacedim;
+  write_dataset (id, "mu", H5T_NATIVE_DOUBLE, dim, problem->mu, flags);
+  write_dataset (id, "mu_r", H5T_NATIVE_DOUBLE, dim, problem->mu_r, flags);
+
+  if (problem->G)
+  {
+    dim = (hsize_t)problem->G->n;
+    ASSERT (problem->b, "ERROR: b must be given if G is present");
+    write_dataset (id, "b", H5T_NATIVE_DOUBLE, dim, problem->b, flags);
+  }
+}
+
+/* read global vectors */
+static void read_global_rolling_vectors (hid_t id, struct fclib_global_rolling *problem)
+{
+  MM (problem->f = (double*)FCLIB_MALLOC (sizeof(double)*problem->M->m));
+  read_dataset (id, "f", H5T_NATIVE_DOUBLE, problem->M->m, problem->f);
+
+  ASSERT (problem->H->n % problem->spacedim == 0, "ERROR: number of H columns is not divisble by the spatial dimension");
+  MM (problem->w = (double*)FCLIB_MALLOC (sizeof(double)*problem->H->n));
+  MM (problem->mu = (double*)FCLIB_MALLOC (sizeof(double)*(problem->H->n / problem->spacedim)));
+  MM (problem->mu_r = (double*)FCLIB_MALLOC (sizeof(double)*(problem->H->n / problem->spacedim)));
+  read_dataset (id, "w", H5T_NATIVE_DOUBLE, problem->H->n, problem->w);
+  read_dataset (id, "mu", H5T_NATIVE_DOUBLE, problem->H->n / problem->spacedim, problem->mu);
+  read_dataset (id, "mu_r", H5T_NATIVE_DOUBLE, problem->H->n / problem->spacedim, problem->mu_r);
+
+  if (problem->G)
+  {
+    MM (problem->b = (double*)FCLIB_MALLOC (sizeof(double)*problem->G->n));
+    read_dataset (id, "b", H5T_NATIVE_DOUBLE, problem->G->n, problem->b);
+  }
+}
+/* write local vectors */
+static void write_local_vectors (hid_t id, struct fclib_local *problem, int flags)
+{
+  hsize_t dim;
+
+  dim = (hsize_t)problem->W->m;
+  ASSERT (problem->q, "ERROR: q must be given");
+  write_dataset (id, "q", H5T_NATIVE_DOUBLE, dim, problem->q, flags);
+
+  ASSERT (dim % (hsize_t)problem->spacedim == 0, "ERROR: number of W rows is not divisble by the spatial dimension");
+  dim /= (hsize_t)problem->spacedim;
+  write_dataset (id, "mu", H5T_NATIVE_DOUBLE, dim, problem->mu, flags);
+
+  if (problem->V)
+  {
+    dim = (hsize_t)problem->R->m;
+    ASSERT (problem->s, "ERROR: s must be given if R is present");
+    write_dataset (id, "s", H5T_NATIVE_DOUBLE, dim, problem->s, flags);
+  }
+}
+
+/* read local vectors */
+static void read_local_vectors (hid_t id, struct fclib_local *problem)
+{
+  MM (problem->q = (double*)FCLIB_MALLOC (sizeof(double)*problem->W->m));
+  read_dataset (id, "q", H5T_NATIVE_DOUBLE, problem->W->m, problem->q);
+
+  ASSERT (problem->W->m % problem->spacedim == 0, "ERROR: number of W rows is not divisble by the spatial dimension");
+  MM (problem->mu = (double*)FCLIB_MALLOC (sizeof(double)*(problem->W->m / problem->spacedim)));
+  read_dataset (id, "mu", H5T_NATIVE_DOUBLE, problem->W->m / problem->spacedim, problem->mu);
+
+  if (problem->R)
+  {
+    MM (problem->s = (double*)FCLIB_MALLOC (sizeof(double)*problem->R->m));
+    read_dataset (id, "s", H5T_NATIVE_DOUBLE, problem->R->m, problem->s);
+  }
+}
+
+/* write problem info */
+static void write_problem_info (hid_t id, struct fclib_info *info)
+{
+  if (info->title) IO (FCLIB_H5LTMAKE_DATASET_STRING (id, "title", info->title));
+  if (info->description) IO (FCLIB_H5LTMAKE_DATASET_STRING (id, "description", info->description));
+  if (info->math_info) IO (FCLIB_H5LTMAKE_DATASET_STRING (id, "math_info", info->math_info));
+}
+
+/* write problem statistics as attributes of the "stats" group of a problem, replacing those stored before */
+static void write_problem_stats (hid_t main_id, struct fclib_problem_stats *stats)
+{
+  hid_t id;
+
+  if (H5 (H5Lexists (main_id, "stats", H5P_DEFAULT))) IO (id = H5Gopen (main_id, "stats", H5P_DEFAULT));
+  else IO (id = H5Gmake (main_id, "stats"));
+
+#define STATS_INT(Field, Size) IO (H5LTset_attribute_int (id, ".", #Field, (const int*) &stats->Field, Size))
+#define STATS_DOUBLE(Field) IO (H5LTset_attribute_double (id, ".", #Field, &stats->Field, 1))
+  STATS_INT (global, 1);
+  STATS_INT (rows, 1);
+  STATS_INT (cols, 1);
+  STATS_INT (nnz, 1);
+  STATS_INT (row_min, 1);
+  STATS_INT (row_max, 1);
+  STATS_DOUBLE (row_mean);
+  STATS_INT (row_histogram, FCLIB_PROBLEM_STATS_BINS);
+  STATS_INT (bandwidth, 1);
+  STATS_INT (blocks, 1);
+  STATS_DOUBLE (block_fill);
+  STATS_INT (contacts, 1);
+  STATS_INT (edges, 1);
+  STATS_INT (degree_min, 1);
+  STATS_INT (degree_max, 1);
+  STATS_DOUBLE (degree_mean);
+  STATS_INT (degree_histogram, FCLIB_PROBLEM_STATS_BINS);
+  STATS_INT (components, 1);
+  STATS_INT (largest_component, 1);
+  STATS_DOUBLE (frictionless);
+#undef STATS_INT
+#undef STATS_DOUBLE
+
+  IO (H5Gclose (id));
+}
+
+/* read problem statistics from the attributes of a "stats" group */
+static void read_problem_stats (hid_t id, struct fclib_problem_stats *stats)
+{
+#define STATS_INT(Field) IO (H5LTget_attribute_int (id, ".", #Field, (int*) &stats->Field))
+#define STATS_DOUBLE(Field) IO (H5LTget_attribute_double (id, ".", #Field, &stats->Field))
+  STATS_INT (global);
+  STATS_INT (rows);
+  STATS_INT (cols);
+  STATS_INT (nnz);
+  STATS_INT (row_min);
+  STATS_INT (row_max);
+  STATS_DOUBLE (row_mean);
+  STATS_INT (row_histogram);
+  STATS_INT (bandwidth);
+  STATS_INT (blocks);
+  STATS_DOUBLE (block_fill);
+  STATS_INT (contacts);
+  STATS_INT (edges);
+  STATS_INT (degree_min);
+  STATS_INT (degree_max);
+  STATS_DOUBLE (degree_mean);
+  STATS_INT (degree_histogram);
+  STATS_INT (components);
+  STATS_INT (largest_component);
+  STATS_DOUBLE (frictionless);
+#undef STATS_INT
+#undef STATS_DOUBLE
+}
+
+/* read problem info */
+static struct fclib_info* read_problem_info (hid_t id)
+{
+  struct fclib_info *info;
+  H5T_class_t class_id;
+  hsize_t dim;
+  size_t size;
+
+  MM (info = (struct fclib_info*)FCLIB_CALLOC (1, sizeof (struct fclib_info)));
+  error_keep (info, release_info, 1);
+
+  if (H5 (H5LTfind_dataset (id, "title")))
+  {
+    IO (H5LTget_dataset_info  (id, "title", &dim, &class_id, &size));
+    MM (info->title = (char*)FCLIB_MALLOC (sizeof(char)*size));
+    IO (FCLIB_H5LTREAD_DATASET_STRING (id, "title", info->title));
+  }
+  else info->title = NULL;
+
+  if (H5 (H5LTfind_dataset (id, "description")))
+  {
+    IO (H5LTget_dataset_info  (id, "description", &dim, &class_id, &size));
+    MM (info->description = (char*)FCLIB_MALLOC (sizeof(char)*size));
+    IO (FCLIB_H5LTREAD_DATASET_STRING (id, "description", info->description));
+  }
+  else info->description = NULL;
+
+  if (H5 (H5LTfind_dataset (id, "math_info")))
+  {
+    IO (H5LTget_dataset_info  (id, "math_info", &dim, &class_id, &size));
+    MM (info->math_info = (char*)FCLIB_MALLOC (sizeof(char)*size));
+    IO (FCLIB_H5LTREAD_DATASET_STRING (id, "math_info", info->math_info));
+  }
+  else info->math_info = NULL;
+
+  error_drop (info);
+  return info;
+}
+
+/* fail unless every one of the 'count' solutions has every vector of the problem */
+static void check_solution_vectors (int count, struct fclib_solution *solutions, int nv, int nr, int nl)
+{
+  int k;
+
+  ASSERT (nr, "ERROR: contact constraints must be present");
+  for (k = 0; k < count; k ++)
+  {
+    ASSERT (!nv || solutions [k].v, "ERROR: vector v of solution %d must be given", k);
+    ASSERT (!nl || solutions [k].l, "ERROR: vector l of solution %d must be given", k);
+    ASSERT (solutions [k].u && solutions [k].r, "ERROR: vectors u and r of solution %d must be given", k);
+  }
+}
+
+/* write solution */
+static void write_solution (hid_t id, struct fclib_solution *solution, int nv, int nr, int nl)
+{
+  hsize_t nv_t = (hsize_t)nv;
+  hsize_t nl_t = (hsize_t)nl;
+  hsize_t nr_t = (hsize_t)nr;
+  if (nv) IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "v", 1, &nv_t, solution->v));
+  if (nl) IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "l", 1, &nl_t, solution->l));
+
+  ASSERT (nr, "ERROR: contact constraints must be present");
+  IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "u", 1, &nr_t, solution->u));
+  IO (FCLIB_H5LTMAKE_DATASET_DOUBLE (id, "r", 1, &nr_t, solution->r));
+}
+
+/* read solution */
+static void read_solution (hid_t id, int nv, int nr, int nl, struct fclib_solution *solution)
+{
+  if (nv)
+  {
+    MM (solution->v = (double*)FCLIB_MALLOC (sizeof(double)*nv));
+    read_dataset (id, "v", H5T_NATIVE_DOUBLE, nv, solution->v);
+  }
+  else solution->v = NULL;
+
+  if (nl)
+  {
+    MM (solution->l = (double*)FCLIB_MALLOC (sizeof(double)*nl));
+    read_dataset (id, "l", H5T_NATIVE_DOUBLE, nl, solution->l);
+  }
+  else solution->l = NULL;
+
+  ASSERT (nr, "ERROR: contact constraints must be present");
+  MM (solution->u = (double*)FCLIB_MALLOC (sizeof(double)*nr));
+  read_dataset (id, "u", H5T_NATIVE_DOUBLE, nr, solution->u);
+  MM (solution->r = (double*)FCLIB_MALLOC (sizeof(double)*nr));
+  read_dataset (id, "r", H5T_NATIVE_DOUBLE, nr, solution->r);
+}
+
+/* number of elements of a stored dataset */
+static int stored_size (hid_t id, const char *name)
+{
+  hid_t dataset_id, space_id;
+  hssize_t size;
+
+  IO (dataset_id = H5Dopen (id, name, H5P_DEFAULT));
+  IO (space_id = H5Dget_space (dataset_id));
+  IO (size = H5Sget_simple_extent_npoints (space_id));
+  IO (H5Sclose (space_id));
+  IO (H5Dclose (dataset_id));
+  ASSERT (size <= INT_MAX, "ERROR: dataset %s has %lld elements", name, (long long)size);
+
+  return (int)size;
+}
+
+/* fail unless the stored vector 'name' exists with size n */
+static void check_stored_vector (hid_t id, const char *name, int n)
+{
+  int size;
+
+  ASSERT (H5 (H5Lexists (id, name, H5P_DEFAULT)), "ERROR: stored vector %s is missing (corrupted file)", name);
+  size = stored_size (id, name);
+  ASSERT (size == n, "ERROR: size of %s differs from the stored one: %d != %d", name, n, size);
+}
+
+/* overwrite a stored vector in place, its size having been checked */
+static void overwrite_vector (hid_t id, const char *name, double *x)
+{
+  hid_t dataset_id;
+
+  IO (dataset_id = H5Dopen (id, name, H5P_DEFAULT));
+  IO (FCLIB_H5DWRITE (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, x));
+  IO (H5Dclose (dataset_id));
+}
+
+/* overwrite solution in place; fail before writing anything if a vector is missing or a stored size differs */
+static void overwrite_solution (hid_t id, struct fclib_solution *solution, int nv, int nr, int nl)
+{
+  check_solution_vectors (1, solution, nv, nr, nl);
+
+  if (nv) check_stored_vector (id, "v", nv);
+  if (nl) check_stored_vector (id, "l", nl);
+  check_stored_vector (id, "u", nr);
+  check_stored_vector (id, "r", nr);
+
+  if (nv) overwrite_vector (id, "v", solution->v);
+  if (nl) overwrite_vector (id, "l", solution->l);
+  overwrite_vector (id, "u", solution->u);
+  overwrite_vector (id, "r", solution->r);
+}
+
+/* maximal number of doubles in one row of a chunk of a guesses dataset */
+#define FCLIB_GUESS_CHUNK (1 << 20)
+
+/* bytes aimed at by the chunks of a guesses dataset: rows of small vectors are grouped */
+#define FCLIB_GUESS_CHUNK_BYTES (1 << 15)
+
+/* vector 'name' of a solution */
+static double** solution_vector (struct fclib_solution *solution, const char *name)
+{
+  switch (name [0])
+  {
+  case 'v': return &solution->v;
+  case 'u': return &solution->u;
+  case 'r': return &solution->r;
+  default: return &solution->l;
+  }
+}
+
+/* fail unless the [rows x n] dataset 'name' holds exactly 'stored' rows, or is missing while none are */
+static void check_guess_rows (hid_t id, const char *name, int n, int stored)
+{
+  hid_t dataset_id, space_id;
+  hsize_t dims [2];
+
+  if (!H5 (H5Lexists (id, name, H5P_DEFAULT)))
+  {
+    ASSERT (stored == 0, "ERROR: guesses dataset %s is missing while %d guesses are stored (corrupted file)", name, stored);
+    return;
+  }
+
+  IO (dataset_id = H5Dopen (id, name, H5P_DEFAULT));
+  IO (space_id = H5Dget_space (dataset_id));
+  ASSERT (H5 (H5Sget_simple_extent_ndims (space_id)) == 2, "ERROR: guesses dataset %s is not two-dimensional", name);
+  IO (H5Sget_simple_extent_dims (space_id, dims, NULL));
+  IO (H5Sclose (space_id));
+  IO (H5Dclose (dataset_id));
+  ASSERT (dims [0] == (hsize_t)stored && dims [1] == (hsize_t)n,
+          "ERROR: guesses dataset %s has %llu rows of %llu, %d rows of %d expected (corrupted file)", name,
+          (unsigned long long)dims [0], (unsigned long long)dims [1], stored, n);
+}
+
+/* write 'count' rows of length n at row 'stored' of the [rows x n] dataset 'name' with a single write
+ * of the whole block; the dataset has been checked by check_guess_rows and is created when missing,
+ * with chunks of about FCLIB_GUESS_CHUNK_BYTES */
+static void append_guess_rows (hid_t id, const char *name, int n, int stored, int count, struct fclib_solution *guesses)
+{
+  hid_t dataset_id, filespace_id, memspace_id, plist_id;
+  hsize_t dims [2] = {(hsize_t)stored + (hsize_t)count, (hsize_t)n};
+  hsize_t start [2] = {(hsize_t)stored, 0}, block [2] = {(hsize_t)count, (hsize_t)n};
+  double *x;
+  int k;
+
+  if (H5 (H5Lexists (id, name, H5P_DEFAULT)))
+  {
+    IO (dataset_id = H5Dopen (id, name, H5P_DEFAULT));
+  }
+  else
+  {
+    size_t rows = FCLIB_GUESS_CHUNK_BYTES / (sizeof(double)*(size_t)n);
+    hsize_t empty [2] = {0, (hsize_t)n}, maxdims [2] = {H5S_UNLIMITED, (hsize_t)n};
+    hsize_t chunk [2] = {(hsize_t)(rows > 0 ? rows : 1), (hsize_t)(n < FCLIB_GUESS_CHUNK ? n : FCLIB_GUESS_CHUNK)};
+
+    IO (filespace_id = H5Screate_simple (2, empty, maxdims));
+    IO (plist_id = H5Pcreate (H5P_DATASET_CREATE));
+    IO (H5Pset_chunk (plist_id, 2, chunk));
+    IO (dataset_id = H5Dcreate (id, name, H5T_NATIVE_DOUBLE, filespace_id, H5P_DEFAULT, plist_id, H5P_DEFAULT));
+    IO (H5Pclose (plist_id));
+    IO (H5Sclose (filespace_id));
+  }
+
+  MM (x = (double*)FCLIB_MALLOC (sizeof(double)*(size_t)count*(size_t)n));
+  error_keep (x, release_memory, 1);
+  for (k = 0; k < count; k ++) memcpy (x + (size_t)k*n, *solution_vector (&guesses [k], name), sizeof(double)*n);
+
+  IO (H5Dset_extent (dataset_id, dims));
+  IO (filespace_id = H5Dget_space (dataset_id));
+  IO (H5Sselect_hyperslab (filespace_id, H5S_SELECT_SET, start, NULL, block, NULL));
+  IO (memspace_id = H5Screate_simple (2, block, NULL));
+  IO (FCLIB_H5DWRITE (dataset_id, H5T_NATIVE_DOUBLE, memspace_id, filespace_id, H5P_DEFAULT, x));
+
+  IO (H5Sclose (memspace_id));
+  IO (H5Sclose (filespace_id));
+  IO (H5Dclose (dataset_id));
+  error_drop (x);
+  free (x);
+}
+
+/* read rows 'first' to 'first + count - 1' of the [rows x n] dataset 'name' into vector 'name'
+ * of the guesses, opening the dataset once and reading the whole block in one call */
+static void read_guess_rows (hid_t id, const char *name, int n, int first, int count, struct fclib_solution *guesses)
+{
+  hid_t dataset_id, filespace_id, memspace_id;
+  hsize_t start [2] = {(hsize_t)first, 0}, block [2] = {(hsize_t)count, (hsize_t)n}, dims [2];
+  double *x;
+  int k;
+
+  IO (dataset_id = H5Dopen (id, name, H5P_DEFAULT));
+  IO (filespace_id = H5Dget_space (dataset_id));
+  ASSERT (H5 (H5Sget_simple_extent_ndims (filespace_id)) == 2, "ERROR: guesses dataset %s is not two-dimensional", name);
+  IO (H5Sget_simple_extent_dims (filespace_id, dims, NULL));
+  ASSERT (dims [1] == (hsize_t)n && dims [0] >= (hsize_t)first + (hsize_t)count,
+          "ERROR: guesses dataset %s has %llu rows of %llu, %d rows of %d expected", name,
+          (unsigned long long)dims [0], (unsigned long long)dims [1], first + count, n);
+
+  MM (x = (double*)FCLIB_MALLOC (sizeof(double)*(size_t)count*(size_t)n));
+  error_keep (x, release_memory, 1);
+  IO (H5Sselect_hyperslab (filespace_id, H5S_SELECT_SET, start, NULL, block, NULL));
+  IO (memspace_id = H5Screate_simple (2, block, NULL));
+  IO (FCLIB_H5DREAD (dataset_id, H5T_NATIVE_DOUBLE, memspace_id, filespace_id, H5P_DEFAULT, x));
+  IO (H5Sclose (memspace_id));
+  IO (H5Sclose (filespace_id));
+  IO (H5Dclose (dataset_id));
+
+  for (k = 0; k < count; k ++)
+  {
+    double **v = solution_vector (&guesses [k], name);
+    MM (*v = (double*)FCLIB_MALLOC (sizeof(double)*n));
+    memcpy (*v, x + (size_t)k*n, sizeof(double)*n);
+  }
+
+  error_drop (x);
+  free (x);
+}
+
+/* read 'count' guesses stored from row 'first' on in the compact layout, into zeroed solutions */
+static void read_guesses (hid_t id, int nv, int nr, int nl, int first, int count, struct fclib_solution *guesses)
+{
+  if (count == 0) return;
+
+  if (nv) read_guess_rows (id, "v", nv, first, count, guesses);
+  if (nl) read_guess_rows (id, "l", nl, first, count, guesses);
+
+  ASSERT (nr, "ERROR: contact constraints must be present");
+  read_guess_rows (id, "u", nr, first, count, guesses);
+  read_guess_rows (id, "r", nr, first, count, guesses);
+}
+
+/* write guesses in the compact layout (or as new groups in the per-guess group layout of older files);
+ * main_id is the /guesses group, 'stored' the number of guesses already in it */
+static void append_guesses (hid_t main_id, int stored, int count, struct fclib_solution *guesses, int nv, int nr, int nl)
+{
+  hid_t id;
+  hsize_t dim = 1;
+  int total = stored + count;
+
+  /* check everything before writing anything, so that a failure leaves the file as it was */
+  check_solution_vectors (count, guesses, nv, nr, nl);
+
+  if (stored && !H5 (H5Lexists (main_id, "r", H5P_DEFAULT))) /* per-guess group layout */
+  {
+    char num [128];
+    int i;
+
+    for (i = 0; i < stored; i ++)
+    {
+      snprintf (num, 128, "%d", i+1);
+      ASSERT (H5 (H5Lexists (main_id, num, H5P_DEFAULT)), "ERROR: guess %s is missing (corrupted file)", num);
+    }
+    for (i = 0; i < count; i ++)
+    {
+      snprintf (num, 128, "%d", stored+i+1);
+      ASSERT (!H5 (H5Lexists (main_id, num, H5P_DEFAULT)), "ERROR: guess %s is stored already (corrupted file)", num);
+    }
+
+    for (i = 0; i < count; i ++)
+    {
+      snprintf (num, 128, "%d", stored+i+1);
+      IO (id = H5Gmake (main_id, num));
+      write_solution (id, &guesses [i], nv, nr, nl);
+      IO (H5Gclose (id));
+    }
+  }
+  else
+  {
+    if (nv) check_guess_rows (main_id, "v", nv, stored);
+    if (nl) check_guess_rows (main_id, "l", nl, stored);
+    check_guess_rows (main_id, "u", nr, stored);
+    check_guess_rows (main_id, "r", nr, stored);
+
+    if (count > 0)
+    {
+      if (nv) append_guess_rows (main_id, "v", nv, stored, count, guesses);
+      if (nl) append_guess_rows (main_id, "l", nl, stored, count, guesses);
+      append_guess_rows (main_id, "u", nr, stored, count, guesses);
+      append_guess_rows (main_id, "r", nr, stored, count, guesses);
+    }
+  }
+
+  if (H5 (H5Lexists (main_id, "number_of_guesses", H5P_DEFAULT)))
+  {
+    IO (id = H5Dopen (main_id, "number_of_guesses", H5P_DEFAULT));
+    IO (FCLIB_H5DWRITE (id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, &total));
+    IO (H5Dclose (id));
+  }
+  else IO (FCLIB_H5LTMAKE_DATASET_INT (main_id, "number_of_guesses", 1, &dim, &total));
+}
+
+/* read solution sizes */
+static void read_nvnunrnl (hid_t file_id, int *nv, int *nr, int *nl)
+{
+  if (H5 (H5Lexists (file_id, "/fclib_global", H5P_DEFAULT)))
+  {
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global/M/n", nv));
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global/H/n", nr));
+    if (H5 (H5Lexists (file_id, "/fclib_global/G", H5P_DEFAULT)))
+    {
+      IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global/G/n", nl));
+    }
+    else *nl = 0;
+  }
+  else if (H5 (H5Lexists (file_id, "/fclib_local", H5P_DEFAULT)))
+  {
+    *nv = 0;
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_local/W/n", nr));
+    if (H5 (H5Lexists (file_id, "/fclib_local/R", H5P_DEFAULT)))
+    {
+      IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_local/R/n", nl));
+    }
+    else *nl = 0;
+  }
+  else if (H5 (H5Lexists (file_id, "/fclib_global_rolling", H5P_DEFAULT)))
+  {
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global_rolling/M/n", nv));
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global_rolling/H/n", nr));
+    if (H5 (H5Lexists (file_id, "/fclib_global_rolling/G", H5P_DEFAULT)))
+    {
+      IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global_rolling/G/n", nl));
+    }
+    else *nl = 0;
+  }
+  else FAIL (FCLIB_ERROR_INVALID, "ERROR: neither global nor local problem has been stored. Global or local have to be stored before solutions or guesses");
+}
+
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_create_int_attributes_in_info(const char *path, const char * attr_name,
+                                        int attr_value)
+{
+  struct error_context ctx;
+  hid_t  file_id, id, dataspace_id, attr_id;
+  hsize_t     dims[1];
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+
+  if (H5 (H5Lexists (file_id, "/fclib_local/info", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_local/info", H5P_DEFAULT));
+  }
+  else IO (id = H5Gmake (file_id, "/fclib_local/info"));
+
+  dims[0]=1;
+  IO (dataspace_id = H5Screate_simple(1, dims, NULL));
+  IO (attr_id = H5Acreate (id, attr_name, H5T_NATIVE_INT, dataspace_id,
+                           H5P_DEFAULT, H5P_DEFAULT));
+  IO (H5Sclose (dataspace_id));
+  IO(H5Awrite(attr_id, H5T_NATIVE_INT , &attr_value ));
+  IO(H5Aclose (attr_id));
+  IO (H5Gclose (id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* write problem statistics into the file of the problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_problem_stats (const char *path, struct fclib_problem_stats *stats)
+{
+  struct error_context ctx;
+  const char *group = (stats->global ? "/fclib_global" : "/fclib_local");
+  hid_t  file_id, main_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  ASSERT (H5 (H5Lexists (file_id, group, H5P_DEFAULT)), "ERROR: no %s problem has been stored in %s",
+          stats->global ? "global" : "local", path);
+  IO (main_id = H5Gopen (file_id, group, H5P_DEFAULT));
+  write_problem_stats (main_id, stats);
+  IO (H5Gclose (main_id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* read problem statistics stored in a file;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_read_problem_stats (const char *path, int global, struct fclib_problem_stats *stats)
+{
+  struct error_context ctx;
+  const char *group = (global ? "/fclib_global/stats" : "/fclib_local/stats");
+  hid_t  file_id, id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_READ);
+  ASSERT (H5 (H5Lexists (file_id, global ? "/fclib_global" : "/fclib_local", H5P_DEFAULT)) &&
+          H5 (H5Lexists (file_id, group, H5P_DEFAULT)), "ERROR: no statistics of a %s problem have been stored in %s",
+          global ? "global" : "local", path);
+  IO (id = H5Gopen (file_id, group, H5P_DEFAULT));
+  read_problem_stats (id, stats);
+  IO (H5Gclose (id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* =========================== interface ============================ */
+
+/* last error */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_last_error (const char **message)
+{
+  if (message) *message = (error_code ? error_message : "");
+
+  return error_code;
+}
+
+/* reset the last error */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_clear_error (void)
+{
+  error_code = FCLIB_ERROR_NONE;
+  error_message [0] = '\0';
+}
+
+/* write global problem into an open file */
+static void write_global_file (hid_t file_id, struct fclib_global *problem, int flags)
+{
+  hid_t  main_id, id;
+  hsize_t dim = 1;
+
+  ASSERT (!H5 (H5Lexists (file_id, "/fclib_global", H5P_DEFAULT)), "ERROR: a global problem has already been written to this file"); /* cannot overwrite existing datasets */
+
+  IO (main_id = H5Gmake (file_id, "/fclib_global"));
+
+  ASSERT (problem->spacedim == 2 || problem->spacedim == 3, "ERROR: space dimension must be 2 or 3");
+  IO (FCLIB_H5LTMAKE_DATASET_INT (file_id, "/fclib_global/spacedim", 1, &dim, &problem->spacedim));
+
+  ASSERT (problem->M, "ERROR: M must be given");
+  IO (id = H5Gmake (file_id, "/fclib_global/M"));
+  write_matrix (id, problem->M, flags);
+  IO (H5Gclose (id));
+
+  ASSERT (problem->H, "ERROR: H must be given");
+  IO (id = H5Gmake (file_id, "/fclib_global/H"));
+  write_matrix (id, problem->H, flags);
+  IO (H5Gclose (id));
+
+  if (problem->G)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_global/G"));
+    write_matrix (id, problem->G, flags);
+    IO (H5Gclose (id));
+  }
+
+  IO (id = H5Gmake (file_id, "/fclib_global/vectors"));
+  write_global_vectors (id, problem, flags);
+  IO (H5Gclose (id));
+
+  if (problem->info)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_global/info"));
+    write_problem_info (id, problem->info);
+    IO (H5Gclose (id));
+  }
+
+  if (flags & FCLIB_WRITE_STATS)
+  {
+    struct fclib_problem_stats stats;
+
+    ASSERT (fclib_global_problem_stats (problem, &stats), "ERROR: computing the problem statistics failed");
+    write_problem_stats (main_id, &stats);
+  }
+
+  IO (H5Gclose (main_id));
+}
+
+/* write global problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global (struct fclib_global *problem, const char *path)
+{
+  return fclib_write_global_with_flags (problem, path, 0);
+}
+
+/* write global problem with flags;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_with_flags (struct fclib_global *problem, const char *path, int flags)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_CREATE);
+  write_global_file (file_id, problem, flags);
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* write global problem into a file image;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_to_buffer (struct fclib_global *problem, void **buffer, size_t *size)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = image_create ();
+  write_global_file (file_id, problem, 0);
+  image_close (file_id, buffer, size);
+
+  error_leave ();
+  return 1;
+}
+
+/* write global rolling problem into an open file */
+static void write_global_rolling_file (hid_t file_id, struct fclib_global_rolling *problem, int flags)
+{
+  hid_t  main_id, id;
+  hsize_t dim = 1;
+
+  ASSERT (!H5 (H5Lexists (file_id, "/fclib_global_rolling", H5P_DEFAULT)), "ERROR: a global problem has already been written to this file"); /* cannot overwrite existing datasets */
+
+  IO (main_id = H5Gmake (file_id, "/fclib_global_rolling"));
+
+  ASSERT (problem->spacedim == 3 || problem->spacedim == 5, "ERROR: space dimension must be 3 or 5");
+  IO (FCLIB_H5LTMAKE_DATASET_INT (file_id, "/fclib_global_rolling/spacedim", 1, &dim, &problem->spacedim));
+
+  ASSERT (problem->M, "ERROR: M must be given");
+  IO (id = H5Gmake (file_id, "/fclib_global_rolling/M"));
+  write_matrix (id, problem->M, flags);
+  IO (H5Gclose (id));
+
+  ASSERT (problem->H, "ERROR: H must be given");
+  IO (id = H5Gmake (file_id, "/fclib_global_rolling/H"));
+  write_matrix (id, problem->H, flags);
+  IO (H5Gclose (id));
+
+  if (problem->G)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_global_rolling/G"));
+    write_matrix (id, problem->G, flags);
+    IO (H5Gclose (id));
+  }
+
+  IO (id = H5Gmake (file_id, "/fclib_global_rolling/vectors"));
+  write_global_rolling_vectors (id, problem, flags);
+  IO (H5Gclose (id));
+
+  if (problem->info)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_global_rolling/info"));
+    write_problem_info (id, problem->info);
+    IO (H5Gclose (id));
+  }
+
+  IO (H5Gclose (main_id));
+}
+
+/* write global problem rolling;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_rolling (struct fclib_global_rolling *problem, const char *path)
+{
+  return fclib_write_global_rolling_with_flags (problem, path, 0);
+}
+
+/* write global problem rolling with flags;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_rolling_with_flags (struct fclib_global_rolling *problem, const char *path, int flags)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_CREATE);
+  write_global_rolling_file (file_id, problem, flags);
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* write global rolling problem into a file image;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_global_rolling_to_buffer (struct fclib_global_rolling *problem, void **buffer, size_t *size)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = image_create ();
+  write_global_rolling_file (file_id, problem, 0);
+  image_close (file_id, buffer, size);
+
+  error_leave ();
+  return 1;
+}
+
+
+
+
+
+
+/* write local problem into an open file */
+static void write_local_file (hid_t file_id, struct fclib_local *problem, int flags)
+{
+  hid_t  main_id, id;
+  hsize_t dim = 1;
+
+  ASSERT (!H5 (H5Lexists (file_id, "/fclib_local", H5P_DEFAULT)), "ERROR: a local problem has already been written to this file"); /* cannot overwrite existing datasets */
+
+  IO (main_id = H5Gmake (file_id, "/fclib_local"));
+
+  ASSERT (problem->spacedim == 2 || problem->spacedim == 3, "ERROR: space dimension must be 2 or 3");
+  IO (FCLIB_H5LTMAKE_DATASET_INT (file_id, "/fclib_local/spacedim", 1, &dim, &problem->spacedim));
+
+  ASSERT (problem->W, "ERROR: W must be given");
+  IO (id = H5Gmake (file_id, "/fclib_local/W"));
+  write_matrix (id, problem->W, flags);
+  IO (H5Gclose (id));
+
+  if (problem->V && problem->R)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_local/V"));
+    write_matrix (id, problem->V, flags);
+    IO (H5Gclose (id));
+
+    IO (id = H5Gmake (file_id, "/fclib_local/R"));
+    write_matrix (id, problem->R, flags);
+    IO (H5Gclose (id));
+  }
+  else ASSERT (!problem->V && !problem->R, "ERROR: V and R must be defined at the same time");
+
+  IO (id = H5Gmake (file_id, "/fclib_local/vectors"));
+  write_local_vectors (id, problem, flags);
+  IO (H5Gclose (id));
+
+  if (problem->info)
+  {
+    IO (id = H5Gmake (file_id, "/fclib_local/info"));
+    write_problem_info (id, problem->info);
+    IO (H5Gclose (id));
+  }
+
+  if (flags & FCLIB_WRITE_STATS)
+  {
+    struct fclib_problem_stats stats;
+
+    ASSERT (fclib_local_problem_stats (problem, &stats), "ERROR: computing the problem statistics failed");
+    write_problem_stats (main_id, &stats);
+  }
+
+  IO (H5Gclose (main_id));
+}
+
+/* write local problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_local (struct fclib_local *problem, const char *path)
+{
+  return fclib_write_local_with_flags (problem, path, 0);
+}
+
+/* write local problem with flags;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_local_with_flags (struct fclib_local *problem, const char *path, int flags)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_CREATE);
+  write_local_file (file_id, problem, flags);
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* write local problem into a file image;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_local_to_buffer (struct fclib_local *problem, void **buffer, size_t *size)
+{
+  struct error_context ctx;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = image_create ();
+  write_local_file (file_id, problem, 0);
+  image_close (file_id, buffer, size);
+
+  error_leave ();
+  return 1;
+}
+
+/* write solution;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_solution (struct fclib_solution *solution, const char *path)
+{
+  struct error_context ctx;
+  hid_t  file_id, id;
+  int nv, nr, nl;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  ASSERT (!H5 (H5Lexists (file_id, "/solution", H5P_DEFAULT)), "ERROR: a solution has already been written to this file"); /* cannot overwrite existing datasets */
+
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  IO (id = H5Gmake (file_id, "/solution"));
+  write_solution (id, solution, nv, nr, nl);
+  IO (H5Gclose (id));
+
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* write initial guesses;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_guesses (int number_of_guesses,  struct fclib_solution *guesses, const char *path)
+{
+  struct error_context ctx;
+  hid_t  file_id, main_id;
+  int nv, nr, nl;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  ASSERT (!H5 (H5Lexists (file_id, "/guesses", H5P_DEFAULT)), "ERROR: some guesses have already been written to this file"); /* cannot overwrite existing datasets */
+
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  IO (main_id = H5Gmake (file_id, "/guesses"));
+  append_guesses (main_id, 0, number_of_guesses, guesses, nv, nr, nl);
+
+  IO (H5Gclose (main_id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* append initial guesses;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_append_guesses (int number_of_guesses, struct fclib_solution *guesses, const char *path)
+{
+  struct error_context ctx;
+  hid_t  file_id, main_id;
+  int nv, nr, nl, stored = 0;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  if (H5 (H5Lexists (file_id, "/guesses/number_of_guesses", H5P_DEFAULT)))
+  {
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/guesses/number_of_guesses", &stored));
+  }
+
+  IO (main_id = H5Gmake (file_id, "/guesses"));
+  append_guesses (main_id, stored, number_of_guesses, guesses, nv, nr, nl);
+
+  IO (H5Gclose (main_id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* append a single initial guess;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_append_guess (struct fclib_solution *guess, const char *path)
+{
+  return fclib_append_guesses (1, guess, path);
+}
+
+/* replace solution;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_replace_solution (struct fclib_solution *solution, const char *path)
+{
+  struct error_context ctx;
+  hid_t  file_id, id;
+  int nv, nr, nl;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  if (H5 (H5Lexists (file_id, "/solution", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/solution", H5P_DEFAULT));
+    overwrite_solution (id, solution, nv, nr, nl);
+  }
+  else
+  {
+    check_solution_vectors (1, solution, nv, nr, nl);
+    IO (id = H5Gmake (file_id, "/solution"));
+    write_solution (id, solution, nv, nr, nl);
+  }
+  IO (H5Gclose (id));
+
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* read global problem;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global* fclib_read_global (const char *path)
+{
+  return fclib_read_global_with_flags (path, 0);
+}
+
+/* read global problem from an open file; the problem is registered with the error context and must
+ * be dropped by the caller */
+static struct fclib_global* read_global_file (hid_t file_id, int flags)
+{
+  struct fclib_global *problem;
+  hid_t  main_id, id;
+
+  MM (problem = (struct fclib_global*)FCLIB_CALLOC (1, sizeof (struct fclib_global)));
+  error_keep (problem, release_global, 1);
+
+  IO (main_id = H5Gopen (file_id, "/fclib_global", H5P_DEFAULT));
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global/spacedim", &problem->spacedim));
+
+  IO (id = H5Gopen (file_id, "/fclib_global/M", H5P_DEFAULT));
+  problem->M = read_matrix (id, flags);
+  IO (H5Gclose (id));
+
+  IO (id = H5Gopen (file_id, "/fclib_global/H", H5P_DEFAULT));
+  problem->H = read_matrix (id, flags);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_global/G", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_global/G", H5P_DEFAULT));
+    problem->G = read_matrix (id, flags);
+    IO (H5Gclose (id));
+  }
+
+  IO (id = H5Gopen (file_id, "/fclib_global/vectors", H5P_DEFAULT));
+  read_global_vectors (id, problem);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_global/info", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_global/info", H5P_DEFAULT));
+    problem->info = read_problem_info (id);
+    IO (H5Gclose (id));
+  }
+
+  IO (H5Gclose (main_id));
+
+  return problem;
+}
+
+/* read global problem with flags;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global* fclib_read_global_with_flags (const char *path, int flags)
+{
+  struct error_context ctx;
+  struct fclib_global *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  problem = read_global_file (file_id, flags);
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+
+/* read global problem from a file image;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global* fclib_read_global_from_buffer (const void *buffer, size_t size, int flags)
+{
+  struct error_context ctx;
+  struct fclib_global *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = image_open (buffer, size);
+  problem = read_global_file (file_id, flags);
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+/* read global problem;
+ * return problem on success; NULL on failure */
 FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global_rolling* fclib_read_global_rolling (const char *path)
 {
-  struct fclib_global_rolling *problem;
-  hid_t  file_id, main_id, id;
+  return fclib_read_global_rolling_with_flags (path, 0);
+}
+
+/* read global rolling problem from an open file; the problem is registered with the error context and must
+ * be dropped by the caller */
+static struct fclib_global_rolling* read_global_rolling_file (hid_t file_id, int flags)
+{
+  struct fclib_global_rolling *problem;
+  hid_t  main_id, id;
+
+  MM (problem = (struct fclib_global_rolling*)FCLIB_CALLOC (1, sizeof (struct fclib_global_rolling)));
+  error_keep (problem, release_global_rolling, 1);
+
+  IO (main_id = H5Gopen (file_id, "/fclib_global_rolling", H5P_DEFAULT));
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_global_rolling/spacedim", &problem->spacedim));
+
+  IO (id = H5Gopen (file_id, "/fclib_global_rolling/M", H5P_DEFAULT));
+  problem->M = read_matrix (id, flags);
+  IO (H5Gclose (id));
+
+  IO (id = H5Gopen (file_id, "/fclib_global_rolling/H", H5P_DEFAULT));
+  problem->H = read_matrix (id, flags);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_global_rolling/G", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_global_rolling/G", H5P_DEFAULT));
+    problem->G = read_matrix (id, flags);
+    IO (H5Gclose (id));
+  }
+
+  IO (id = H5Gopen (file_id, "/fclib_global_rolling/vectors", H5P_DEFAULT));
+  read_global_rolling_vectors (id, problem);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_global_rolling/info", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_global_rolling/info", H5P_DEFAULT));
+    problem->info = read_problem_info (id);
+    IO (H5Gclose (id));
+  }
+
+  IO (H5Gclose (main_id));
+
+  return problem;
+}
+
+/* read global rolling problem with flags;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global_rolling* fclib_read_global_rolling_with_flags (const char *path, int flags)
+{
+  struct error_context ctx;
+  struct fclib_global_rolling *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  problem = read_global_rolling_file (file_id, flags);
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+
+/* read global rolling problem from a file image;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global_rolling* fclib_read_global_rolling_from_buffer (const void *buffer, size_t size, int flags)
+{
+  struct error_context ctx;
+  struct fclib_global_rolling *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = image_open (buffer, size);
+  problem = read_global_rolling_file (file_id, flags);
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+/* read local problem;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_read_local (const char *path)
+{
+  return fclib_read_local_with_flags (path, 0);
+}
+
+/* read local problem from an open file; the problem is registered with the error context
+ * and must be dropped by the caller; 'name' labels the file in messages */
+static struct fclib_local* read_local_file (hid_t file_id, int flags, const char *name)
+{
+  struct fclib_local *problem;
+  hid_t  main_id, id;
+
+  ASSERT (H5 (H5Lexists (file_id, "/fclib_local", H5P_DEFAULT)), "ERROR: spurious input file %s :: fclib_local group does not exists", name);
+
+  MM (problem = (struct fclib_local*)FCLIB_CALLOC (1, sizeof (struct fclib_local)));
+  error_keep (problem, release_local, 1);
+
+  IO (main_id = H5Gopen (file_id, "/fclib_local", H5P_DEFAULT));
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/fclib_local/spacedim", &problem->spacedim));
+
+  IO (id = H5Gopen (file_id, "/fclib_local/W", H5P_DEFAULT));
+  problem->W = read_matrix (id, flags);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_local/V", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_local/V", H5P_DEFAULT));
+    problem->V = read_matrix (id, flags);
+    IO (H5Gclose (id));
+
+    IO (id = H5Gopen (file_id, "/fclib_local/R", H5P_DEFAULT));
+    problem->R = read_matrix (id, flags);
+    IO (H5Gclose (id));
+  }
+
+  IO (id = H5Gopen (file_id, "/fclib_local/vectors", H5P_DEFAULT));
+  read_local_vectors (id, problem);
+  IO (H5Gclose (id));
+
+  if (H5 (H5Lexists (file_id, "/fclib_local/info", H5P_DEFAULT)))
+  {
+    IO (id = H5Gopen (file_id, "/fclib_local/info", H5P_DEFAULT));
+    problem->info = read_problem_info (id);
+    IO (H5Gclose (id));
+  }
+
+  IO (H5Gclose (main_id));
+
+  return problem;
+}
+
+/* read local problem with flags;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_read_local_with_flags (const char *path, int flags)
+{
+  struct error_context ctx;
+  struct fclib_local *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  problem = read_local_file (file_id, flags, path);
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+
+/* read local problem from a file image;
+ * return problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_read_local_from_buffer (const void *buffer, size_t size, int flags)
+{
+  struct error_context ctx;
+  struct fclib_local *problem;
+  hid_t  file_id;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = image_open (buffer, size);
+  problem = read_local_file (file_id, flags, "image");
+  IO (H5Fclose (file_id));
+
+  error_drop (problem);
+  error_leave ();
+  return problem;
+}
+
+/* read solution;
+ * return solution on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_solution* fclib_read_solution (const char *path)
+{
+  struct error_context ctx;
+  struct fclib_solution *solution;
+  hid_t  file_id, id;
+  int nv, nr, nl;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  MM (solution = (struct fclib_solution*)FCLIB_CALLOC (1, sizeof (struct fclib_solution)));
+  error_keep (solution, release_solutions, 1);
+
+  IO (id = H5Gopen (file_id, "/solution", H5P_DEFAULT));
+  read_solution (id, nv, nr, nl, solution);
+  IO (H5Gclose (id));
+
+  IO (H5Fclose (file_id));
+
+  error_drop (solution);
+  error_leave ();
+  return solution;
+}
+
+/* read initial guesses;
+ * return vector of guesses on success; NULL on failure;
+ * output numebr of guesses in the variable pointed by 'number_of_guesses' */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_solution* fclib_read_guesses (const char *path, int *number_of_guesses)
+{
+  struct error_context ctx;
+  struct fclib_solution *guesses;
+  hid_t  file_id, main_id, id;
+  int nv, nr, nl, i;
+  char num [128];
+
+  *number_of_guesses = 0;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    *number_of_guesses = 0;
+    return NULL;
+  }
+
+  guesses = NULL;
+
+  file_id = file_open (path, FILE_READ);
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  if (H5 (H5Lexists (file_id, "/guesses", H5P_DEFAULT)))
+  {
+    IO (main_id = H5Gopen (file_id, "/guesses", H5P_DEFAULT));
+
+    IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/guesses/number_of_guesses", number_of_guesses));
+    ASSERT (*number_of_guesses >= 0, "ERROR: invalid number of guesses => %d", *number_of_guesses);
+
+    MM (guesses = (struct fclib_solution*)FCLIB_CALLOC ((*number_of_guesses > 0 ? *number_of_guesses : 1), sizeof (struct fclib_solution)));
+    error_keep (guesses, release_solutions, *number_of_guesses);
+
+    if (H5 (H5Lexists (main_id, "r", H5P_DEFAULT))) /* compact layout */
+    {
+      read_guesses (main_id, nv, nr, nl, 0, *number_of_guesses, guesses);
+    }
+    else for (i = 0; i < *number_of_guesses; i ++)
+    {
+      snprintf (num, 128, "%d", i+1);
+      IO (id = H5Gopen (main_id, num, H5P_DEFAULT));
+      read_solution (id, nv, nr, nl, &guesses [i]);
+      IO (H5Gclose (id));
+    }
+
+    IO (H5Gclose (main_id));
+    error_drop (guesses);
+  }
+
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return guesses;
+}
+
+/* read a single initial guess;
+ * return guess on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_solution* fclib_read_guess (const char *path, int index)
+{
+  struct error_context ctx;
+  struct fclib_solution *guess;
+  hid_t  file_id, main_id, id;
+  int nv, nr, nl, count;
+  char num [128];
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  read_nvnunrnl (file_id, &nv, &nr, &nl);
+
+  ASSERT (H5 (H5Lexists (file_id, "/guesses", H5P_DEFAULT)), "ERROR: no guesses have been written to this file");
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/guesses/number_of_guesses", &count));
+  ASSERT (index >= 0 && index < count, "ERROR: guess %d does not exist, %d guesses stored", index, count);
+
+  MM (guess = (struct fclib_solution*)FCLIB_CALLOC (1, sizeof (struct fclib_solution)));
+  error_keep (guess, release_solutions, 1);
+
+  IO (main_id = H5Gopen (file_id, "/guesses", H5P_DEFAULT));
+
+  if (H5 (H5Lexists (main_id, "r", H5P_DEFAULT))) /* compact layout */
+  {
+    read_guesses (main_id, nv, nr, nl, index, 1, guess);
+  }
+  else
+  {
+    snprintf (num, 128, "%d", index+1);
+    IO (id = H5Gopen (main_id, num, H5P_DEFAULT));
+    read_solution (id, nv, nr, nl, guess);
+    IO (H5Gclose (id));
+  }
+
+  IO (H5Gclose (main_id));
+  IO (H5Fclose (file_id));
+
+  error_drop (guess);
+  error_leave ();
+  return guess;
+}
+
+/* delete global problem */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_global (struct fclib_global *problem)
+{
+  delete_matrix (problem->M);
+  delete_matrix (problem->H);
+  delete_matrix (problem->G);
+  free (problem->mu);
+  free (problem->f);
+  if (problem->b) free (problem->b);
+  free (problem->w);
+  delete_info (problem->info);
+}
+
+/* delete local problem */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_local (struct fclib_local *problem)
+{
+  delete_matrix (problem->W);
+  delete_matrix (problem->V);
+  delete_matrix (problem->R);
+  free (problem->mu);
+  free (problem->q);
+  if (problem->s) free (problem->s);
+  delete_info (problem->info);
+}
+/* delete global problem */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_global_rolling (struct fclib_global_rolling *problem)
+{
+  delete_matrix (problem->M);
+  delete_matrix (problem->H);
+  delete_matrix (problem->G);
+  free (problem->mu);
+  free (problem->mu_r);
+  free (problem->f);
+  if (problem->b) free (problem->b);
+  free (problem->w);
+  delete_info (problem->info);
+}
+
+
+
+/* delete solutions or guesses */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_solutions (struct fclib_solution *data, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i ++)
+  {
+    if (data [i].v) free (data [i].v);
+    if (data [i].u) free (data [i].u);
+    if (data [i].r) free (data [i].r);
+    if (data [i].l) free (data [i].l);
+  }
+
+  free (data);
+}
+
+/* convert a matrix to block compressed rows */
+static struct fclib_matrix* matrix_to_bsr (struct fclib_matrix *mat, int bs)
+{
+  struct fclib_matrix *csr, *bsr;
+  int mb, nb, bs2 = bs*bs, *mark, j, k, l, r, nnzb;
+
+  if (bs <= 0 || mat->m % bs || mat->n % bs)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: matrix dimensions %d x %d are not divisible by the block size %d", mat->m, mat->n, bs);
+    return NULL;
+  }
+
+  csr = (mat->nz == -2 ? mat : matrix_csr (mat));
+  if (csr != mat) error_keep (csr, release_matrix, 1);
+  mb = mat->m / bs;
+  nb = mat->n / bs;
+  MM (mark = (int*)FCLIB_MALLOC (sizeof(int)*(nb > 0 ? nb : 1)));
+  error_keep (mark, release_memory, 1);
+  for (j = 0; j < nb; j ++) mark [j] = -1;
+
+  /* count the blocks of each block row */
+  for (nnzb = j = 0; j < mb; j ++)
+  {
+    for (r = j*bs; r < (j+1)*bs; r ++)
+      for (k = csr->p [r]; k < csr->p [r+1]; k ++)
+        if (mark [csr->i [k]/bs] != j)
+        {
+          mark [csr->i [k]/bs] = j;
+          nnzb ++;
+        }
+  }
+
+  bsr = matrix_alloc (mat->m, mat->n, nnzb*bs2, -3, bs);
+  error_keep (bsr, release_matrix, 1);
+  memset (bsr->x, 0, sizeof(double)*nnzb*bs2);
+  for (j = 0; j < nb; j ++) mark [j] = -1;
+
+  /* assemble the blocks; mark [J] is the position of block column J in the current block row */
+  for (bsr->p [0] = nnzb = j = 0; j < mb; j ++)
+  {
+    for (r = j*bs; r < (j+1)*bs; r ++)
+      for (k = csr->p [r]; k < csr->p [r+1]; k ++)
+      {
+        l = csr->i [k]/bs;
+        if (mark [l] < bsr->p [j])
+        {
+          mark [l] = nnzb;
+          bsr->i [nnzb ++] = l;
+        }
+        bsr->x [mark [l]*bs2 + (r - j*bs)*bs + csr->i [k] % bs] += csr->x [k];
+      }
+    bsr->p [j+1] = nnzb;
+  }
+
+  error_drop (mark);
+  free (mark);
+  if (csr != mat)
+  {
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  bsr->info = matrix_info_copy (mat->info);
+  error_drop (bsr);
+
+  return bsr;
+}
+
+/* convert a matrix to block compressed rows;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_to_bsr (struct fclib_matrix *mat, int bs)
+{
+  struct error_context ctx;
+  struct fclib_matrix *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_to_bsr (mat, bs);
+
+  error_leave ();
+  return result;
+}
+
+/* convert a block compressed row matrix to triplet, compressed column or compressed row form */
+static struct fclib_matrix* matrix_from_bsr (struct fclib_matrix *mat, int nz)
+{
+  struct fclib_matrix *csr, *out;
+
+  if (mat->nz != -3)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: not a block compressed row matrix => fclib_matrix->nz = %d", mat->nz);
+    return NULL;
+  }
+
+  if (nz < -2)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => nz = %d", nz);
+    return NULL;
+  }
+
+  csr = matrix_csr (mat);
+  if (nz == -2) return csr;
+
+  error_keep (csr, release_matrix, 1);
+  out = matrix_from_csr (csr, nz);
+  error_drop (csr);
+  delete_matrix (csr);
+
+  return out;
+}
+
+/* convert a block compressed row matrix to triplet, compressed column or compressed row form;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_from_bsr (struct fclib_matrix *mat, int nz)
+{
+  struct error_context ctx;
+  struct fclib_matrix *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_from_bsr (mat, nz);
+
+  error_leave ();
+  return result;
+}
+
+/* keep the upper triangle of a symmetric matrix */
+static struct fclib_matrix* matrix_to_symmetric (struct fclib_matrix *mat)
+{
+  struct fclib_matrix *csr, *sym;
+  int j, k, l;
+
+  if (mat->m != mat->n)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: a symmetric matrix must be square => %d x %d", mat->m, mat->n);
+    return NULL;
+  }
+
+  /* drop the strictly lower triangle in compressed rows, then compress the columns */
+  csr = matrix_csr (mat);
+  error_keep (csr, release_matrix, 1);
+  for (l = j = 0; j < csr->m; j ++)
+  {
+    k = csr->p [j];
+    csr->p [j] = l;
+    for (; k < csr->p [j+1]; k ++)
+      if (csr->i [k] >= j)
+      {
+        csr->i [l] = csr->i [k];
+        csr->x [l ++] = csr->x [k];
+      }
+  }
+  csr->p [csr->m] = l;
+  csr->nzmax = l;
+
+  sym = matrix_from_csr (csr, -1);
+  error_drop (csr);
+  delete_matrix (csr);
+  sym->nz = -4;
+
+  return sym;
+}
+
+/* keep the upper triangle of a symmetric matrix;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_to_symmetric (struct fclib_matrix *mat)
+{
+  struct error_context ctx;
+  struct fclib_matrix *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_to_symmetric (mat);
+
+  error_leave ();
+  return result;
+}
+
+/* expand a symmetric matrix stored as its upper triangle */
+static struct fclib_matrix* matrix_expand_symmetric (struct fclib_matrix *mat)
+{
+  struct fclib_matrix *csr, *full;
+
+  if (mat->nz != -4)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: not a symmetric matrix => fclib_matrix->nz = %d", mat->nz);
+    return NULL;
+  }
+
+  csr = matrix_csr (mat);
+  error_keep (csr, release_matrix, 1);
+  full = matrix_from_csr (csr, -1);
+  error_drop (csr);
+  delete_matrix (csr);
+
+  return full;
+}
+
+/* expand a symmetric matrix stored as its upper triangle;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_expand_symmetric (struct fclib_matrix *mat)
+{
+  struct error_context ctx;
+  struct fclib_matrix *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_expand_symmetric (mat);
+
+  error_leave ();
+  return result;
+}
+
+/* convert a matrix to another storage */
+static struct fclib_matrix* matrix_convert (struct fclib_matrix *mat, int nz)
+{
+  struct fclib_matrix *csr, *out;
+
+  if (nz < -4 || mat->nz < -4)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => nz = %d", nz < -4 ? nz : mat->nz);
+    return NULL;
+  }
+
+  if (nz == -4) return matrix_to_symmetric (mat);
+
+  if (nz == -3)
+  {
+    if (mat->nz != -3)
+    {
+      error_report (FCLIB_ERROR_INVALID, "ERROR: the block size is not known, use fclib_matrix_to_bsr");
+      return NULL;
+    }
+    return matrix_to_bsr (mat, mat->bs);
+  }
+
+  if (mat->nz >= -2 && nz < 0) return matrix_compress (mat, nz);
+
+  csr = matrix_csr (mat);
+  if (nz == -2) return csr;
+
+  error_keep (csr, release_matrix, 1);
+  out = matrix_from_csr (csr, nz);
+  error_drop (csr);
+  delete_matrix (csr);
+
+  return out;
+}
+
+/* convert a matrix to another storage;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_convert (struct fclib_matrix *mat, int nz)
+{
+  struct error_context ctx;
+  struct fclib_matrix *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_convert (mat, nz);
+
+  error_leave ();
+  return result;
+}
+
+/* convert a matrix in place */
+static int matrix_convert_inplace (struct fclib_matrix *mat, int nz)
+{
+  int nnz, outer, *idx, j, k;
+
+  if (nz < -4 || mat->nz < -4)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => nz = %d", nz < -4 ? nz : mat->nz);
+    return 0;
+  }
+
+  if (nz < -2 || mat->nz < -2) /* block and symmetric storage go through a copy */
+  {
+    struct fclib_matrix *out = matrix_convert (mat, nz), tmp;
+
+    if (!out) return 0;
+    tmp = *mat;
+    *mat = *out;
+    *out = tmp;
+    delete_matrix (out);
+
+    return 1;
+  }
+
+  if (mat->nz < 0 && mat->nz == nz) /* same compressed form: sort the indices */
+  {
+    outer = (nz == -1 ? mat->n : mat->m);
+#pragma omp parallel for schedule(dynamic, 256) if (mat->p [outer] > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < outer; j ++) sort_pairs (mat->i + mat->p [j], mat->x + mat->p [j], mat->p [j+1] - mat->p [j]);
+
+    return 1;
+  }
+
+  if (mat->nz < 0) /* expand the pointers of a compressed matrix to triplet indices */
+  {
+    outer = (mat->nz == -1 ? mat->n : mat->m);
+    nnz = mat->p [outer];
+    MM (idx = (int*)FCLIB_MALLOC (sizeof(int)*(nnz > 0 ? nnz : 1)));
+#pragma omp parallel for private(k) if (nnz > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < outer; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++) idx [k] = j;
+
+    free (mat->p);
+    if (mat->nz == -2) mat->p = idx; /* rows */
+    else
+    {
+      mat->p = mat->i; /* rows */
+      mat->i = idx; /* columns */
+    }
+    mat->nz = nnz;
+  }
+
+  if (nz >= 0) return 1;
+
+  /* triplet to compressed: bucket the entries by column or row */
+  nnz = mat->nz;
+  outer = (nz == -1 ? mat->n : mat->m);
+  MM (idx = (int*)FCLIB_MALLOC (sizeof(int)*(outer+1)));
+  if (nz == -2)
+  {
+    triplet_sort_inplace (mat->p, mat->i, mat->x, nnz, outer, idx);
+    free (mat->p);
+  }
+  else
+  {
+    triplet_sort_inplace (mat->i, mat->p, mat->x, nnz, outer, idx);
+    free (mat->i);
+    mat->i = mat->p;
+  }
+  mat->p = idx;
+  mat->nz = nz;
+  mat->nzmax = nnz;
+
+  return 1;
+}
+
+/* convert a matrix in place;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_matrix_convert_inplace (struct fclib_matrix *mat, int nz)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = matrix_convert_inplace (mat, nz);
+
+  error_leave ();
+  return result;
+}
+
+/* sort, sum duplicates and drop zeros */
+static int matrix_canonicalize (struct fclib_matrix *mat)
+{
+  int outer, *w, j, k, l;
+
+  if (mat->nz < -4)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d", mat->nz);
+    return 0;
+  }
+
+  if (mat->nz >= 0) /* triplet: canonicalize as compressed rows, then expand back */
+  {
+    return matrix_convert_inplace (mat, -2) &&
+           matrix_canonicalize (mat) &&
+           matrix_convert_inplace (mat, 0);
+  }
+
+  outer = (mat->nz == -1 || mat->nz == -4 ? mat->n : mat->m / (mat->nz == -3 ? mat->bs : 1));
+  MM (w = (int*)FCLIB_CALLOC (outer+1, sizeof(int)));
+  error_keep (w, release_memory, 1);
+
+  if (mat->nz == -3) /* blocks: sort the block columns of each block row into new arrays */
+  {
+    int bs2 = mat->bs*mat->bs, nnzb = mat->p [outer], *bi;
+    unsigned long long *key;
+    double *bx;
+
+    MM (key = (unsigned long long*)FCLIB_MALLOC (sizeof(unsigned long long)*(nnzb > 0 ? nnzb : 1)));
+    error_keep (key, release_memory, 1);
+    MM (bi = (int*)FCLIB_MALLOC (sizeof(int)*(nnzb > 0 ? nnzb : 1)));
+    error_keep (bi, release_memory, 1);
+    MM (bx = (double*)FCLIB_MALLOC (sizeof(double)*(nnzb > 0 ? nnzb*bs2 : 1)));
+    error_keep (bx, release_memory, 1);
+
+#pragma omp parallel for private(k, l) schedule(dynamic, 64) if (nnzb*bs2 > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < outer; j ++)
+    {
+      int n = mat->p [j], r, c;
+
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++) key [k] = ((unsigned long long)mat->i [k] << 32) | (unsigned)k;
+      sort_keys (key + mat->p [j], mat->p [j+1] - mat->p [j]);
+
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      {
+        int col = (int)(key [k] >> 32), src = (int)(key [k] & 0xffffffffu);
+
+        if (n == mat->p [j] || bi [n-1] != col)
+        {
+          bi [n] = col;
+          memcpy (bx + (size_t)n*bs2, mat->x + (size_t)src*bs2, sizeof(double)*bs2);
+          n ++;
+        }
+        else for (l = 0; l < bs2; l ++) bx [(size_t)(n-1)*bs2 + l] += mat->x [(size_t)src*bs2 + l];
+      }
+
+      for (l = r = mat->p [j]; r < n; r ++) /* drop all-zero blocks */
+      {
+        for (c = 0; c < bs2 && bx [(size_t)r*bs2 + c] == 0.0; c ++);
+        if (c == bs2) continue;
+        if (l != r)
+        {
+          bi [l] = bi [r];
+          memcpy (bx + (size_t)l*bs2, bx + (size_t)r*bs2, sizeof(double)*bs2);
+        }
+        l ++;
+      }
+      w [j] = l - mat->p [j];
+    }
+
+    error_drop (bx);
+    error_drop (bi);
+    error_drop (key);
+    free (key);
+    free (mat->i);
+    free (mat->x);
+    mat->i = bi;
+    mat->x = bx;
+  }
+  else /* compressed entries: sort, sum duplicates and drop zeros in each column or row */
+  {
+#pragma omp parallel for private(k, l) schedule(dynamic, 256) if (mat->p [outer] > FCLIB_PARALLEL_MIN)
+    for (j = 0; j < outer; j ++)
+    {
+      int *i = mat->i + mat->p [j], n = mat->p [j+1] - mat->p [j];
+      double *x = mat->x + mat->p [j];
+
+      sort_pairs (i, x, n);
+      for (l = k = 0; k < n; k ++)
+      {
+        if (l > 0 && i [l-1] == i [k]) x [l-1] += x [k];
+        else
+        {
+          i [l] = i [k];
+          x [l ++] = x [k];
+        }
+      }
+      for (n = l, l = k = 0; k < n; k ++)
+        if (x [k] != 0.0)
+        {
+          i [l] = i [k];
+          x [l ++] = x [k];
+        }
+      w [j] = l;
+    }
+  }
+
+  /* compact the segments in order */
+  {
+    int bs2 = (mat->nz == -3 ? mat->bs*mat->bs : 1);
+
+    for (l = j = 0; j < outer; j ++)
+    {
+      k = mat->p [j];
+      mat->p [j] = l;
+      if (k != l)
+      {
+        memmove (mat->i + l, mat->i + k, sizeof(int)*w [j]);
+        memmove (mat->x + (size_t)l*bs2, mat->x + (size_t)k*bs2, sizeof(double)*w [j]*bs2);
+      }
+      l += w [j];
+    }
+    mat->p [outer] = l;
+    mat->nzmax = l*bs2;
+  }
+
+  error_drop (w);
+  free (w);
+
+  return 1;
+}
+
+/* sort, sum duplicates and drop zeros;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_matrix_canonicalize (struct fclib_matrix *mat)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = matrix_canonicalize (mat);
+
+  error_leave ();
+  return result;
+}
+
+/* check the structure of a matrix */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_matrix_validate (struct fclib_matrix *mat, int *structure)
+{
+  char reason [256];
+  int s;
+
+  if (!matrix_validate (mat, &s, reason, sizeof (reason)))
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: invalid matrix => %s", reason);
+    return 0;
+  }
+  if (structure) *structure = s;
+
+  return 1;
+}
+
+/* y += A x */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_matrix_gaxpy (struct fclib_matrix *A, const double *x, double *y)
+{
+  matrix_gaxpy (A, x, y);
+}
+
+/* project a contact vector of dimension sd onto the friction cone of coefficient mu */
+static void cone_projection (double *r, double mu, int sd)
+{
+  double normT = (sd == 3 ? hypot (r [1], r [2]) : fabs (r [1]));
+  int k;
+
+  if (mu * normT <= - r [0])
+  {
+    for (k = 0; k < sd; k ++) r [k] = 0.0;
+  }
+  else if (normT > mu * r [0])
+  {
+    r [0] = (mu * normT + r [0]) / (mu * mu + 1.0);
+    for (k = 1; k < sd; k ++) r [k] = mu * r [0] * r [k] / normT;
+  }
+}
+
+/* add the squared natural map residual of one contact */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_merit_contact (int spacedim, const double *r, const double *u, double mu, double *error)
+{
+  double t [3] = {0.0, 0.0, 0.0};
+  int k;
+
+  t [0] = r [0] - (u [0] + mu * (spacedim == 3 ? hypot (u [1], u [2]) : fabs (u [1])));
+  for (k = 1; k < spacedim; k ++) t [k] = r [k] - u [k];
+  cone_projection (t, mu, spacedim);
+  for (k = 0; k < spacedim; k ++) *error += (r [k] - t [k]) * (r [k] - t [k]);
+}
+
+/* number of contacts of a row of H above which they are linked as a chain rather than a clique in the contact graph */
+#define FCLIB_GRAPH_CLIQUE_MAX 32
+
+/* parts of at most this many contacts are not dissected further */
+#define FCLIB_ND_LEAF 64
+
+/* contact graph of a square matrix in compressed rows: contacts c != d are neighbours when the
+ * sd x sd block (c, d) or (d, c) holds an entry; returned as a canonical compressed row pattern */
+static struct fclib_matrix* contact_graph (struct fclib_matrix *csr, int sd)
+{
+  struct fclib_matrix *pairs, *graph;
+  int nc = csr->m/sd, c, d, k, l;
+
+  pairs = matrix_alloc (nc, nc, 2*csr->p [csr->m] + 1, 0, 0);
+  error_keep (pairs, release_matrix, 1);
+  for (l = c = 0; c < nc; c ++)
+    for (k = csr->p [sd*c]; k < csr->p [sd*c+sd]; k ++)
+      if ((d = csr->i [k]/sd) != c)
+      {
+        pairs->p [l] = pairs->i [l+1] = c;
+        pairs->i [l] = pairs->p [l+1] = d;
+        pairs->x [l] = pairs->x [l+1] = 1.0;
+        l += 2;
+      }
+  pairs->nz = l;
+  graph = matrix_compress (pairs, -2);
+  error_drop (pairs);
+  delete_matrix (pairs);
+  error_keep (graph, release_matrix, 1);
+  matrix_canonicalize (graph);
+  error_drop (graph);
+
+  return graph;
+}
+
+/* contact graph of H^T H for H in compressed rows: contacts c != d are neighbours when they have entries
+ * in a common row of H; the contacts of a row with many contacts are chained to keep the graph linear in size */
+static struct fclib_matrix* contact_graph_rows (struct fclib_matrix *csr, int sd)
+{
+  struct fclib_matrix *pairs, *graph;
+  int nc = csr->n/sd, *list, *mark, nl, a, b, j, k, l;
+  long long total;
+
+  MM (list = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  error_keep (list, release_memory, 1);
+  MM (mark = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  error_keep (mark, release_memory, 1);
+  for (a = 0; a < nc; a ++) mark [a] = -1;
+
+  for (total = j = 0; j < csr->m; j ++)
+  {
+    for (nl = 0, k = csr->p [j]; k < csr->p [j+1]; k ++)
+      if (mark [csr->i [k]/sd] != j) mark [csr->i [k]/sd] = j, nl ++;
+    if (nl > 1) total += (nl > FCLIB_GRAPH_CLIQUE_MAX ? 2*(nl-1) : (long long)nl*(nl-1));
+  }
+  ASSERT (total < 0x7fffffffLL, "ERROR: contact graph too large => %lld edges", total);
+
+  pairs = matrix_alloc (nc, nc, (int)total + 1, 0, 0);
+  error_keep (pairs, release_matrix, 1);
+  for (a = 0; a < nc; a ++) mark [a] = -1;
+  for (l = j = 0; j < csr->m; j ++)
+  {
+    for (nl = 0, k = csr->p [j]; k < csr->p [j+1]; k ++)
+      if (mark [csr->i [k]/sd] != j) mark [csr->i [k]/sd] = j, list [nl ++] = csr->i [k]/sd;
+
+    for (a = 0; a < nl; a ++)
+      for (b = (nl > FCLIB_GRAPH_CLIQUE_MAX ? a-1 : 0); b < (nl > FCLIB_GRAPH_CLIQUE_MAX ? a+2 : nl) && b < nl; b ++)
+        if (b >= 0 && b != a)
+        {
+          pairs->p [l] = list [a];
+          pairs->i [l] = list [b];
+          pairs->x [l ++] = 1.0;
+        }
+  }
+  pairs->nz = l;
+  graph = matrix_compress (pairs, -2);
+  error_drop (pairs);
+  delete_matrix (pairs);
+  error_keep (graph, release_matrix, 1);
+  matrix_canonicalize (graph);
+  error_drop (graph);
+
+  error_drop (mark);
+  error_drop (list);
+  free (mark);
+  free (list);
+
+  return graph;
+}
+
+/* breadth first search of a graph from root over the vertices v with part [v] == id (all vertices when part is NULL);
+ * the visited vertices get mark [v] = stamp and their level, and are queue [0..count-1] in visiting order.
+ * With sorted, the neighbours of a vertex are queued by increasing degree (Cuthill-McKee).
+ * Returns the number of visited vertices; the number of levels is returned in *levels */
+static int graph_bfs (struct fclib_matrix *g, int root, const int *part, int id, int *mark, int stamp,
+                      int *level, int *queue, int *levels, int sorted)
+{
+  int head = 0, tail = 1, v, w, t, a, b, k;
+
+  queue [0] = root;
+  mark [root] = stamp;
+  level [root] = 0;
+
+  while (head < tail)
+  {
+    v = queue [head ++];
+    for (a = tail, k = g->p [v]; k < g->p [v+1]; k ++)
+    {
+      w = g->i [k];
+      if (mark [w] == stamp || (part && part [w] != id)) continue;
+      mark [w] = stamp;
+      level [w] = level [v] + 1;
+      queue [tail ++] = w;
+    }
+
+    if (sorted)
+      for (b = a+1; b < tail; b ++) /* insertion sort of the new vertices by degree */
+      {
+        t = queue [b];
+        for (w = b; w > a && g->p [queue [w-1]+1] - g->p [queue [w-1]] > g->p [t+1] - g->p [t]; w --) queue [w] = queue [w-1];
+        queue [w] = t;
+      }
+  }
+
+  *levels = level [queue [tail-1]] + 1;
+
+  return tail;
+}
+
+/* pseudo-peripheral vertex of the component of start (George-Liu): the search restarts from a vertex of minimum
+ * degree in the last level as long as the number of levels grows; on exit queue, level, *count and *levels hold
+ * the search from the returned vertex, and mark [v] == *stamp for the vertices of the component */
+static int graph_peripheral (struct fclib_matrix *g, int start, const int *part, int id, int *mark, int *stamp,
+                             int *level, int *queue, int *count, int *levels)
+{
+  int root = start, best, deg, nlev, k, v;
+
+  *count = graph_bfs (g, root, part, id, mark, ++ (*stamp), level, queue, &nlev, 0);
+
+  for (;;)
+  {
+    for (best = -1, deg = 0, k = *count-1; k >= 0 && level [queue [k]] == nlev-1; k --)
+    {
+      v = queue [k];
+      if (best < 0 || g->p [v+1] - g->p [v] < deg) best = v, deg = g->p [v+1] - g->p [v];
+    }
+    if (best == root) break;
+
+    *levels = nlev;
+    *count = graph_bfs (g, best, part, id, mark, ++ (*stamp), level, queue, &nlev, 0);
+    root = best;
+    if (nlev <= *levels) break;
+  }
+
+  *levels = nlev;
+
+  return root;
+}
+
+/* reverse Cuthill-McKee ordering of a graph, component after component */
+static void order_rcm (struct fclib_matrix *g, int *perm)
+{
+  int nc = g->m, *mark, *level, *queue, stamp = -1, n, count, levels, root, v, k;
+  char *done;
+
+  MM (mark = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (level = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (queue = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (done = (char*)FCLIB_CALLOC (nc > 0 ? nc : 1, 1));
+  for (v = 0; v < nc; v ++) mark [v] = -1;
+
+  for (n = v = 0; v < nc; v ++)
+  {
+    if (done [v]) continue;
+    root = graph_peripheral (g, v, NULL, 0, mark, &stamp, level, queue, &count, &levels);
+    count = graph_bfs (g, root, NULL, 0, mark, ++ stamp, level, perm + n, &levels, 1);
+    for (k = n; k < n+count; k ++) done [perm [k]] = 1;
+    n += count;
+  }
+
+  for (k = 0; k < nc/2; k ++)
+  {
+    v = perm [k];
+    perm [k] = perm [nc-1-k];
+    perm [nc-1-k] = v;
+  }
+
+  free (done);
+  free (queue);
+  free (level);
+  free (mark);
+}
+
+/* nested dissection ordering of a graph: a part is split into its connected components, or else by the middle level
+ * of a level structure rooted at a pseudo-peripheral vertex, which is ordered after the two halves it separates */
+static void order_nd (struct fclib_matrix *g, int *perm)
+{
+  int nc = g->m, *part, *mark, *level, *queue, *stack, *tmp, top = 0, ids = 1, stamp = -1;
+  int lo, hi, n, na, nb, id, count, levels, a, b, k;
+
+  MM (part = (int*)FCLIB_CALLOC (nc > 0 ? nc : 1, sizeof(int)));
+  MM (mark = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (level = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (queue = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (tmp = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (stack = (int*)FCLIB_MALLOC (sizeof(int)*(2*nc+2)));
+  for (k = 0; k < nc; k ++) perm [k] = k, mark [k] = -1;
+
+  stack [top ++] = 0; /* parts [lo, hi) of perm still to be dissected */
+  stack [top ++] = nc;
+  while (top > 0)
+  {
+    hi = stack [-- top];
+    lo = stack [-- top];
+    n = hi - lo;
+    if (n <= FCLIB_ND_LEAF) continue;
+
+    id = part [perm [lo]];
+    graph_peripheral (g, perm [lo], part, id, mark, &stamp, level, queue, &count, &levels);
+    if (count < n) /* disconnected: the component found, then the rest */
+    {
+      memcpy (tmp, queue, sizeof(int)*count);
+      for (b = count, k = lo; k < hi; k ++)
+        if (mark [perm [k]] != stamp) tmp [b ++] = perm [k];
+      na = count;
+      nb = n - count;
+    }
+    else if (levels < 3) continue; /* no separating level: keep the part as it is */
+    else /* levels are contiguous in the queue: [0, a) before, [a, b) separator, [b, n) after */
+    {
+      for (a = 0; level [queue [a]] < levels/2; a ++);
+      for (b = a; level [queue [b]] == levels/2; b ++);
+      memcpy (tmp, queue, sizeof(int)*a);
+      memcpy (tmp + a, queue + b, sizeof(int)*(n-b));
+      memcpy (tmp + a + n-b, queue + a, sizeof(int)*(b-a));
+      na = a;
+      nb = n-b;
+    }
+    memcpy (perm + lo, tmp, sizeof(int)*n);
+
+    for (k = lo; k < lo+na; k ++) part [perm [k]] = ids;
+    for (ids ++; k < lo+na+nb; k ++) part [perm [k]] = ids;
+    for (ids ++; k < hi; k ++) part [perm [k]] = -1; /* separator */
+
+    stack [top ++] = lo;
+    stack [top ++] = lo+na;
+    stack [top ++] = lo+na;
+    stack [top ++] = lo+na+nb;
+  }
+
+  free (stack);
+  free (tmp);
+  free (queue);
+  free (level);
+  free (mark);
+  free (part);
+}
+
+/* ordering of the vertices of a contact graph; NULL for an unknown method */
+static int* graph_ordering (struct fclib_matrix *graph, int method)
+{
+  int *perm;
+
+  MM (perm = (int*)FCLIB_MALLOC (sizeof(int)*(graph->m > 0 ? graph->m : 1)));
+  error_keep (perm, release_memory, 1);
+  if (method == FCLIB_ORDERING_RCM) order_rcm (graph, perm);
+  else order_nd (graph, perm);
+  error_drop (perm);
+
+  return perm;
+}
+
+/* inverse of a contact permutation, expanded to the sd components of each contact;
+ * NULL if perm is not a permutation of 0..nc-1 */
+static int* contact_inverse (const int *perm, int nc, int sd)
+{
+  int *inv, c, e;
+
+  MM (inv = (int*)FCLIB_MALLOC (sizeof(int)*(nc*sd > 0 ? nc*sd : 1)));
+  for (c = 0; c < nc*sd; c ++) inv [c] = -1;
+
+  for (c = 0; c < nc; c ++)
+  {
+    if (perm [c] < 0 || perm [c] >= nc || inv [sd*perm [c]] >= 0)
+    {
+      error_report (FCLIB_ERROR_INVALID, "ERROR: not a permutation of %d contacts => perm [%d] = %d", nc, c, perm [c]);
+      free (inv);
+      return NULL;
+    }
+    for (e = 0; e < sd; e ++) inv [sd*perm [c]+e] = sd*c+e;
+  }
+
+  return inv;
+}
+
+/* permute blocks of sd entries in place: x [k] = x [perm [k]], or x [perm [k]] = x [k] with inverse */
+static void permute_blocks (double *x, const int *perm, int nc, int sd, int inverse)
+{
+  double *y;
+  int c, e;
+
+  MM (y = (double*)FCLIB_MALLOC (sizeof(double)*(nc*sd > 0 ? nc*sd : 1)));
+  error_keep (y, release_memory, 1);
+  memcpy (y, x, sizeof(double)*nc*sd);
+
+#pragma omp parallel for private(e) if (nc*sd > FCLIB_PARALLEL_MIN)
+  for (c = 0; c < nc; c ++)
+    for (e = 0; e < sd; e ++)
+    {
+      if (inverse) x [sd*perm [c]+e] = y [sd*c+e];
+      else x [sd*c+e] = y [sd*perm [c]+e];
+    }
+
+  error_drop (y);
+  free (y);
+}
+
+/* permute the rows and columns of a matrix in place, keeping its storage: entry (r, c) moves to (rinv [r], cinv [c]);
+ * NULL leaves the rows or the columns in place. Symmetric permutations of symmetric matrices keep them symmetric */
+static void matrix_permute (struct fclib_matrix *mat, const int *rinv, const int *cinv)
+{
+  struct fclib_matrix *csr, *trip, *out, tmp;
+  int nnz, j, k;
+
+  csr = matrix_csr (mat);
+  error_keep (csr, release_matrix, 1);
+  nnz = csr->p [csr->m];
+  trip = matrix_alloc (csr->m, csr->n, nnz, nnz, 0);
+  error_keep (trip, release_matrix, 1);
+
+#pragma omp parallel for private(k) if (nnz > FCLIB_PARALLEL_MIN)
+  for (j = 0; j < csr->m; j ++)
+    for (k = csr->p [j]; k < csr->p [j+1]; k ++)
+    {
+      trip->p [k] = (rinv ? rinv [j] : j);
+      trip->i [k] = (cinv ? cinv [csr->i [k]] : csr->i [k]);
+      trip->x [k] = csr->x [k];
+    }
+  error_drop (csr);
+  delete_matrix (csr);
+
+  out = (mat->nz >= 0 ? trip : mat->nz == -3 ? matrix_to_bsr (trip, mat->bs) : matrix_convert (trip, mat->nz));
+  error_drop (trip);
+  if (out != trip) delete_matrix (trip);
+
+  out->info = mat->info;
+  mat->info = NULL;
+  tmp = *mat;
+  *mat = *out;
+  *out = tmp;
+  delete_matrix (out);
+}
+
+/* contact ordering of a local problem */
+static int* local_ordering (struct fclib_local *problem, int method)
+{
+  struct fclib_matrix *csr, *graph;
+  int *perm;
+
+  if (method != FCLIB_ORDERING_RCM && method != FCLIB_ORDERING_ND)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown contact ordering => %d", method);
+    return NULL;
+  }
+
+  csr = (problem->W->nz == -2 ? problem->W : matrix_csr (problem->W));
+  if (csr != problem->W) error_keep (csr, release_matrix, 1);
+  graph = contact_graph (csr, problem->spacedim);
+  if (csr != problem->W)
+  {
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  error_keep (graph, release_matrix, 1);
+  perm = graph_ordering (graph, method);
+  error_drop (graph);
+  delete_matrix (graph);
+
+  return perm;
+}
+
+/* contact ordering of a local problem;
+ * return permutation on success; NULL on failure */
+FCLIB_STATIC int* FCLIB_APICOMPILE fclib_local_ordering (struct fclib_local *problem, int method)
+{
+  struct error_context ctx;
+  int *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = local_ordering (problem, method);
+
+  error_leave ();
+  return result;
+}
+
+/* contact ordering of a global problem */
+static int* global_ordering (struct fclib_global *problem, int method)
+{
+  struct fclib_matrix *csr, *graph;
+  int *perm;
+
+  if (method != FCLIB_ORDERING_RCM && method != FCLIB_ORDERING_ND)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown contact ordering => %d", method);
+    return NULL;
+  }
+
+  csr = (problem->H->nz == -2 ? problem->H : matrix_csr (problem->H));
+  if (csr != problem->H) error_keep (csr, release_matrix, 1);
+  graph = contact_graph_rows (csr, problem->spacedim);
+  if (csr != problem->H)
+  {
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  error_keep (graph, release_matrix, 1);
+  perm = graph_ordering (graph, method);
+  error_drop (graph);
+  delete_matrix (graph);
+
+  return perm;
+}
+
+/* contact ordering of a global problem;
+ * return permutation on success; NULL on failure */
+FCLIB_STATIC int* FCLIB_APICOMPILE fclib_global_ordering (struct fclib_global *problem, int method)
+{
+  struct error_context ctx;
+  int *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = global_ordering (problem, method);
+
+  error_leave ();
+  return result;
+}
+
+/* histogram bin of a count: 0 in bin 0, 2^(b-1) to 2^b - 1 in bin b and larger counts in the last bin */
+static int stats_bin (int count)
+{
+  int b;
+
+  for (b = 0; count > 0 && b < FCLIB_PROBLEM_STATS_BINS-1; count >>= 1) b ++;
+
+  return b;
+}
+
+/* root of a contact in a union-find forest, halving the path */
+static int stats_root (int *parent, int c)
+{
+  while (parent [c] != c) c = parent [c] = parent [parent [c]];
+
+  return c;
+}
+
+/* statistics of a matrix in compressed rows and of its contact graph: one parallel pass over the rows
+ * (by sd x sd block rows, counting the blocks with a mark per block column), one over the contacts
+ * and a union-find over the edges for the components */
+static void problem_stats (struct fclib_matrix *csr, struct fclib_matrix *graph, int sd, double *mu,
+                           struct fclib_problem_stats *stats)
+{
+  int m = csr->m, nbr = (m + sd - 1)/sd, nbc = (csr->n + sd - 1)/sd, nc = graph->m, *parent, *size, failed = 0, c, k;
+
+  memset (stats, 0, sizeof (struct fclib_problem_stats));
+  stats->rows = m;
+  stats->cols = csr->n;
+  stats->nnz = csr->p [m];
+  stats->row_min = csr->n;
+  stats->contacts = nc;
+  stats->edges = graph->p [nc] / 2;
+  stats->degree_min = nc;
+
+  /* a failed allocation in a thread is raised after the region, on the calling thread */
+#pragma omp parallel private(c, k) reduction(|:failed) if (stats->nnz > FCLIB_PARALLEL_MIN)
+  {
+    int rows [FCLIB_PROBLEM_STATS_BINS] = {0}, degrees [FCLIB_PROBLEM_STATS_BINS] = {0},
+        row_min = csr->n, row_max = 0, band = 0, blocks = 0, degree_min = nc, degree_max = 0, frictionless = 0, *mark, b, j;
+
+    mark = (int*)FCLIB_MALLOC (sizeof(int)*(nbc > 0 ? nbc : 1));
+    failed |= !mark;
+    for (b = 0; mark && b < nbc; b ++) mark [b] = -1;
+
+#pragma omp for schedule(dynamic, 256) nowait
+    for (b = 0; b < nbr; b ++)
+      for (j = sd*b; mark && j < sd*b+sd && j < m; j ++)
+      {
+        int len = csr->p [j+1] - csr->p [j];
+
+        rows [stats_bin (len)] ++;
+        if (len < row_min) row_min = len;
+        if (len > row_max) row_max = len;
+
+        for (k = csr->p [j]; k < csr->p [j+1]; k ++)
+        {
+          int i = csr->i [k];
+
+          if (abs (i - j) > band) band = abs (i - j);
+          if (mark [i/sd] != b) mark [i/sd] = b, blocks ++;
+        }
+      }
+
+#pragma omp for nowait
+    for (c = 0; c < nc; c ++)
+    {
+      int degree = graph->p [c+1] - graph->p [c];
+
+      degrees [stats_bin (degree)] ++;
+      if (degree < degree_min) degree_min = degree;
+      if (degree > degree_max) degree_max = degree;
+      if (mu && mu [c] == 0.0) frictionless ++;
+    }
+
+#pragma omp critical
+    {
+      for (k = 0; k < FCLIB_PROBLEM_STATS_BINS; k ++)
+      {
+        stats->row_histogram [k] += rows [k];
+        stats->degree_histogram [k] += degrees [k];
+      }
+      if (row_min < stats->row_min) stats->row_min = row_min;
+      if (row_max > stats->row_max) stats->row_max = row_max;
+      if (band > stats->bandwidth) stats->bandwidth = band;
+      stats->blocks += blocks;
+      if (degree_min < stats->degree_min) stats->degree_min = degree_min;
+      if (degree_max > stats->degree_max) stats->degree_max = degree_max;
+      stats->frictionless += frictionless;
+    }
+
+    free (mark);
+  }
+  if (failed) FAIL (FCLIB_ERROR_MEMORY, "ERROR: out of memory");
+
+  if (m == 0) stats->row_min = 0;
+  if (nc == 0) stats->degree_min = 0;
+  stats->row_mean = (m > 0 ? (double) stats->nnz / m : 0.0);
+  stats->block_fill = (stats->blocks > 0 ? (double) stats->nnz / ((double) stats->blocks * sd * sd) : 0.0);
+  stats->degree_mean = (nc > 0 ? 2.0 * stats->edges / nc : 0.0);
+  stats->frictionless = (nc > 0 ? stats->frictionless / nc : 0.0);
+
+  MM (parent = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  for (c = 0; c < nc; c ++) parent [c] = c;
+  for (c = 0; c < nc; c ++)
+    for (k = graph->p [c]; k < graph->p [c+1]; k ++)
+      if (graph->i [k] > c)
+      {
+        int a = stats_root (parent, c), b = stats_root (parent, graph->i [k]);
+
+        if (a != b) parent [a < b ? b : a] = (a < b ? a : b);
+      }
+
+  MM (size = (int*)FCLIB_CALLOC (nc > 0 ? nc : 1, sizeof(int)));
+  for (c = 0; c < nc; c ++) size [stats_root (parent, c)] ++;
+  for (c = 0; c < nc; c ++)
+    if (size [c] > 0)
+    {
+      stats->components ++;
+      if (size [c] > stats->largest_component) stats->largest_component = size [c];
+    }
+
+  free (size);
+  free (parent);
+}
+
+/* structural statistics of a local problem */
+static int local_problem_stats (struct fclib_local *problem, struct fclib_problem_stats *stats)
+{
+  struct fclib_matrix *csr, *graph;
+
+  if (!problem->W || problem->spacedim <= 0 || problem->W->m != problem->W->n || problem->W->m % problem->spacedim)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: W must be square with spacedim x spacedim blocks");
+    return 0;
+  }
+
+  csr = (problem->W->nz == -2 ? problem->W : matrix_csr (problem->W));
+  if (csr != problem->W) error_keep (csr, release_matrix, 1);
+  graph = contact_graph (csr, problem->spacedim);
+  error_keep (graph, release_matrix, 1);
+  problem_stats (csr, graph, problem->spacedim, problem->mu, stats);
+  error_drop (graph);
+  delete_matrix (graph);
+  if (csr != problem->W)
+  {
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  stats->global = 0;
+
+  return 1;
+}
+
+/* structural statistics of a local problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_local_problem_stats (struct fclib_local *problem, struct fclib_problem_stats *stats)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = local_problem_stats (problem, stats);
+
+  error_leave ();
+  return result;
+}
+
+/* structural statistics of a global problem */
+static int global_problem_stats (struct fclib_global *problem, struct fclib_problem_stats *stats)
+{
+  struct fclib_matrix *csr, *graph;
+
+  if (!problem->H || problem->spacedim <= 0 || problem->H->n % problem->spacedim)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: H must have spacedim columns per contact");
+    return 0;
+  }
+
+  csr = (problem->H->nz == -2 ? problem->H : matrix_csr (problem->H));
+  if (csr != problem->H) error_keep (csr, release_matrix, 1);
+  graph = contact_graph_rows (csr, problem->spacedim);
+  error_keep (graph, release_matrix, 1);
+  problem_stats (csr, graph, problem->spacedim, problem->mu, stats);
+  error_drop (graph);
+  delete_matrix (graph);
+  if (csr != problem->H)
+  {
+    error_drop (csr);
+    delete_matrix (csr);
+  }
+  stats->global = 1;
+
+  return 1;
+}
+
+/* structural statistics of a global problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_global_problem_stats (struct fclib_global *problem, struct fclib_problem_stats *stats)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = global_problem_stats (problem, stats);
+
+  error_leave ();
+  return result;
+}
+
+/* reorder the contacts of a local problem */
+static int local_permute (struct fclib_local *problem, const int *perm)
+{
+  int sd = problem->spacedim, nc = problem->W->m / sd, *inv;
+
+  if (!(inv = contact_inverse (perm, nc, sd))) return 0;
+  error_keep (inv, release_memory, 1);
+
+  matrix_permute (problem->W, inv, inv);
+  if (problem->V) matrix_permute (problem->V, inv, NULL);
+  permute_blocks (problem->q, perm, nc, sd, 0);
+  permute_blocks (problem->mu, perm, nc, 1, 0);
+
+  error_drop (inv);
+  free (inv);
+
+  return 1;
+}
+
+/* reorder the contacts of a local problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_local_permute (struct fclib_local *problem, const int *perm)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = local_permute (problem, perm);
+
+  error_leave ();
+  return result;
+}
+
+/* reorder the contacts of a global problem */
+static int global_permute (struct fclib_global *problem, const int *perm)
+{
+  int sd = problem->spacedim, nc = problem->H->n / sd, *inv;
+
+  if (!(inv = contact_inverse (perm, nc, sd))) return 0;
+  error_keep (inv, release_memory, 1);
+
+  matrix_permute (problem->H, NULL, inv);
+  permute_blocks (problem->w, perm, nc, sd, 0);
+  permute_blocks (problem->mu, perm, nc, 1, 0);
+
+  error_drop (inv);
+  free (inv);
+
+  return 1;
+}
+
+/* reorder the contacts of a global problem;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_global_permute (struct fclib_global *problem, const int *perm)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = global_permute (problem, perm);
+
+  error_leave ();
+  return result;
+}
+
+/* permute the contact vectors of solutions */
+static int permute_solutions (int spacedim, int contacts, const int *perm, int inverse,
+                              struct fclib_solution *solutions, int count)
+{
+  int *inv, k;
+
+  if (!(inv = contact_inverse (perm, contacts, 1))) return 0;
+  free (inv);
+
+  for (k = 0; k < count; k ++)
+  {
+    if (solutions [k].u) permute_blocks (solutions [k].u, perm, contacts, spacedim, inverse);
+    if (solutions [k].r) permute_blocks (solutions [k].r, perm, contacts, spacedim, inverse);
+  }
+
+  return 1;
+}
+
+/* permute the contact vectors of solutions;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_permute_solutions (int spacedim, int contacts, const int *perm, int inverse,
+                                                           struct fclib_solution *solutions, int count)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = permute_solutions (spacedim, contacts, perm, inverse, solutions, count);
+
+  error_leave ();
+  return result;
+}
+
+/* check that the stored vector 'path' holds 'rows' rows of nc contacts of sd components;
+ * with perm, reorder the contacts of each row: x [k] = x [perm [k]] */
+static void permute_stored_vector (hid_t file_id, const char *path, int nc, int sd, int rows, const int *perm)
+{
+  size_t n = (size_t)nc*sd*rows;
+  hid_t dataset_id, space_id;
+  hssize_t size;
+  double *x;
+  int k;
+
+  IO (dataset_id = H5Dopen (file_id, path, H5P_DEFAULT));
+  IO (space_id = H5Dget_space (dataset_id));
+  IO (size = H5Sget_simple_extent_npoints (space_id));
+  IO (H5Sclose (space_id));
+  ASSERT ((size_t)size == n, "ERROR: %s has %lld elements, %d rows of %d contacts expected (corrupted file)", path, (long long)size, rows, nc);
+
+  if (perm && n > 0)
+  {
+    MM (x = (double*)FCLIB_MALLOC (sizeof(double)*n));
+    error_keep (x, release_memory, 1);
+    IO (FCLIB_H5DREAD (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, x));
+    for (k = 0; k < rows; k ++) permute_blocks (x + (size_t)k*nc*sd, perm, nc, sd, 0);
+    IO (FCLIB_H5DWRITE (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, x));
+    error_drop (x);
+    free (x);
+  }
+  IO (H5Dclose (dataset_id));
+}
+
+/* check the contact vectors u and r of the solution and the guesses stored in a file (perm == NULL),
+ * or reorder their contacts by perm */
+static void permute_stored_solutions (hid_t file_id, int nc, int sd, const int *perm)
+{
+  char path [128];
+  int count = 0, i;
+
+  if (H5 (H5Lexists (file_id, "/solution", H5P_DEFAULT)))
+  {
+    permute_stored_vector (file_id, "/solution/u", nc, sd, 1, perm);
+    permute_stored_vector (file_id, "/solution/r", nc, sd, 1, perm);
+  }
+
+  if (!H5 (H5Lexists (file_id, "/guesses/number_of_guesses", H5P_DEFAULT))) return;
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, "/guesses/number_of_guesses", &count));
+
+  if (H5 (H5Lexists (file_id, "/guesses/r", H5P_DEFAULT))) /* compact layout */
+  {
+    permute_stored_vector (file_id, "/guesses/u", nc, sd, count, perm);
+    permute_stored_vector (file_id, "/guesses/r", nc, sd, count, perm);
+  }
+  else for (i = 1; i <= count; i ++) /* per-guess group layout */
+  {
+    snprintf (path, sizeof (path), "/guesses/%d/u", i);
+    permute_stored_vector (file_id, path, nc, sd, 1, perm);
+    snprintf (path, sizeof (path), "/guesses/%d/r", i);
+    permute_stored_vector (file_id, path, nc, sd, 1, perm);
+  }
+}
+
+/* store a contact permutation with a problem in a file, reordering the stored solution and guesses with it;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_write_permutation (const char *path, int global, const int *perm, int flags)
+{
+  struct error_context ctx;
+  const char *group = (global ? "/fclib_global/vectors" : "/fclib_local/vectors");
+  hid_t  file_id, id;
+  int *inv, *old, *step, nc, sd, nv, nr, nl, k;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  file_id = file_open (path, FILE_UPDATE);
+  ASSERT (H5 (H5Lexists (file_id, global ? "/fclib_global" : "/fclib_local", H5P_DEFAULT)), "ERROR: no %s problem has been stored in %s",
+          global ? "global" : "local", path);
+  IO (FCLIB_H5LTREAD_DATASET_INT (file_id, global ? "/fclib_global/spacedim" : "/fclib_local/spacedim", &sd));
+  IO (id = H5Gopen (file_id, group, H5P_DEFAULT));
+  nc = stored_size (id, "mu");
+  ASSERT ((inv = contact_inverse (perm, nc, 1)), "ERROR: not a permutation of the %d stored contacts", nc);
+  free (inv);
+
+  /* the stored vectors follow the permutation stored before (the original order when none):
+   * contact k of the new order is contact inv [perm [k]] of the stored one */
+  MM (step = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  error_keep (step, release_memory, 1);
+  memcpy (step, perm, sizeof(int)*nc);
+  if (H5 (H5Lexists (id, "perm", H5P_DEFAULT)))
+  {
+    ASSERT (stored_size (id, "perm") == nc, "ERROR: size of the stored permutation differs from the number of contacts (corrupted file)");
+    MM (old = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+    error_keep (old, release_memory, 1);
+    read_dataset (id, "perm", H5T_NATIVE_INT, (hsize_t)nc, old);
+    ASSERT ((inv = contact_inverse (old, nc, 1)), "ERROR: the stored permutation is not a permutation (corrupted file)");
+    for (k = 0; k < nc; k ++) step [k] = inv [perm [k]];
+    free (inv);
+    error_drop (old);
+    free (old);
+  }
+
+  /* the stored solution and guesses are those of the global problem when there is one */
+  if (global || !H5 (H5Lexists (file_id, "/fclib_global", H5P_DEFAULT)))
+  {
+    read_nvnunrnl (file_id, &nv, &nr, &nl);
+    ASSERT (nr == nc*sd, "ERROR: %d contact components stored for %d contacts (corrupted file)", nr, nc);
+    permute_stored_solutions (file_id, nc, sd, NULL); /* check every size before writing anything */
+    permute_stored_solutions (file_id, nc, sd, step);
+  }
+  error_drop (step);
+  free (step);
+
+  if (H5 (H5Lexists (id, "perm", H5P_DEFAULT))) IO (H5Ldelete (id, "perm", H5P_DEFAULT));
+  write_dataset (id, "perm", H5T_NATIVE_INT, (hsize_t)nc, perm, flags);
+  IO (H5Gclose (id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* read the contact permutation stored with a problem in a file;
+ * return permutation on success, NULL on failure */
+FCLIB_STATIC int* FCLIB_APICOMPILE fclib_read_permutation (const char *path, int global)
+{
+  struct error_context ctx;
+  const char *group = (global ? "/fclib_global/vectors" : "/fclib_local/vectors");
+  hid_t  file_id, id;
+  int *perm, nc, size;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  file_id = file_open (path, FILE_READ);
+  ASSERT (H5 (H5Lexists (file_id, global ? "/fclib_global" : "/fclib_local", H5P_DEFAULT)), "ERROR: no %s problem has been stored in %s",
+          global ? "global" : "local", path);
+  IO (id = H5Gopen (file_id, group, H5P_DEFAULT));
+  ASSERT (H5 (H5Lexists (id, "perm", H5P_DEFAULT)), "ERROR: no contact permutation of the %s problem has been stored in %s",
+          global ? "global" : "local", path);
+  nc = stored_size (id, "mu");
+  size = stored_size (id, "perm");
+  ASSERT (size == nc, "ERROR: size of the stored permutation differs from the number of contacts: %d != %d", size, nc);
+  MM (perm = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  error_keep (perm, release_memory, 1);
+  read_dataset (id, "perm", H5T_NATIVE_INT, (hsize_t)nc, perm);
+  IO (H5Gclose (id));
+  IO (H5Fclose (file_id));
+
+  error_drop (perm);
+  error_leave ();
+  return perm;
+}
+
+/* thread count and thread number of the parallel kernels */
+#ifdef _OPENMP
+#define THREADS(Requested) ((Requested) > 0 ? (Requested) : omp_get_max_threads ())
+#define THREAD_NUM omp_get_thread_num ()
+#else
+#define THREADS(Requested) 1
+#define THREAD_NUM 0
+#endif
+
+/* wall clock time in seconds (processor time without OpenMP) */
+static double wall_time (void)
+{
+#ifdef _OPENMP
+  return omp_get_wtime ();
+#else
+  return (double) clock () / (double) CLOCKS_PER_SEC;
+#endif
+}
+
+/* copy problem info */
+static struct fclib_info* problem_info_copy (struct fclib_info *info)
+{
+  struct fclib_info *copy;
+  char **str [3];
+  int k;
+
+  if (!info) return NULL;
+
+  MM (copy = (struct fclib_info*)FCLIB_MALLOC (sizeof (struct fclib_info)));
+  *copy = *info;
+  str [0] = &copy->title;
+  str [1] = &copy->description;
+  str [2] = &copy->math_info;
+  for (k = 0; k < 3; k ++)
+    if (*str [k])
+    {
+      char *c;
+      MM (c = (char*)FCLIB_MALLOC (strlen (*str [k]) + 1));
+      strcpy (c, *str [k]);
+      *str [k] = c;
+    }
+
+  return copy;
+}
+
+/* start of the diagonal blocks of a square compressed column matrix, such that no entry couples
+ * two blocks; returns the number of blocks, the block starts are in start [0..nblocks] */
+static int matrix_diagonal_blocks (struct fclib_matrix *csc, int *start)
+{
+  int nblocks = 0, end = -1, *reach, i, j, k;
+
+  /* reach [j] is the farthest row or column coupled to j */
+  MM (reach = (int*)FCLIB_MALLOC (sizeof(int)*(csc->n > 0 ? csc->n : 1)));
+  for (j = 0; j < csc->n; j ++) reach [j] = j;
+  for (j = 0; j < csc->n; j ++)
+    for (k = csc->p [j]; k < csc->p [j+1]; k ++)
+    {
+      i = csc->i [k];
+      if (i > reach [j]) reach [j] = i;
+      if (j > reach [i]) reach [i] = j;
+    }
+
+  start [0] = 0;
+  for (j = 0; j < csc->n; j ++)
+  {
+    if (reach [j] > end) end = reach [j];
+    if (end == j) start [++ nblocks] = j+1;
+  }
+  free (reach);
+
+  return nblocks;
+}
+
+/* y += A x for a dense row major n x n block; the common block sizes are unrolled by the compiler */
+static void block_gemv (int n, const double *a, const double *x, double *y)
+{
+  int r, c;
+
+  if (n == 3)
+  {
+    for (r = 0; r < 3; r ++, a += 3) y [r] += a [0]*x [0] + a [1]*x [1] + a [2]*x [2];
+  }
+  else if (n == 6)
+  {
+    for (r = 0; r < 6; r ++, a += 6) y [r] += a [0]*x [0] + a [1]*x [1] + a [2]*x [2] + a [3]*x [3] + a [4]*x [4] + a [5]*x [5];
+  }
+  else
+  {
+    for (r = 0; r < n; r ++, a += n)
+    {
+      double sum = 0.0;
+      for (c = 0; c < n; c ++) sum += a [c]*x [c];
+      y [r] += sum;
+    }
+  }
+}
+
+/* explicit inverse of a dense symmetric positive definite n x n block through its Cholesky factor,
+ * computed in the lower triangle of work; return 1 on success, 0 if the block is not positive definite */
+static int block_inverse (int n, const double *a, double *inv, double *work)
+{
+  int r, c, k;
+
+  memcpy (work, a, sizeof(double)*n*n);
+  for (c = 0; c < n; c ++)
+  {
+    for (k = 0; k < c; k ++) work [c*n+c] -= work [c*n+k] * work [c*n+k];
+    if (work [c*n+c] <= 0.0) return 0;
+    work [c*n+c] = sqrt (work [c*n+c]);
+    for (r = c+1; r < n; r ++)
+    {
+      for (k = 0; k < c; k ++) work [r*n+c] -= work [r*n+k] * work [c*n+k];
+      work [r*n+c] /= work [c*n+c];
+    }
+  }
+
+  for (c = 0; c < n; c ++) /* solve L L^T x = e_c into column c */
+  {
+    for (r = 0; r < n; r ++)
+    {
+      double x = (r == c ? 1.0 : 0.0);
+      for (k = 0; k < r; k ++) x -= work [r*n+k] * inv [k*n+c];
+      inv [r*n+c] = x / work [r*n+r];
+    }
+    for (r = n-1; r >= 0; r --)
+    {
+      double x = inv [r*n+c];
+      for (k = r+1; k < n; k ++) x -= work [k*n+r] * inv [k*n+c];
+      inv [r*n+c] = x / work [r*n+r];
+    }
+  }
+
+  return 1;
+}
+
+/* y += M x with the dense blocks of a block-diagonal matrix */
+static void block_diagonal_gaxpy (struct fclib_block_diagonal *bd, const double *blocks, const double *x, double *y)
+{
+  int b;
+
+#pragma omp parallel for if (bd->start [bd->nblocks] > FCLIB_PARALLEL_MIN)
+  for (b = 0; b < bd->nblocks; b ++)
+    block_gemv (bd->start [b+1] - bd->start [b], blocks + bd->offset [b], x + bd->start [b], y + bd->start [b]);
+}
+
+/* up-looking sparse Cholesky factorization of a compressed column matrix with sorted indices,
+ * of which the upper triangle is used, into a lower triangular compressed column factor
+ * with the diagonal first in each column; parent receives the elimination tree.
+ * return the factor on success; NULL if the matrix is not positive definite */
+static struct fclib_matrix* cholesky_sparse (struct fclib_matrix *csc, int *parent)
+{
+  struct fclib_matrix *L;
+  int n = csc->n, *ancestor, *c, *stack, *mark, top, len, i, j, k, q;
+  double *x, d, lki;
+
+  MM (ancestor = (int*)FCLIB_MALLOC (sizeof(int)*(n > 0 ? n : 1)));
+  MM (c = (int*)FCLIB_CALLOC (n+1, sizeof(int)));
+  MM (stack = (int*)FCLIB_MALLOC (sizeof(int)*(n > 0 ? n : 1)));
+  MM (mark = (int*)FCLIB_MALLOC (sizeof(int)*(n > 0 ? n : 1)));
+  MM (x = (double*)FCLIB_CALLOC (n > 0 ? n : 1, sizeof(double)));
+
+  /* elimination tree, with path compression through ancestor */
+  for (k = 0; k < n; k ++)
+  {
+    parent [k] = ancestor [k] = -1;
+    for (q = csc->p [k]; q < csc->p [k+1]; q ++)
+      for (i = csc->i [q]; i != -1 && i < k; i = j)
+      {
+        j = ancestor [i];
+        ancestor [i] = k;
+        if (j == -1) parent [i] = k;
+      }
+  }
+
+  /* the nonzero pattern of row k of L is the subtree of the elimination tree reached from
+   * the entries of column k above the diagonal; it is pushed on stack [top..n-1] */
+#define ROW_PATTERN(K)\
+  do {\
+    top = n; mark [K] = K;\
+    for (q = csc->p [K]; q < csc->p [K+1]; q ++)\
+    {\
+      i = csc->i [q];\
+      if (i > K) continue;\
+      for (len = 0; mark [i] != K; i = parent [i]) { stack [len ++] = i; mark [i] = K; }\
+      while (len > 0) stack [-- top] = stack [-- len];\
+    }\
+  } while (0)
+
+  /* column counts */
+  for (k = 0; k < n; k ++) mark [k] = -1;
+  for (k = 0; k < n; k ++)
+  {
+    ROW_PATTERN (k);
+    for (q = top; q < n; q ++) c [stack [q]] ++;
+    c [k] ++;
+  }
+  L = matrix_alloc (n, n, 0, -1, 0);
+  cumsum (c, n);
+  memcpy (L->p, c, sizeof(int)*(n+1));
+  L->nzmax = L->p [n];
+  free (L->i);
+  free (L->x);
+  MM (L->i = (int*)FCLIB_MALLOC (sizeof(int)*(L->nzmax > 0 ? L->nzmax : 1)));
+  MM (L->x = (double*)FCLIB_MALLOC (sizeof(double)*(L->nzmax > 0 ? L->nzmax : 1)));
+
+  /* numerical factorization, row by row; c [j] is the next free position of column j */
+  for (k = 0; k < n; k ++) mark [k] = -1;
+  for (k = 0; k < n; k ++)
+  {
+    ROW_PATTERN (k);
+    for (q = csc->p [k]; q < csc->p [k+1]; q ++)
+      if (csc->i [q] <= k) x [csc->i [q]] += csc->x [q];
+    d = x [k];
+    x [k] = 0.0;
+    for (; top < n; top ++)
+    {
+      i = stack [top];
+      lki = x [i] / L->x [L->p [i]];
+      x [i] = 0.0;
+      for (q = L->p [i]+1; q < c [i]; q ++) x [L->i [q]] -= L->x [q] * lki;
+      d -= lki * lki;
+      q = c [i] ++;
+      L->i [q] = k;
+      L->x [q] = lki;
+    }
+    if (d <= 0.0) break;
+    q = c [k] ++;
+    L->i [q] = k;
+    L->x [q] = sqrt (d);
+  }
+#undef ROW_PATTERN
+
+  free (ancestor);
+  free (c);
+  free (stack);
+  free (mark);
+  free (x);
+
+  if (k < n)
+  {
+    delete_matrix (L);
+    return NULL;
+  }
+
+  return L;
+}
+
+/* solve L y = b for a sparse b with entries bi [0..bn) and values bx (NULL to compute the
+ * pattern only); y is accumulated in the dense x, which must be zero on entry. The pattern of y,
+ * in topological order, is returned in stack [top..n-1]; mark must be zero on entry and is reset */
+static int lsolve_sparse (struct fclib_matrix *L, int *parent, int *bi, double *bx, int bn, double *x, char *mark, int *stack)
+{
+  int n = L->n, top = n, len, i, j, k;
+
+  for (k = 0; k < bn; k ++)
+  {
+    for (len = 0, i = bi [k]; i != -1 && !mark [i]; i = parent [i])
+    {
+      stack [len ++] = i;
+      mark [i] = 1;
+    }
+    while (len > 0) stack [-- top] = stack [-- len];
+    if (bx) x [bi [k]] += bx [k];
+  }
+
+  for (k = top; k < n; k ++)
+  {
+    j = stack [k];
+    mark [j] = 0;
+    if (!bx) continue;
+    x [j] /= L->x [L->p [j]];
+    for (i = L->p [j]+1; i < L->p [j+1]; i ++) x [L->i [i]] -= L->x [i] * x [j];
+  }
+
+  return top;
+}
+
+/* find the block-diagonal structure of a matrix */
+static struct fclib_block_diagonal* matrix_analyze (struct fclib_matrix *mat, int max_block_size)
+{
+  struct fclib_block_diagonal *bd;
+  struct fclib_matrix *csc;
+  int fail = 0, memory = 0, b, j, k;
+
+  if (mat->m != mat->n)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: a block-diagonal matrix must be square => %d x %d", mat->m, mat->n);
+    return NULL;
+  }
+
+  csc = matrix_convert (mat, -1);
+  if (!csc) return NULL;
+  error_keep (csc, release_matrix, 1);
+
+  MM (bd = (struct fclib_block_diagonal*)FCLIB_CALLOC (1, sizeof (struct fclib_block_diagonal)));
+  error_keep (bd, release_block_diagonal, 1);
+  MM (bd->start = (int*)FCLIB_MALLOC (sizeof(int)*(mat->n+1)));
+  bd->nblocks = matrix_diagonal_blocks (csc, bd->start);
+  for (bd->bs = (bd->nblocks ? bd->start [1] : 0), b = 0; b < bd->nblocks; b ++)
+  {
+    int size = bd->start [b+1] - bd->start [b];
+    if (size > bd->maxbs) bd->maxbs = size;
+    if (size != bd->bs) bd->bs = 0;
+  }
+
+  if (bd->maxbs <= (max_block_size > 0 ? max_block_size : 64))
+  {
+    MM (bd->offset = (int*)FCLIB_MALLOC (sizeof(int)*(bd->nblocks+1)));
+    for (bd->offset [0] = b = 0; b < bd->nblocks; b ++)
+      bd->offset [b+1] = bd->offset [b] + (bd->start [b+1] - bd->start [b]) * (bd->start [b+1] - bd->start [b]);
+    MM (bd->blocks = (double*)FCLIB_CALLOC (bd->offset [bd->nblocks] > 0 ? bd->offset [bd->nblocks] : 1, sizeof(double)));
+    MM (bd->inverse = (double*)FCLIB_MALLOC (sizeof(double)*(bd->offset [bd->nblocks] > 0 ? bd->offset [bd->nblocks] : 1)));
+
+    /* a failed allocation in a thread is raised after the loop, on the calling thread */
+#pragma omp parallel for private(j, k) reduction(|:fail, memory) schedule(dynamic, 64) if (csc->p [csc->n] > FCLIB_PARALLEL_MIN)
+    for (b = 0; b < bd->nblocks; b ++)
+    {
+      int s = bd->start [b], n = bd->start [b+1] - s;
+      double *a = bd->blocks + bd->offset [b], work [64*64], *w = work;
+
+      for (j = s; j < s+n; j ++)
+        for (k = csc->p [j]; k < csc->p [j+1]; k ++) a [(csc->i [k]-s)*n + j-s] += csc->x [k];
+
+      if (n > 64 && !(w = (double*)FCLIB_MALLOC (sizeof(double)*n*n))) memory = 1;
+      else if (!block_inverse (n, a, bd->inverse + bd->offset [b], w)) fail = 1;
+      if (w && w != work) free (w);
+    }
+    if (memory) FAIL (FCLIB_ERROR_MEMORY, "ERROR: out of memory");
+
+    if (fail)
+    {
+      free (bd->inverse);
+      bd->inverse = NULL;
+    }
+  }
+
+  error_drop (bd);
+  error_drop (csc);
+  delete_matrix (csc);
+
+  return bd;
+}
+
+/* find the block-diagonal structure of a matrix;
+ * return structure on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_block_diagonal* fclib_matrix_analyze (struct fclib_matrix *mat, int max_block_size)
+{
+  struct error_context ctx;
+  struct fclib_block_diagonal *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = matrix_analyze (mat, max_block_size);
+
+  error_leave ();
+  return result;
+}
+
+/* delete block-diagonal structure */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_block_diagonal (struct fclib_block_diagonal *bd)
+{
+  if (bd)
+  {
+    free (bd->start);
+    free (bd->offset);
+    free (bd->blocks);
+    free (bd->inverse);
+    free (bd);
+  }
+}
+
+/* reduce a global problem to a local one */
+static struct fclib_local* global_to_local (struct fclib_global *problem, struct fclib_reduction_options *options)
+{
+  struct fclib_reduction_options defaults = {0, 0, 0, NULL};
+  struct fclib_block_diagonal *bd;
+  struct fclib_matrix *B [2], *BG, *left, *right, *rows, *K;
+  struct fclib_local *local;
+  int n, m, p, nc, threads, *iwork, j, k;
+  double *z, *work;
+
+  if (!options) options = &defaults;
+  threads = THREADS (options->threads);
+  n = problem->M->n;
+  m = problem->H->n;
+  p = (problem->G ? problem->G->n : 0);
+
+  if (problem->M->m != n || problem->H->m != n || (problem->G && problem->G->m != n))
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: inconsistent dimensions of M (%d x %d), H (%d x %d) and G", problem->M->m, n, problem->H->m, m);
+    return NULL;
+  }
+
+  /* BG = [H G] in compressed columns */
+  B [0] = matrix_convert (problem->H, -1);
+  error_keep (B [0], release_matrix, 1);
+  B [1] = (p ? matrix_convert (problem->G, -1) : NULL);
+  if (p) error_keep (B [1], release_matrix, 1);
+  BG = matrix_alloc (n, m+p, B [0]->p [m] + (p ? B [1]->p [p] : 0), -1, 0);
+  error_keep (BG, release_matrix, 1);
+  memcpy (BG->p, B [0]->p, sizeof(int)*(m+1));
+  memcpy (BG->i, B [0]->i, sizeof(int)*B [0]->p [m]);
+  memcpy (BG->x, B [0]->x, sizeof(double)*B [0]->p [m]);
+  for (j = 0; j < p; j ++) BG->p [m+j+1] = BG->p [m] + B [1]->p [j+1];
+  if (p) memcpy (BG->i + BG->p [m], B [1]->i, sizeof(int)*B [1]->p [p]);
+  if (p) memcpy (BG->x + BG->p [m], B [1]->x, sizeof(double)*B [1]->p [p]);
+  error_drop (B [1]);
+  error_drop (B [0]);
+  delete_matrix (B [0]);
+  delete_matrix (B [1]);
+  MM (z = (double*)FCLIB_MALLOC (sizeof(double)*(n > 0 ? n : 1)));
+  error_keep (z, release_memory, 1);
+
+  bd = (options->M_blocks ? options->M_blocks : matrix_analyze (problem->M, options->max_block_size));
+  if (bd && bd != options->M_blocks) error_keep (bd, release_block_diagonal, 1);
+  if (bd && bd->inverse && bd->maxbs <= (options->max_block_size > 0 ? options->max_block_size : 64))
+  {
+    /* block-diagonal M: K = BG^T X with X = M^-1 BG, which is dense in every block hit by a column of BG */
+    int *block, nb = (bd->nblocks > 0 ? bd->nblocks : 1);
+
+    MM (block = (int*)FCLIB_MALLOC (sizeof(int)*(n > 0 ? n : 1)));
+    error_keep (block, release_memory, 1);
+    for (j = 0; j < bd->nblocks; j ++)
+      for (k = bd->start [j]; k < bd->start [j+1]; k ++) block [k] = j;
+
+    /* the work arrays of all threads are allocated here, where a failure can be raised */
+    MM (work = (double*)FCLIB_CALLOC ((size_t)threads*(n > 0 ? n : 1), sizeof(double)));
+    error_keep (work, release_memory, 1);
+    MM (iwork = (int*)FCLIB_MALLOC (sizeof(int)*2*(size_t)threads*nb));
+    error_keep (iwork, release_memory, 1);
+    right = matrix_alloc (n, m+p, 0, -1, 0);
+    error_keep (right, release_matrix, 1);
+    for (k = 0; k < 2; k ++)
+    {
+#pragma omp parallel num_threads(threads)
+      {
+        double *x = work + (size_t)THREAD_NUM*(n > 0 ? n : 1);
+        int *mark = iwork + 2*(size_t)THREAD_NUM*nb, *list = mark + nb, len, b, c, q;
+
+        for (b = 0; b < nb; b ++) mark [b] = 0;
+
+#pragma omp for schedule(dynamic, 64)
+        for (j = 0; j < m+p; j ++)
+        {
+          for (len = 0, q = BG->p [j]; q < BG->p [j+1]; q ++)
+          {
+            b = block [BG->i [q]];
+            if (mark [b] != j+1)
+            {
+              mark [b] = j+1;
+              list [len ++] = b;
+            }
+            x [BG->i [q]] += BG->x [q];
+          }
+
+          if (k == 0) for (right->p [j] = c = 0; c < len; c ++) right->p [j] += bd->start [list [c]+1] - bd->start [list [c]];
+          else
+            for (q = right->p [j], c = 0; c < len; c ++)
+            {
+              int s = bd->start [list [c]], size = bd->start [list [c]+1] - s, r;
+
+              for (r = 0; r < size; r ++)
+              {
+                right->i [q+r] = s+r;
+                right->x [q+r] = 0.0;
+              }
+              block_gemv (size, bd->inverse + bd->offset [list [c]], x + s, right->x + q);
+              q += size;
+            }
+
+          for (q = BG->p [j]; q < BG->p [j+1]; q ++) x [BG->i [q]] = 0.0;
+        }
+      }
+
+      if (k == 0)
+      {
+        cumsum (right->p, m+p);
+        right->nzmax = right->p [m+p];
+        free (right->i);
+        MM (right->i = (int*)FCLIB_MALLOC (sizeof(int)*(right->nzmax > 0 ? right->nzmax : 1)));
+        free (right->x);
+        MM (right->x = (double*)FCLIB_MALLOC (sizeof(double)*(right->nzmax > 0 ? right->nzmax : 1)));
+      }
+    }
+    error_drop (iwork);
+    error_drop (work);
+    error_drop (block);
+    free (work);
+    free (iwork);
+    free (block);
+
+    /* z = M^-1 f */
+    memset (z, 0, sizeof(double)*n);
+    block_diagonal_gaxpy (bd, bd->inverse, problem->f, z);
+    left = BG;
+  }
+  else
+  {
+    /* general M = L L^T: K = Y^T Y with Y = L^-1 BG computed by sparse triangular solves */
+    struct fclib_matrix *M, *L;
+    int *parent;
+    char *marks;
+
+    M = matrix_convert (problem->M, -1);
+    error_keep (M, release_matrix, 1);
+    matrix_canonicalize (M);
+    MM (parent = (int*)FCLIB_MALLOC (sizeof(int)*(n > 0 ? n : 1)));
+    error_keep (parent, release_memory, 1);
+    L = cholesky_sparse (M, parent);
+    if (!L) FAIL (FCLIB_ERROR_INVALID, "ERROR: the matrix M is not positive definite");
+    error_keep (L, release_matrix, 1);
+    error_drop (M);
+    delete_matrix (M);
+
+    /* the work arrays of all threads, left zero by the triangular solves */
+    MM (work = (double*)FCLIB_CALLOC ((size_t)threads*(n > 0 ? n : 1), sizeof(double)));
+    error_keep (work, release_memory, 1);
+    MM (marks = (char*)FCLIB_CALLOC ((size_t)threads*(n > 0 ? n : 1), 1));
+    error_keep (marks, release_memory, 1);
+    MM (iwork = (int*)FCLIB_MALLOC (sizeof(int)*(size_t)threads*(n > 0 ? n : 1)));
+    error_keep (iwork, release_memory, 1);
+    left = matrix_alloc (n, m+p, 0, -1, 0);
+    error_keep (left, release_matrix, 1);
+    for (k = 0; k < 2; k ++) /* the patterns first, then the values */
+    {
+#pragma omp parallel num_threads(threads)
+      {
+        double *x = work + (size_t)THREAD_NUM*(n > 0 ? n : 1);
+        char *mark = marks + (size_t)THREAD_NUM*(n > 0 ? n : 1);
+        int *stack = iwork + (size_t)THREAD_NUM*(n > 0 ? n : 1), top, q;
+
+#pragma omp for schedule(dynamic, 64)
+        for (j = 0; j < m+p; j ++)
+        {
+          top = lsolve_sparse (L, parent, BG->i + BG->p [j], k ? BG->x + BG->p [j] : NULL, BG->p [j+1] - BG->p [j], x, mark, stack);
+          if (k == 0) left->p [j] = n - top;
+          else
+            for (q = left->p [j]; top < n; top ++, q ++)
+            {
+              left->i [q] = stack [top];
+              left->x [q] = x [stack [top]];
+              x [stack [top]] = 0.0;
+            }
+        }
+      }
+
+      if (k == 0)
+      {
+        cumsum (left->p, m+p);
+        left->nzmax = left->p [m+p];
+        free (left->i);
+        MM (left->i = (int*)FCLIB_MALLOC (sizeof(int)*(left->nzmax > 0 ? left->nzmax : 1)));
+        free (left->x);
+        MM (left->x = (double*)FCLIB_MALLOC (sizeof(double)*(left->nzmax > 0 ? left->nzmax : 1)));
+      }
+    }
+    error_drop (iwork);
+    error_drop (marks);
+    error_drop (work);
+    free (work);
+    free (marks);
+    free (iwork);
+
+    /* z = L^-1 f */
+    memcpy (z, problem->f, sizeof(double)*n);
+    for (j = 0; j < n; j ++)
+    {
+      z [j] /= L->x [L->p [j]];
+      for (k = L->p [j]+1; k < L->p [j+1]; k ++) z [L->i [k]] -= L->x [k] * z [j];
+    }
+
+    error_drop (L);
+    error_drop (parent);
+    error_drop (BG);
+    delete_matrix (L);
+    delete_matrix (BG);
+    free (parent);
+    right = left;
+  }
+  if (bd != options->M_blocks)
+  {
+    error_drop (bd);
+    fclib_delete_block_diagonal (bd);
+  }
+
+  /* K = left^T right on the pattern of the needed blocks W (upper triangle if symmetric), V and R;
+   * column j of K accumulates the rows of left, stored in compressed rows, hit by column j of right */
+  rows = matrix_compress (left, -2);
+  error_keep (rows, release_matrix, 1);
+  K = matrix_alloc (m+p, m+p, 0, -1, 0);
+  error_keep (K, release_matrix, 1);
+
+  MM (work = (double*)FCLIB_CALLOC ((size_t)threads*(m+p > 0 ? m+p : 1), sizeof(double)));
+  error_keep (work, release_memory, 1);
+  MM (iwork = (int*)FCLIB_MALLOC (sizeof(int)*2*(size_t)threads*(m+p > 0 ? m+p : 1)));
+  error_keep (iwork, release_memory, 1);
+  for (k = 0; k < 2; k ++)
+  {
+#pragma omp parallel num_threads(threads)
+    {
+      double *acc = work + (size_t)THREAD_NUM*(m+p > 0 ? m+p : 1);
+      int *mark = iwork + 2*(size_t)THREAD_NUM*(m+p > 0 ? m+p : 1), *list = mark + (m+p > 0 ? m+p : 1), len, a, c, q, r;
+
+      for (a = 0; a < m+p; a ++) mark [a] = 0;
+
+#pragma omp for schedule(dynamic, 64)
+      for (j = 0; j < m+p; j ++)
+      {
+        int last = (j < m ? (options->symmetric ? j : m-1) : m+p-1);
+
+        for (len = 0, q = right->p [j]; q < right->p [j+1]; q ++)
+          for (r = rows->p [right->i [q]]; r < rows->p [right->i [q]+1]; r ++)
+          {
+            a = rows->i [r];
+            if (a > last) break; /* sorted rows */
+            if (mark [a] != j+1)
+            {
+              mark [a] = j+1;
+              list [len ++] = a;
+            }
+            acc [a] += rows->x [r] * right->x [q];
+          }
+
+        if (k == 0) K->p [j] = len;
+        else
+        {
+          for (q = K->p [j], c = 0; c < len; c ++, q ++) K->i [q] = list [c];
+          sort_pairs (K->i + K->p [j], K->x + K->p [j], len);
+          for (q = K->p [j]; q < K->p [j+1]; q ++) K->x [q] = acc [K->i [q]];
+        }
+        for (c = 0; c < len; c ++) acc [list [c]] = 0.0;
+      }
+    }
+
+    if (k == 0)
+    {
+      cumsum (K->p, m+p);
+      K->nzmax = K->p [m+p];
+      free (K->i);
+      MM (K->i = (int*)FCLIB_MALLOC (sizeof(int)*(K->nzmax > 0 ? K->nzmax : 1)));
+      free (K->x);
+      MM (K->x = (double*)FCLIB_MALLOC (sizeof(double)*(K->nzmax > 0 ? K->nzmax : 1)));
+    }
+  }
+  error_drop (iwork);
+  error_drop (work);
+  error_drop (rows);
+  free (work);
+  free (iwork);
+  delete_matrix (rows);
+  if (right != left)
+  {
+    error_drop (right);
+    delete_matrix (right);
+  }
+
+  MM (local = (struct fclib_local*)FCLIB_CALLOC (1, sizeof (struct fclib_local)));
+  error_keep (local, release_local, 1);
+  local->spacedim = problem->spacedim;
+  local->info = problem_info_copy (problem->info);
+  nc = (problem->spacedim > 0 ? m / problem->spacedim : 0);
+  MM (local->mu = (double*)FCLIB_MALLOC (sizeof(double)*(nc > 0 ? nc : 1)));
+  memcpy (local->mu, problem->mu, sizeof(double)*nc);
+
+  /* q = left_H^T z + w, s = left_G^T z + b */
+  MM (local->q = (double*)FCLIB_MALLOC (sizeof(double)*(m > 0 ? m : 1)));
+  local->s = NULL;
+  if (p) MM (local->s = (double*)FCLIB_MALLOC (sizeof(double)*p));
+#pragma omp parallel for private(k) num_threads(threads) if (left->nzmax > FCLIB_PARALLEL_MIN)
+  for (j = 0; j < m+p; j ++)
+  {
+    double sum = (j < m ? (problem->w ? problem->w [j] : 0.0) : (problem->b ? problem->b [j-m] : 0.0));
+    for (k = left->p [j]; k < left->p [j+1]; k ++) sum += left->x [k] * z [left->i [k]];
+    if (j < m) local->q [j] = sum;
+    else local->s [j-m] = sum;
+  }
+  error_drop (z);
+  error_drop (left);
+  delete_matrix (left);
+  free (z);
+
+  /* split K into W, V and R */
+  local->W = matrix_alloc (m, m, K->p [m], options->symmetric ? -4 : -1, 0);
+  memcpy (local->W->p, K->p, sizeof(int)*(m+1));
+  memcpy (local->W->i, K->i, sizeof(int)*K->p [m]);
+  memcpy (local->W->x, K->x, sizeof(double)*K->p [m]);
+  local->V = local->R = NULL;
+  if (p)
+  {
+    local->V = matrix_alloc (m, p, K->p [m+p] - K->p [m], -1, 0);
+    local->R = matrix_alloc (p, p, K->p [m+p] - K->p [m], -1, 0);
+    local->V->p [0] = local->R->p [0] = 0;
+    for (j = 0; j < p; j ++)
+    {
+      int *lv = local->V->p, *lr = local->R->p;
+
+      lv [j+1] = lv [j];
+      lr [j+1] = lr [j];
+      for (k = K->p [m+j]; k < K->p [m+j+1]; k ++)
+      {
+        if (K->i [k] < m)
+        {
+          local->V->i [lv [j+1]] = K->i [k];
+          local->V->x [lv [j+1] ++] = K->x [k];
+        }
+        else
+        {
+          local->R->i [lr [j+1]] = K->i [k] - m;
+          local->R->x [lr [j+1] ++] = K->x [k];
+        }
+      }
+    }
+    local->V->nzmax = local->V->p [p];
+    local->R->nzmax = local->R->p [p];
+  }
+  error_drop (K);
+  delete_matrix (K);
+  error_drop (local);
+
+  return local;
+}
+
+/* reduce a global problem to a local one;
+ * return local problem on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_global_to_local (struct fclib_global *problem, struct fclib_reduction_options *options)
+{
+  struct error_context ctx;
+  struct fclib_local *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = global_to_local (problem, options);
+
+  error_leave ();
+  return result;
+}
+
+/* number of bodies of a slab of fclib_generate_write_global */
+#define FCLIB_SCENE_SLAB (1 << 16)
+
+/* number of elements of a chunk of the extendible datasets of fclib_generate_write_global */
+#define FCLIB_SCENE_CHUNK (1 << 16)
+
+/* largest number of contacts of a body with bodies of lower index or the ground */
+#define FCLIB_SCENE_SLOTS 6
+
+/* generated scene: body x + nx (y + ny z) sits at (x, y, z) of an nx x ny x nz lattice */
+struct scene
+{
+  int kind, nx, ny, nz, bodies;
+  double mu, step;
+  unsigned long long seed;
+};
+
+/* rigid body of a scene */
+struct scene_body
+{
+  double x [3]; /* centre */
+  double h [3]; /* radius (spheres) or half sizes (boxes) */
+  double yaw;   /* rotation about z (boxes) */
+  double m;     /* mass */
+  double J [9]; /* inertia in the global frame, row major */
+};
+
+/* contact of body a with a body b < a, or with the ground (b = -1) */
+struct scene_contact
+{
+  int a, b;
+  double p [3]; /* point */
+  double n [3]; /* normal, pointing from b to a */
+  double gap;   /* normal gap, negative for an overlap */
+};
+
+/* bodies [b0, b0+bodies) of a scene with the contacts they own (those with lower bodies);
+ * the pointers are exclusive sums starting from 0 */
+struct scene_slab
+{
+  int b0, bodies, contacts;
+  int *cp;        /* contacts per body, size bodies+1 */
+  int *mp, *mi;   /* compressed columns of the M columns of the bodies, mp of size 6 bodies+1 */
+  double *mx;
+  int *hp, *hi;   /* compressed columns of the H columns of the contacts, hp of size 3 contacts+1 */
+  double *hx;
+  double *f, *w, *mu;
+};
+
+/* random number in [0, 1) of a seed and a key (splitmix64), independent of the evaluation order */
+static double scene_random (unsigned long long seed, unsigned long long key)
+{
+  unsigned long long z = seed + 0x9E3779B97F4A7C15ULL * (key + 1);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+
+  return (double) (z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* lattice size of a scene from the options; return 1 on success, 0 on failure */
+static int scene_setup (struct fclib_generator_options *options, struct scene *s)
+{
+  double contacts = (options->contacts > 0 ? options->contacts : 1000), per, side;
+
+  s->kind = options->scene;
+  s->mu = (options->mu > 0.0 ? options->mu : 0.3);
+  s->step = (options->step > 0.0 ? options->step : 0.01);
+  s->seed = options->seed;
+
+  switch (s->kind) /* contacts per body and lattice side */
+  {
+  case FCLIB_SCENE_SPHERES: per = 3.0, side = cbrt (contacts / per); break;
+  case FCLIB_SCENE_BOXES: per = 4.0, side = cbrt (contacts / per); break;
+  case FCLIB_SCENE_COLUMN: per = 6.0, side = cbrt (contacts / (4.0 * per)); break; /* four times taller than wide */
+  default:
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown scene => %d", s->kind);
+    return 0;
+  }
+
+  s->nx = s->ny = (int) (side + 0.5);
+  if (s->nx < (s->kind == FCLIB_SCENE_COLUMN ? 2 : 1)) s->nx = s->ny = (s->kind == FCLIB_SCENE_COLUMN ? 2 : 1);
+  s->nz = (int) (contacts / per / ((double) s->nx * s->ny) + 0.5);
+  if (s->nz < 1) s->nz = 1;
+
+  if ((double) s->nx * s->ny * s->nz * per * 36.0 > 2147483647.0) /* entries of H */
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: too many contacts for 32-bit indices => %d", options->contacts);
+    return 0;
+  }
+  s->bodies = s->nx * s->ny * s->nz;
+
+  return 1;
+}
+
+/* geometry, mass and inertia of body b */
+static void scene_body (const struct scene *s, int b, struct scene_body *B)
+{
+  int x = b % s->nx, y = (b / s->nx) % s->ny, z = b / (s->nx * s->ny);
+  unsigned long long key = 16ULL * (unsigned long long) b;
+  double rho = 1.0 + 0.2 * (scene_random (s->seed, key) - 0.5), jitter [3];
+  int k;
+
+  for (k = 0; k < 3; k ++) jitter [k] = 1e-3 * (scene_random (s->seed, key+1+k) - 0.5);
+  for (k = 0; k < 9; k ++) B->J [k] = 0.0;
+  B->yaw = 0.0;
+
+  if (s->kind == FCLIB_SCENE_BOXES) /* stacks 1.5 apart of boxes 0.5 high */
+  {
+    double c, sn, I [3];
+
+    B->h [0] = 0.5 * (1.0 + 0.2 * (scene_random (s->seed, key+4) - 0.5));
+    B->h [1] = 0.5 * (1.0 + 0.2 * (scene_random (s->seed, key+5) - 0.5));
+    B->h [2] = 0.25;
+    B->yaw = 0.2 * (scene_random (s->seed, key+6) - 0.5);
+    B->x [0] = 1.5 * x + jitter [0];
+    B->x [1] = 1.5 * y + jitter [1];
+    B->x [2] = 0.25 + 0.5 * z + jitter [2];
+    B->m = rho * 8.0 * B->h [0] * B->h [1] * B->h [2];
+    I [0] = B->m / 3.0 * (B->h [1] * B->h [1] + B->h [2] * B->h [2]);
+    I [1] = B->m / 3.0 * (B->h [0] * B->h [0] + B->h [2] * B->h [2]);
+    I [2] = B->m / 3.0 * (B->h [0] * B->h [0] + B->h [1] * B->h [1]);
+    c = cos (B->yaw);
+    sn = sin (B->yaw);
+    B->J [0] = c * c * I [0] + sn * sn * I [1];
+    B->J [1] = B->J [3] = c * sn * (I [0] - I [1]);
+    B->J [4] = sn * sn * I [0] + c * c * I [1];
+    B->J [8] = I [2];
+    return;
+  }
+
+  B->h [0] = B->h [1] = B->h [2] = 0.5; /* unit spheres */
+  if (s->kind == FCLIB_SCENE_COLUMN) /* triangular layers, odd layers over the pockets of even ones */
+  {
+    double shift = (z % 2 ? 1.0 / 3.0 : 0.0);
+
+    B->x [0] = x + 0.5 * y + 1.5 * shift;
+    B->x [1] = 0.5 * sqrt (3.0) * (y + shift);
+    B->x [2] = 0.5 + sqrt (2.0 / 3.0) * z;
+  }
+  else
+  {
+    B->x [0] = x;
+    B->x [1] = y;
+    B->x [2] = 0.5 + z;
+  }
+  for (k = 0; k < 3; k ++) B->x [k] += jitter [k];
+  B->m = rho * 4.0 / 3.0 * acos (-1.0) * 0.125;
+  B->J [0] = B->J [4] = B->J [8] = 0.4 * B->m * 0.25;
+}
+
+/* contact of two spheres or of a sphere with the ground */
+static void sphere_contact (const struct scene_body *A, const struct scene_body *B, struct scene_contact *c)
+{
+  double d;
+  int k;
+
+  if (!B)
+  {
+    c->n [0] = c->n [1] = 0.0;
+    c->n [2] = 1.0;
+    c->gap = A->x [2] - A->h [0];
+    for (k = 0; k < 3; k ++) c->p [k] = A->x [k] - A->h [0] * c->n [k];
+    return;
+  }
+
+  for (k = 0; k < 3; k ++) c->n [k] = A->x [k] - B->x [k];
+  d = sqrt (c->n [0] * c->n [0] + c->n [1] * c->n [1] + c->n [2] * c->n [2]);
+  for (k = 0; k < 3; k ++) c->n [k] /= d;
+  c->gap = d - A->h [0] - B->h [0];
+  for (k = 0; k < 3; k ++) c->p [k] = B->x [k] + (B->h [0] + 0.5 * c->gap) * c->n [k];
+}
+
+/* contacts of body a with bodies of lower index or the ground, in a fixed order;
+ * c may be NULL to count them; return the number of contacts */
+static int scene_contacts (const struct scene *s, int a, struct scene_contact *c)
+{
+  int nx = s->nx, layer = s->nx * s->ny, x = a % nx, y = (a / nx) % s->ny, z = a / layer;
+  int other [FCLIB_SCENE_SLOTS], count = 0, k;
+  struct scene_body A, B;
+
+  if (s->kind == FCLIB_SCENE_BOXES) /* corners of the bottom face on the box below or the ground */
+  {
+    if (c)
+    {
+      double top = 0.0, cs, sn;
+
+      scene_body (s, a, &A);
+      if (z > 0)
+      {
+        scene_body (s, a - layer, &B);
+        top = B.x [2] + B.h [2];
+      }
+      cs = cos (A.yaw);
+      sn = sin (A.yaw);
+      for (k = 0; k < 4; k ++)
+      {
+        double dx = (k % 2 ? A.h [0] : -A.h [0]), dy = (k / 2 ? A.h [1] : -A.h [1]);
+
+        c [k].a = a;
+        c [k].b = (z > 0 ? a - layer : -1);
+        c [k].p [0] = A.x [0] + cs * dx - sn * dy;
+        c [k].p [1] = A.x [1] + sn * dx + cs * dy;
+        c [k].p [2] = A.x [2] - A.h [2];
+        c [k].n [0] = c [k].n [1] = 0.0;
+        c [k].n [2] = 1.0;
+        c [k].gap = c [k].p [2] - top;
+      }
+    }
+    return 4;
+  }
+
+  if (z == 0) other [count ++] = -1;
+  if (s->kind == FCLIB_SCENE_COLUMN)
+  {
+    int below = a - layer, dx, dy;
+
+    for (k = 0; z > 0 && k < 3; k ++) /* the three spheres of the pocket below */
+    {
+      dx = (z % 2 ? (k == 1) : -(k != 1));
+      dy = (z % 2 ? (k == 2) : -(k != 0));
+      if (x+dx >= 0 && x+dx < nx && y+dy >= 0 && y+dy < s->ny) other [count ++] = below + dx + dy*nx;
+    }
+    if (x > 0) other [count ++] = a - 1;
+    if (y > 0) other [count ++] = a - nx;
+    if (y > 0 && x+1 < nx) other [count ++] = a - nx + 1;
+  }
+  else
+  {
+    if (x > 0) other [count ++] = a - 1;
+    if (y > 0) other [count ++] = a - nx;
+    if (z > 0) other [count ++] = a - layer;
+  }
+
+  if (c)
+  {
+    scene_body (s, a, &A);
+    for (k = 0; k < count; k ++)
+    {
+      if (other [k] >= 0) scene_body (s, other [k], &B);
+      sphere_contact (&A, other [k] >= 0 ? &B : NULL, &c [k]);
+      c [k].a = a;
+      c [k].b = other [k];
+    }
+  }
+
+  return count;
+}
+
+/* local frame of a contact: the normal and two tangents as the columns of a row major 3x3 matrix */
+static void scene_frame (const double *n, double *F)
+{
+  double e [3] = {0.0, 0.0, 0.0}, t [3], d;
+  int k = (fabs (n [0]) <= fabs (n [1]) ? 0 : 1);
+
+  if (fabs (n [2]) < fabs (n [k])) k = 2;
+  e [k] = 1.0; /* axis least aligned with n */
+  t [0] = n [1] * e [2] - n [2] * e [1];
+  t [1] = n [2] * e [0] - n [0] * e [2];
+  t [2] = n [0] * e [1] - n [1] * e [0];
+  d = sqrt (t [0] * t [0] + t [1] * t [1] + t [2] * t [2]);
+  for (k = 0; k < 3; k ++)
+  {
+    F [3*k] = n [k];
+    F [3*k+1] = t [k] / d;
+  }
+  F [2] = n [1] * F [7] - n [2] * F [4];
+  F [5] = n [2] * F [1] - n [0] * F [7];
+  F [8] = n [0] * F [4] - n [1] * F [1];
+}
+
+/* H entries of a body in the column of direction f of a contact at p: f and (p - x) x f, negated for the lower body */
+static void scene_column (const struct scene_body *B, const double *p, const double *f, double sign, double *x)
+{
+  double r [3] = {p [0] - B->x [0], p [1] - B->x [1], p [2] - B->x [2]};
+
+  x [0] = sign * f [0];
+  x [1] = sign * f [1];
+  x [2] = sign * f [2];
+  x [3] = sign * (r [1] * f [2] - r [2] * f [1]);
+  x [4] = sign * (r [2] * f [0] - r [0] * f [2]);
+  x [5] = sign * (r [0] * f [1] - r [1] * f [0]);
+}
+
+/* generate the bodies [b0, b0+bodies) of a scene and their contacts */
+static void scene_slab (const struct scene *s, int b0, int bodies, int threads, struct scene_slab *slab)
+{
+  int j;
+
+  slab->b0 = b0;
+  slab->bodies = bodies;
+  MM (slab->cp = (int*)FCLIB_MALLOC (sizeof(int)*(bodies+1)));
+  MM (slab->mp = (int*)FCLIB_MALLOC (sizeof(int)*(6*bodies+1)));
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 256)
+  for (j = 0; j < bodies; j ++)
+  {
+    struct scene_body B;
+    int k, l;
+
+    scene_body (s, b0+j, &B);
+    slab->cp [j] = scene_contacts (s, b0+j, NULL);
+    for (k = 0; k < 3; k ++) slab->mp [6*j+k] = 1;
+    for (k = 0; k < 3; k ++)
+      for (slab->mp [6*j+3+k] = l = 0; l < 3; l ++) slab->mp [6*j+3+k] += (B.J [3*l+k] != 0.0);
+  }
+  cumsum (slab->cp, bodies);
+  cumsum (slab->mp, 6*bodies);
+  slab->contacts = slab->cp [bodies];
+
+  MM (slab->hp = (int*)FCLIB_MALLOC (sizeof(int)*(3*slab->contacts+1)));
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 256)
+  for (j = 0; j < bodies; j ++)
+  {
+    struct scene_contact c [FCLIB_SCENE_SLOTS];
+    int count = scene_contacts (s, b0+j, c), e, k;
+
+    for (e = 0; e < count; e ++)
+      for (k = 0; k < 3; k ++) slab->hp [3*(slab->cp [j]+e)+k] = (c [e].b >= 0 ? 12 : 6);
+  }
+  cumsum (slab->hp, 3*slab->contacts);
+
+  MM (slab->mi = (int*)FCLIB_MALLOC (sizeof(int)*slab->mp [6*bodies]));
+  MM (slab->mx = (double*)FCLIB_MALLOC (sizeof(double)*slab->mp [6*bodies]));
+  MM (slab->hi = (int*)FCLIB_MALLOC (sizeof(int)*(slab->hp [3*slab->contacts] > 0 ? slab->hp [3*slab->contacts] : 1)));
+  MM (slab->hx = (double*)FCLIB_MALLOC (sizeof(double)*(slab->hp [3*slab->contacts] > 0 ? slab->hp [3*slab->contacts] : 1)));
+  MM (slab->f = (double*)FCLIB_MALLOC (sizeof(double)*6*bodies));
+  MM (slab->w = (double*)FCLIB_MALLOC (sizeof(double)*(3*slab->contacts > 0 ? 3*slab->contacts : 1)));
+  MM (slab->mu = (double*)FCLIB_MALLOC (sizeof(double)*(slab->contacts > 0 ? slab->contacts : 1)));
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 256)
+  for (j = 0; j < bodies; j ++)
+  {
+    struct scene_contact c [FCLIB_SCENE_SLOTS];
+    struct scene_body A, B;
+    int a = b0+j, count, e, k, l, q;
+    unsigned long long key = 16ULL * (unsigned long long) a;
+    double v [6], F [9];
+
+    scene_body (s, a, &A);
+    for (k = 0; k < 6; k ++) v [k] = 0.01 * (scene_random (s->seed, key+7+k) - 0.5); /* previous velocity */
+    for (k = 0; k < 3; k ++) /* mass: f = m v - step m g e_z */
+    {
+      q = slab->mp [6*j+k];
+      slab->mi [q] = 6*a+k;
+      slab->mx [q] = A.m;
+      slab->f [6*j+k] = A.m * v [k] - (k == 2 ? s->step * A.m * 9.81 : 0.0);
+    }
+    for (k = 0; k < 3; k ++) /* inertia: f = J omega */
+    {
+      for (q = slab->mp [6*j+3+k], slab->f [6*j+3+k] = 0.0, l = 0; l < 3; l ++)
+      {
+        if (A.J [3*l+k] != 0.0)
+        {
+          slab->mi [q] = 6*a+3+l;
+          slab->mx [q ++] = A.J [3*l+k];
+        }
+        slab->f [6*j+3+k] += A.J [3*k+l] * v [3+l];
+      }
+    }
+
+    count = scene_contacts (s, a, c);
+    for (e = 0; e < count; e ++)
+    {
+      int col = 3*(slab->cp [j]+e);
+
+      if (c [e].b >= 0) scene_body (s, c [e].b, &B);
+      scene_frame (c [e].n, F);
+      for (k = 0; k < 3; k ++, col ++)
+      {
+        double f [3] = {F [k], F [3+k], F [6+k]};
+
+        q = slab->hp [col];
+        if (c [e].b >= 0)
+        {
+          scene_column (&B, c [e].p, f, -1.0, slab->hx + q);
+          for (l = 0; l < 6; l ++) slab->hi [q ++] = 6*c [e].b+l;
+        }
+        scene_column (&A, c [e].p, f, 1.0, slab->hx + q);
+        for (l = 0; l < 6; l ++) slab->hi [q ++] = 6*a+l;
+        slab->w [col] = (k == 0 ? c [e].gap / s->step : 0.0);
+      }
+      slab->mu [slab->cp [j]+e] = s->mu;
+    }
+  }
+}
+
+/* release the arrays of a slab */
+static void scene_slab_free (struct scene_slab *slab)
+{
+  free (slab->cp);
+  free (slab->mp);
+  free (slab->mi);
+  free (slab->mx);
+  free (slab->hp);
+  free (slab->hi);
+  free (slab->hx);
+  free (slab->f);
+  free (slab->w);
+  free (slab->mu);
+}
+
+/* release the arrays of a slab of a failed call, see error_keep */
+static void release_slab (void *ptr, int count)
+{
+  (void) count;
+  scene_slab_free ((struct scene_slab*) ptr);
+}
+
+/* problem info of a scene */
+static struct fclib_info* scene_info (const struct scene *s, int contacts)
+{
+  const char *title [3] = {"Sphere packing", "Stacked boxes", "Granular column"};
+  struct fclib_info *info;
+  char text [512];
+
+  MM (info = (struct fclib_info*)FCLIB_MALLOC (sizeof (struct fclib_info)));
+  MM (info->title = (char*)FCLIB_MALLOC (strlen (title [s->kind]) + 1));
+  strcpy (info->title, title [s->kind]);
+  snprintf (text, 512, "Generated by fclib: %d rigid bodies on a %d x %d x %d lattice, %d contacts, mu = %g, time step = %g, seed = %llu",
+            s->bodies, s->nx, s->ny, s->nz, contacts, s->mu, s->step, s->seed);
+  MM (info->description = (char*)FCLIB_MALLOC (strlen (text) + 1));
+  strcpy (info->description, text);
+  snprintf (text, 512, "M block-diagonal with 6x6 blocks, W = H^T M^-1 H positive semi-definite");
+  MM (info->math_info = (char*)FCLIB_MALLOC (strlen (text) + 1));
+  strcpy (info->math_info, text);
+
+  return info;
+}
+
+/* generate a global problem */
+static struct fclib_global* generate_global (struct fclib_generator_options *options)
+{
+  struct fclib_generator_options defaults = {0, 0, 0.0, 0.0, 0.0, 0, 0};
+  struct fclib_global *problem;
+  struct scene_slab slab;
+  struct scene s;
+
+  if (!options) options = &defaults;
+  if (!scene_setup (options, &s)) return NULL;
+
+  /* the problem is registered first, then takes the arrays of the slab */
+  MM (problem = (struct fclib_global*)FCLIB_CALLOC (1, sizeof (struct fclib_global)));
+  error_keep (problem, release_global, 1);
+  problem->spacedim = 3;
+  MM (problem->M = (struct fclib_matrix*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix)));
+  MM (problem->H = (struct fclib_matrix*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix)));
+  scene_slab (&s, 0, s.bodies, THREADS (options->threads), &slab);
+
+  problem->M->m = problem->M->n = 6*s.bodies;
+  problem->M->nz = -1;
+  problem->M->nzmax = slab.mp [6*s.bodies];
+  problem->M->p = slab.mp;
+  problem->M->i = slab.mi;
+  problem->M->x = slab.mx;
+  problem->H->m = 6*s.bodies;
+  problem->H->n = 3*slab.contacts;
+  problem->H->nz = -1;
+  problem->H->nzmax = slab.hp [3*slab.contacts];
+  problem->H->p = slab.hp;
+  problem->H->i = slab.hi;
+  problem->H->x = slab.hx;
+  problem->f = slab.f;
+  problem->w = slab.w;
+  problem->mu = slab.mu;
+  error_keep (slab.cp, release_memory, 1);
+  problem->info = scene_info (&s, slab.contacts);
+  error_drop (slab.cp);
+  free (slab.cp);
+  error_drop (problem);
+
+  return problem;
+}
+
+/* generate a global problem */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_global* fclib_generate_global (struct fclib_generator_options *options)
+{
+  struct error_context ctx;
+  struct fclib_global *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = generate_global (options);
+
+  error_leave ();
+  return result;
+}
+
+/* generate a local problem */
+static struct fclib_local* generate_local (struct fclib_generator_options *options)
+{
+  struct fclib_generator_options defaults = {0, 0, 0.0, 0.0, 0.0, 0, 0};
+  struct fclib_reduction_options reduction = {0, 0, 0, NULL};
+  struct fclib_global *global;
+  struct fclib_local *local;
+  struct fclib_matrix *W;
+  double compliance, mean = 0.0;
+  int j, k;
+
+  if (!options) options = &defaults;
+  if (!(global = generate_global (options))) return NULL;
+  error_keep (global, release_global, 1);
+  reduction.threads = options->threads;
+  local = global_to_local (global, &reduction);
+  error_drop (global);
+  fclib_delete_global (global);
+  free (global);
+  if (!local) return NULL;
+
+  compliance = (options->compliance == 0.0 ? 1e-6 : options->compliance);
+  if (compliance > 0.0) /* W is in compressed columns with its whole diagonal in the pattern */
+  {
+    W = local->W;
+    for (j = 0; j < W->n; j ++)
+      for (k = W->p [j]; k < W->p [j+1]; k ++)
+        if (W->i [k] == j) mean += W->x [k];
+    mean /= (W->n > 0 ? W->n : 1);
+    for (j = 0; j < W->n; j ++)
+      for (k = W->p [j]; k < W->p [j+1]; k ++)
+        if (W->i [k] == j) W->x [k] += compliance * mean;
+  }
+
+  return local;
+}
+
+/* generate a local problem */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_generate_local (struct fclib_generator_options *options)
+{
+  struct error_context ctx;
+  struct fclib_local *result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return NULL;
+  }
+
+  result = generate_local (options);
+
+  error_leave ();
+  return result;
+}
+
+/* 1d dataset of n elements; extendible in chunks when n is 0 */
+static hid_t scene_dataset (hid_t id, const char *name, hid_t type, hsize_t n)
+{
+  hsize_t maxdim = (n ? n : H5S_UNLIMITED), chunk = FCLIB_SCENE_CHUNK;
+  hid_t dataset_id, space_id, plist_id;
+
+  IO (space_id = H5Screate_simple (1, &n, &maxdim));
+  IO (plist_id = H5Pcreate (H5P_DATASET_CREATE));
+  if (!n) IO (H5Pset_chunk (plist_id, 1, &chunk));
+  IO (dataset_id = H5Dcreate (id, name, type, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT));
+  IO (H5Pclose (plist_id));
+  IO (H5Sclose (space_id));
+
+  return dataset_id;
+}
+
+/* write count elements at offset of a 1d dataset, extending it if needed */
+static void scene_write (hid_t dataset_id, hid_t type, hsize_t offset, hsize_t count, const void *data)
+{
+  hid_t filespace_id, memspace_id;
+  hsize_t dim;
+
+  if (!count) return;
+  IO (filespace_id = H5Dget_space (dataset_id));
+  IO (H5Sget_simple_extent_dims (filespace_id, &dim, NULL));
+  if (offset + count > dim)
+  {
+    dim = offset + count;
+    IO (H5Sclose (filespace_id));
+    IO (H5Dset_extent (dataset_id, &dim));
+    IO (filespace_id = H5Dget_space (dataset_id));
+  }
+  IO (H5Sselect_hyperslab (filespace_id, H5S_SELECT_SET, &offset, NULL, &count, NULL));
+  IO (memspace_id = H5Screate_simple (1, &count, NULL));
+  IO (FCLIB_H5DWRITE (dataset_id, type, memspace_id, filespace_id, H5P_DEFAULT, data));
+  IO (H5Sclose (memspace_id));
+  IO (H5Sclose (filespace_id));
+}
+
+/* generate a global problem and write it slab by slab */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_generate_write_global (struct fclib_generator_options *options, const char *path)
+{
+  struct fclib_generator_options defaults = {0, 0, 0.0, 0.0, 0.0, 0, 0};
+  struct error_context ctx;
+  hid_t file_id, main_id, id [3], data [9];
+  const char *matrix [2] = {"/fclib_global/M", "/fclib_global/H"};
+  struct fclib_info *info;
+  struct scene_slab slab;
+  struct scene s;
+  hsize_t dim = 1;
+  int threads, contacts, b0, sizes [2][3], nnz [2] = {0, 0}, j, k;
+
+  if (!options) options = &defaults;
+  if (!scene_setup (options, &s)) return 0;
+  threads = THREADS (options->threads);
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  contacts = 0;
+#pragma omp parallel for num_threads(threads) reduction(+:contacts)
+  for (j = 0; j < s.bodies; j ++) contacts += scene_contacts (&s, j, NULL);
+
+  if ((file_id = H5 (H5Fcreate (path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT))) < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: creating file %s failed", path);
+  error_file (file_id);
+  IO (main_id = H5Gmake (file_id, "/fclib_global"));
+  j = 3;
+  IO (FCLIB_H5LTMAKE_DATASET_INT (file_id, "/fclib_global/spacedim", 1, &dim, &j));
+
+  sizes [0][0] = sizes [0][1] = sizes [1][0] = 6*s.bodies; /* m, n and nz of M and H */
+  sizes [1][1] = 3*contacts;
+  sizes [0][2] = sizes [1][2] = -1;
+  for (k = 0; k < 2; k ++)
+  {
+    IO (id [k] = H5Gmake (file_id, matrix [k]));
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id [k], "m", 1, &dim, &sizes [k][0]));
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id [k], "n", 1, &dim, &sizes [k][1]));
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id [k], "nz", 1, &dim, &sizes [k][2]));
+    data [3*k] = scene_dataset (id [k], "p", H5T_NATIVE_INT, (hsize_t)sizes [k][1]+1);
+    data [3*k+1] = scene_dataset (id [k], "i", H5T_NATIVE_INT, 0);
+    data [3*k+2] = scene_dataset (id [k], "x", H5T_NATIVE_DOUBLE, 0);
+  }
+  IO (id [2] = H5Gmake (file_id, "/fclib_global/vectors"));
+  data [6] = scene_dataset (id [2], "f", H5T_NATIVE_DOUBLE, (hsize_t)6*s.bodies);
+  data [7] = scene_dataset (id [2], "w", H5T_NATIVE_DOUBLE, (hsize_t)3*contacts);
+  data [8] = scene_dataset (id [2], "mu", H5T_NATIVE_DOUBLE, (hsize_t)contacts);
+
+  for (b0 = 0, contacts = 0; b0 < s.bodies; b0 += FCLIB_SCENE_SLAB)
+  {
+    int bodies = (s.bodies - b0 < FCLIB_SCENE_SLAB ? s.bodies - b0 : FCLIB_SCENE_SLAB);
+    int *ptr [2], cols [2];
+
+    scene_slab (&s, b0, bodies, threads, &slab);
+    error_keep (&slab, release_slab, 1);
+    ptr [0] = slab.mp;
+    ptr [1] = slab.hp;
+    cols [0] = 6*bodies;
+    cols [1] = 3*slab.contacts;
+    for (k = 0; k < 2; k ++)
+    {
+      int first = (k ? 3*contacts : 6*b0), count = ptr [k][cols [k]];
+
+      for (j = 0; j < cols [k]; j ++) ptr [k][j] += nnz [k];
+      scene_write (data [3*k], H5T_NATIVE_INT, (hsize_t)first, (hsize_t)cols [k], ptr [k]);
+      scene_write (data [3*k+1], H5T_NATIVE_INT, (hsize_t)nnz [k], (hsize_t)count, k ? slab.hi : slab.mi);
+      scene_write (data [3*k+2], H5T_NATIVE_DOUBLE, (hsize_t)nnz [k], (hsize_t)count, k ? slab.hx : slab.mx);
+      nnz [k] += count;
+    }
+    scene_write (data [6], H5T_NATIVE_DOUBLE, (hsize_t)6*b0, (hsize_t)6*bodies, slab.f);
+    scene_write (data [7], H5T_NATIVE_DOUBLE, (hsize_t)3*contacts, (hsize_t)3*slab.contacts, slab.w);
+    scene_write (data [8], H5T_NATIVE_DOUBLE, (hsize_t)contacts, (hsize_t)slab.contacts, slab.mu);
+    contacts += slab.contacts;
+    error_drop (&slab);
+    scene_slab_free (&slab);
+  }
+
+  for (k = 0; k < 2; k ++) /* last pointers and sizes */
+  {
+    scene_write (data [3*k], H5T_NATIVE_INT, (hsize_t)sizes [k][1], 1, &nnz [k]);
+    IO (FCLIB_H5LTMAKE_DATASET_INT (id [k], "nzmax", 1, &dim, &nnz [k]));
+  }
+  for (k = 0; k < 9; k ++) IO (H5Dclose (data [k]));
+  for (k = 0; k < 3; k ++) IO (H5Gclose (id [k]));
+
+  info = scene_info (&s, contacts);
+  error_keep (info, release_info, 1);
+  IO (id [0] = H5Gmake (file_id, "/fclib_global/info"));
+  write_problem_info (id [0], info);
+  IO (H5Gclose (id [0]));
+  error_drop (info);
+  delete_info (info);
+
+  IO (H5Gclose (main_id));
+  IO (H5Fclose (file_id));
+
+  error_leave ();
+  return 1;
+}
+
+/* bytes of a MatrixMarket file parsed by one task */
+#define FCLIB_MTX_CHUNK (1 << 20)
+
+/* entries formatted by one task when writing */
+#define FCLIB_MTX_BATCH (1 << 14)
+
+/* longest formatted entry: two indices and a %.17g value */
+#define FCLIB_MTX_LINE 64
+
+/* MatrixMarket fields and symmetries */
+enum {MTX_REAL, MTX_PATTERN};
+enum {MTX_GENERAL, MTX_SYMMETRIC, MTX_SKEW};
+
+/* a file mapped into memory, or read into a buffer where mmap is not available */
+struct mtx_file
+{
+  char *data;
+  size_t size;
+  int mapped;
+};
+
+static void release_mtx_file (void *ptr, int count)
+{
+  struct mtx_file *file = (struct mtx_file*) ptr;
+
+  (void) count;
+#ifndef _WIN32
+  if (file->mapped) munmap (file->data, file->size);
+  else
+#endif
+  free (file->data);
+  free (file);
+}
+
+static void release_stream (void *ptr, int count)
+{
+  (void) count;
+  fclose ((FILE*) ptr);
+}
+
+/* map a whole file into memory and register it with the error context */
+static struct mtx_file* mtx_open (const char *path)
+{
+  struct mtx_file *file;
+
+  MM (file = (struct mtx_file*)FCLIB_CALLOC (1, sizeof (struct mtx_file)));
+  error_keep (file, release_mtx_file, 1);
+
+#ifndef _WIN32
+  {
+    struct stat st;
+    int fd = open (path, O_RDONLY);
+
+    if (fd < 0) FAIL (FCLIB_ERROR_FILE, "ERROR: opening file %s failed", path);
+    if (fstat (fd, &st) < 0)
+    {
+      close (fd);
+      FAIL (FCLIB_ERROR_FILE, "ERROR: opening file %s failed", path);
+    }
+    file->size = (size_t) st.st_size;
+    if (file->size > 0)
+    {
+      void *data = mmap (NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (data != MAP_FAILED)
+      {
+        file->data = (char*) data;
+        file->mapped = 1;
+        madvise (data, file->size, MADV_SEQUENTIAL);
+      }
+    }
+    close (fd);
+    if (file->size > 0 && !file->mapped) FAIL (FCLIB_ERROR_FILE, "ERROR: mapping file %s failed", path);
+  }
+#else
+  {
+    FILE *f = fopen (path, "rb");
+    long size;
+
+    if (!f) FAIL (FCLIB_ERROR_FILE, "ERROR: opening file %s failed", path);
+    error_keep (f, release_stream, 1);
+    if (fseek (f, 0, SEEK_END) || (size = ftell (f)) < 0 || fseek (f, 0, SEEK_SET)) FAIL (FCLIB_ERROR_FILE, "ERROR: reading file %s failed", path);
+    file->size = (size_t) size;
+    MM (file->data = (char*)FCLIB_MALLOC (file->size > 0 ? file->size : 1));
+    if (fread (file->data, 1, file->size, f) != file->size) FAIL (FCLIB_ERROR_FILE, "ERROR: reading file %s failed", path);
+    error_drop (f);
+    fclose (f);
+  }
+#endif
+
+  return file;
+}
+
+static int mtx_blank (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* end of the line starting at s */
+static const char* mtx_line_end (const char *s, const char *end)
+{
+  const char *e = (const char*) memchr (s, '\n', (size_t)(end - s));
+
+  return e ? e : end;
+}
+
+/* first character of the entry on the line [s, e), or NULL for blank and comment lines */
+static const char* mtx_entry (const char *s, const char *e)
+{
+  while (s < e && mtx_blank (*s)) s ++;
+
+  return s < e && *s != '%' ? s : NULL;
+}
+
+/* parse a decimal count below 10^18; return its end, or NULL */
+static const char* mtx_long (const char *s, const char *e, long long *v)
+{
+  const char *t;
+  long long r = 0;
+
+  for (t = s; t < e && (unsigned)(*t - '0') < 10; t ++)
+  {
+    r = 10*r + (*t - '0');
+    if (r >= 1000000000000000000LL) return NULL;
+  }
+  *v = r;
+
+  return t > s && (t == e || mtx_blank (*t)) ? t : NULL;
+}
+
+/* parse a positive index; return its end, or NULL */
+static const char* mtx_index (const char *s, const char *e, int *v)
+{
+  long long r;
+
+  if (!(s = mtx_long (s, e, &r)) || r > INT_MAX) return NULL;
+  *v = (int) r;
+
+  return s;
+}
+
+/* parse a decimal number; the hand-written fast path is exact for significands below 2^53
+ * scaled by at most 10^22. With x87 extended precision, up to 19 digits scaled by at most
+ * 10^27 are rounded once to 64 bits, then to 53 bits unless the first rounding may have
+ * moved the number across a halfway point. The other numbers go to strtod; return its
+ * end, or NULL */
+static const char* mtx_double (const char *s, const char *e, double *x)
+{
+  static const double power [23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  unsigned long long mant = 0;
+  int digits = 0, scale = 0, exponent = 0, exact = 1, any = 0, negative = 0, eneg = 0;
+  const char *t = s, *u;
+  char copy [64], *stop;
+
+  if (t < e && (*t == '-' || *t == '+')) negative = (*t ++ == '-');
+  for (; t < e && (unsigned)(*t - '0') < 10; t ++, any = 1)
+  {
+    if (digits < 19) mant = 10*mant + (*t - '0'), digits += (mant > 0);
+    else scale ++, exact = 0;
+  }
+  if (t < e && *t == '.')
+  {
+    for (t ++; t < e && (unsigned)(*t - '0') < 10; t ++, any = 1)
+    {
+      if (digits < 19) mant = 10*mant + (*t - '0'), digits += (mant > 0), scale --;
+      else exact = 0;
+    }
+  }
+  if (any && t < e && (*t == 'e' || *t == 'E'))
+  {
+    u = t + 1;
+    if (u < e && (*u == '-' || *u == '+')) eneg = (*u ++ == '-');
+    for (t = u; t < e && (unsigned)(*t - '0') < 10; t ++)
+      if (exponent < 100000) exponent = 10*exponent + (*t - '0');
+    if (t == u) any = 0;
+  }
+
+  if (any && (t == e || mtx_blank (*t)) && exact)
+  {
+    scale += (eneg ? -exponent : exponent);
+    if (mant == 0) scale = 0;
+    if (mant < (1ULL << 53) && scale >= -22 && scale <= 22)
+    {
+      *x = (scale < 0 ? (double) mant / power [-scale] : (double) mant * power [scale]);
+      if (negative) *x = -*x;
+      return t;
+    }
+#if LDBL_MANT_DIG == 64 && (defined(__x86_64__) || defined(__i386__))
+    else if (scale >= -27 && scale <= 27)
+    {
+      static const long double lpower [28] = {1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+                                              1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+      long double r = (scale < 0 ? (long double) mant / lpower [-scale] : (long double) mant * lpower [scale]);
+      unsigned long long bits;
+
+      memcpy (&bits, &r, sizeof (bits)); /* x87 significand */
+      if ((bits - 0x3ff) % 0x800 > 2) /* the low 11 bits are not 0x3ff, 0x400 or 0x401 */
+      {
+        *x = (double) r;
+        if (negative) *x = -*x;
+        return t;
+      }
+    }
+#endif
+  }
+
+  for (u = s; u < e && !mtx_blank (*u); u ++);
+  if (u == s || u - s >= 64) return NULL;
+  memcpy (copy, s, (size_t)(u - s));
+  copy [u - s] = '\0';
+  *x = strtod (copy, &stop);
+
+  return stop == copy + (u - s) ? u : NULL;
+}
+
+/* count the entries of the lines in [s, e) */
+static long long mtx_count (const char *s, const char *e)
+{
+  long long count = 0;
+  const char *l;
+
+  for (; s < e; s = l + 1)
+  {
+    l = mtx_line_end (s, e);
+    if (mtx_entry (s, l)) count ++;
+  }
+
+  return count;
+}
+
+/* parse the entries of the lines in [s, e) into zero-based triplets;
+ * return the first invalid line, or NULL */
+static const char* mtx_parse (const char *s, const char *e, int field, int m, int n, int *row, int *col, double *x)
+{
+  const char *l, *t;
+  int r, c;
+
+  for (; s < e; s = l + 1)
+  {
+    l = mtx_line_end (s, e);
+    if (!(t = mtx_entry (s, l))) continue;
+
+    if (!(t = mtx_index (t, l, &r))) return s;
+    while (t < l && mtx_blank (*t)) t ++;
+    if (!(t = mtx_index (t, l, &c))) return s;
+    if (field == MTX_PATTERN) *x = 1.0;
+    else
+    {
+      while (t < l && mtx_blank (*t)) t ++;
+      if (!(t = mtx_double (t, l, x))) return s;
+    }
+    while (t < l && mtx_blank (*t)) t ++;
+    if (t < l || r < 1 || r > m || c < 1 || c > n) return s;
+
+    *(row ++) = r - 1;
+    *(col ++) = c - 1;
+    x ++;
+  }
+
+  return NULL;
+}
 
-  if ((file_id = H5Fopen (path, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
+/* line number of position t */
+static long long mtx_line (const char *data, const char *t)
+{
+  long long line = 1;
+  const char *l;
+
+  for (; (l = (const char*) memchr (data, '\n', (size_t)(t - data))); data = l + 1) line ++;
+
+  return line;
+}
+
+/* read the banner and the size line; return the first data line */
+static const char* mtx_header (const char *path, const char *s, const char *e, int *field, int *symmetry, int *m, int *n, long long *nnz)
+{
+  char token [5][32];
+  const char *data = s, *l = mtx_line_end (s, e), *t;
+  int k, j;
+
+  for (t = s, k = 0; k < 5; k ++) /* %%MatrixMarket matrix coordinate <field> <symmetry>, case-insensitive */
+  {
+    while (t < l && mtx_blank (*t)) t ++;
+    for (j = 0; t < l && !mtx_blank (*t); t ++) if (j < 31) token [k][j ++] = (char) tolower ((unsigned char) *t);
+    token [k][j] = '\0';
+  }
+  ASSERT (strcmp (token [0], "%%matrixmarket") == 0 && strcmp (token [1], "matrix") == 0,
+          "ERROR: %s is not a MatrixMarket matrix file", path);
+  ASSERT (strcmp (token [2], "coordinate") == 0, "ERROR: %s :: only coordinate MatrixMarket files are supported, not %s", path, token [2]);
+
+  if (strcmp (token [3], "real") == 0 || strcmp (token [3], "double") == 0 || strcmp (token [3], "integer") == 0) *field = MTX_REAL;
+  else if (strcmp (token [3], "pattern") == 0) *field = MTX_PATTERN;
+  else FAIL (FCLIB_ERROR_INVALID, "ERROR: %s :: unsupported MatrixMarket field %s", path, token [3]);
+
+  if (strcmp (token [4], "general") == 0) *symmetry = MTX_GENERAL;
+  else if (strcmp (token [4], "symmetric") == 0) *symmetry = MTX_SYMMETRIC;
+  else if (strcmp (token [4], "skew-symmetric") == 0) *symmetry = MTX_SKEW;
+  else FAIL (FCLIB_ERROR_INVALID, "ERROR: %s :: unsupported MatrixMarket symmetry %s", path, token [4]);
+
+  for (s = l + 1; s < e; s = l + 1) /* size line after the comments */
+  {
+    l = mtx_line_end (s, e);
+    if ((t = mtx_entry (s, l))) break;
+  }
+  ASSERT (s < e, "ERROR: %s :: missing MatrixMarket size line", path);
+  ASSERT ((t = mtx_index (t, l, m)) && (t = mtx_index (t + strspn (t, " \t"), l, n)) && (t = mtx_long (t + strspn (t, " \t"), l, nnz)),
+          "ERROR: %s :: invalid MatrixMarket size line %lld", path, mtx_line (data, s));
+  ASSERT (*nnz <= INT_MAX, "ERROR: %s :: %lld entries do not fit in an fclib_matrix", path, *nnz);
+  ASSERT (*symmetry == MTX_GENERAL || *m == *n, "ERROR: %s :: a symmetric matrix must be square => %d x %d", path, *m, *n);
+
+  return l < e ? l + 1 : e;
+}
+
+/* whether a compressed matrix equals its transpose once duplicates are summed and zeros dropped:
+ * the compressed columns of a matrix are the compressed rows of its transpose */
+static int mtx_symmetric (struct fclib_matrix *mat)
+{
+  struct fclib_matrix *csc, *csr;
+  int n = mat->n, nnz, same;
+
+  csc = matrix_compress (mat, -1);
+  error_keep (csc, release_matrix, 1);
+  csr = matrix_compress (mat, -2);
+  error_keep (csr, release_matrix, 1);
+  ASSERT (matrix_canonicalize (csc) && matrix_canonicalize (csr), "ERROR: canonicalizing a MatrixMarket matrix failed");
+
+  nnz = csc->p [n];
+  same = memcmp (csc->p, csr->p, sizeof(int)*(n+1)) == 0 &&
+         memcmp (csc->i, csr->i, sizeof(int)*nnz) == 0 &&
+         memcmp (csc->x, csr->x, sizeof(double)*nnz) == 0;
+
+  error_drop (csr);
+  delete_matrix (csr);
+  error_drop (csc);
+  delete_matrix (csc);
+
+  return same;
+}
+
+/* read a MatrixMarket file;
+ * return new matrix on success; NULL on failure */
+FCLIB_STATIC struct FCLIB_APICOMPILE fclib_matrix* fclib_matrix_read_mtx (const char *path, int nz)
+{
+  struct error_context ctx;
+  struct mtx_file *file;
+  struct fclib_matrix *mat, *out;
+  const char *data, *end, **start, **failed;
+  long long nnz, *count, total, mirrored;
+  int field, symmetry, m, n, chunks, j, k;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
+    error_catch ();
     return NULL;
   }
 
-  MM (problem = (struct fclib_global_rolling*)calloc (1, sizeof (struct fclib_global_rolling)));
+  ASSERT (nz == 0 || nz == -1 || nz == -2 || nz == -4, "ERROR: MatrixMarket files are read in triplet, compressed or symmetric form, not nz = %d", nz);
+  file = mtx_open (path);
+  ASSERT (file->size > 0, "ERROR: %s is empty", path);
+  end = file->data + file->size;
+  data = mtx_header (path, file->data, end, &field, &symmetry, &m, &n, &nnz);
+  ASSERT (nz != -4 || m == n, "ERROR: a symmetric matrix must be square => %d x %d", m, n);
+
+  /* split the data lines into chunks starting at line boundaries */
+  chunks = (int)((size_t)(end - data) / FCLIB_MTX_CHUNK) + 1;
+  MM (start = (const char**)FCLIB_MALLOC (sizeof(const char*)*(chunks+1)));
+  error_keep ((void*) start, release_memory, 1);
+  MM (failed = (const char**)FCLIB_MALLOC (sizeof(const char*)*chunks));
+  error_keep ((void*) failed, release_memory, 1);
+  MM (count = (long long*)FCLIB_MALLOC (sizeof(long long)*(chunks+1)));
+  error_keep (count, release_memory, 1);
+  for (start [0] = data, k = 1; k < chunks; k ++)
+  {
+    const char *l = mtx_line_end (data + (size_t) k * FCLIB_MTX_CHUNK, end);
+    start [k] = (l < end ? l + 1 : end);
+    if (start [k] < start [k-1]) start [k] = start [k-1];
+  }
+  start [chunks] = end;
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (k = 0; k < chunks; k ++) count [k+1] = mtx_count (start [k], start [k+1]);
+  for (count [0] = 0, k = 0; k < chunks; k ++) count [k+1] += count [k];
+  total = count [chunks];
+  ASSERT (total == nnz, "ERROR: %s :: %lld entries found, %lld declared", path, total, nnz);
+
+  /* entries mirrored by the expansion of a symmetric file are appended later */
+  mat = matrix_alloc (m, n, (int) nnz, (int) nnz, 0);
+  error_keep (mat, release_matrix, 1);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (k = 0; k < chunks; k ++)
+    failed [k] = mtx_parse (start [k], start [k+1], field, m, n, mat->p + count [k], mat->i + count [k], mat->x + count [k]);
+  for (k = 0; k < chunks; k ++)
+    ASSERT (!failed [k], "ERROR: %s :: invalid MatrixMarket entry on line %lld", path, mtx_line (file->data, failed [k]));
+
+  error_drop (count);
+  free (count);
+  error_drop ((void*) failed);
+  free ((void*) failed);
+  error_drop ((void*) start);
+  free ((void*) start);
+  error_drop (file);
+  release_mtx_file (file, 1);
+
+  if (symmetry != MTX_GENERAL && nz == -4) /* keep one triangle, as the upper one */
+  {
+    ASSERT (symmetry == MTX_SYMMETRIC, "ERROR: %s :: a skew-symmetric matrix cannot be stored as symmetric", path);
+#pragma omp parallel for if (nnz > FCLIB_PARALLEL_MIN)
+    for (k = 0; k < (int) nnz; k ++)
+    {
+      if (mat->p [k] > mat->i [k])
+      {
+        j = mat->p [k];
+        mat->p [k] = mat->i [k];
+        mat->i [k] = j;
+      }
+    }
+  }
+  else if (symmetry != MTX_GENERAL) /* mirror the off-diagonal entries */
+  {
+    for (mirrored = k = 0; k < (int) nnz; k ++) mirrored += (mat->p [k] != mat->i [k]);
+    ASSERT (nnz + mirrored <= 2147483647, "ERROR: %s :: too many entries for the expansion of a symmetric matrix", path);
+    MM (mat->p = (int*)FCLIB_REALLOC (mat->p, sizeof(int)*(nnz+mirrored > 0 ? nnz+mirrored : 1)));
+    MM (mat->i = (int*)FCLIB_REALLOC (mat->i, sizeof(int)*(nnz+mirrored > 0 ? nnz+mirrored : 1)));
+    MM (mat->x = (double*)FCLIB_REALLOC (mat->x, sizeof(double)*(nnz+mirrored > 0 ? nnz+mirrored : 1)));
+    for (j = (int) nnz, k = 0; k < (int) nnz; k ++)
+    {
+      if (mat->p [k] != mat->i [k])
+      {
+        mat->p [j] = mat->i [k];
+        mat->i [j] = mat->p [k];
+        mat->x [j ++] = (symmetry == MTX_SKEW ? -mat->x [k] : mat->x [k]);
+      }
+    }
+    mat->nz = mat->nzmax = j;
+  }
+
+  if (nz < 0)
+  {
+    out = matrix_compress (mat, nz == -2 ? -2 : -1);
+    error_drop (mat);
+    delete_matrix (mat);
+    mat = out;
+  }
+  if (nz == -4 && symmetry == MTX_SYMMETRIC) mat->nz = -4;
+  else if (nz == -4) /* keep the upper triangle of a general file, which must be symmetric */
+  {
+    error_keep (mat, release_matrix, 1);
+    ASSERT (mtx_symmetric (mat), "ERROR: %s :: the general matrix is not symmetric and cannot be stored as symmetric", path);
+    out = matrix_to_symmetric (mat);
+    error_drop (mat);
+    delete_matrix (mat);
+    mat = out;
+  }
+  else if (nz == 0) error_drop (mat);
+
+  error_leave ();
+  return mat;
+}
+
+/* write the entries [k0, k1) of a matrix, counted in storage order (blocks for block storage);
+ * return the number of bytes */
+static size_t mtx_format (struct fclib_matrix *mat, int k0, int k1, char *out)
+{
+  char *o = out;
+  int j = 0, k, bs = (mat->nz == -3 ? mat->bs : 1), bs2 = bs*bs, r, c, l;
+
+  if (mat->nz < 0) /* outer index of entry k0 */
+  {
+    int lo = 0, hi = (mat->nz == -2 ? mat->m : mat->nz == -3 ? mat->m / bs : mat->n);
+
+    while (lo < hi)
+    {
+      int mid = (lo + hi) / 2;
+      if (mat->p [mid+1] <= k0) lo = mid + 1;
+      else hi = mid;
+    }
+    j = lo;
+  }
+
+  for (k = k0; k < k1; k ++)
+  {
+    if (mat->nz >= 0) r = mat->p [k], c = mat->i [k];
+    else
+    {
+      while (mat->p [j+1] <= k) j ++;
+      if (mat->nz == -1) r = mat->i [k], c = j;
+      else if (mat->nz == -4) r = j, c = mat->i [k]; /* upper triangle written as the lower one */
+      else if (mat->nz == -2) r = j, c = mat->i [k];
+      else
+      {
+        for (l = 0; l < bs2; l ++)
+          o += sprintf (o, "%d %d %.17g\n", j*bs + l/bs + 1, mat->i [k]*bs + l%bs + 1, mat->x [k*bs2 + l]);
+        continue;
+      }
+    }
+    o += sprintf (o, "%d %d %.17g\n", r + 1, c + 1, mat->x [k]);
+  }
+
+  return (size_t)(o - out);
+}
+
+/* write a matrix to a MatrixMarket file;
+ * return 1 on success, 0 on failure */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_matrix_write_mtx (struct fclib_matrix *mat, const char *path)
+{
+  struct error_context ctx;
+  FILE *f;
+  char *buffer;
+  size_t *length;
+  long long entries;
+  int units, batch, threads, bs2, k, t;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env)) return error_catch ();
+
+  ASSERT (mat->nz >= -4, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d", mat->nz);
+  bs2 = (mat->nz == -3 ? mat->bs * mat->bs : 1);
+  if (mat->nz >= 0) units = mat->nz;
+  else units = mat->p [mat->nz == -2 ? mat->m : mat->nz == -3 ? mat->m / mat->bs : mat->n];
+  entries = (long long) units * bs2;
+  batch = (FCLIB_MTX_BATCH / bs2 > 0 ? FCLIB_MTX_BATCH / bs2 : 1);
+#ifdef _OPENMP
+  threads = omp_get_max_threads ();
+#else
+  threads = 1;
+#endif
+
+  if (!(f = fopen (path, "w"))) FAIL (FCLIB_ERROR_FILE, "ERROR: creating file %s failed", path);
+  error_keep (f, release_stream, 1);
+  MM (buffer = (char*)FCLIB_MALLOC ((size_t) threads * batch * bs2 * FCLIB_MTX_LINE));
+  error_keep (buffer, release_memory, 1);
+  MM (length = (size_t*)FCLIB_MALLOC (sizeof(size_t)*threads));
+  error_keep (length, release_memory, 1);
+
+  ASSERT (fprintf (f, "%%%%MatrixMarket matrix coordinate real %s\n", mat->nz == -4 ? "symmetric" : "general") > 0,
+          "ERROR: writing file %s failed", path);
+  if (mat->info && mat->info->comment)
+  {
+    const char *c = mat->info->comment, *l;
+
+    for (; *c; c = (*l ? l + 1 : l))
+    {
+      l = c + strcspn (c, "\n");
+      fprintf (f, "%%%.*s\n", (int)(l - c), c);
+    }
+  }
+  ASSERT (fprintf (f, "%d %d %lld\n", mat->m, mat->n, entries) > 0, "ERROR: writing file %s failed", path);
+
+  /* format 'threads' batches in parallel, then write them in order */
+  for (k = 0; k < units; k += threads * batch)
+  {
+#pragma omp parallel for schedule(static, 1)
+    for (t = 0; t < threads; t ++)
+    {
+      long long k0 = (long long) k + (long long) t * batch, k1 = k0 + batch;
+
+      if (k1 > units) k1 = units;
+      length [t] = (k0 < k1 ? mtx_format (mat, (int) k0, (int) k1, buffer + (size_t) t * batch * bs2 * FCLIB_MTX_LINE) : 0);
+    }
+    for (t = 0; t < threads; t ++)
+      ASSERT (fwrite (buffer + (size_t) t * batch * bs2 * FCLIB_MTX_LINE, 1, length [t], f) == length [t], "ERROR: writing file %s failed", path);
+  }
+
+  error_drop (length);
+  free (length);
+  error_drop (buffer);
+  free (buffer);
+  error_drop (f);
+  ASSERT (fclose (f) == 0, "ERROR: writing file %s failed", path);
+
+  error_leave ();
+  return 1;
+}
+
+/* y = A x for a compressed row matrix, or y = A^T x for a compressed column matrix */
+static void estimate_gather (const struct fclib_matrix *A, const double *x, double *y)
+{
+  int outer = (A->nz == -2 ? A->m : A->n), j, k;
+
+  for (j = 0; j < outer; j ++)
+  {
+    double s = 0.0;
+
+    for (k = A->p [j]; k < A->p [j+1]; k ++) s += A->x [k] * x [A->i [k]];
+    y [j] = s;
+  }
+}
+
+/* euclidean norm */
+static double estimate_norm (int n, const double *x)
+{
+  double s = 0.0;
+  int k;
+
+  for (k = 0; k < n; k ++) s += x [k] * x [k];
+
+  return sqrt (s);
+}
+
+/* remove from x of size n its components along the 'count' orthonormal columns of basis (twice) */
+static void estimate_orthogonalize (int n, int count, const double *basis, double *x)
+{
+  int pass, c, j;
+
+  for (pass = 0; pass < 2; pass ++)
+    for (c = 0; c < count; c ++)
+    {
+      const double *b = basis + (size_t) c*n;
+      double d = 0.0;
+
+      for (j = 0; j < n; j ++) d += b [j] * x [j];
+      for (j = 0; j < n; j ++) x [j] -= d * b [j];
+    }
+}
+
+/* Golub-Kahan-Lanczos bidiagonalization started at z of size n, the smaller dimension: 'down' maps
+ * vectors of the larger dimension l to size n, 'up' is its transpose; alpha [0..k-1] receives the
+ * diagonal and beta [1..k-1] the subdiagonal of the lower bidiagonal B whose B B^T is the Lanczos
+ * tridiagonal of 'down up' started at z / |z|; work is of size 2n+2l, or (iterations+1)(n+l) with
+ * full reorthogonalization of the Lanczos vectors; the steps stop on an invariant subspace, after
+ * 'iterations' or at the deadline (if not 0); return their number k */
+static int estimate_bidiagonal (const struct fclib_matrix *up, const struct fclib_matrix *down, const double *z,
+                                int iterations, double deadline, int reorthogonalize, double *alpha, double *beta, double *work)
+{
+  int n = (down->nz == -2 ? down->m : down->n), l = (up->nz == -2 ? up->m : up->n), j, k;
+  double *u = work, *w = u + n, *v = w + n, *t = v + l, *swap, a, b, norm, scale;
+
+  if (reorthogonalize) /* u_k and v_k kept in the columns of U = u and V = v */
+  {
+    v = u + (size_t) iterations*n;
+    w = v + (size_t) iterations*l;
+    t = w + n;
+  }
+
+  norm = estimate_norm (n, z);
+  for (j = 0; j < n; j ++) u [j] = z [j] / norm;
+  estimate_gather (up, u, v);
+  scale = a = estimate_norm (l, v);
+
+  for (k = 0; ; )
+  {
+    alpha [k ++] = a;
+    if (a <= 1e-12 * scale || k == iterations || (deadline > 0.0 && wall_time () > deadline)) break;
+    for (j = 0; j < l; j ++) v [j] /= a;
+
+    estimate_gather (down, v, w);
+    for (j = 0; j < n; j ++) w [j] -= a * u [j];
+    if (reorthogonalize)
+    {
+      estimate_orthogonalize (n, k, work, w);
+      u += n;
+    }
+    b = estimate_norm (n, w);
+    if (b > scale) scale = b;
+    if (b <= 1e-12 * scale) break;
+    beta [k] = b;
+    for (j = 0; j < n; j ++) u [j] = w [j] / b;
+
+    estimate_gather (up, u, t);
+    for (j = 0; j < l; j ++) t [j] -= b * v [j];
+    if (reorthogonalize)
+    {
+      estimate_orthogonalize (l, k, work + (size_t) iterations*n, t);
+      memcpy (v + l, t, sizeof(double)*l);
+      v += l;
+    }
+    else swap = v, v = t, t = swap;
+    a = estimate_norm (l, v);
+    if (a > scale) scale = a;
+  }
+
+  return k;
+}
+
+/* number of eigenvalues below x > 0 of the symmetric tridiagonal matrix of size n with a zero diagonal
+ * and the off-diagonal e [0..n-2] (Sturm sequence) */
+static int estimate_sturm (int n, const double *e, double x)
+{
+  double q = -x;
+  int count = 1, t;
+
+  for (t = 1; t < n; t ++)
+  {
+    q = -x - e [t-1] * e [t-1] / q;
+    if (q == 0.0) q = -DBL_EPSILON * x;
+    count += (q < 0.0);
+  }
+
+  return count;
+}
+
+/* extreme singular values of the lower bidiagonal matrix of diagonal alpha [0..k-1] and subdiagonal
+ * beta [1..k-1], by bisection on the eigenvalues +-sigma of its Golub-Kahan form, to high relative
+ * accuracy even for the smallest; e is work of size 2k */
+static void estimate_extremes (int k, const double *alpha, const double *beta, double *e, double *smin, double *smax)
+{
+  double lo, hi, mid, bound = 0.0;
+  int n = 2*k, j;
+
+  for (j = 0; j < k; j ++)
+  {
+    e [2*j] = alpha [j];
+    if (j+1 < k) e [2*j+1] = beta [j+1];
+  }
+  for (j = 0; j < n-1; j ++)
+    if (fabs (e [j]) > bound) bound = fabs (e [j]);
+  if (bound == 0.0)
+  {
+    *smin = *smax = 0.0;
+    return;
+  }
+
+  for (lo = 0.0, hi = 2.0*bound, j = 0; j < 100; j ++)
+  {
+    mid = 0.5 * (lo + hi);
+    if (estimate_sturm (n, e, mid) == n) hi = mid;
+    else lo = mid;
+  }
+  *smax = hi;
+
+  for (lo = 0.0, j = 0; j < 100; j ++)
+  {
+    mid = 0.5 * (lo + hi);
+    if (estimate_sturm (n, e, mid) > k) hi = mid;
+    else lo = mid;
+  }
+  *smin = lo;
+}
+
+/* eigenvalues d and first components z of the eigenvectors of the symmetric tridiagonal matrix of
+ * diagonal d [0..n-1] and off-diagonal e [0..n-2] (e of size n, destroyed), by implicit QL iterations */
+static void estimate_eigen (int n, double *d, double *e, double *z)
+{
+  double b, c, f, g, p, r, s;
+  int i, l, m, iter;
+
+  for (i = 0; i < n; i ++) z [i] = (i == 0);
+  e [n-1] = 0.0;
+
+  for (l = 0; l < n; l ++)
+    for (iter = 0; iter < 64; iter ++)
+    {
+      for (m = l; m < n-1; m ++)
+        if (fabs (e [m]) <= DBL_EPSILON * (fabs (d [m]) + fabs (d [m+1]))) break;
+      if (m == l) break;
+
+      g = (d [l+1] - d [l]) / (2.0 * e [l]); /* Wilkinson shift */
+      r = hypot (g, 1.0);
+      g = d [m] - d [l] + e [l] / (g + (g >= 0.0 ? r : -r));
+      s = c = 1.0;
+      p = 0.0;
+      for (i = m-1; i >= l; i --)
+      {
+        f = s * e [i];
+        b = c * e [i];
+        e [i+1] = r = hypot (f, g);
+        if (r == 0.0) break;
+        s = f / r;
+        c = g / r;
+        g = d [i+1] - p;
+        r = (d [i] - g) * s + 2.0 * c * b;
+        p = s * r;
+        d [i+1] = g + p;
+        g = c * r - b;
+        f = z [i+1];
+        z [i+1] = s * z [i] + c * f;
+        z [i] = c * z [i] - s * f;
+      }
+      if (r == 0.0 && i >= l) /* underflow: deflate and repeat */
+      {
+        d [i+1] -= p;
+        e [m] = 0.0;
+        continue;
+      }
+      d [l] -= p;
+      e [l] = g;
+      e [m] = 0.0;
+    }
+}
+
+/* estimate the conditioning, rank and determinant of a matrix */
+static int matrix_estimate_info (struct fclib_matrix *mat, struct fclib_estimate_options *options)
+{
+  struct fclib_estimate_options defaults = {0, 0, 0.0, 0.0, 0, 0};
+  struct fclib_matrix *csr, *csc;
+  double *theta, *tau, *smin, *smax, *work, deadline, tolerance, sigma_min, sigma_max, threshold, rank, logdet;
+  int *steps, iterations, probes, unit, n, l, threads, done, j, q;
+  size_t lanczos, size;
+
+  if (!options) options = &defaults;
+  if (mat->nz < -4)
+  {
+    error_report (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => fclib_matrix->nz = %d", mat->nz);
+    return 0;
+  }
+
+  n = (mat->m < mat->n ? mat->m : mat->n);
+  l = (mat->m < mat->n ? mat->n : mat->m);
+  iterations = (options->iterations > 0 ? options->iterations : 100);
+  if (iterations > n) iterations = (n > 0 ? n : 1);
+  probes = (options->probes > 0 ? options->probes : 16);
+  unit = (n <= probes);
+  if (unit) probes = n;
+  tolerance = (options->tolerance > 0.0 ? options->tolerance : 1e-6);
+  threads = THREADS (options->threads);
+  deadline = (options->time > 0.0 ? wall_time () + options->time : 0.0);
+
+  /* A v and A^T u as gathers, 'down' onto the smaller dimension, 'up' onto the larger one */
+  csr = matrix_convert (mat, -2);
+  error_keep (csr, release_matrix, 1);
+  csc = matrix_convert (mat, -1);
+  error_keep (csc, release_matrix, 1);
+  MM (theta = (double*)FCLIB_MALLOC (sizeof(double)*(probes > 0 ? probes*iterations : 1)));
+  error_keep (theta, release_memory, 1);
+  MM (tau = (double*)FCLIB_MALLOC (sizeof(double)*(probes > 0 ? probes*iterations : 1)));
+  error_keep (tau, release_memory, 1);
+  MM (smin = (double*)FCLIB_MALLOC (sizeof(double)*(probes > 0 ? probes : 1)));
+  error_keep (smin, release_memory, 1);
+  MM (smax = (double*)FCLIB_MALLOC (sizeof(double)*(probes > 0 ? probes : 1)));
+  error_keep (smax, release_memory, 1);
+  MM (steps = (int*)FCLIB_CALLOC (probes > 0 ? probes : 1, sizeof(int)));
+  error_keep (steps, release_memory, 1);
+
+  /* small matrices probed along unit vectors keep their Lanczos vectors for full reorthogonalization;
+   * the work arrays of all threads are allocated here, where a failure can be raised */
+  lanczos = (unit ? (size_t) (iterations+1) * (n+l) : (size_t) 2*(n+l));
+  size = lanczos + n + 4*iterations;
+  MM (work = (double*)FCLIB_MALLOC (sizeof(double)*size*threads));
+  error_keep (work, release_memory, 1);
+
+#pragma omp parallel num_threads(threads)
+  {
+    struct fclib_matrix *up = (mat->m < mat->n ? csc : csr), *down = (mat->m < mat->n ? csr : csc);
+    double *v = work + size*THREAD_NUM, *z, *alpha, *beta, *e;
+    int i, k;
+
+    z = v + lanczos;
+    alpha = z + n;
+    beta = alpha + iterations;
+    e = beta + iterations;
+
+#pragma omp for schedule(dynamic, 1)
+    for (q = 0; q < probes; q ++)
+    {
+      double *d = theta + (size_t) q*iterations, *w = tau + (size_t) q*iterations;
+
+      if (q > 0 && deadline > 0.0 && wall_time () > deadline) continue;
+
+      for (i = 0; i < n; i ++) /* unit vectors or Rademacher vectors */
+        z [i] = (unit ? (i == q) : scene_random (options->seed, (unsigned long long) q * n + i) < 0.5 ? -1.0 : 1.0);
+      k = estimate_bidiagonal (up, down, z, iterations, deadline, unit, alpha, beta, v);
+      estimate_extremes (k, alpha, beta, e, &smin [q], &smax [q]);
+
+      for (i = 0; i < k; i ++) /* B B^T */
+      {
+        d [i] = alpha [i] * alpha [i] + (i > 0 ? beta [i] * beta [i] : 0.0);
+        e [i] = (i+1 < k ? alpha [i] * beta [i+1] : 0.0);
+      }
+      estimate_eigen (k, d, e, w);
+      for (i = 0; i < k; i ++) w [i] *= w [i];
+      steps [q] = k;
+    }
+  }
+  error_drop (work);
+  free (work);
+
+  /* the extreme Ritz values over all probes, then the quadratures n z^T f (A A^T) z / |z|^2 averaged */
+  sigma_min = HUGE_VAL;
+  sigma_max = 0.0;
+  for (done = q = 0; q < probes; q ++)
+    if (steps [q])
+    {
+      done ++;
+      if (smin [q] < sigma_min) sigma_min = smin [q];
+      if (smax [q] > sigma_max) sigma_max = smax [q];
+    }
+  threshold = (tolerance * sigma_max) * (tolerance * sigma_max);
+  for (rank = logdet = 0.0, q = 0; q < probes; q ++)
+    for (j = 0; j < steps [q]; j ++)
+    {
+      double t = theta [(size_t) q*iterations + j], w = tau [(size_t) q*iterations + j];
+
+      rank += w * (t > threshold);
+      logdet += w * log (t > threshold ? t : threshold);
+    }
+  if (done)
+  {
+    rank *= (double) n / done;
+    logdet *= (double) n / done;
+  }
+
+  if (!mat->info) MM (mat->info = (struct fclib_matrix_info*)FCLIB_CALLOC (1, sizeof (struct fclib_matrix_info)));
+  mat->info->rank = (int) floor (rank + 0.5);
+  if (mat->info->rank > n) mat->info->rank = n;
+  mat->info->conditioning = (!done ? 1.0 : sigma_min > 0.0 && mat->info->rank == n ? sigma_max / sigma_min : HUGE_VAL);
+  mat->info->determinant = (mat->m == mat->n && mat->info->rank == n ? exp (0.5 * logdet) : 0.0); /* |det A|: log det A A^T has no sign */
+
+  error_drop (steps);
+  error_drop (smax);
+  error_drop (smin);
+  error_drop (tau);
+  error_drop (theta);
+  error_drop (csc);
+  error_drop (csr);
+  free (steps);
+  free (smax);
+  free (smin);
+  free (tau);
+  free (theta);
+  delete_matrix (csc);
+  delete_matrix (csr);
+
+  return 1;
+}
+
+/* estimate the conditioning, rank and determinant of a matrix */
+FCLIB_STATIC int FCLIB_APICOMPILE fclib_matrix_estimate_info (struct fclib_matrix *mat, struct fclib_estimate_options *options)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
+  }
+
+  result = matrix_estimate_info (mat, options);
+
+  error_leave ();
+  return result;
+}
+
+/* delete matrix */
+FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_matrix (struct fclib_matrix *mat)
+{
+  delete_matrix (mat);
+}
+
+#ifdef FCLIB_WITH_MERIT_FUNCTIONS
+#include "cs.h"
+
+
+FCLIB_STATIC inline double dnrm2(double * v ,  int n)
+{
+  int i;
+  double norm2=0.0;
+#pragma omp simd reduction(+:norm2)
+  for (i=0; i <n ; i++) norm2 += v[i]*v[i];
+  return sqrt(norm2);
+}
+
+FCLIB_STATIC void projectionOnCone(double* r, double  mu)
+{
+  cone_projection(r, mu, 3);
+}
+
+FCLIB_STATIC void FrictionContact3D_unitary_compute_and_add_error(double *z , double *w, double mu, double * error)
+{
+  fclib_merit_contact(3, z, w, mu, error);
+}
+
+/* calculate merit function for a global problem */
+FCLIB_STATIC double fclib_merit_global (struct fclib_global *problem, enum fclib_merit merit, struct fclib_solution *solution)
+{
+  return fclib_merit_global_blocks (problem, NULL, merit, solution);
+}
+
+/* calculate merit function for a global problem with the blocks of a block-diagonal M */
+static double merit_global_blocks (struct fclib_global *problem, struct fclib_block_diagonal *M_blocks, enum fclib_merit merit, struct fclib_solution *solution)
+{
+  struct fclib_matrix * M =  problem->M;
+  struct fclib_matrix * H =  problem->H;
+  struct fclib_matrix * G =  problem->G;
+  struct fclib_block_diagonal * bd = M_blocks;
+
+  double *f = problem->f;
+  double *w = problem->w;
+  double *b = problem->b;
+  double *mu = problem->mu;
+  int d = problem->spacedim;
+  if (d !=3 )
+  {
+    printf("fclib_merit_global for space dimension = %i not yet implemented\n",d);
+    return 0;
+  }
+
+  double *v = solution->v;
+  double *r = solution->r;
+  double *l = solution->l;
+
+  double error_eq, error;
+  double * tmp, * rhs;
+
+  error=0.0;
+  error_eq=0.0;
+  int i, ic, ic3;
+  if (merit == MERIT_1)
+  {
+    STATS_START (start);
+    int n = M->n, n_e = 0;
+    if (G) n_e = G->n;
+
+    /* compute M v - H r - G \lambda - f, with the dense blocks of a block-diagonal M when they are given */
+    MM (tmp = (double *)FCLIB_MALLOC((n > 0 ? n : 1)*sizeof(double)));
+    error_keep (tmp, release_memory, 1);
+    MM (rhs = (double *)FCLIB_MALLOC((n > 0 ? n : 1)*sizeof(double)));
+    error_keep (rhs, release_memory, 1);
+    for (i =0; i <n; i++) tmp[i] = 0.0, rhs[i] = f[i];
+    if (bd && bd->blocks) block_diagonal_gaxpy(bd, bd->blocks, v, tmp);
+    else matrix_gaxpy(M, v, tmp);
+    matrix_gaxpy(H, r, rhs);
+    if (n_e >0) matrix_gaxpy(G, l, rhs);
+    for (i =0; i <n; i++) tmp[i] -= rhs[i];
+    error_eq += dnrm2(tmp,n)/(1.0 +  dnrm2(f,n) );
+    error_drop (rhs);
+    error_drop (tmp);
+    free(rhs);
+    free(tmp);
+
+    /* compute G^T v + b */
+    if (n_e >0)
+    {
+      MM (tmp = (double *)FCLIB_MALLOC(n_e*sizeof(double)));
+      for (i =0; i <n_e; i++) tmp[i] = b[i] ;
+      matrix_gatxpy(G, v, tmp);
+      error_eq += dnrm2(tmp,n_e)/(1.0 +  dnrm2(b,n_e) );
+      free(tmp);
+    }
 
-  IO (main_id = H5Gopen (file_id, "/fclib_global_rolling", H5P_DEFAULT));
-  IO (H5LTread_dataset_int (file_id, "/fclib_global_rolling/spacedim", &problem->spacedim));
+    /* compute u = H^T v + w */
+    MM (tmp = (double *)FCLIB_MALLOC((H->n > 0 ? H->n : 1)*sizeof(double)));
+    for (i =0; i <H->n; i++) tmp[i] = w[i] ;
+    matrix_gatxpy(H, v, tmp);
 
-  IO (id = H5Gopen (file_id, "/fclib_global_rolling/M", H5P_DEFAULT));
-  problem->M = read_matrix (id);
-  IO (H5Gclose (id));
+    /* Compute natural map */
+    int nc = H->n/3;
+    for (ic = 0, ic3 = 0 ; ic < nc ; ic++, ic3 += 3)
+    {
+      FrictionContact3D_unitary_compute_and_add_error(r + ic3, tmp + ic3, mu[ic], &error);
+    }
 
-  IO (id = H5Gopen (file_id, "/fclib_global_rolling/H", H5P_DEFAULT));
-  problem->H = read_matrix (id);
-  IO (H5Gclose (id));
+    free(tmp);
+    error = sqrt(error)/(1.0 +  sqrt(dnrm2(w,H->n)) )+error_eq;
+    STATS_MERIT ("fclib_merit_global", start);
 
-  if (H5Lexists (file_id, "/fclib_global_rolling/G", H5P_DEFAULT))
-  {
-    IO (id = H5Gopen (file_id, "/fclib_global_rolling/G", H5P_DEFAULT));
-    problem->G = read_matrix (id);
-    IO (H5Gclose (id));
+    return error;
   }
 
-  IO (id = H5Gopen (file_id, "/fclib_global_rolling/vectors", H5P_DEFAULT));
-  read_global_rolling_vectors (id, problem);
-  IO (H5Gclose (id));
+  return 0; /* TODO */
+}
+
+/* calculate merit function for a global problem with the blocks of a block-diagonal M */
+FCLIB_STATIC double fclib_merit_global_blocks (struct fclib_global *problem, struct fclib_block_diagonal *M_blocks, enum fclib_merit merit, struct fclib_solution *solution)
+{
+  struct error_context ctx;
+  double result;
 
-  if (H5Lexists (file_id, "/fclib_global_rolling/info", H5P_DEFAULT))
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
   {
-    IO (id = H5Gopen (file_id, "/fclib_global_rolling/info", H5P_DEFAULT));
-    problem->info = read_problem_info (id);
-    IO (H5Gclose (id));
+    error_catch ();
+    return -1.0;
   }
 
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
+  result = merit_global_blocks (problem, M_blocks, merit, solution);
 
-  return problem;
+  error_leave ();
+  return result;
 }
-/* read local problem;
- * return problem on success; NULL on failure */
-FCLIB_STATIC struct FCLIB_APICOMPILE fclib_local* fclib_read_local (const char *path)
-{
-  struct fclib_local *problem;
-  hid_t  file_id, main_id, id;
-
-  if ((file_id = H5Fopen (path, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)
-  {
-    fprintf (stderr, "ERROR: opening file failed\n");
-    return NULL;
-  }
 
-  if (!H5Lexists (file_id, "/fclib_local", H5P_DEFAULT))
-  {
-    fprintf (stderr, "ERROR: spurious input file %s :: fclib_local group does not exists", path);
-    return NULL;
-  }
+/* merit function MERIT_1 of a 3d local problem, with W given in any storage and a workspace
+ * of W->n plus the number of equality constraints doubles */
+static double merit_local_1 (struct fclib_local *problem, struct fclib_matrix *W, double *r, double *l, double *work)
+{
+  struct fclib_matrix * V =  problem->V;
+  struct fclib_matrix * R =  problem->R;
 
-  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  double *mu = problem->mu;
+  double *q = problem->q;
+  double *s = problem->s;
 
-  IO (main_id = H5Gopen (file_id, "/fclib_local", H5P_DEFAULT));
-  IO (H5LTread_dataset_int (file_id, "/fclib_local/spacedim", &problem->spacedim));
+  double error_l, error;
+  double * tmp;
 
-  IO (id = H5Gopen (file_id, "/fclib_local/W", H5P_DEFAULT));
-  problem->W = read_matrix (id);
-  IO (H5Gclose (id));
+  error=0.0;
+  error_l=0.0;
+  int i, ic, ic3;
+  STATS_START (start);
 
-  if (H5Lexists (file_id, "/fclib_local/V", H5P_DEFAULT))
+  int n_e =0;
+  if (R) n_e = R->n;
+  /* compute V^T {r} + R \lambda + s */
+  if (n_e >0)
   {
-    IO (id = H5Gopen (file_id, "/fclib_local/V", H5P_DEFAULT));
-    problem->V = read_matrix (id);
-    IO (H5Gclose (id));
-
-    IO (id = H5Gopen (file_id, "/fclib_local/R", H5P_DEFAULT));
-    problem->R = read_matrix (id);
-    IO (H5Gclose (id));
+    tmp = work + W->n;
+    for (i =0; i <n_e; i++) tmp[i] = s[i] ;
+    matrix_gatxpy(V, r, tmp);
+    matrix_gaxpy(R, l, tmp);
+    error_l += dnrm2(tmp,n_e)/(1.0 +  dnrm2(s,n_e) );
   }
+  /* compute  \hat u = W {r}    + V\lambda  + q  */
 
-  IO (id = H5Gopen (file_id, "/fclib_local/vectors", H5P_DEFAULT));
-  read_local_vectors (id, problem);
-  IO (H5Gclose (id));
+  tmp = work;
+  for (i =0; i <W->n; i++) tmp[i] = q[i] ;
+  if (n_e >0) matrix_gaxpy(V, l, tmp);
+  matrix_gaxpy(W, r, tmp);
 
-  if (H5Lexists (file_id, "/fclib_local/info", H5P_DEFAULT))
+  /* Compute natural map */
+  int nc = W->n/3;
+  for (ic = 0, ic3 = 0 ; ic < nc ; ic++, ic3 += 3)
   {
-    IO (id = H5Gopen (file_id, "/fclib_local/info", H5P_DEFAULT));
-    problem->info = read_problem_info (id);
-    IO (H5Gclose (id));
+    FrictionContact3D_unitary_compute_and_add_error(r + ic3, tmp + ic3, mu[ic], &error);
   }
 
-  IO (H5Gclose (main_id));
-  IO (H5Fclose (file_id));
+  error = sqrt(error)/(1.0 +  sqrt(dnrm2(q,W->n)) )+error_l;
+  STATS_MERIT ("fclib_merit_local", start);
 
-  return problem;
+  return error;
 }
 
-/* read solution;
- * return solution on success; NULL on failure */
-FCLIB_STATIC struct FCLIB_APICOMPILE fclib_solution* fclib_read_solution (const char *path)
+/* calculate merit function for a local problem */
+static double merit_local (struct fclib_local *problem, enum fclib_merit merit, struct fclib_solution *solution)
 {
-  struct fclib_solution *solution;
-  hid_t  file_id, id;
-  int nv, nr, nl;
-
-  if ((file_id = H5Fopen (path, H5F_ACC_RDONLY, H5P_DEFAULT)) < 0)  /* overwrite */
+  int d = problem->spacedim;
+  if (d !=3 )
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
+    printf("fclib_merit_local for space dimension = %i not yet implemented\n",d);
     return 0;
   }
 
-  MM (solution = (struct fclib_solution*)malloc (sizeof (struct fclib_solution)));
-
-  if (! read_nvnunrnl (file_id, &nv, &nr, &nl)) return 0;
+  if (merit == MERIT_1)
+  {
+    int n_e = (problem->R ? problem->R->n : 0);
+    double error, *work;
 
-  IO (id = H5Gopen (file_id, "/solution", H5P_DEFAULT));
-  read_solution (id, nv, nr, nl, solution);
-  IO (H5Gclose (id));
+    MM (work = (double *)FCLIB_MALLOC((problem->W->n + n_e > 0 ? problem->W->n + n_e : 1)*sizeof(double)));
+    error = merit_local_1(problem, problem->W, solution->r, solution->l, work);
+    free(work);
 
-  IO (H5Fclose (file_id));
+    return error;
+  }
 
-  return solution;
+  return 0; /* TODO */
 }
 
-/* read initial guesses;
- * return vector of guesses on success; NULL on failure;
- * output numebr of guesses in the variable pointed by 'number_of_guesses' */
-FCLIB_STATIC struct FCLIB_APICOMPILE fclib_solution* fclib_read_guesses (const char *path, int *number_of_guesses)
+/* calculate merit function for a local problem */
+FCLIB_STATIC double fclib_merit_local (struct fclib_local *problem, enum fclib_merit merit, struct fclib_solution *solution)
 {
-  struct fclib_solution *guesses;
-  hid_t  file_id, main_id, id;
-  int nv, nr, nl, i;
-  char num [128];
+  struct error_context ctx;
+  double result;
 
-  if ((file_id = H5Fopen (path, H5F_ACC_RDWR, H5P_DEFAULT)) < 0)  /* overwrite */
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
   {
-    fprintf (stderr, "ERROR: opening file failed\n");
-    return 0;
+    error_catch ();
+    return -1.0;
   }
 
-  if (! read_nvnunrnl (file_id, &nv, &nr, &nl)) return 0;
+  result = merit_local (problem, merit, solution);
 
-  if (H5Lexists (file_id, "/guesses", H5P_DEFAULT))
-  {
-    IO (main_id = H5Gopen (file_id, "/guesses", H5P_DEFAULT));
+  error_leave ();
+  return result;
+}
 
-    IO (H5LTread_dataset_int (file_id, "/guesses/number_of_guesses", number_of_guesses));
+/* solve the single contact problem u = A r + b, C* contains u + mu ||u_T|| e_N perpendicular to r in C, warm started from r;
+ * ainv is the inverse of the 3x3 block A, or NULL when A is singular */
+static void contact_solve (const double *a, const double *ainv, double rho, double mu, const double *b, double *r)
+{
+  double u [3], t [3], diff, norm;
+  int k;
 
-    MM (guesses = (struct fclib_solution*)malloc ((*number_of_guesses) * sizeof (struct fclib_solution)));
+  if (b [0] >= 0.0) /* taking off: r = 0 and u = b */
+  {
+    r [0] = r [1] = r [2] = 0.0;
+    return;
+  }
 
-    for (i = 0; i < *number_of_guesses; i ++)
+  if (ainv) /* sticking: u = 0 */
+  {
+    t [0] = t [1] = t [2] = 0.0;
+    block_gemv (3, ainv, b, t);
+    if (-t [0] >= 0.0 && hypot (t [1], t [2]) <= -mu * t [0])
     {
-      snprintf (num, 128, "%d", i+1);
-      IO (id = H5Gopen (main_id, num, H5P_DEFAULT));
-      read_solution (id, nv, nr, nl, &guesses [i]);
-      IO (H5Gclose (id));
+      r [0] = -t [0];
+      r [1] = -t [1];
+      r [2] = -t [2];
+      return;
     }
-
-    IO (H5Gclose (main_id));
   }
 
-  IO (H5Fclose (file_id));
-
-  return guesses;
+  for (k = 0; k < 100; k ++) /* sliding: fixed point r = P_C (r - rho (u + mu ||u_T|| e_N)) */
+  {
+    u [0] = b [0];
+    u [1] = b [1];
+    u [2] = b [2];
+    block_gemv (3, a, r, u);
+    t [0] = r [0] - rho * (u [0] + mu * hypot (u [1], u [2]));
+    t [1] = r [1] - rho * u [1];
+    t [2] = r [2] - rho * u [2];
+    projectionOnCone (t, mu);
+    diff = (t [0]-r [0])*(t [0]-r [0]) + (t [1]-r [1])*(t [1]-r [1]) + (t [2]-r [2])*(t [2]-r [2]);
+    norm = t [0]*t [0] + t [1]*t [1] + t [2]*t [2];
+    r [0] = t [0];
+    r [1] = t [1];
+    r [2] = t [2];
+    if (diff <= 1e-28 * (1.0 + norm)) break;
+  }
 }
 
-/* delete global problem */
-FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_global (struct fclib_global *problem)
+/* diagonal blocks of a 3d local problem in compressed rows, with their inverses and fixed point steps;
+ * regular [c] is 0 when block c is singular */
+static void contact_blocks (struct fclib_matrix *csr, double *diag, double *dinv, double *rho, char *regular)
 {
-  delete_matrix (problem->M);
-  delete_matrix (problem->H);
-  delete_matrix (problem->G);
-  free (problem->mu);
-  free (problem->f);
-  if (problem->b) free (problem->b);
-  free (problem->w);
-  delete_info (problem->info);
-}
+  int nc = csr->m/3, c, r, k;
+  double work [9];
 
-/* delete local problem */
-FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_local (struct fclib_local *problem)
-{
-  delete_matrix (problem->W);
-  delete_matrix (problem->V);
-  delete_matrix (problem->R);
-  free (problem->mu);
-  free (problem->q);
-  if (problem->s) free (problem->s);
-  delete_info (problem->info);
-}
-/* delete global problem */
-FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_global_rolling (struct fclib_global_rolling *problem)
-{
-  delete_matrix (problem->M);
-  delete_matrix (problem->H);
-  delete_matrix (problem->G);
-  free (problem->mu);
-  free (problem->mu_r);
-  free (problem->f);
-  if (problem->b) free (problem->b);
-  free (problem->w);
-  delete_info (problem->info);
+#pragma omp parallel for private(r, k, work) if (csr->p [csr->m] > FCLIB_PARALLEL_MIN)
+  for (c = 0; c < nc; c ++)
+  {
+    double *a = diag + 9*c, norm = 0.0;
+
+    for (k = 0; k < 9; k ++) a [k] = 0.0;
+    for (r = 0; r < 3; r ++)
+      for (k = csr->p [3*c+r]; k < csr->p [3*c+r+1]; k ++)
+        if (csr->i [k] >= 3*c && csr->i [k] < 3*c+3) a [3*r + csr->i [k]-3*c] += csr->x [k];
+    for (k = 0; k < 9; k ++) norm += a [k]*a [k];
+    rho [c] = (norm > 0.0 ? 1.0 / sqrt (norm) : 1.0);
+    regular [c] = (char) block_inverse (3, a, dinv + 9*c, work);
+  }
 }
 
-
-
-/* delete solutions or guesses */
-FCLIB_STATIC void FCLIB_APICOMPILE fclib_delete_solutions (struct fclib_solution *data, int count)
+/* one Gauss-Seidel sweep over the contacts [first, last) of a list (all contacts in order when list is NULL) */
+static void contact_sweep (struct fclib_local *problem, struct fclib_matrix *csr, double *diag, double *dinv, double *rho, char *regular,
+                           int *list, int first, int last, double *r)
 {
-  int i;
+  int j, c, k, row;
+  double b [3];
 
-  for (i = 0; i < count; i ++)
+  for (j = first; j < last; j ++)
   {
-    if (data [i].v) free (data [i].v);
-    if (data [i].u) free (data [i].u);
-    if (data [i].r) free (data [i].r);
-    if (data [i].l) free (data [i].l);
-  }
+    c = (list ? list [j] : j);
+    for (row = 0; row < 3; row ++) /* b = q_c + W_c r - A_c r_c */
+    {
+      double sum = problem->q [3*c+row];
+      for (k = csr->p [3*c+row]; k < csr->p [3*c+row+1]; k ++) sum += csr->x [k] * r [csr->i [k]];
+      b [row] = sum;
+    }
+    for (row = 0; row < 3; row ++)
+      b [row] -= diag [9*c+3*row] * r [3*c] + diag [9*c+3*row+1] * r [3*c+1] + diag [9*c+3*row+2] * r [3*c+2];
 
-  free (data);
+    contact_solve (diag + 9*c, regular [c] ? dinv + 9*c : NULL, rho [c], problem->mu [c], b, r + 3*c);
+  }
 }
 
-#ifdef FCLIB_WITH_MERIT_FUNCTIONS
-#include "cs.h"
-
-
-FCLIB_STATIC inline double dnrm2(double * v ,  int n)
+/* update contact c in an asynchronous sweep; other threads update coupled contacts at the same time, so that
+ * the reactions are read, and those of c written, one component at a time with atomic accesses */
+static void contact_update_atomic (struct fclib_local *problem, struct fclib_matrix *csr, double *diag, double *dinv, double *rho, char *regular,
+                                   int c, double *r)
 {
-  int i;
-  double norm2=0.0;
-  for (i=0; i <n ; i++) norm2 += v[i]*v[i];
-  return sqrt(norm2);
-}
+  int k, row;
+  double b [3], rc [3], x;
 
-FCLIB_STATIC inline void projectionOnCone(double* r, double  mu)
-{
-  double normT = hypot(r[1], r[2]);
-  if (mu * normT <= - r[0])
+  for (row = 0; row < 3; row ++) /* b = q_c + W_c r - A_c r_c */
   {
-    r[0] = 0.0;
-    r[1] = 0.0;
-    r[2] = 0.0;
-    return ;
-  }
-  else if (normT <= mu * r[0])
-  {
-    return ;
+    double sum = problem->q [3*c+row];
+    for (k = csr->p [3*c+row]; k < csr->p [3*c+row+1]; k ++)
+    {
+#pragma omp atomic read
+      x = r [csr->i [k]];
+      sum += csr->x [k] * x;
+    }
+    b [row] = sum;
   }
-  else
+  rc [0] = r [3*c]; /* only this thread writes the reactions of c */
+  rc [1] = r [3*c+1];
+  rc [2] = r [3*c+2];
+  for (row = 0; row < 3; row ++)
+    b [row] -= diag [9*c+3*row] * rc [0] + diag [9*c+3*row+1] * rc [1] + diag [9*c+3*row+2] * rc [2];
+
+  contact_solve (diag + 9*c, regular [c] ? dinv + 9*c : NULL, rho [c], problem->mu [c], b, rc);
+
+  for (row = 0; row < 3; row ++)
   {
-    double mu2 = mu * mu;
-    r[0] = (mu * normT + r[0]) / (mu2 + 1.0);
-    r[1] = mu * r[0] * r[1] / normT;
-    r[2] = mu * r[0] * r[2] / normT;
-    return;
+#pragma omp atomic write
+    r [3*c+row] = rc [row];
   }
 }
 
-FCLIB_STATIC void FrictionContact3D_unitary_compute_and_add_error(double *z , double *w, double mu, double * error)
+/* greedy coloring of the contacts such that no two contacts coupled by a block of W share a color;
+ * on exit the contacts of color k are list [color [k]..color [k+1]-1]; returns the number of colors */
+static int contact_colors (struct fclib_matrix *csr, int *list, int **color)
 {
+  struct fclib_matrix *graph;
+  int nc = csr->m/3, ncolors = 0, *colorof, *used, c, k, l;
 
-  double normUT;
-  double worktmp[3];
-  /* Compute the modified local velocity */
-  normUT = hypot(w[1], w[2]); // i.e sqrt(w[ic3p1]*w[ic3p1]+w[ic3p2]*w[ic3p2]);
-  worktmp[0] = z[0] -  (w[0] + mu * normUT);
-  worktmp[1] = z[1] -   w[1] ;
-  worktmp[2] = z[2] -  w[2] ;
-  projectionOnCone(worktmp, mu);
-  worktmp[0] = z[0] -  worktmp[0];
-  worktmp[1] = z[1] -  worktmp[1];
-  worktmp[2] = z[2] -  worktmp[2];
-  *error +=  worktmp[0] * worktmp[0] + worktmp[1] * worktmp[1] + worktmp[2] * worktmp[2];
+  graph = contact_graph (csr, 3);
 
-}
+  MM (colorof = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+  MM (used = (int*)FCLIB_MALLOC (sizeof(int)*(nc+1)));
+  for (c = 0; c < nc; c ++) used [c] = -1;
+  for (c = 0; c < nc; c ++) /* smallest color not used by a colored neighbour */
+  {
+    for (k = graph->p [c]; k < graph->p [c+1]; k ++)
+      if (graph->i [k] < c) used [colorof [graph->i [k]]] = c;
+    for (l = 0; used [l] == c; l ++);
+    colorof [c] = l;
+    if (l+1 > ncolors) ncolors = l+1;
+  }
+  delete_matrix (graph);
 
-/* calculate merit function for a global problem */
-FCLIB_STATIC double fclib_merit_global (struct fclib_global *problem, enum fclib_merit merit, struct fclib_solution *solution)
-{
-  return 0; /* TODO */
+  MM (*color = (int*)FCLIB_CALLOC (ncolors+1, sizeof(int)));
+  for (c = 0; c < nc; c ++) (*color) [colorof [c]] ++;
+  cumsum (*color, ncolors);
+  memcpy (used, *color, sizeof(int)*ncolors);
+  for (c = 0; c < nc; c ++) list [used [colorof [c]] ++] = c;
+
+  free (used);
+  free (colorof);
+
+  return ncolors;
 }
 
-/* calculate merit function for a local problem */
-FCLIB_STATIC double fclib_merit_local (struct fclib_local *problem, enum fclib_merit merit, struct fclib_solution *solution)
+/* solve a local problem by projected Gauss-Seidel */
+static int solve_local (struct fclib_local *problem, struct fclib_solution *solution, struct fclib_solver_options *options, struct fclib_solver_info *info)
 {
+  struct fclib_solver_options defaults = {0, 0.0, 0, FCLIB_SOLVER_SERIAL, 0};
+  struct fclib_matrix *W;
+  double *diag, *dinv, *rho, *work, *history [2] = {NULL, NULL}, tolerance, error = 0.0, start = wall_time ();
+  int nc, max_iterations, check_interval, ncolors = 0, checks = 0, *list = NULL, *color = NULL, iter, i, j, k;
+#ifdef _OPENMP
+  int threads;
+#endif
+  char *regular;
 
-  struct fclib_matrix * W =  problem->W;
-  struct fclib_matrix * V =  problem->V;
-  struct fclib_matrix * R =  problem->R;
+  if (!options) options = &defaults;
+#ifdef _OPENMP
+  threads = THREADS (options->threads);
+#endif
+  max_iterations = (options->max_iterations > 0 ? options->max_iterations : 1000);
+  tolerance = (options->tolerance > 0.0 ? options->tolerance : 1e-8);
+  check_interval = (options->check_interval > 0 ? options->check_interval : 1);
 
-  double *mu = problem->mu;
-  double *q = problem->q;
-  double *s = problem->s;
-  int d = problem->spacedim;
-  if (d !=3 )
+  if (problem->spacedim != 3 || (problem->R && problem->R->n > 0))
   {
-    printf("fclib_merit_local for space dimension = %i not yet implemented\n",d);
+    error_report (FCLIB_ERROR_INVALID, "ERROR: only 3d local problems without equality constraints can be solved");
     return 0;
   }
 
-  double *v = solution->v;
-  double *r = solution->r;
-  double *u = solution->u;
-  double *l = solution->l;
-
-  double error_l, error;
-  double * tmp;
-
-  error=0.0;
-  error_l=0.0;
-  int i, ic, ic3;
-  if (merit == MERIT_1)
+  W = matrix_convert (problem->W, -2);
+  if (!W) return 0;
+  error_keep (W, release_matrix, 1);
+  nc = W->m/3;
+  MM (diag = (double*)FCLIB_MALLOC (sizeof(double)*(nc > 0 ? 9*nc : 1)));
+  error_keep (diag, release_memory, 1);
+  MM (dinv = (double*)FCLIB_MALLOC (sizeof(double)*(nc > 0 ? 9*nc : 1)));
+  error_keep (dinv, release_memory, 1);
+  MM (rho = (double*)FCLIB_MALLOC (sizeof(double)*(nc > 0 ? nc : 1)));
+  error_keep (rho, release_memory, 1);
+  MM (regular = (char*)FCLIB_MALLOC (nc > 0 ? nc : 1));
+  error_keep (regular, release_memory, 1);
+  MM (work = (double*)FCLIB_MALLOC (sizeof(double)*(W->n > 0 ? W->n : 1)));
+  error_keep (work, release_memory, 1);
+  contact_blocks (W, diag, dinv, rho, regular);
+  if (options->mode == FCLIB_SOLVER_COLORED)
+  {
+    MM (list = (int*)FCLIB_MALLOC (sizeof(int)*(nc > 0 ? nc : 1)));
+    error_keep (list, release_memory, 1);
+    ncolors = contact_colors (W, list, &color);
+    error_keep (color, release_memory, 1);
+  }
+  if (info)
   {
+    k = max_iterations / check_interval + 1;
+    MM (history [0] = (double*)FCLIB_MALLOC (sizeof(double)*k));
+    error_keep (history [0], release_memory, 1);
+    MM (history [1] = (double*)FCLIB_MALLOC (sizeof(double)*k));
+    error_keep (history [1], release_memory, 1);
+  }
 
-    /* cs M_cs;  */
-    /* fclib_matrix_to_cssparse(W, &M_cs); */
-    /* cs V_cs;  */
-    /* fclib_matrix_to_cssparse(V, &V_cs); */
-    /* cs R_cs;  */
-    /* fclib_matrix_to_cssparse(R, &R_cs); */
-    int n_e =0;
-    if (R) n_e = R->n;
-    /* compute V^T {r} + R \lambda + s */
-    if (n_e >0)
+  for (iter = 1; iter <= max_iterations; iter ++)
+  {
+    if (options->mode == FCLIB_SOLVER_COLORED)
     {
-      cs * VT = cs_transpose((cs *)V, 0) ;
-      tmp = (double *)malloc(n_e*sizeof(double));
-      for (i =0; i <n_e; i++) tmp[i] = s[i] ;
-      cs_gaxpy(VT, r, tmp);
-      cs_gaxpy((cs *)R, l, tmp);
-      error_l += dnrm2(tmp,n_e)/(1.0 +  dnrm2(s,n_e) );
-      free(tmp);
+#pragma omp parallel private(k) num_threads(threads)
+      for (k = 0; k < ncolors; k ++)
+      {
+#pragma omp for schedule(static)
+        for (j = color [k]; j < color [k+1]; j ++) contact_sweep (problem, W, diag, dinv, rho, regular, list, j, j+1, solution->r);
+      }
     }
-    /* compute  \hat u = W {r}    + V\lambda  + q  */
-
-    tmp = (double *)malloc(W->n*sizeof(double));
-    for (i =0; i <W->n; i++) tmp[i] = q[i] ;
-    cs_gaxpy((cs*)V, l, tmp);
-    cs_gaxpy((cs*)W, r, tmp);
+    else if (options->mode == FCLIB_SOLVER_ASYNCHRONOUS)
+    {
+      /* concurrent updates of coupled contacts read whichever reactions are in memory */
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+      for (j = 0; j < nc; j ++) contact_update_atomic (problem, W, diag, dinv, rho, regular, j, solution->r);
+    }
+    else contact_sweep (problem, W, diag, dinv, rho, regular, NULL, 0, nc, solution->r);
 
-    /* Compute natural map */
-    int nc = W->n/3;
-    for (ic = 0, ic3 = 0 ; ic < nc ; ic++, ic3 += 3)
+    if (iter % check_interval == 0 || iter == max_iterations)
     {
-      FrictionContact3D_unitary_compute_and_add_error(r + ic3, tmp + ic3, mu[ic], &error);
+      error = merit_local_1 (problem, W, solution->r, NULL, work);
+      if (info)
+      {
+        history [0][checks] = error;
+        history [1][checks] = wall_time () - start;
+      }
+      checks ++;
+      if (error <= tolerance) break;
     }
+  }
+  if (iter > max_iterations) iter = max_iterations;
 
-    free(tmp);
-    error = sqrt(error)/(1.0 +  sqrt(dnrm2(q,W->n)) )+error_l;
+  if (solution->u) /* u = W r + q */
+  {
+    for (i = 0; i < W->n; i ++) solution->u [i] = problem->q [i];
+    matrix_gaxpy (W, solution->r, solution->u);
+  }
 
-    /* printf("error_l = %12.8e", error_l); */
-    /* printf("norm of u  = %12.8e\n",  dnrm2(u,W->n)); */
-    /* printf("norm of r  = %12.8e\n",  dnrm2(r,W->n)); */
-    /* printf("error = %12.8e\n", error); */
+  if (info)
+  {
+    info->iterations = iter;
+    info->error = error;
+    info->converged = (error <= tolerance);
+    info->time = wall_time () - start;
+    info->colors = ncolors;
+    info->checks = checks;
+    info->history_error = history [0];
+    info->history_time = history [1];
+  }
 
-    return error;
+  error_drop (history [1]);
+  error_drop (history [0]);
+  error_drop (color);
+  error_drop (list);
+  error_drop (work);
+  error_drop (regular);
+  error_drop (rho);
+  error_drop (dinv);
+  error_drop (diag);
+  error_drop (W);
+  delete_matrix (W);
+  free (diag);
+  free (dinv);
+  free (rho);
+  free (regular);
+  free (work);
+  free (list);
+  free (color);
+
+  return error <= tolerance;
+}
+
+/* solve a local problem by projected Gauss-Seidel;
+ * return 1 when the tolerance is reached, 0 otherwise */
+FCLIB_STATIC int fclib_solve_local (struct fclib_local *problem, struct fclib_solution *solution, struct fclib_solver_options *options, struct fclib_solver_info *info)
+{
+  struct error_context ctx;
+  int result;
+
+  error_enter (&ctx);
+  if (setjmp (ctx.env))
+  {
+    error_catch ();
+    return 0;
   }
 
-  return 0; /* TODO */
+  result = solve_local (problem, solution, options, info);
+
+  error_leave ();
+  return result;
 }
 #endif /* FCLIB_WITH_MERIT_FUNCTIONS */
 
+#undef FCLIB_H5LTMAKE_DATASET_INT /* internal to the implementation */
+#undef FCLIB_H5LTMAKE_DATASET_DOUBLE
+#undef FCLIB_H5LTMAKE_DATASET_STRING
+#undef FCLIB_H5LTREAD_DATASET_INT
+#undef FCLIB_H5LTREAD_DATASET_DOUBLE
+#undef FCLIB_H5LTREAD_DATASET_STRING
+#undef FCLIB_H5DREAD
+#undef FCLIB_H5DWRITE
+#undef FCLIB_MALLOC
+#undef FCLIB_CALLOC
+#undef FCLIB_REALLOC
+
+#undef FAIL /* the including file may define its own */
+#undef ASSERT
+#undef IO
+#undef MM
+
 #endif /* FCLIB_IMPLEMENTATION */
 /*@@*/
 
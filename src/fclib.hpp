@@ -0,0 +1,762 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+
+/*!\file fclib.hpp
+ * ----------------------------------------------
+ * C++17 interface of fclib.h: move-only owners of problems and solutions,
+ * views of their arrays without copies, and SpMV and merit kernels
+ * specialized at compile time on the storage and the space dimension;
+ * failures throw fclib::error
+ */
+
+#ifndef _fclib_hpp_
+#define _fclib_hpp_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#endif
+
+#include "fclib.h"
+
+namespace fclib
+{
+
+#if defined(__cpp_lib_span)
+template <class T> using span = std::span<T>;
+#else
+/** view of contiguous elements, std::span before C++20 */
+template <class T> class span
+{
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using size_type = std::size_t;
+  using iterator = T*;
+
+  constexpr span () noexcept : data_ (nullptr), size_ (0) {}
+  constexpr span (T *data, size_type size) noexcept : data_ (data), size_ (size) {}
+
+  /** view of a container with data () and size (), or of a span of less qualified elements */
+  template <class C, class = std::enable_if_t<std::is_convertible_v<decltype (std::declval<C&> ().data ()), T*>>>
+  constexpr span (C &&c) noexcept : data_ (c.data ()), size_ (c.size ()) {}
+
+  constexpr T* data () const noexcept { return data_; }
+  constexpr size_type size () const noexcept { return size_; }
+  constexpr bool empty () const noexcept { return size_ == 0; }
+  constexpr T& operator [] (size_type k) const noexcept { return data_ [k]; }
+  constexpr iterator begin () const noexcept { return data_; }
+  constexpr iterator end () const noexcept { return data_ + size_; }
+
+private:
+  T *data_;
+  size_type size_;
+};
+#endif
+
+/** exception thrown by the failing calls, with the code and message of fclib_last_error */
+class error : public std::runtime_error
+{
+public:
+  error (int code, const std::string &message) : std::runtime_error (message), code_ (code) {}
+
+  /** one of fclib_error */
+  int code () const noexcept { return code_; }
+
+private:
+  int code_;
+};
+
+namespace detail
+{
+  /* throw the last error, or 'what' when none was recorded */
+  [[noreturn]] inline void raise (const char *what)
+  {
+    const char *message;
+    int code = fclib_last_error (&message);
+
+    throw error (code ? code : FCLIB_ERROR_INVALID, message [0] ? message : what);
+  }
+
+  /* elements of the arrays of a matrix */
+  inline std::size_t pointers (const fclib_matrix *A) noexcept
+  {
+    if (A->nz >= 0) return (std::size_t) A->nz;
+    if (A->nz == FCLIB_CSR) return (std::size_t) A->m + 1;
+    if (A->nz == FCLIB_BSR) return (std::size_t) (A->m / A->bs) + 1;
+    return (std::size_t) A->n + 1;
+  }
+
+  inline std::size_t indices (const fclib_matrix *A) noexcept
+  {
+    if (A->nz >= 0) return (std::size_t) A->nz;
+    if (A->nz == FCLIB_BSR) return (std::size_t) (A->nzmax / (A->bs * A->bs));
+    return (std::size_t) A->nzmax;
+  }
+
+  inline std::size_t values (const fclib_matrix *A) noexcept
+  {
+    return A->nz >= 0 ? (std::size_t) A->nz : (std::size_t) A->nzmax;
+  }
+
+  template <class T> span<T> view (T *data, std::size_t size) noexcept
+  {
+    return data ? span<T> (data, size) : span<T> ();
+  }
+
+  /* copy a file image written by fclib and release it */
+  inline std::vector<unsigned char> image (void *buffer, std::size_t size)
+  {
+    std::unique_ptr<void, void (*) (void*)> owner (buffer, std::free);
+    const unsigned char *bytes = static_cast<const unsigned char*> (buffer);
+
+    return std::vector<unsigned char> (bytes, bytes + size);
+  }
+}
+
+/** storage of a matrix, one of fclib_storage */
+inline int storage (const fclib_matrix &A) noexcept
+{
+  return A.nz >= 0 ? FCLIB_TRIPLET : A.nz;
+}
+
+/** view of a matrix owned by a problem; M is fclib_matrix or const fclib_matrix */
+template <class M> class basic_matrix_view
+{
+public:
+  using index_type = std::conditional_t<std::is_const_v<M>, const int, int>;
+  using value_type = std::conditional_t<std::is_const_v<M>, const double, double>;
+
+  basic_matrix_view () noexcept : A_ (nullptr) {}
+  explicit basic_matrix_view (M *A) noexcept : A_ (A) {}
+  template <class N, class = std::enable_if_t<std::is_convertible_v<N*, M*>>>
+  basic_matrix_view (const basic_matrix_view<N> &other) noexcept : A_ (other.get ()) {}
+
+  /** false for an absent matrix, e.g. V and R of a problem without equality constraints */
+  explicit operator bool () const noexcept { return A_ != nullptr; }
+  M* get () const noexcept { return A_; }
+  M& operator * () const noexcept { return *A_; }
+  M* operator -> () const noexcept { return A_; }
+
+  int rows () const noexcept { return A_->m; }
+  int cols () const noexcept { return A_->n; }
+  int storage () const noexcept { return fclib::storage (*A_); }
+  int block_size () const noexcept { return A_->nz == FCLIB_BSR ? A_->bs : 1; }
+
+  /** number of stored values */
+  int nnz () const noexcept
+  {
+    switch (storage ())
+    {
+    case FCLIB_TRIPLET: return A_->nz;
+    case FCLIB_CSR: return A_->p [A_->m];
+    case FCLIB_BSR: return A_->p [A_->m / A_->bs] * A_->bs * A_->bs;
+    default: return A_->p [A_->n];
+    }
+  }
+
+  /** row indices (triplet), column or row pointers (compressed) and values, see fclib_matrix */
+  span<index_type> p () const noexcept { return detail::view<index_type> (A_->p, detail::pointers (A_)); }
+  span<index_type> i () const noexcept { return detail::view<index_type> (A_->i, detail::indices (A_)); }
+  span<value_type> x () const noexcept { return detail::view<value_type> (A_->x, detail::values (A_)); }
+
+private:
+  M *A_;
+};
+
+using MatrixView = basic_matrix_view<fclib_matrix>;
+using ConstMatrixView = basic_matrix_view<const fclib_matrix>;
+
+/** y += A x for the storage Storage (one of fclib_storage) and, for FCLIB_BSR, the block size
+ *  Bs (0 for the one of A) known at compile time */
+template <int Storage, int Bs = 0> void gaxpy (ConstMatrixView A, span<const double> x, span<double> y)
+{
+  const int *p = A->p, *i = A->i;
+  const double *a = A->x;
+  double *yv = y.data ();
+  const double *xv = x.data ();
+
+  if constexpr (Storage == FCLIB_TRIPLET)
+  {
+    for (int k = 0; k < A->nz; k ++) yv [p [k]] += a [k] * xv [i [k]];
+  }
+  else if constexpr (Storage == FCLIB_CSC)
+  {
+    for (int j = 0; j < A->n; j ++)
+      for (int k = p [j]; k < p [j+1]; k ++) yv [i [k]] += a [k] * xv [j];
+  }
+  else if constexpr (Storage == FCLIB_CSR)
+  {
+    for (int j = 0; j < A->m; j ++)
+    {
+      double yj = 0.0;
+      for (int k = p [j]; k < p [j+1]; k ++) yj += a [k] * xv [i [k]];
+      yv [j] += yj;
+    }
+  }
+  else if constexpr (Storage == FCLIB_BSR)
+  {
+    const int bs = (Bs > 0 ? Bs : A->bs);
+    for (int j = 0; j < A->m / bs; j ++)
+      for (int k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + bs*bs*k, *xk = xv + bs*i [k];
+        for (int r = 0; r < bs; r ++)
+        {
+          double yr = 0.0;
+          for (int c = 0; c < bs; c ++) yr += b [r*bs+c] * xk [c];
+          yv [bs*j+r] += yr;
+        }
+      }
+  }
+  else
+  {
+    static_assert (Storage == FCLIB_SYMMETRIC, "unknown fclib_storage");
+    for (int j = 0; j < A->n; j ++)
+    {
+      double xj = xv [j], yj = 0.0;
+      for (int k = p [j]; k < p [j+1]; k ++)
+      {
+        int r = i [k];
+        yv [r] += a [k] * xj;
+        if (r != j) yj += a [k] * xv [r];
+      }
+      yv [j] += yj;
+    }
+  }
+}
+
+/** y += A^T x, see gaxpy */
+template <int Storage, int Bs = 0> void gatxpy (ConstMatrixView A, span<const double> x, span<double> y)
+{
+  const int *p = A->p, *i = A->i;
+  const double *a = A->x;
+  double *yv = y.data ();
+  const double *xv = x.data ();
+
+  if constexpr (Storage == FCLIB_TRIPLET)
+  {
+    for (int k = 0; k < A->nz; k ++) yv [i [k]] += a [k] * xv [p [k]];
+  }
+  else if constexpr (Storage == FCLIB_CSC)
+  {
+    for (int j = 0; j < A->n; j ++)
+    {
+      double yj = 0.0;
+      for (int k = p [j]; k < p [j+1]; k ++) yj += a [k] * xv [i [k]];
+      yv [j] += yj;
+    }
+  }
+  else if constexpr (Storage == FCLIB_CSR)
+  {
+    for (int j = 0; j < A->m; j ++)
+      for (int k = p [j]; k < p [j+1]; k ++) yv [i [k]] += a [k] * xv [j];
+  }
+  else if constexpr (Storage == FCLIB_BSR)
+  {
+    const int bs = (Bs > 0 ? Bs : A->bs);
+    for (int j = 0; j < A->m / bs; j ++)
+      for (int k = p [j]; k < p [j+1]; k ++)
+      {
+        const double *b = a + bs*bs*k, *xj = xv + bs*j;
+        for (int c = 0; c < bs; c ++)
+        {
+          double yc = 0.0;
+          for (int r = 0; r < bs; r ++) yc += b [r*bs+c] * xj [r];
+          yv [bs*i [k]+c] += yc;
+        }
+      }
+  }
+  else gaxpy<Storage, Bs> (A, x, y); /* symmetric */
+}
+
+/** y += A x, dispatched on the storage of A (3x3 and 2x2 blocks are specialized) */
+inline void gaxpy (ConstMatrixView A, span<const double> x, span<double> y)
+{
+  switch (A.storage ())
+  {
+  case FCLIB_TRIPLET: gaxpy<FCLIB_TRIPLET> (A, x, y); break;
+  case FCLIB_CSC: gaxpy<FCLIB_CSC> (A, x, y); break;
+  case FCLIB_CSR: gaxpy<FCLIB_CSR> (A, x, y); break;
+  case FCLIB_BSR:
+    if (A->bs == 3) gaxpy<FCLIB_BSR, 3> (A, x, y);
+    else if (A->bs == 2) gaxpy<FCLIB_BSR, 2> (A, x, y);
+    else gaxpy<FCLIB_BSR> (A, x, y);
+    break;
+  case FCLIB_SYMMETRIC: gaxpy<FCLIB_SYMMETRIC> (A, x, y); break;
+  default: throw error (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => nz = " + std::to_string (A->nz));
+  }
+}
+
+/** y += A^T x, dispatched on the storage of A */
+inline void gatxpy (ConstMatrixView A, span<const double> x, span<double> y)
+{
+  switch (A.storage ())
+  {
+  case FCLIB_TRIPLET: gatxpy<FCLIB_TRIPLET> (A, x, y); break;
+  case FCLIB_CSC: gatxpy<FCLIB_CSC> (A, x, y); break;
+  case FCLIB_CSR: gatxpy<FCLIB_CSR> (A, x, y); break;
+  case FCLIB_BSR:
+    if (A->bs == 3) gatxpy<FCLIB_BSR, 3> (A, x, y);
+    else if (A->bs == 2) gatxpy<FCLIB_BSR, 2> (A, x, y);
+    else gatxpy<FCLIB_BSR> (A, x, y);
+    break;
+  case FCLIB_SYMMETRIC: gatxpy<FCLIB_SYMMETRIC> (A, x, y); break;
+  default: throw error (FCLIB_ERROR_INVALID, "ERROR: unknown sparse matrix type => nz = " + std::to_string (A->nz));
+  }
+}
+
+/** local problem, see fclib_local; move-only owner of the C structure */
+class LocalProblem
+{
+public:
+  LocalProblem () noexcept = default;
+
+  /** take ownership of a problem allocated by fclib (fclib_read_local, fclib_global_to_local, ...) */
+  explicit LocalProblem (fclib_local *problem) noexcept : p_ (problem) {}
+
+  LocalProblem (LocalProblem&&) noexcept = default;
+  LocalProblem& operator = (LocalProblem&&) noexcept = default;
+  LocalProblem (const LocalProblem&) = delete;
+  LocalProblem& operator = (const LocalProblem&) = delete;
+
+  /** read a problem, see fclib_read_local_with_flags */
+  static LocalProblem read (const std::string &path, int flags = 0)
+  {
+    fclib_clear_error ();
+    fclib_local *problem = fclib_read_local_with_flags (path.c_str (), flags);
+    if (!problem) detail::raise ("ERROR: reading a local problem failed");
+    return LocalProblem (problem);
+  }
+
+  /** generate a synthetic problem, see fclib_generate_local */
+  static LocalProblem generate (fclib_generator_options options)
+  {
+    fclib_clear_error ();
+    fclib_local *problem = fclib_generate_local (&options);
+    if (!problem) detail::raise ("ERROR: generating a local problem failed");
+    return LocalProblem (problem);
+  }
+
+  /** write the problem, see fclib_write_local */
+  void write (const std::string &path) const
+  {
+    fclib_clear_error ();
+    if (!fclib_write_local (p_.get (), path.c_str ())) detail::raise ("ERROR: writing a local problem failed");
+  }
+
+  /** read a problem from an HDF5 file image, see fclib_read_local_from_buffer */
+  static LocalProblem read_buffer (const void *buffer, std::size_t size, int flags = 0)
+  {
+    fclib_clear_error ();
+    fclib_local *problem = fclib_read_local_from_buffer (buffer, size, flags);
+    if (!problem) detail::raise ("ERROR: reading a local problem image failed");
+    return LocalProblem (problem);
+  }
+
+  /** serialize the problem to an HDF5 file image, see fclib_write_local_to_buffer */
+  std::vector<unsigned char> write_buffer () const
+  {
+    void *buffer;
+    std::size_t size;
+
+    fclib_clear_error ();
+    if (!fclib_write_local_to_buffer (p_.get (), &buffer, &size)) detail::raise ("ERROR: writing a local problem image failed");
+    return detail::image (buffer, size);
+  }
+
+  fclib_local* get () const noexcept { return p_.get (); }
+
+  /** give up the ownership; release with fclib_delete_local and free */
+  fclib_local* release () noexcept { return p_.release (); }
+
+  explicit operator bool () const noexcept { return p_ != nullptr; }
+
+  int spacedim () const noexcept { return p_->spacedim; }
+  int contacts () const noexcept { return p_->W->m / p_->spacedim; }
+
+  MatrixView W () noexcept { return MatrixView (p_->W); }
+  MatrixView V () noexcept { return MatrixView (p_->V); }
+  MatrixView R () noexcept { return MatrixView (p_->R); }
+  ConstMatrixView W () const noexcept { return ConstMatrixView (p_->W); }
+  ConstMatrixView V () const noexcept { return ConstMatrixView (p_->V); }
+  ConstMatrixView R () const noexcept { return ConstMatrixView (p_->R); }
+
+  span<double> q () noexcept { return detail::view (p_->q, (std::size_t) p_->W->m); }
+  span<double> mu () noexcept { return detail::view (p_->mu, (std::size_t) contacts ()); }
+  span<double> s () noexcept { return p_->R ? detail::view (p_->s, (std::size_t) p_->R->m) : span<double> (); }
+  span<const double> q () const noexcept { return const_cast<LocalProblem*> (this)->q (); }
+  span<const double> mu () const noexcept { return const_cast<LocalProblem*> (this)->mu (); }
+  span<const double> s () const noexcept { return const_cast<LocalProblem*> (this)->s (); }
+
+private:
+  struct deleter
+  {
+    void operator () (fclib_local *p) const noexcept { fclib_delete_local (p); std::free (p); }
+  };
+  std::unique_ptr<fclib_local, deleter> p_;
+};
+
+/** global problem, see fclib_global; move-only owner of the C structure */
+class GlobalProblem
+{
+public:
+  GlobalProblem () noexcept = default;
+
+  /** take ownership of a problem allocated by fclib (fclib_read_global, fclib_generate_global, ...) */
+  explicit GlobalProblem (fclib_global *problem) noexcept : p_ (problem) {}
+
+  GlobalProblem (GlobalProblem&&) noexcept = default;
+  GlobalProblem& operator = (GlobalProblem&&) noexcept = default;
+  GlobalProblem (const GlobalProblem&) = delete;
+  GlobalProblem& operator = (const GlobalProblem&) = delete;
+
+  /** read a problem, see fclib_read_global_with_flags */
+  static GlobalProblem read (const std::string &path, int flags = 0)
+  {
+    fclib_clear_error ();
+    fclib_global *problem = fclib_read_global_with_flags (path.c_str (), flags);
+    if (!problem) detail::raise ("ERROR: reading a global problem failed");
+    return GlobalProblem (problem);
+  }
+
+  /** generate a synthetic problem, see fclib_generate_global */
+  static GlobalProblem generate (fclib_generator_options options)
+  {
+    fclib_clear_error ();
+    fclib_global *problem = fclib_generate_global (&options);
+    if (!problem) detail::raise ("ERROR: generating a global problem failed");
+    return GlobalProblem (problem);
+  }
+
+  /** write the problem, see fclib_write_global */
+  void write (const std::string &path) const
+  {
+    fclib_clear_error ();
+    if (!fclib_write_global (p_.get (), path.c_str ())) detail::raise ("ERROR: writing a global problem failed");
+  }
+
+  /** read a problem from an HDF5 file image, see fclib_read_global_from_buffer */
+  static GlobalProblem read_buffer (const void *buffer, std::size_t size, int flags = 0)
+  {
+    fclib_clear_error ();
+    fclib_global *problem = fclib_read_global_from_buffer (buffer, size, flags);
+    if (!problem) detail::raise ("ERROR: reading a global problem image failed");
+    return GlobalProblem (problem);
+  }
+
+  /** serialize the problem to an HDF5 file image, see fclib_write_global_to_buffer */
+  std::vector<unsigned char> write_buffer () const
+  {
+    void *buffer;
+    std::size_t size;
+
+    fclib_clear_error ();
+    if (!fclib_write_global_to_buffer (p_.get (), &buffer, &size)) detail::raise ("ERROR: writing a global problem image failed");
+    return detail::image (buffer, size);
+  }
+
+  /** reduce to a local problem, see fclib_global_to_local (options may be NULL) */
+  LocalProblem to_local (fclib_reduction_options *options = nullptr) const
+  {
+    fclib_clear_error ();
+    fclib_local *local = fclib_global_to_local (p_.get (), options);
+    if (!local) detail::raise ("ERROR: reducing a global problem failed");
+    return LocalProblem (local);
+  }
+
+  fclib_global* get () const noexcept { return p_.get (); }
+
+  /** give up the ownership; release with fclib_delete_global and free */
+  fclib_global* release () noexcept { return p_.release (); }
+
+  explicit operator bool () const noexcept { return p_ != nullptr; }
+
+  int spacedim () const noexcept { return p_->spacedim; }
+  int contacts () const noexcept { return p_->H->n / p_->spacedim; }
+
+  MatrixView M () noexcept { return MatrixView (p_->M); }
+  MatrixView H () noexcept { return MatrixView (p_->H); }
+  MatrixView G () noexcept { return MatrixView (p_->G); }
+  ConstMatrixView M () const noexcept { return ConstMatrixView (p_->M); }
+  ConstMatrixView H () const noexcept { return ConstMatrixView (p_->H); }
+  ConstMatrixView G () const noexcept { return ConstMatrixView (p_->G); }
+
+  span<double> f () noexcept { return detail::view (p_->f, (std::size_t) p_->M->m); }
+  span<double> w () noexcept { return detail::view (p_->w, (std::size_t) p_->H->n); }
+  span<double> mu () noexcept { return detail::view (p_->mu, (std::size_t) contacts ()); }
+  span<double> b () noexcept { return p_->G ? detail::view (p_->b, (std::size_t) p_->G->n) : span<double> (); }
+  span<const double> f () const noexcept { return const_cast<GlobalProblem*> (this)->f (); }
+  span<const double> w () const noexcept { return const_cast<GlobalProblem*> (this)->w (); }
+  span<const double> mu () const noexcept { return const_cast<GlobalProblem*> (this)->mu (); }
+  span<const double> b () const noexcept { return const_cast<GlobalProblem*> (this)->b (); }
+
+private:
+  struct deleter
+  {
+    void operator () (fclib_global *p) const noexcept { fclib_delete_global (p); std::free (p); }
+  };
+  std::unique_ptr<fclib_global, deleter> p_;
+};
+
+/** solution or guess of a problem, see fclib_solution; move-only owner of its vectors,
+ *  whose sizes come from the problem (v: velocities, u, r: contacts, l: multipliers) */
+class Solution
+{
+public:
+  Solution () noexcept : s_ {}, nv_ (0), nr_ (0), nl_ (0) {}
+
+  /** zeroed solution of a problem */
+  explicit Solution (const LocalProblem &problem) : Solution (sizes (problem)) {}
+  explicit Solution (const GlobalProblem &problem) : Solution (sizes (problem)) {}
+
+  /** sizes of the vectors of a solution of a problem */
+  struct dims { int nv, nr, nl; };
+
+  static dims sizes (const LocalProblem &problem) noexcept
+  {
+    return dims {0, problem.W ().cols (), problem.R () ? problem.R ().cols () : 0};
+  }
+
+  static dims sizes (const GlobalProblem &problem) noexcept
+  {
+    return dims {problem.M ().cols (), problem.H ().cols (), problem.G () ? problem.G ().cols () : 0};
+  }
+
+  /** take ownership of the vectors of a solution allocated by fclib; the structure itself is not released */
+  Solution (const fclib_solution &solution, int nv, int nr, int nl) noexcept : s_ (solution), nv_ (nv), nr_ (nr), nl_ (nl) {}
+
+  Solution (Solution &&other) noexcept : s_ (other.s_), nv_ (other.nv_), nr_ (other.nr_), nl_ (other.nl_) { other.s_ = fclib_solution {}; }
+  Solution& operator = (Solution &&other) noexcept
+  {
+    if (this != &other)
+    {
+      clear ();
+      s_ = other.s_;
+      nv_ = other.nv_, nr_ = other.nr_, nl_ = other.nl_;
+      other.s_ = fclib_solution {};
+    }
+    return *this;
+  }
+  Solution (const Solution&) = delete;
+  Solution& operator = (const Solution&) = delete;
+  ~Solution () { clear (); }
+
+  /** read the solution of a problem stored in the same file, see fclib_read_solution */
+  template <class Problem> static Solution read (const std::string &path, const Problem &problem)
+  {
+    fclib_clear_error ();
+    fclib_solution *solution = fclib_read_solution (path.c_str ());
+    if (!solution) detail::raise ("ERROR: reading a solution failed");
+    return adopt (solution, sizes (problem));
+  }
+
+  /** read guess 'index' of a problem stored in the same file, see fclib_read_guess */
+  template <class Problem> static Solution read_guess (const std::string &path, int index, const Problem &problem)
+  {
+    fclib_clear_error ();
+    fclib_solution *guess = fclib_read_guess (path.c_str (), index);
+    if (!guess) detail::raise ("ERROR: reading a guess failed");
+    return adopt (guess, sizes (problem));
+  }
+
+  /** write the solution, see fclib_write_solution; with replace, see fclib_replace_solution */
+  void write (const std::string &path, bool replace = false) const
+  {
+    fclib_solution s = s_;
+    fclib_clear_error ();
+    if (!(replace ? fclib_replace_solution (&s, path.c_str ()) : fclib_write_solution (&s, path.c_str ())))
+      detail::raise ("ERROR: writing a solution failed");
+  }
+
+  fclib_solution* get () noexcept { return &s_; }
+  const fclib_solution* get () const noexcept { return &s_; }
+
+  span<double> v () noexcept { return detail::view (s_.v, (std::size_t) nv_); }
+  span<double> u () noexcept { return detail::view (s_.u, (std::size_t) nr_); }
+  span<double> r () noexcept { return detail::view (s_.r, (std::size_t) nr_); }
+  span<double> l () noexcept { return detail::view (s_.l, (std::size_t) nl_); }
+  span<const double> v () const noexcept { return detail::view<const double> (s_.v, (std::size_t) nv_); }
+  span<const double> u () const noexcept { return detail::view<const double> (s_.u, (std::size_t) nr_); }
+  span<const double> r () const noexcept { return detail::view<const double> (s_.r, (std::size_t) nr_); }
+  span<const double> l () const noexcept { return detail::view<const double> (s_.l, (std::size_t) nl_); }
+
+private:
+  explicit Solution (dims d) : s_ {}, nv_ (d.nv), nr_ (d.nr), nl_ (d.nl)
+  {
+    if ((nv_ && !(s_.v = (double*) std::calloc (nv_, sizeof (double)))) ||
+        (nr_ && !(s_.u = (double*) std::calloc (nr_, sizeof (double)))) ||
+        (nr_ && !(s_.r = (double*) std::calloc (nr_, sizeof (double)))) ||
+        (nl_ && !(s_.l = (double*) std::calloc (nl_, sizeof (double)))))
+    {
+      clear ();
+      throw error (FCLIB_ERROR_MEMORY, "ERROR: out of memory");
+    }
+  }
+
+  static Solution adopt (fclib_solution *solution, dims d) noexcept
+  {
+    Solution s (*solution, d.nv, d.nr, d.nl);
+    std::free (solution);
+    return s;
+  }
+
+  void clear () noexcept
+  {
+    std::free (s_.v);
+    std::free (s_.u);
+    std::free (s_.r);
+    std::free (s_.l);
+    s_ = fclib_solution {};
+  }
+
+  fclib_solution s_;
+  int nv_, nr_, nl_;
+};
+
+/** read all guesses of a problem stored in the same file, see fclib_read_guesses; the guess
+ *  vectors allocated by fclib are adopted without copies */
+template <class Problem>
+std::vector<Solution> read_guesses (const std::string &path, const Problem &problem)
+{
+  Solution::dims d = Solution::sizes (problem);
+  std::vector<Solution> guesses;
+  int count;
+
+  fclib_clear_error ();
+  fclib_solution *data = fclib_read_guesses (path.c_str (), &count);
+  if (!data)
+  {
+    if (fclib_last_error (nullptr)) detail::raise ("ERROR: reading guesses failed");
+    return guesses; /* none stored */
+  }
+
+  try
+  {
+    guesses.reserve (count);
+  }
+  catch (...)
+  {
+    fclib_delete_solutions (data, count);
+    throw;
+  }
+  for (int k = 0; k < count; k ++) guesses.emplace_back (data [k], d.nv, d.nr, d.nl); /* no reallocation */
+  std::free (data);
+
+  return guesses;
+}
+
+/** write guesses, see fclib_write_guesses; with append, see fclib_append_guesses */
+inline void write_guesses (const std::vector<Solution> &guesses, const std::string &path, bool append = false)
+{
+  std::vector<fclib_solution> data;
+
+  data.reserve (guesses.size ());
+  for (const Solution &g : guesses) data.push_back (*g.get ());
+  fclib_clear_error ();
+  if (!(append ? fclib_append_guesses ((int) data.size (), data.data (), path.c_str ())
+               : fclib_write_guesses ((int) data.size (), data.data (), path.c_str ())))
+    detail::raise ("ERROR: writing guesses failed");
+}
+
+namespace detail
+{
+  inline double norm (span<const double> x) noexcept
+  {
+    double s = 0.0;
+    for (double v : x) s += v * v;
+    return std::sqrt (s);
+  }
+}
+
+/** merit function MERIT_1 of fclib_merit_local for the space dimension Spacedim (2 or 3) and
+ *  the storage Storage of W known at compile time; it does not need FCLIB_WITH_MERIT_FUNCTIONS */
+template <int Spacedim, int Storage>
+double merit_local (const LocalProblem &problem, const Solution &solution)
+{
+  static_assert (Spacedim == 2 || Spacedim == 3, "the space dimension must be 2 or 3");
+  ConstMatrixView W = problem.W (), V = problem.V (), R = problem.R ();
+  span<const double> q = problem.q (), mu = problem.mu (), r = solution.r (), l = solution.l ();
+  double e = 0.0, e_l = 0.0;
+
+  if (problem.spacedim () != Spacedim || W.storage () != Storage)
+    throw error (FCLIB_ERROR_INVALID, "ERROR: the problem does not match the space dimension or the storage of merit_local");
+
+  if (R && R.cols () > 0) /* V^T r + R l + s */
+  {
+    std::vector<double> t (problem.s ().begin (), problem.s ().end ());
+    gatxpy (V, r, t);
+    gaxpy (R, l, t);
+    e_l = detail::norm (t) / (1.0 + detail::norm (problem.s ()));
+  }
+
+  std::vector<double> w (q.begin (), q.end ()); /* W r + V l + q */
+  if (R && R.cols () > 0) gaxpy (V, l, w);
+  gaxpy<Storage> (W, r, w);
+
+  for (int c = 0; c < problem.contacts (); c ++)
+    fclib_merit_contact (Spacedim, r.data () + Spacedim*c, w.data () + Spacedim*c, mu [c], &e);
+
+  return std::sqrt (e) / (1.0 + std::sqrt (detail::norm (q))) + e_l;
+}
+
+/** merit function MERIT_1 of a local problem, dispatched on its space dimension and the storage of W */
+inline double merit_local (const LocalProblem &problem, const Solution &solution)
+{
+  const int d = problem.spacedim (), s = problem.W ().storage ();
+
+  if (d == 3)
+  {
+    switch (s)
+    {
+    case FCLIB_TRIPLET: return merit_local<3, FCLIB_TRIPLET> (problem, solution);
+    case FCLIB_CSC: return merit_local<3, FCLIB_CSC> (problem, solution);
+    case FCLIB_CSR: return merit_local<3, FCLIB_CSR> (problem, solution);
+    case FCLIB_BSR: return merit_local<3, FCLIB_BSR> (problem, solution);
+    case FCLIB_SYMMETRIC: return merit_local<3, FCLIB_SYMMETRIC> (problem, solution);
+    }
+  }
+  else if (d == 2)
+  {
+    switch (s)
+    {
+    case FCLIB_TRIPLET: return merit_local<2, FCLIB_TRIPLET> (problem, solution);
+    case FCLIB_CSC: return merit_local<2, FCLIB_CSC> (problem, solution);
+    case FCLIB_CSR: return merit_local<2, FCLIB_CSR> (problem, solution);
+    case FCLIB_BSR: return merit_local<2, FCLIB_BSR> (problem, solution);
+    case FCLIB_SYMMETRIC: return merit_local<2, FCLIB_SYMMETRIC> (problem, solution);
+    }
+  }
+
+  throw error (FCLIB_ERROR_INVALID, "ERROR: merit_local for space dimension " + std::to_string (d) + " and storage " +
+               std::to_string (s) + " is not implemented");
+}
+
+} /* namespace fclib */
+
+#endif /* _fclib_hpp_ */
@@ -0,0 +1,239 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+
+
+/*!\file fclib_index.h
+ * ----------------------------------------------
+ * codec and HDF5 filter class of the fclib index filter (FCLIB_FILTER_INDEX), shared by
+ * the implementation of fclib.h and by the HDF5 plugin H5Zfclib.c; installed with fclib.h,
+ * whose implementation includes it, so that programs may also register index_filter_class
+ * with H5Zregister themselves instead of loading the plugin. All its definitions are static,
+ * one copy per translation unit
+ */
+
+#ifndef _fclib_index_h_
+#define _fclib_index_h_
+
+#include "fclib.h" /* FCLIB_FILTER_INDEX */
+#include <stdint.h>
+#include <string.h>
+#include <hdf5.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FCLIB_INDEX_SSSE3 /* decoding with SSSE3 when the processor has it */
+#endif
+
+/* fclib index filter: 32-bit integers, sorted or nearly sorted as the indices of the matrices,
+ * are stored as the zigzagged differences of consecutive values, each in 1 to 4 bytes whose count
+ * is given by 2 bits of a control byte (StreamVByte); a chunk holds the number of values in 4
+ * little-endian bytes, the control bytes of the values, then their bytes */
+#define INDEX_HEADER 4
+
+/* decoding tables, by control byte c: value j has INDEX_L bytes, from byte INDEX_O of the group */
+#define INDEX_L(c, j) ((((c) >> (2*(j))) & 3) + 1)
+#define INDEX_O(c, j) (((j) > 0 ? INDEX_L (c, 0) : 0) + ((j) > 1 ? INDEX_L (c, 1) : 0) + ((j) > 2 ? INDEX_L (c, 2) : 0))
+#define INDEX_B(c, j, b) ((b) < INDEX_L (c, j) ? INDEX_O (c, j) + (b) : 0x80)
+#define INDEX_V(c, j) INDEX_B (c, j, 0), INDEX_B (c, j, 1), INDEX_B (c, j, 2), INDEX_B (c, j, 3)
+#define INDEX_S1(c) {INDEX_V (c, 0), INDEX_V (c, 1), INDEX_V (c, 2), INDEX_V (c, 3)}
+#define INDEX_S4(c) INDEX_S1 (4*(c)), INDEX_S1 (4*(c)+1), INDEX_S1 (4*(c)+2), INDEX_S1 (4*(c)+3)
+#define INDEX_S16(c) INDEX_S4 (4*(c)), INDEX_S4 (4*(c)+1), INDEX_S4 (4*(c)+2), INDEX_S4 (4*(c)+3)
+#define INDEX_N1(c) (INDEX_O (c, 3) + INDEX_L (c, 3))
+#define INDEX_N4(c) INDEX_N1 (4*(c)), INDEX_N1 (4*(c)+1), INDEX_N1 (4*(c)+2), INDEX_N1 (4*(c)+3)
+#define INDEX_N16(c) INDEX_N4 (4*(c)), INDEX_N4 (4*(c)+1), INDEX_N4 (4*(c)+2), INDEX_N4 (4*(c)+3)
+
+/* SSSE3 shuffle of the bytes of 4 values, by control byte */
+static const unsigned char index_shuffle [256][16] = {INDEX_S16 (0), INDEX_S16 (1), INDEX_S16 (2), INDEX_S16 (3),
+  INDEX_S16 (4), INDEX_S16 (5), INDEX_S16 (6), INDEX_S16 (7), INDEX_S16 (8), INDEX_S16 (9), INDEX_S16 (10),
+  INDEX_S16 (11), INDEX_S16 (12), INDEX_S16 (13), INDEX_S16 (14), INDEX_S16 (15)};
+
+/* bytes of 4 values, by control byte */
+static const unsigned char index_length [256] = {INDEX_N16 (0), INDEX_N16 (1), INDEX_N16 (2), INDEX_N16 (3),
+  INDEX_N16 (4), INDEX_N16 (5), INDEX_N16 (6), INDEX_N16 (7), INDEX_N16 (8), INDEX_N16 (9), INDEX_N16 (10),
+  INDEX_N16 (11), INDEX_N16 (12), INDEX_N16 (13), INDEX_N16 (14), INDEX_N16 (15)};
+
+/* bytes of n encoded values, at most */
+static size_t index_bound (size_t n)
+{
+  return INDEX_HEADER + (n + 3) / 4 + 4 * n;
+}
+
+/* number of values of an encoded chunk */
+static size_t index_count (const unsigned char *in)
+{
+  return (size_t) in [0] | (size_t) in [1] << 8 | (size_t) in [2] << 16 | (size_t) in [3] << 24;
+}
+
+/* encode the n values at src, those past 'valid' taken as zeros, into the index_bound (n) bytes
+ * at out; return the size of the encoding */
+static size_t index_encode (const uint32_t *src, size_t valid, size_t n, unsigned char *out)
+{
+  unsigned char *control = out + INDEX_HEADER, *data = control + (n + 3) / 4;
+  uint32_t previous = 0;
+  size_t k;
+
+  out [0] = (unsigned char) n, out [1] = (unsigned char) (n >> 8);
+  out [2] = (unsigned char) (n >> 16), out [3] = (unsigned char) (n >> 24);
+  memset (control, 0, (n + 3) / 4);
+
+  for (k = 0; k < n; k ++)
+  {
+    uint32_t x = (k < valid ? src [k] : 0), d = x - previous, v = (d << 1) ^ (0u - (d >> 31));
+    unsigned code = (unsigned) (v > 0xFF) + (unsigned) (v > 0xFFFF) + (unsigned) (v > 0xFFFFFF);
+
+    control [k/4] |= (unsigned char) (code << (2 * (k%4)));
+    data [0] = (unsigned char) v, data [1] = (unsigned char) (v >> 8); /* within the bound: 4 bytes a value */
+    data [2] = (unsigned char) (v >> 16), data [3] = (unsigned char) (v >> 24);
+    data += code + 1;
+    previous = x;
+  }
+
+  return (size_t) (data - out);
+}
+
+#ifdef FCLIB_INDEX_SSSE3
+/* decode groups of 4 values while 16 bytes can be loaded; return the number of values decoded */
+__attribute__ ((target ("ssse3")))
+static size_t index_decode_ssse3 (const unsigned char *control, const unsigned char **data, const unsigned char *end,
+                                  size_t count, uint32_t *previous, uint32_t *out)
+{
+  const unsigned char *p = *data;
+  __m128i last = _mm_set1_epi32 ((int) *previous), one = _mm_set1_epi32 (1), zero = _mm_setzero_si128 ();
+  size_t k;
+
+  for (k = 0; k + 4 <= count && end - p >= 16; k += 4)
+  {
+    unsigned c = control [k/4];
+    __m128i v = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i*) p), _mm_loadu_si128 ((const __m128i*) index_shuffle [c]));
+
+    v = _mm_xor_si128 (_mm_srli_epi32 (v, 1), _mm_sub_epi32 (zero, _mm_and_si128 (v, one))); /* unzigzag */
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 4)); /* prefix sum */
+    v = _mm_add_epi32 (v, _mm_slli_si128 (v, 8));
+    last = _mm_add_epi32 (v, _mm_shuffle_epi32 (last, 0xFF));
+    _mm_storeu_si128 ((__m128i*) (out + k), last);
+    p += index_length [c];
+  }
+
+  *previous = (uint32_t) _mm_cvtsi128_si32 (_mm_shuffle_epi32 (last, 0xFF));
+  *data = p;
+
+  return k;
+}
+#endif
+
+/* decode the first 'count' values of the 'size' bytes at in into out; return 0 when corrupt */
+static int index_decode (const unsigned char *in, size_t size, uint32_t *out, size_t count)
+{
+  const unsigned char *control = in + INDEX_HEADER, *data, *end = in + size;
+  uint32_t previous = 0;
+  size_t n, k = 0;
+
+  if (size < INDEX_HEADER || (n = index_count (in)) < count || size - INDEX_HEADER < (n + 3) / 4) return 0;
+  data = control + (n + 3) / 4;
+
+#ifdef FCLIB_INDEX_SSSE3
+  if (__builtin_cpu_supports ("ssse3")) k = index_decode_ssse3 (control, &data, end, count, &previous, out);
+#endif
+
+  for (; k < count; k ++)
+  {
+    size_t length = ((control [k/4] >> (2 * (k%4))) & 3) + 1;
+    uint32_t v = data [0];
+
+    if ((size_t) (end - data) < length) return 0;
+    if (length > 1) v |= (uint32_t) data [1] << 8;
+    if (length > 2) v |= (uint32_t) data [2] << 16;
+    if (length > 3) v |= (uint32_t) data [3] << 24;
+    previous += (v >> 1) ^ (0u - (v & 1));
+    out [k] = previous;
+    data += length;
+  }
+
+  return 1;
+}
+
+/* reverse the bytes of the n values at x */
+static void index_swap (uint32_t *x, size_t n)
+{
+  size_t k;
+
+  for (k = 0; k < n; k ++) x [k] = (x [k] >> 24) | ((x [k] >> 8) & 0xFF00) | ((x [k] << 8) & 0xFF0000) | (x [k] << 24);
+}
+
+/* HDF5 callbacks of the filter, called within the HDF5 calls (hence not wrapped): only datasets
+ * of 32-bit integers, whose byte order is kept in the second filter value */
+static htri_t index_can_apply (hid_t dcpl_id, hid_t type_id, hid_t space_id)
+{
+  (void) dcpl_id;
+  (void) space_id;
+  return H5Tget_class (type_id) == H5T_INTEGER && H5Tget_size (type_id) == 4;
+}
+
+static herr_t index_set_local (hid_t dcpl_id, hid_t type_id, hid_t space_id)
+{
+  unsigned flags, values [2];
+  size_t nvalues = 0;
+
+  (void) space_id;
+  if (H5Pget_filter_by_id2 (dcpl_id, FCLIB_FILTER_INDEX, &flags, &nvalues, NULL, 0, NULL, NULL) < 0) return -1;
+  values [0] = (unsigned) H5Tget_size (type_id);
+  values [1] = (H5Tget_order (type_id) == H5T_ORDER_BE);
+
+  return H5Pmodify_filter (dcpl_id, FCLIB_FILTER_INDEX, flags, 2, values);
+}
+
+static size_t index_filter (unsigned flags, size_t nvalues, const unsigned values [], size_t nbytes, size_t *buf_size, void **buf)
+{
+  const uint32_t one = 1;
+  int swap = ((nvalues > 1 && values [1]) != (*(const unsigned char*) &one == 0)); /* not in the order of the host */
+  unsigned char *out;
+  size_t n, size;
+
+  if (flags & H5Z_FLAG_REVERSE)
+  {
+    if (nbytes < INDEX_HEADER) return 0;
+    n = index_count ((const unsigned char*) *buf);
+    if (!(out = (unsigned char*) H5allocate_memory (4 * n + 1, 0))) return 0;
+    if (!index_decode ((const unsigned char*) *buf, nbytes, (uint32_t*) out, n))
+    {
+      H5free_memory (out);
+      return 0;
+    }
+    if (swap) index_swap ((uint32_t*) out, n);
+    *buf_size = 4 * n + 1;
+    size = 4 * n;
+  }
+  else
+  {
+    if (nbytes % 4) return 0;
+    n = nbytes / 4;
+    if (!(out = (unsigned char*) H5allocate_memory (index_bound (n), 0))) return 0;
+    if (swap) index_swap ((uint32_t*) *buf, n);
+    size = index_encode ((const uint32_t*) *buf, n, n, out);
+    *buf_size = index_bound (n);
+  }
+
+  H5free_memory (*buf);
+  *buf = out;
+
+  return size;
+}
+
+static const H5Z_class2_t index_filter_class = {H5Z_CLASS_T_VERS, (H5Z_filter_t) FCLIB_FILTER_INDEX, 1, 1,
+  "fclib index filter: delta, zigzag and StreamVByte", index_can_apply, index_set_local, index_filter};
+
+#endif /* _fclib_index_h_ */
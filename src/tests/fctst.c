@@ -25,6 +25,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <math.h>
+#include <limits.h>
+#include <hdf5.h>
 #include "fclib.h"
 
 /* useful macros */
@@ -83,7 +86,7 @@ static struct fclib_matrix* random_matrix (int m, int n)
     MM (mat->i = (int*)malloc (sizeof(int)*mat->nzmax));
     int l = mat->nzmax / k;
     for (mat->p [0] = j = 0; j < k; j ++) mat->p [j+1] = mat->p [j] + l;
-    for (j = 0; j < mat->nzmax; j ++) mat->i [j] = rand () % k;
+    for (j = 0; j < mat->nzmax; j ++) mat->i [j] = rand () % (mat->nz == -1 ? mat->m : mat->n);
   }
 
   MM (mat->x = (double*)malloc (sizeof(double)*mat->nzmax));
@@ -174,6 +177,18 @@ static struct fclib_local* random_local_problem (int contact_points, int neq)
   if (rand () % 2) problem->spacedim = 2;
   else problem->spacedim = 3;
   problem->W = random_matrix (problem->spacedim*contact_points, problem->spacedim*contact_points);
+  if (rand () % 3 == 0) /* block compressed rows */
+  {
+    struct fclib_matrix *bsr = fclib_matrix_to_bsr (problem->W, problem->spacedim);
+    fclib_delete_matrix (problem->W);
+    problem->W = bsr;
+  }
+  else if (rand () % 3 == 0) /* upper triangle only */
+  {
+    struct fclib_matrix *sym = fclib_matrix_to_symmetric (problem->W);
+    fclib_delete_matrix (problem->W);
+    problem->W = sym;
+  }
   if (neq && rand () % 2)
   {
     problem->V = random_matrix (problem->spacedim*contact_points, neq);
@@ -272,7 +287,7 @@ static int compare_matrices (char *name, struct fclib_matrix *a, struct fclib_ma
       }
     }
   }
-  else if (a->nz == -1)
+  else if (a->nz == -1 || a->nz == -4)
   {
     for (i = 0; i < a->n+1; i ++)
       if (a->p [i] != b->p [i])
@@ -313,6 +328,33 @@ static int compare_matrices (char *name, struct fclib_matrix *a, struct fclib_ma
       }
   }
 
+  else if (a->nz == -3)
+  {
+    if (a->bs != b->bs)
+    {
+      fprintf (stderr, "ERROR: For %s in {a,b} a->bs != b->bs => %d != %d\n", name, a->bs, b->bs);
+      return 0;
+    }
+
+    for (i = 0; i < a->m/a->bs+1; i ++)
+      if (a->p [i] != b->p [i])
+      {
+	fprintf (stderr,
+	         "ERROR: For %s in {a,b} a->p [%d] != b->p [%d] => %d != %d\n",
+		 name, i, i, a->p [i], b->p [i]);
+	return 0;
+      }
+
+    for (i = 0; i < a->nzmax/(a->bs*a->bs); i ++)
+      if (a->i [i] != b->i [i])
+      {
+	fprintf (stderr,
+	         "ERROR: For %s in {a,b} a->i [%d] != b->i [%d] => %d != %d\n",
+		 name, i, i, a->i [i], b->i [i]);
+	return 0;
+      }
+  }
+
   for (i = 0; i < a->nzmax; i ++)
     if (a->x [i] != b->x [i])
     {
@@ -331,6 +373,415 @@ static int compare_matrices (char *name, struct fclib_matrix *a, struct fclib_ma
   return 1;
 }
 
+/* dense copy of a sparse matrix, in row major order */
+static double* dense_matrix (struct fclib_matrix *mat)
+{
+  double *a;
+  int j, k, r, c;
+
+  MM (a = (double*)calloc ((size_t)mat->m*mat->n, sizeof(double)));
+
+  if (mat->nz >= 0)
+    for (k = 0; k < mat->nz; k ++) a [(size_t)mat->p [k]*mat->n + mat->i [k]] += mat->x [k];
+  else if (mat->nz == -1 || mat->nz == -4)
+    for (j = 0; j < mat->n; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      {
+        a [(size_t)mat->i [k]*mat->n + j] += mat->x [k];
+        if (mat->nz == -4 && mat->i [k] != j) a [(size_t)j*mat->n + mat->i [k]] += mat->x [k];
+      }
+  else if (mat->nz == -2)
+    for (j = 0; j < mat->m; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++) a [(size_t)j*mat->n + mat->i [k]] += mat->x [k];
+  else if (mat->nz == -3)
+    for (j = 0; j < mat->m/mat->bs; j ++)
+      for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+        for (r = 0; r < mat->bs; r ++)
+          for (c = 0; c < mat->bs; c ++)
+            a [(size_t)(j*mat->bs+r)*mat->n + mat->i [k]*mat->bs+c] += mat->x [k*mat->bs*mat->bs + r*mat->bs + c];
+
+  return a;
+}
+
+/* compare the dense form of two matrices up to round-off */
+static int compare_dense_matrices (char *name, struct fclib_matrix *a, struct fclib_matrix *b)
+{
+  double *da, *db;
+  size_t k, n;
+  int ok = 1;
+
+  if (a->m != b->m || a->n != b->n) return 0;
+
+  da = dense_matrix (a);
+  db = dense_matrix (b);
+  for (k = 0, n = (size_t)a->m*a->n; k < n && ok; k ++)
+    if (fabs (da [k] - db [k]) > 1e-12 * (1.0 + fabs (da [k])))
+    {
+      fprintf (stderr, "ERROR: For %s entry %d differs => %g != %g\n", name, (int)k, da [k], db [k]);
+      ok = 0;
+    }
+
+  free (da);
+  free (db);
+
+  return ok;
+}
+
+/* convert a random matrix to block compressed rows and back */
+static void test_bsr_conversion (int bs)
+{
+  struct fclib_matrix *mat, *bsr, *back;
+  int nz;
+
+  printf ("Converting matrices to and from %dx%d block compressed rows ...\n", bs, bs);
+
+  nz = bs * (1 + rand () % 50);
+  mat = random_matrix (nz, nz);
+  bsr = fclib_matrix_to_bsr (mat, bs);
+  ASSERT (bsr && bsr->nz == -3 && bsr->bs == bs, "ERROR: conversion to block compressed rows failed");
+  ASSERT (compare_dense_matrices ("BSR", mat, bsr), "ERROR: block compressed rows differ from the original matrix");
+
+  for (nz = 0; nz >= -2; nz --)
+  {
+    back = fclib_matrix_from_bsr (bsr, nz);
+    ASSERT (back && back->nz == (nz < 0 ? nz : back->nzmax), "ERROR: conversion from block compressed rows failed");
+    ASSERT (compare_dense_matrices ("BSR", mat, back), "ERROR: converted matrix differs from the original matrix");
+    fclib_delete_matrix (back);
+  }
+
+  fclib_delete_matrix (bsr);
+  fclib_delete_matrix (mat);
+}
+
+/* compare y += A x for every storage of a random matrix with the dense product */
+static void test_gaxpy (int n)
+{
+  struct fclib_matrix *mat, *A [5];
+  double *a, *x, *y, *z;
+  int r, c, f;
+
+  printf ("Multiplying a %d x %d matrix in every storage ...\n", n, n);
+
+  mat = random_matrix (n, n);
+  A [0] = fclib_matrix_convert (mat, 0);
+  A [1] = fclib_matrix_convert (mat, -1);
+  A [2] = fclib_matrix_convert (mat, -2);
+  A [3] = fclib_matrix_to_bsr (mat, 3);
+  A [4] = fclib_matrix_to_symmetric (mat);
+
+  a = dense_matrix (mat);
+  x = random_vector (n);
+  y = random_vector (n);
+  MM (z = (double*)malloc (sizeof(double)*n));
+  for (f = 0; f < 5; f ++)
+  {
+    ASSERT (A [f], "ERROR: conversion failed");
+    memcpy (z, y, sizeof(double)*n);
+    fclib_matrix_gaxpy (A [f], x, z);
+    if (f == 4) /* the upper triangle stands for its symmetric completion */
+    {
+      for (r = 0; r < n; r ++)
+        for (c = r+1; c < n; c ++) a [c*n+r] = a [r*n+c];
+    }
+    for (r = 0; r < n; r ++)
+    {
+      double s = y [r];
+
+      for (c = 0; c < n; c ++) s += a [r*n+c] * x [c];
+      ASSERT (fabs (s - z [r]) <= 1e-12 * (1.0 + fabs (s)), "ERROR: product of storage %d differs at %d => %g != %g", f, r, s, z [r]);
+    }
+    fclib_delete_matrix (A [f]);
+  }
+
+  free (a);
+  free (x);
+  free (y);
+  free (z);
+  fclib_delete_matrix (mat);
+}
+
+/* check that compressed indices are strictly increasing and values are nonzero */
+static int is_canonical (struct fclib_matrix *mat)
+{
+  int outer = (mat->nz == -2 ? mat->m : mat->n), j, k;
+
+  for (j = 0; j < outer; j ++)
+    for (k = mat->p [j]; k < mat->p [j+1]; k ++)
+      if ((k > mat->p [j] && mat->i [k-1] >= mat->i [k]) || mat->x [k] == 0.0) return 0;
+
+  return 1;
+}
+
+/* convert a random matrix between triplet and compressed forms, in place or not, and canonicalize it */
+static void test_conversions (int m, int n)
+{
+  struct fclib_matrix *mat, *out, *tmp;
+  int from, to;
+
+  printf ("Converting a %d x %d matrix between triplet and compressed forms ...\n", m, n);
+
+  mat = random_matrix (m, n);
+  mat->x [0] = 0.0; /* an explicit zero */
+
+  for (to = 0; to >= -2; to --)
+  {
+    out = fclib_matrix_convert (mat, to);
+    ASSERT (out && out->nz == (to < 0 ? to : out->nz), "ERROR: conversion failed");
+    ASSERT (compare_dense_matrices ("converted", mat, out), "ERROR: converted matrix differs from the original matrix");
+
+    for (from = 0; from >= -2; from --) /* in place from every form */
+    {
+      tmp = fclib_matrix_convert (mat, from);
+      ASSERT (fclib_matrix_convert_inplace (tmp, to) && tmp->nz == (to < 0 ? to : tmp->nz), "ERROR: in place conversion failed");
+      ASSERT (compare_dense_matrices ("in place", mat, tmp), "ERROR: matrix converted in place differs from the original matrix");
+      fclib_delete_matrix (tmp);
+    }
+
+    ASSERT (fclib_matrix_canonicalize (out), "ERROR: canonicalization failed");
+    ASSERT (compare_dense_matrices ("canonical", mat, out), "ERROR: canonical matrix differs from the original matrix");
+    if (to < 0) ASSERT (is_canonical (out), "ERROR: matrix is not in canonical form");
+    fclib_delete_matrix (out);
+  }
+
+  out = fclib_matrix_to_bsr (mat, 1);
+  ASSERT (fclib_matrix_canonicalize (out) && compare_dense_matrices ("canonical BSR", mat, out), "ERROR: block canonicalization failed");
+  ASSERT (fclib_matrix_convert_inplace (out, -1) && out->nz == -1 && is_canonical (out), "ERROR: in place conversion from blocks failed");
+  fclib_delete_matrix (out);
+
+  fclib_delete_matrix (mat);
+}
+
+/* random symmetric positive definite matrix, block-diagonal with 6x6 blocks or generally sparse */
+static struct fclib_matrix* random_spd_matrix (int n, int blocks)
+{
+  struct fclib_matrix *mat;
+  double *a;
+  int r, c, k;
+
+  MM (a = (double*)calloc ((size_t)n*n, sizeof(double)));
+  for (r = 0; r < n; r ++)
+    for (c = 0; c < r; c ++)
+      if (blocks ? r/6 == c/6 : rand () % 10 == 0) a [r*n+c] = a [c*n+r] = (double) rand () / (double) RAND_MAX - 0.5;
+  for (r = 0; r < n; r ++)
+    for (a [r*n+r] = 1.0, c = 0; c < n; c ++) if (c != r) a [r*n+r] += fabs (a [r*n+c]);
+
+  for (k = r = 0; r < n*n; r ++) if (a [r] != 0.0) k ++;
+  MM (mat = (struct fclib_matrix*)malloc (sizeof (struct fclib_matrix)));
+  mat->m = mat->n = n;
+  mat->nzmax = mat->nz = k;
+  mat->info = NULL;
+  MM (mat->p = (int*)malloc (sizeof(int)*k));
+  MM (mat->i = (int*)malloc (sizeof(int)*k));
+  MM (mat->x = (double*)malloc (sizeof(double)*k));
+  for (k = r = 0; r < n; r ++)
+    for (c = 0; c < n; c ++)
+      if (a [r*n+c] != 0.0)
+      {
+        mat->p [k] = r;
+        mat->i [k] = c;
+        mat->x [k ++] = a [r*n+c];
+      }
+  free (a);
+
+  return mat;
+}
+
+/* solve A X = B for a dense symmetric positive definite A (overwritten by its Cholesky factor)
+ * and the ncols columns of B, stored column after column */
+static void dense_spd_solve (double *a, int n, double *b, int ncols)
+{
+  int r, c, k, j;
+
+  for (c = 0; c < n; c ++)
+  {
+    for (k = 0; k < c; k ++) a [c*n+c] -= a [c*n+k] * a [c*n+k];
+    a [c*n+c] = sqrt (a [c*n+c]);
+    for (r = c+1; r < n; r ++)
+    {
+      for (k = 0; k < c; k ++) a [r*n+c] -= a [r*n+k] * a [c*n+k];
+      a [r*n+c] /= a [c*n+c];
+    }
+  }
+
+  for (j = 0; j < ncols; j ++)
+  {
+    double *x = b + (size_t)j*n;
+    for (r = 0; r < n; r ++)
+    {
+      for (k = 0; k < r; k ++) x [r] -= a [r*n+k] * x [k];
+      x [r] /= a [r*n+r];
+    }
+    for (r = n-1; r >= 0; r --)
+    {
+      for (k = r+1; k < n; k ++) x [r] -= a [k*n+r] * x [k];
+      x [r] /= a [r*n+r];
+    }
+  }
+}
+
+/* find the blocks of a block-diagonal matrix and check their inverses */
+static void test_block_diagonal (void)
+{
+  struct fclib_block_diagonal *bd;
+  struct fclib_matrix *mat;
+  int n = 6 * (1 + rand () % 20), b, r, c, k;
+
+  printf ("Analyzing a block-diagonal matrix ...\n");
+
+  mat = random_spd_matrix (n, 1);
+  bd = fclib_matrix_analyze (mat, 0);
+  ASSERT (bd && bd->nblocks == n/6 && bd->bs == 6 && bd->maxbs == 6 && bd->inverse, "ERROR: block-diagonal structure not found");
+  for (b = 0; b < bd->nblocks; b ++)
+  {
+    double *a = bd->blocks + bd->offset [b], *inv = bd->inverse + bd->offset [b];
+
+    ASSERT (bd->start [b] == 6*b, "ERROR: wrong start of block %d", b);
+    for (r = 0; r < 6; r ++)
+      for (c = 0; c < 6; c ++)
+      {
+        double sum = 0.0;
+        for (k = 0; k < 6; k ++) sum += a [r*6+k] * inv [k*6+c];
+        ASSERT (fabs (sum - (r == c ? 1.0 : 0.0)) < 1e-10, "ERROR: wrong inverse of block %d", b);
+      }
+  }
+  fclib_delete_block_diagonal (bd);
+
+  bd = fclib_matrix_analyze (mat, 3); /* blocks too large to be kept */
+  ASSERT (bd && bd->nblocks == n/6 && !bd->blocks && !bd->inverse, "ERROR: blocks kept above the size limit");
+  fclib_delete_block_diagonal (bd);
+  fclib_delete_matrix (mat);
+}
+
+/* reduce a random global problem to a local one and compare with a dense reduction */
+static void test_global_to_local (int blocks)
+{
+  struct fclib_reduction_options options = {0, 0, 0, NULL};
+  struct fclib_global *problem;
+  struct fclib_local *local;
+  double *a, *h, *g, *x, *wd, *vd, *rd, sum, value;
+  int n, m, p, r, c, k;
+
+  printf ("Reducing a global problem with a %s mass matrix ...\n", blocks ? "block-diagonal" : "sparse");
+
+  problem = random_global_problem (6 * (1 + rand () % 10), 1 + rand () % 20, 1 + rand () % 5);
+  n = problem->M->n;
+  fclib_delete_matrix (problem->M);
+  problem->M = random_spd_matrix (n, blocks);
+  m = problem->H->n;
+  p = (problem->G ? problem->G->n : 0);
+  options.symmetric = rand () % 2;
+  options.max_block_size = (blocks ? 0 : 1); /* the general sparse factorization otherwise */
+  if (blocks && rand () % 2)
+  {
+    options.M_blocks = fclib_matrix_analyze (problem->M, 0);
+    ASSERT (options.M_blocks && options.M_blocks->bs == 6, "ERROR: analysis of M failed");
+  }
+
+  local = fclib_global_to_local (problem, &options);
+  ASSERT (local && local->W->nz == (options.symmetric ? -4 : -1), "ERROR: reduction to a local problem failed");
+  ASSERT (local->spacedim == problem->spacedim && (p == 0) == (local->V == NULL) && (p == 0) == (local->R == NULL), "ERROR: reduced problem is inconsistent");
+
+  /* dense X = M^-1 [H G f] */
+  a = dense_matrix (problem->M);
+  h = dense_matrix (problem->H);
+  g = (p ? dense_matrix (problem->G) : NULL);
+  MM (x = (double*)malloc (sizeof(double)*n*(m+p+1)));
+  for (c = 0; c < m+p; c ++)
+    for (r = 0; r < n; r ++) x [c*n+r] = (c < m ? h [r*m+c] : g [r*p+c-m]);
+  memcpy (x + (size_t)(m+p)*n, problem->f, sizeof(double)*n);
+  dense_spd_solve (a, n, x, m+p+1);
+
+  /* [W V; V^T R] = [H G]^T X and [q; s] = [H G]^T M^-1 f + [w; b]; V^T is not stored */
+  wd = dense_matrix (local->W);
+  vd = (p ? dense_matrix (local->V) : NULL);
+  rd = (p ? dense_matrix (local->R) : NULL);
+  for (r = 0; r < m+p; r ++)
+    for (c = (r < m ? 0 : m); c <= m+p; c ++)
+    {
+      for (sum = 0.0, k = 0; k < n; k ++) sum += (r < m ? h [k*m+r] : g [k*p+r-m]) * x [c*n+k];
+      if (c == m+p)
+      {
+        sum += (r < m ? problem->w [r] : problem->b [r-m]);
+        value = (r < m ? local->q [r] : local->s [r-m]);
+      }
+      else if (c < m) value = wd [r*m+c];
+      else if (r < m) value = vd [r*p+c-m];
+      else value = rd [(r-m)*p+c-m];
+      ASSERT (fabs (sum - value) <= 1e-10 * (1.0 + fabs (sum)), "ERROR: reduced entry (%d, %d) differs => %g != %g", r, c, value, sum);
+    }
+
+  free (wd);
+  free (vd);
+  free (rd);
+  free (a);
+  free (h);
+  free (g);
+  free (x);
+  fclib_delete_block_diagonal (options.M_blocks);
+  fclib_delete_local (local);
+  free (local);
+
+  /* a negative definite M fails in the factorization, which returns with the error */
+  if (!blocks)
+  {
+    for (k = 0; k < (problem->M->nz >= 0 ? problem->M->nz : problem->M->p [n]); k ++) problem->M->x [k] = -problem->M->x [k];
+    ASSERT (!fclib_global_to_local (problem, &options) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+            "ERROR: reduction with a negative definite M did not fail");
+    fclib_clear_error ();
+  }
+
+  fclib_delete_global (problem);
+  free (problem);
+}
+
+/* store W as its upper triangle, write it and read it back as it is and expanded */
+static void test_symmetric_storage (void)
+{
+  struct fclib_local *problem, *p;
+  struct fclib_matrix *sym, *full;
+  double *a, *b;
+  int r, c, n;
+
+  printf ("Writing and reading a symmetric matrix stored as its upper triangle ...\n");
+
+  problem = random_local_problem (10 + rand () % 100, 0);
+  sym = fclib_matrix_to_symmetric (problem->W);
+  ASSERT (sym && sym->nz == -4, "ERROR: conversion to symmetric storage failed");
+  full = fclib_matrix_expand_symmetric (sym);
+  ASSERT (full && full->nz == -1, "ERROR: expansion of symmetric storage failed");
+
+  n = problem->W->n;
+  a = dense_matrix (problem->W);
+  b = dense_matrix (full);
+  for (r = 0; r < n; r ++)
+    for (c = r; c < n; c ++)
+    {
+      ASSERT (fabs (a [r*n+c] - b [r*n+c]) <= 1e-12 * (1.0 + fabs (a [r*n+c])) &&
+              b [r*n+c] == b [c*n+r], "ERROR: expanded matrix differs at (%d, %d)", r, c);
+    }
+  free (a);
+  free (b);
+
+  fclib_delete_matrix (problem->W);
+  problem->W = sym;
+  ASSERT (fclib_write_local (problem, "output_file.hdf5"), "ERROR: writing symmetric storage failed");
+
+  p = fclib_read_local ("output_file.hdf5");
+  ASSERT (compare_matrices ("W", sym, p->W), "ERROR: written/read symmetric matrix comparison failed");
+  fclib_delete_local (p);
+  free (p);
+
+  p = fclib_read_local_with_flags ("output_file.hdf5", FCLIB_READ_EXPAND_SYMMETRIC);
+  ASSERT (p->W->nz == -1 && compare_dense_matrices ("W", full, p->W), "ERROR: expanded/read symmetric matrix comparison failed");
+  fclib_delete_local (p);
+  free (p);
+
+  fclib_delete_matrix (full);
+  fclib_delete_local (problem);
+  free (problem);
+  remove ("output_file.hdf5");
+}
+
 /* compare two vectors */
 static int compare_vectors (char *name, int n, double *a, double *b)
 {
@@ -405,6 +856,1162 @@ static int compare_solutions (struct fclib_solution *a, struct fclib_solution *b
   return 1;
 }
 
+/* check that perm is a permutation of 0..n-1 */
+static int is_permutation (int *perm, int n)
+{
+  char *seen;
+  int k, ok = 1;
+
+  MM (seen = (char*)calloc (n > 0 ? n : 1, 1));
+  for (k = 0; k < n && ok; k ++)
+  {
+    ok = (perm [k] >= 0 && perm [k] < n && !seen [perm [k]]);
+    if (ok) seen [perm [k]] = 1;
+  }
+  free (seen);
+
+  return ok;
+}
+
+/* reorder the contacts of random problems, check the permuted data, its storage and the mapping of solutions back */
+static void test_contact_ordering (int method)
+{
+  struct fclib_local *problem, *p;
+  struct fclib_global *global;
+  struct fclib_solution *sol, *orig;
+  struct fclib_matrix *W;
+  double *a, *b, *q, *mu;
+  int *perm, *stored, *shuffle, sd, nc, n, r, c, k, band;
+
+  printf ("Reordering contacts by %s ...\n", method == FCLIB_ORDERING_RCM ? "reverse Cuthill-McKee" : "nested dissection");
+
+  /* local problem: W, q, mu and the solutions follow the permutation */
+  problem = random_local_problem (10 + rand () % 200, rand () % 20);
+  sd = problem->spacedim;
+  n = problem->W->n;
+  nc = n / sd;
+  a = dense_matrix (problem->W);
+  MM (q = (double*)malloc (sizeof(double)*n));
+  MM (mu = (double*)malloc (sizeof(double)*nc));
+  memcpy (q, problem->q, sizeof(double)*n);
+  memcpy (mu, problem->mu, sizeof(double)*nc);
+  sol = random_local_solutions (problem, 2);
+  orig = random_local_solutions (problem, 2);
+  for (k = 0; k < 2; k ++)
+  {
+    memcpy (orig [k].u, sol [k].u, sizeof(double)*n);
+    memcpy (orig [k].r, sol [k].r, sizeof(double)*n);
+  }
+
+  perm = fclib_local_ordering (problem, method);
+  ASSERT (perm && is_permutation (perm, nc), "ERROR: local contact ordering is not a permutation");
+  ASSERT (fclib_local_permute (problem, perm), "ERROR: permuting a local problem failed");
+
+  b = dense_matrix (problem->W);
+  for (r = 0; r < n; r ++)
+  {
+    int ro = sd*perm [r/sd] + r%sd;
+    ASSERT (problem->q [r] == q [ro] && problem->mu [r/sd] == mu [perm [r/sd]], "ERROR: permuted vectors differ at %d", r);
+    for (c = 0; c < n; c ++)
+    {
+      int co = sd*perm [c/sd] + c%sd;
+      ASSERT (fabs (b [r*n+c] - a [ro*n+co]) <= 1e-12 * (1.0 + fabs (a [ro*n+co])), "ERROR: permuted W differs at (%d, %d)", r, c);
+    }
+  }
+  free (a);
+  free (b);
+
+  /* the solution and guesses stored in the original order are reordered with the stored permutation */
+  ASSERT (fclib_write_local (problem, "output_file.hdf5") && fclib_write_solution (orig, "output_file.hdf5") &&
+          fclib_write_guesses (2, orig, "output_file.hdf5") && fclib_write_permutation ("output_file.hdf5", 0, perm, rand () % 4),
+          "ERROR: writing a permuted problem failed");
+  p = fclib_read_local ("output_file.hdf5");
+  stored = fclib_read_permutation ("output_file.hdf5", 0);
+  ASSERT (p && compare_local_problems (problem, p) && stored && memcmp (stored, perm, sizeof(int)*nc) == 0,
+          "ERROR: written/read permuted problem comparison failed");
+
+  /* a second permutation is composed with the stored one, which maps the solutions back */
+  ASSERT (fclib_permute_solutions (sd, nc, perm, 0, sol, 2), "ERROR: permuting solutions failed");
+  {
+    struct fclib_solution *s = fclib_read_solution ("output_file.hdf5");
+    ASSERT (s && compare_solutions (sol, s, 0, n, 0), "ERROR: the stored solution does not follow the stored permutation");
+    fclib_delete_solutions (s, 1);
+  }
+  MM (shuffle = (int*)malloc (sizeof(int)*nc));
+  for (k = 0; k < nc; k ++) shuffle [k] = nc-1-k;
+  ASSERT (fclib_local_permute (p, shuffle) && fclib_permute_solutions (sd, nc, shuffle, 0, sol, 2), "ERROR: second permutation failed");
+  for (k = 0; k < nc; k ++) perm [k] = stored [shuffle [k]];
+  ASSERT (fclib_write_permutation ("output_file.hdf5", 0, perm, 0), "ERROR: replacing the stored permutation failed");
+  free (stored);
+  stored = fclib_read_permutation ("output_file.hdf5", 0);
+  {
+    struct fclib_solution *g;
+    int count;
+
+    g = fclib_read_guesses ("output_file.hdf5", &count);
+    ASSERT (g && count == 2 && compare_solutions (sol, g, 0, n, 0) && compare_solutions (sol+1, g+1, 0, n, 0),
+            "ERROR: the stored guesses do not follow the replaced permutation");
+    fclib_delete_solutions (g, count);
+  }
+  ASSERT (stored && fclib_permute_solutions (sd, nc, stored, 1, sol, 2), "ERROR: mapping solutions back failed");
+  for (k = 0; k < 2; k ++)
+  {
+    ASSERT (compare_solutions (orig+k, sol+k, 0, n, 0), "ERROR: solutions mapped back differ from the original ones");
+  }
+  shuffle [0] = shuffle [1];
+  ASSERT (!fclib_local_permute (p, shuffle), "ERROR: a non-permutation was accepted");
+  ASSERT (!fclib_write_permutation ("output_file.hdf5", 0, shuffle, 0), "ERROR: storing a non-permutation was accepted");
+  ASSERT (!fclib_read_permutation ("output_file.hdf5", 1), "ERROR: a permutation of a missing problem was read");
+
+  /* a stored permutation of the wrong size is rejected */
+  {
+    hid_t file_id, id, space_id, dataset_id;
+    hsize_t dim = (hsize_t)nc+1;
+
+    MM (shuffle = (int*)realloc (shuffle, sizeof(int)*(nc+1)));
+    for (k = 0; k <= nc; k ++) shuffle [k] = k;
+    ASSERT ((file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDWR, H5P_DEFAULT)) >= 0 &&
+            (id = H5Gopen (file_id, "/fclib_local/vectors", H5P_DEFAULT)) >= 0 &&
+            H5Ldelete (id, "perm", H5P_DEFAULT) >= 0 && (space_id = H5Screate_simple (1, &dim, NULL)) >= 0 &&
+            (dataset_id = H5Dcreate (id, "perm", H5T_NATIVE_INT, space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0 &&
+            H5Dwrite (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, shuffle) >= 0 &&
+            H5Dclose (dataset_id) >= 0 && H5Sclose (space_id) >= 0 && H5Gclose (id) >= 0 && H5Fclose (file_id) >= 0,
+            "ERROR: rewriting the stored permutation failed");
+  }
+  ASSERT (!fclib_read_permutation ("output_file.hdf5", 0) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: a stored permutation of the wrong size was accepted");
+  fclib_clear_error ();
+  remove ("output_file.hdf5");
+
+  free (shuffle);
+  free (stored);
+  free (perm);
+  free (q);
+  free (mu);
+  fclib_delete_solutions (sol, 2);
+  fclib_delete_solutions (orig, 2);
+  fclib_delete_local (p);
+  free (p);
+  fclib_delete_local (problem);
+  free (problem);
+
+  /* global problem: the columns of H, w and mu follow the permutation */
+  global = random_global_problem (10 + rand () % 100, 10 + rand () % 100, 0);
+  sd = global->spacedim;
+  n = global->H->n;
+  nc = n / sd;
+  a = dense_matrix (global->H);
+  MM (q = (double*)malloc (sizeof(double)*n));
+  memcpy (q, global->w, sizeof(double)*n);
+
+  perm = fclib_global_ordering (global, method);
+  ASSERT (perm && is_permutation (perm, nc), "ERROR: global contact ordering is not a permutation");
+  ASSERT (fclib_global_permute (global, perm), "ERROR: permuting a global problem failed");
+  b = dense_matrix (global->H);
+  for (c = 0; c < n; c ++)
+  {
+    int co = sd*perm [c/sd] + c%sd;
+    ASSERT (global->w [c] == q [co], "ERROR: permuted w differs at %d", c);
+    for (r = 0; r < global->H->m; r ++)
+      ASSERT (fabs (b [r*n+c] - a [r*n+co]) <= 1e-12 * (1.0 + fabs (a [r*n+co])), "ERROR: permuted H differs at (%d, %d)", r, c);
+  }
+  free (a);
+  free (b);
+  free (q);
+  free (perm);
+  fclib_delete_global (global);
+  free (global);
+
+  /* a chain of contacts numbered at random gets back its unit block bandwidth from reverse Cuthill-McKee */
+  if (method != FCLIB_ORDERING_RCM) return;
+
+  nc = 100 + rand () % 100;
+  MM (shuffle = (int*)malloc (sizeof(int)*nc));
+  for (k = 0; k < nc; k ++) shuffle [k] = k;
+  for (k = nc-1; k > 0; k --)
+  {
+    r = rand () % (k+1);
+    c = shuffle [k], shuffle [k] = shuffle [r], shuffle [r] = c;
+  }
+  MM (problem = (struct fclib_local*)calloc (1, sizeof (struct fclib_local)));
+  problem->spacedim = 3;
+  MM (problem->W = W = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  W->m = W->n = 3*nc;
+  W->nzmax = 3*nc;
+  MM (W->p = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->i = (int*)malloc (sizeof(int)*W->nzmax));
+  MM (W->x = (double*)malloc (sizeof(double)*W->nzmax));
+  for (k = 0; k < nc; k ++) /* contact shuffle [k] is coupled to contact shuffle [k+1] */
+  {
+    W->p [W->nz] = 3*shuffle [k];
+    W->i [W->nz] = 3*shuffle [k];
+    W->x [W->nz ++] = 2.0;
+    if (k+1 < nc)
+    {
+      W->p [W->nz] = 3*shuffle [k];
+      W->i [W->nz] = 3*shuffle [k+1];
+      W->x [W->nz ++] = -1.0;
+    }
+  }
+  problem->q = random_vector (3*nc);
+  problem->mu = random_vector (nc);
+
+  perm = fclib_local_ordering (problem, method);
+  ASSERT (perm && fclib_local_permute (problem, perm), "ERROR: reordering a chain of contacts failed");
+  for (band = k = 0; k < W->nz; k ++)
+    if (abs (W->p [k] - W->i [k])/3 > band) band = abs (W->p [k] - W->i [k])/3;
+  ASSERT (band == 1, "ERROR: reverse Cuthill-McKee left a block bandwidth %d on a chain", band);
+
+  free (perm);
+  free (shuffle);
+  fclib_delete_local (problem);
+  free (problem);
+}
+
+/* gather statistics and a trace of writing and reading a problem */
+static void test_stats (void)
+{
+  struct fclib_local *problem, *p;
+  struct fclib_stats stats;
+  char head [16] = "";
+  int on, k;
+  FILE *f;
+
+  printf ("Gathering I/O statistics ...\n");
+
+  problem = random_local_problem (10 + rand () % 100, 10);
+  fclib_stats_reset ();
+  on = fclib_stats_trace ("output_trace.json");
+  ASSERT (fclib_write_local (problem, "output_file.hdf5"), "ERROR: writing local problem failed");
+  p = fclib_read_local ("output_file.hdf5");
+  ASSERT (fclib_stats_get (&stats) == on, "ERROR: statistics and tracing disagree");
+
+  if (on)
+  {
+    ASSERT (stats.io_calls > 0 && stats.io_time >= 0.0 && stats.allocations > 0 && stats.bytes_allocated > 0,
+            "ERROR: HDF5 calls or allocations were not counted");
+    ASSERT (stats.bytes_written [FCLIB_STATS_VECTOR] == (long long)sizeof(double)*(problem->W->m + problem->W->m/problem->spacedim +
+            (problem->R ? problem->R->m : 0)), "ERROR: wrong count of vector bytes written");
+    for (k = 0; k < FCLIB_STATS_CLASSES; k ++)
+      ASSERT (stats.bytes_read [k] == stats.bytes_written [k], "ERROR: bytes read and written differ for class %d", k);
+    ASSERT (stats.bytes_written [FCLIB_STATS_SOLUTION] == 0, "ERROR: a problem has no solution bytes");
+    ASSERT (fclib_stats_trace (NULL), "ERROR: writing the trace failed");
+    ASSERT ((f = fopen ("output_trace.json", "r")) && fgets (head, 16, f) && strncmp (head, "{\"traceEvents\"", 14) == 0,
+            "ERROR: trace is not in the Chrome trace format");
+    fclose (f);
+    remove ("output_trace.json");
+    fclib_stats_reset ();
+    fclib_stats_get (&stats);
+    ASSERT (stats.io_calls == 0 && stats.bytes_written [FCLIB_STATS_MATRIX] == 0, "ERROR: statistics were not reset");
+  }
+  else
+  {
+    ASSERT (stats.io_calls == 0 && stats.allocations == 0, "ERROR: statistics gathered without FCLIB_WITH_STATS");
+    ASSERT (!fclib_stats_trace (NULL), "ERROR: tracing without FCLIB_WITH_STATS");
+  }
+
+  fclib_delete_local (p);
+  free (p);
+  fclib_delete_local (problem);
+  free (problem);
+  remove ("output_file.hdf5");
+}
+
+/* number of HDF5 objects left open by the library */
+static ssize_t open_objects (void)
+{
+  return H5Fget_obj_count ((hid_t)H5F_OBJ_ALL, H5F_OBJ_ALL);
+}
+
+/* check that failing calls return, report their error and leave no file or object open */
+static void test_errors (void)
+{
+  struct fclib_local *problem, *p;
+  struct fclib_solution *solution, *s;
+  const char *message;
+  hid_t file_id;
+  int n;
+
+  printf ("Recovering from I/O errors ...\n");
+
+  problem = random_local_problem (10 + rand () % 100, 10);
+  solution = random_local_solutions (problem, 1);
+  remove ("output_file.hdf5");
+  fclib_clear_error ();
+  ASSERT (fclib_last_error (&message) == FCLIB_ERROR_NONE && message [0] == '\0', "ERROR: error not cleared");
+
+  ASSERT (!fclib_read_local ("missing_file.hdf5") && fclib_last_error (&message) == FCLIB_ERROR_FILE && message [0],
+          "ERROR: reading a missing file did not fail");
+  ASSERT (!fclib_write_solution (solution, "missing_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_FILE,
+          "ERROR: writing a solution to a missing file did not fail");
+
+  ASSERT (fclib_write_local (problem, "output_file.hdf5"), "ERROR: writing local problem failed");
+  ASSERT (!fclib_write_local (problem, "output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: overwriting a local problem did not fail");
+  ASSERT (!fclib_read_global ("output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_HDF5,
+          "ERROR: reading a missing global problem did not fail");
+  ASSERT (!fclib_read_solution ("output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_HDF5,
+          "ERROR: reading a missing solution did not fail");
+  ASSERT (!fclib_read_guess ("output_file.hdf5", 0) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: reading a missing guess did not fail");
+  ASSERT (!fclib_read_guesses ("output_file.hdf5", &n) && n == 0, "ERROR: guesses of a file without guesses");
+  ASSERT (open_objects () == 0, "ERROR: failed calls left %d HDF5 objects open", (int)open_objects ());
+
+  ASSERT (fclib_write_solution (solution, "output_file.hdf5"), "ERROR: writing solution failed");
+
+  IO (file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDWR, H5P_DEFAULT)); /* truncate the matrix W */
+  IO (H5Ldelete (file_id, "/fclib_local/W/x", H5P_DEFAULT));
+  IO (H5Fclose (file_id));
+  ASSERT (!fclib_read_local ("output_file.hdf5") && fclib_last_error (&message) == FCLIB_ERROR_HDF5 && strstr (message, "\"x\""),
+          "ERROR: reading a truncated matrix did not fail");
+  ASSERT (open_objects () == 0, "ERROR: a failed read left %d HDF5 objects open", (int)open_objects ());
+
+  /* the file was closed: it can be updated and read again */
+  s = fclib_read_solution ("output_file.hdf5");
+  ASSERT (s && fclib_replace_solution (s, "output_file.hdf5"), "ERROR: the file was not released by the failed read");
+  fclib_delete_solutions (s, 1);
+
+  ASSERT (fclib_write_local (problem, "output_file2.hdf5") && (p = fclib_read_local ("output_file2.hdf5")) &&
+          compare_local_problems (problem, p), "ERROR: reading after failures failed");
+  ASSERT (fclib_last_error (NULL) == FCLIB_ERROR_HDF5, "ERROR: a successful call changed the last error");
+  fclib_clear_error ();
+  ASSERT (fclib_last_error (&message) == FCLIB_ERROR_NONE && message [0] == '\0', "ERROR: error not cleared");
+
+  fclib_delete_local (p);
+  free (p);
+  fclib_delete_solutions (solution, 1);
+  fclib_delete_local (problem);
+  free (problem);
+  remove ("output_file.hdf5");
+  remove ("output_file2.hdf5");
+}
+
+/* set an index of a valid matrix to a value for which it must be rejected, then restore it */
+static void reject_index (struct fclib_matrix *mat, int *index, int value, const char *what)
+{
+  int saved = *index;
+
+  *index = value;
+  ASSERT (!fclib_matrix_validate (mat, NULL) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: %s was not rejected for storage %d", what, mat->nz);
+  fclib_clear_error ();
+  *index = saved;
+  ASSERT (fclib_matrix_validate (mat, NULL), "ERROR: restoring %s failed for storage %d", what, mat->nz);
+}
+
+/* validate canonical matrices in every storage, unsorted and repeated indices, corrupt pointers
+ * and indices, and reads of corrupt files */
+static void test_validate (int n)
+{
+  int storages [5] = {FCLIB_TRIPLET, FCLIB_CSC, FCLIB_CSR, FCLIB_BSR, FCLIB_SYMMETRIC}, s, j, k, t, structure;
+  struct fclib_matrix *mat, *csc, *a;
+  struct fclib_local *problem, *p;
+  hid_t file_id, dataset_id, space_id;
+  hssize_t count;
+  hsize_t dim;
+  int *i;
+
+  printf ("Validating matrices ...\n");
+
+  mat = random_matrix (3*n, 3*n);
+  ASSERT ((csc = fclib_matrix_convert (mat, FCLIB_CSC)) && fclib_matrix_canonicalize (csc), "ERROR: conversion failed");
+
+  for (s = 0; s < 5; s ++)
+  {
+    a = (storages [s] == FCLIB_BSR ? fclib_matrix_to_bsr (csc, 3) :
+         storages [s] == FCLIB_SYMMETRIC ? fclib_matrix_to_symmetric (csc) : fclib_matrix_convert (csc, storages [s]));
+    ASSERT (a && fclib_matrix_canonicalize (a), "ERROR: conversion to storage %d failed", storages [s]);
+    ASSERT (fclib_matrix_validate (a, &structure) && structure == (FCLIB_MATRIX_SORTED|FCLIB_MATRIX_UNIQUE),
+            "ERROR: canonical matrix of storage %d not valid, sorted and unique => %d", a->nz, structure);
+
+    if (a->nz >= 0) /* triplets: rows in p, columns in i */
+    {
+      for (k = 0; k < a->nz-1 && a->p [k] == a->p [k+1]; k ++);
+      ASSERT (k < a->nz-1, "ERROR: a single row of triplets");
+      t = a->p [k], a->p [k] = a->p [k+1], a->p [k+1] = t;
+      t = a->i [k], a->i [k] = a->i [k+1], a->i [k+1] = t;
+      ASSERT (fclib_matrix_validate (a, &structure) && structure == 0, "ERROR: unsorted triplets => %d", structure);
+      a->p [k] = a->p [k+1], a->i [k] = a->i [k+1];
+      ASSERT (fclib_matrix_validate (a, &structure) && structure == FCLIB_MATRIX_SORTED, "ERROR: repeated triplets => %d", structure);
+
+      reject_index (a, &a->p [0], a->m, "a row out of range");
+      reject_index (a, &a->i [0], -1, "a negative column");
+      reject_index (a, &a->nz, a->nzmax+1, "nz beyond nzmax");
+    }
+    else
+    {
+      int bs = (a->nz == FCLIB_BSR ? a->bs : 1), outer = (a->nz == FCLIB_CSR || a->nz == FCLIB_BSR ? a->m : a->n) / bs,
+          inner = (a->nz == FCLIB_CSR || a->nz == FCLIB_BSR ? a->n : a->m) / bs;
+
+      for (j = 0; j < outer && a->p [j+1] - a->p [j] < 2; j ++);
+      ASSERT (j < outer, "ERROR: no column, row or block row of storage %d with two entries", a->nz);
+      k = a->p [j];
+      t = a->i [k], a->i [k] = a->i [k+1], a->i [k+1] = t;
+      ASSERT (fclib_matrix_validate (a, &structure) && structure == 0, "ERROR: unsorted indices of storage %d => %d", a->nz, structure);
+      a->i [k+1] = a->i [k] = t;
+      ASSERT (fclib_matrix_validate (a, &structure) && structure == FCLIB_MATRIX_SORTED,
+              "ERROR: repeated indices of storage %d => %d", a->nz, structure);
+
+      reject_index (a, &a->p [0], 1, "p [0] != 0");
+      reject_index (a, &a->p [1], -1, "a decreasing pointer");
+      reject_index (a, &a->p [outer], a->nzmax / (bs*bs) + 1, "p [outer] beyond nzmax");
+      reject_index (a, &a->i [k], -1, "a negative index");
+      reject_index (a, &a->i [k], inner, "an index out of range");
+      if (a->nz == FCLIB_SYMMETRIC && j+1 < inner) reject_index (a, &a->i [k], j+1, "an entry below the diagonal");
+      if (a->nz == FCLIB_BSR) reject_index (a, &a->bs, 2*a->bs+1, "a block size not dividing the dimensions");
+    }
+
+    fclib_delete_matrix (a);
+  }
+
+  printf ("Reading corrupt matrices and vectors ...\n");
+
+  problem = random_local_problem (10 + rand () % 100, 0);
+  remove ("output_file.hdf5");
+  ASSERT (fclib_write_local (problem, "output_file.hdf5"), "ERROR: writing local problem failed");
+  ASSERT ((p = fclib_read_local_with_flags ("output_file.hdf5", FCLIB_READ_VALIDATE)) && compare_local_problems (problem, p),
+          "ERROR: validated read failed");
+  fclib_delete_local (p);
+  free (p);
+
+  IO (file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDWR, H5P_DEFAULT)); /* an index of W out of range */
+  IO (dataset_id = H5Dopen (file_id, "/fclib_local/W/i", H5P_DEFAULT));
+  IO (space_id = H5Dget_space (dataset_id));
+  IO (count = H5Sget_simple_extent_npoints (space_id));
+  MM (i = (int*)malloc (sizeof (int) * count));
+  IO (H5Dread (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, i));
+  i [count / 2] = problem->W->m + 7;
+  IO (H5Dwrite (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, i));
+  IO (H5Sclose (space_id));
+  IO (H5Dclose (dataset_id));
+  IO (H5Fclose (file_id));
+  free (i);
+  ASSERT (!fclib_read_local_with_flags ("output_file.hdf5", FCLIB_READ_VALIDATE) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: reading a corrupt matrix did not fail");
+  ASSERT (open_objects () == 0, "ERROR: a failed validated read left %d HDF5 objects open", (int)open_objects ());
+  fclib_clear_error ();
+
+  IO (file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDWR, H5P_DEFAULT)); /* mu longer than the number of contacts */
+  IO (H5Ldelete (file_id, "/fclib_local/vectors/mu", H5P_DEFAULT));
+  dim = (hsize_t) (problem->W->m / problem->spacedim + 1);
+  IO (space_id = H5Screate_simple (1, &dim, NULL));
+  IO (dataset_id = H5Dcreate (file_id, "/fclib_local/vectors/mu", H5T_NATIVE_DOUBLE, space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT));
+  IO (H5Dwrite (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, problem->q));
+  IO (H5Dclose (dataset_id));
+  IO (H5Sclose (space_id));
+  IO (H5Fclose (file_id));
+  ASSERT (!fclib_read_local ("output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: reading an oversized vector did not fail");
+  ASSERT (open_objects () == 0, "ERROR: a failed read left %d HDF5 objects open", (int)open_objects ());
+  fclib_clear_error ();
+
+  fclib_delete_local (problem);
+  free (problem);
+  fclib_delete_matrix (csc);
+  fclib_delete_matrix (mat);
+  remove ("output_file.hdf5");
+}
+
+/* |det| of a dense n x n matrix in row major order by Gaussian elimination with partial pivoting */
+static double dense_determinant (int n, const double *matrix)
+{
+  double det = 1.0, t, *a;
+  int j, k, r, c;
+
+  MM (a = (double*)malloc (sizeof(double)*n*n));
+  memcpy (a, matrix, sizeof(double)*n*n);
+  for (k = 0; k < n && det != 0.0; k ++)
+  {
+    for (r = j = k; j < n; j ++)
+      if (fabs (a [j*n+k]) > fabs (a [r*n+k])) r = j;
+    for (c = 0; c < n; c ++) t = a [k*n+c], a [k*n+c] = a [r*n+c], a [r*n+c] = t;
+    det *= fabs (a [k*n+k]);
+    for (j = k+1; j < n && det != 0.0; j ++)
+      for (t = a [j*n+k] / a [k*n+k], c = k; c < n; c ++) a [j*n+c] -= t * a [k*n+c];
+  }
+  free (a);
+
+  return det;
+}
+
+/* triplets of a dense n x n matrix in row major order */
+static struct fclib_matrix* dense_triplets (int n, double *a)
+{
+  struct fclib_matrix *mat;
+  int k;
+
+  MM (mat = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  mat->m = mat->n = n;
+  mat->nz = mat->nzmax = n*n;
+  MM (mat->p = (int*)malloc (sizeof(int)*n*n));
+  MM (mat->i = (int*)malloc (sizeof(int)*n*n));
+  MM (mat->x = (double*)malloc (sizeof(double)*n*n));
+  for (k = 0; k < n*n; k ++)
+  {
+    mat->p [k] = k / n;
+    mat->i [k] = k % n;
+    mat->x [k] = a [k];
+  }
+
+  return mat;
+}
+
+/* n x n permuted diagonal matrix with singular values spread over [0.5, 2], the first 'zeros' being 0 */
+static struct fclib_matrix* permuted_diagonal (int n, int zeros)
+{
+  struct fclib_matrix *mat;
+  int k;
+
+  MM (mat = (struct fclib_matrix*)calloc (1, sizeof (struct fclib_matrix)));
+  mat->m = mat->n = mat->nz = mat->nzmax = n;
+  MM (mat->p = (int*)malloc (sizeof(int)*n));
+  MM (mat->i = (int*)malloc (sizeof(int)*n));
+  MM (mat->x = (double*)malloc (sizeof(double)*n));
+  for (k = 0; k < n; k ++)
+  {
+    mat->p [k] = k;
+    mat->i [k] = (7*k + 3) % n;
+    mat->x [k] = (k < zeros ? 0.0 : (k % 2 ? -1.0 : 1.0) * (0.5 + 1.5 * k / (n-1)));
+  }
+
+  return mat;
+}
+
+/* estimate the conditioning, rank and determinant of small matrices probed exactly, and of larger ones */
+static void test_estimate (void)
+{
+  struct fclib_estimate_options options = {0, 0, 0.0, 0.0, 7, 0};
+  struct fclib_generator_options generator = {FCLIB_SCENE_BOXES, 300, 0.0, 0.0, 0.0, 7, 0};
+  struct fclib_local *problem;
+  struct fclib_matrix *mat, *sym, *full;
+  struct fclib_matrix_info info;
+  double *a, det, logdet;
+  int n = 12, k;
+
+  printf ("Estimating matrix conditioning, rank and determinant ...\n");
+
+  /* n <= probes: every unit vector is a probe, the quadratures are exact */
+  MM (a = (double*)calloc (n*n, sizeof(double))); /* diagonally dominant */
+  for (k = 0; k < n*n; k ++) a [k] = (rand () % 3 ? 0.0 : rand () / (double) RAND_MAX - 0.5) + (k % (n+1) == 0 ? 2.0 : 0.0);
+  mat = dense_triplets (n, a);
+  det = dense_determinant (n, a);
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->rank == n && mat->info->conditioning >= 1.0 &&
+          isfinite (mat->info->conditioning) && fabs (mat->info->determinant - det) <= 1e-8 * det,
+          "ERROR: estimates of a regular matrix => rank %d, conditioning %g, determinant %g != %g",
+          mat->info->rank, mat->info->conditioning, mat->info->determinant, det);
+  fclib_delete_matrix (mat);
+
+  for (k = 0; k < n; k ++) a [n+k] = a [k]; /* two equal rows */
+  mat = dense_triplets (n, a);
+  free (a);
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->rank == n-1 && mat->info->determinant == 0.0 &&
+          mat->info->conditioning == HUGE_VAL, "ERROR: estimates of a singular matrix => rank %d, conditioning %g, determinant %g",
+          mat->info->rank, mat->info->conditioning, mat->info->determinant);
+  fclib_delete_matrix (mat);
+
+  /* random probes: the exact conditioning is 4, the Lanczos estimate a lower bound */
+  mat = permuted_diagonal (2000, 0);
+  for (logdet = 0.0, k = 0; k < mat->n; k ++) logdet += log (fabs (mat->x [k]));
+  MM (mat->info = (struct fclib_matrix_info*)calloc (1, sizeof (struct fclib_matrix_info)));
+  MM (mat->info->comment = (char*)malloc (8));
+  strcpy (mat->info->comment, "kept");
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->rank == mat->n && strcmp (mat->info->comment, "kept") == 0 &&
+          mat->info->conditioning > 3.9 && mat->info->conditioning <= 4.0 * (1.0 + 1e-10) &&
+          fabs (log (mat->info->determinant) - logdet) <= 1e-6 * logdet,
+          "ERROR: estimates of a permuted diagonal matrix => rank %d, conditioning %g, log determinant %g != %g",
+          mat->info->rank, mat->info->conditioning, log (mat->info->determinant), logdet);
+  info = *mat->info;
+
+  options.threads = 2; /* the same estimates with any number of threads */
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->rank == info.rank &&
+          mat->info->conditioning == info.conditioning && mat->info->determinant == info.determinant,
+          "ERROR: estimates depend on the number of threads");
+  options.iterations = 5;
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->conditioning <= info.conditioning,
+          "ERROR: fewer steps gave a larger conditioning");
+  options.iterations = 0;
+  options.time = 1e-9;
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->conditioning >= 1.0 && mat->info->rank > 0,
+          "ERROR: estimates with a time budget failed");
+  fclib_delete_matrix (mat);
+
+  /* W of a generated problem, stored full and as its upper triangle */
+  options.time = 0.0;
+  ASSERT (problem = fclib_generate_local (&generator), "ERROR: generating a local problem failed");
+  full = problem->W;
+  sym = fclib_matrix_to_symmetric (full);
+  ASSERT (fclib_matrix_estimate_info (sym, &options) && fclib_matrix_estimate_info (full, &options) &&
+          sym->info->rank == full->n && full->info->rank == full->n && isfinite (full->info->conditioning) &&
+          fabs (sym->info->conditioning - full->info->conditioning) <= 1e-2 * full->info->conditioning,
+          "ERROR: estimates of W and of its upper triangle differ => conditioning %g != %g",
+          sym->info->conditioning, full->info->conditioning);
+  fclib_delete_matrix (sym);
+  fclib_delete_local (problem);
+  free (problem);
+
+  mat = permuted_diagonal (2000, 100);
+  ASSERT (fclib_matrix_estimate_info (mat, &options) && mat->info->rank == 1900 && mat->info->determinant == 0.0 &&
+          mat->info->conditioning == HUGE_VAL, "ERROR: estimates of a rank deficient matrix => rank %d", mat->info->rank);
+  mat->nz = -5;
+  ASSERT (!fclib_matrix_estimate_info (mat, NULL) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: an unknown storage was not rejected");
+  fclib_clear_error ();
+  mat->nz = mat->nzmax;
+  fclib_delete_matrix (mat);
+}
+
+/* sum of a histogram of fclib_problem_stats */
+static int histogram_sum (int *histogram)
+{
+  int b, sum = 0;
+
+  for (b = 0; b < FCLIB_PROBLEM_STATS_BINS; b ++) sum += histogram [b];
+
+  return sum;
+}
+
+/* compare the structural statistics with their serial computation on W in compressed rows */
+static void check_problem_stats (struct fclib_local *problem, struct fclib_problem_stats *stats)
+{
+  struct fclib_matrix *W = problem->W;
+  int sd = problem->spacedim, n = W->m, nc = n / sd, *block, *adjacent, *label, rows [FCLIB_PROBLEM_STATS_BINS] = {0},
+      row_min = n, row_max = 0, edges = 0, band = 0, blocks = 0, components = 0, largest = 0, changed, b, c, d, j, k;
+
+  MM (block = (int*)calloc (nc*nc, sizeof(int)));
+  MM (adjacent = (int*)calloc (nc*nc, sizeof(int)));
+  MM (label = (int*)malloc (sizeof(int)*nc));
+
+  for (j = 0; j < n; j ++)
+  {
+    for (k = W->p [j]; k < W->p [j+1]; k ++)
+    {
+      band = (abs (W->i [k] - j) > band ? abs (W->i [k] - j) : band);
+      block [(j/sd)*nc + W->i [k]/sd] = 1;
+      if (j/sd != W->i [k]/sd) adjacent [(j/sd)*nc + W->i [k]/sd] = adjacent [(W->i [k]/sd)*nc + j/sd] = 1;
+    }
+    k = W->p [j+1] - W->p [j];
+    row_min = (k < row_min ? k : row_min);
+    row_max = (k > row_max ? k : row_max);
+    for (b = 0; b < FCLIB_PROBLEM_STATS_BINS-1 && k >= (1 << b); b ++);
+    rows [b] ++;
+  }
+  for (c = 0; c < nc*nc; c ++) blocks += block [c], edges += adjacent [c];
+  edges /= 2;
+
+  for (c = 0; c < nc; c ++) label [c] = c;
+  do
+  {
+    for (changed = c = 0; c < nc; c ++)
+      for (d = 0; d < nc; d ++)
+        if (adjacent [c*nc + d] && label [d] < label [c]) label [c] = label [d], changed = 1;
+  } while (changed);
+  for (c = 0; c < nc; c ++)
+    if (label [c] == c)
+    {
+      for (k = d = 0; d < nc; d ++) k += (label [d] == c);
+      components ++;
+      largest = (k > largest ? k : largest);
+    }
+
+  ASSERT (stats->global == 0 && stats->rows == n && stats->cols == n && stats->nnz == W->p [n] && stats->contacts == nc,
+          "ERROR: wrong sizes in the statistics");
+  ASSERT (stats->row_min == row_min && stats->row_max == row_max && memcmp (stats->row_histogram, rows, sizeof (rows)) == 0,
+          "ERROR: wrong entries of the rows");
+  ASSERT (histogram_sum (stats->degree_histogram) == nc && fabs (stats->degree_mean * nc - 2.0 * edges) <= 1e-12 * edges,
+          "ERROR: the degree histogram does not count every contact");
+  ASSERT (stats->bandwidth == band && stats->blocks == blocks && stats->edges == edges,
+          "ERROR: wrong bandwidth %d != %d, blocks %d != %d or edges %d != %d", stats->bandwidth, band, stats->blocks, blocks,
+          stats->edges, edges);
+  ASSERT (stats->components == components && stats->largest_component == largest,
+          "ERROR: wrong components %d != %d or largest component %d != %d", stats->components, components,
+          stats->largest_component, largest);
+  ASSERT (fabs (stats->block_fill - (double) W->p [n] / (blocks*sd*sd)) < 1e-15 && stats->block_fill <= 1.0,
+          "ERROR: wrong block fill %g", stats->block_fill);
+
+  free (block);
+  free (adjacent);
+  free (label);
+}
+
+/* compute the structural statistics of problems and store them in files */
+static void test_problem_stats (void)
+{
+  struct fclib_generator_options options = {FCLIB_SCENE_BOXES, 300, 0.0, 0.0, 0.0, 7, 0};
+  struct fclib_problem_stats stats, other, back;
+  struct fclib_local *problem;
+  struct fclib_global *global;
+  struct fclib_matrix *csr, *mat;
+  int nc, k;
+
+  printf ("Computing problem statistics ...\n");
+
+  /* local problem: W in compressed rows, then compressed columns and blocks of the same pattern */
+  problem = random_local_problem (10 + rand () % 100, 0);
+  nc = problem->W->m / problem->spacedim;
+  csr = fclib_matrix_convert (problem->W, FCLIB_CSR);
+  fclib_delete_matrix (problem->W);
+  problem->W = csr;
+  for (k = 0; k < nc; k ++) problem->mu [k] = (k % 3 ? 0.5 : 0.0);
+  ASSERT (fclib_local_problem_stats (problem, &stats), "ERROR: computing local statistics failed");
+  check_problem_stats (problem, &stats);
+  ASSERT (stats.frictionless == (double) ((nc + 2) / 3) / nc, "ERROR: wrong frictionless share %g", stats.frictionless);
+
+  problem->W = mat = fclib_matrix_convert (csr, FCLIB_CSC);
+  ASSERT (fclib_local_problem_stats (problem, &other) && memcmp (&stats, &other, sizeof (stats)) == 0,
+          "ERROR: statistics differ in compressed columns");
+  fclib_delete_matrix (mat);
+  problem->W = mat = fclib_matrix_to_bsr (csr, problem->spacedim);
+  ASSERT (fclib_local_problem_stats (problem, &other) && other.blocks == stats.blocks && other.block_fill == 1.0 &&
+          other.edges == stats.edges, "ERROR: statistics of blocks differ");
+  fclib_delete_matrix (mat);
+  problem->W = csr;
+
+  /* stored with the problem, then replaced */
+  remove ("output_file.hdf5");
+  ASSERT (fclib_write_local_with_flags (problem, "output_file.hdf5", FCLIB_WRITE_STATS) &&
+          fclib_read_problem_stats ("output_file.hdf5", 0, &back) && memcmp (&stats, &back, sizeof (stats)) == 0,
+          "ERROR: stored local statistics differ");
+  stats.components ++;
+  ASSERT (fclib_write_problem_stats ("output_file.hdf5", &stats) && fclib_read_problem_stats ("output_file.hdf5", 0, &back) &&
+          back.components == stats.components, "ERROR: replacing the statistics failed");
+  ASSERT (!fclib_read_problem_stats ("output_file.hdf5", 1, &back) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: read statistics of a missing global problem");
+  fclib_clear_error ();
+  remove ("output_file.hdf5");
+  fclib_delete_local (problem);
+  free (problem);
+
+  /* global problem: the contact graph of H^T H */
+  global = fclib_generate_global (&options);
+  nc = global->H->n / global->spacedim;
+  for (k = 0; k < nc / 4; k ++) global->mu [k] = 0.0;
+  ASSERT (fclib_global_problem_stats (global, &stats) && stats.global == 1 && stats.rows == global->H->m && stats.contacts == nc,
+          "ERROR: computing global statistics failed");
+  ASSERT (histogram_sum (stats.row_histogram) == stats.rows && histogram_sum (stats.degree_histogram) == nc &&
+          stats.row_min <= stats.row_mean && stats.row_mean <= stats.row_max && fabs (stats.degree_mean * nc - 2.0 * stats.edges) <= 1e-12 * stats.edges &&
+          stats.components >= 1 && stats.largest_component <= nc && stats.block_fill > 0.0 && stats.block_fill <= 1.0,
+          "ERROR: inconsistent global statistics");
+  ASSERT (stats.frictionless == (double) (nc / 4) / nc, "ERROR: wrong frictionless share %g", stats.frictionless);
+  ASSERT (fclib_write_global_with_flags (global, "output_file.hdf5", FCLIB_WRITE_STATS) &&
+          fclib_read_problem_stats ("output_file.hdf5", 1, &back) && memcmp (&stats, &back, sizeof (stats)) == 0,
+          "ERROR: stored global statistics differ");
+  remove ("output_file.hdf5");
+  fclib_delete_global (global);
+  free (global);
+}
+
+/* serialize problems to in-memory file images and back */
+static void test_buffers (void)
+{
+  struct fclib_local *problem, *p;
+  struct fclib_global *global, *g;
+  void *buffer;
+  size_t size;
+  FILE *f;
+
+  printf ("Serializing problems to file images ...\n");
+
+  problem = random_local_problem (10 + rand () % 100, 10);
+  ASSERT (fclib_write_local_to_buffer (problem, &buffer, &size) && buffer && size > 0, "ERROR: writing a local problem image failed");
+  ASSERT ((p = fclib_read_local_from_buffer (buffer, size, 0)) && compare_local_problems (problem, p),
+          "ERROR: local problem image read back differs");
+  fclib_delete_local (p);
+  free (p);
+  ASSERT (!fclib_read_global_from_buffer (buffer, size, 0) && fclib_last_error (NULL) == FCLIB_ERROR_HDF5,
+          "ERROR: reading a global problem from a local image did not fail");
+
+  /* an image is a complete file */
+  ASSERT ((f = fopen ("output_file.hdf5", "wb")) && fwrite (buffer, 1, size, f) == size, "ERROR: saving the image failed");
+  fclose (f);
+  ASSERT ((p = fclib_read_local ("output_file.hdf5")) && compare_local_problems (problem, p), "ERROR: saved image differs");
+  fclib_delete_local (p);
+  free (p);
+  remove ("output_file.hdf5");
+
+  memset (buffer, 0, size < 512 ? size : 512); /* clobber the superblock */
+  ASSERT (!fclib_read_local_from_buffer (buffer, size, 0) && fclib_last_error (NULL) == FCLIB_ERROR_FILE,
+          "ERROR: reading a corrupt image did not fail");
+  free (buffer);
+
+  global = random_global_problem (10 + rand () % 200, 10 + rand () % 200, 10 + rand () % 200);
+  ASSERT (fclib_write_global_to_buffer (global, &buffer, &size), "ERROR: writing a global problem image failed");
+  ASSERT ((g = fclib_read_global_from_buffer (buffer, size, 0)) && compare_global_problems (global, g),
+          "ERROR: global problem image read back differs");
+  ASSERT (open_objects () == 0, "ERROR: file images left %d HDF5 objects open", (int)open_objects ());
+  free (buffer);
+  fclib_clear_error ();
+
+  fclib_delete_global (g);
+  free (g);
+  fclib_delete_global (global);
+  free (global);
+  fclib_delete_local (problem);
+  free (problem);
+}
+
+/* copy the group src into dst, storing the 1d numeric datasets in chunks of 'chunk' elements
+ * filtered by shuffle (if asked), deflate and fletcher32 (if asked) */
+static void compressed_copy (hid_t src, hid_t dst, hsize_t chunk, int shuffle, int fletcher32)
+{
+  H5G_info_t info;
+  hsize_t k;
+
+  IO (H5Gget_info (src, &info));
+  for (k = 0; k < info.nlinks; k ++)
+  {
+    char name [256];
+    hid_t id, space_id, type_id, native_id, plist_id, copy_id;
+    hsize_t count, dim;
+    void *data;
+
+    IO (H5Lget_name_by_idx (src, ".", H5_INDEX_NAME, H5_ITER_INC, k, name, sizeof (name), H5P_DEFAULT));
+    IO (id = H5Oopen (src, name, H5P_DEFAULT));
+    if (H5Iget_type (id) == H5I_GROUP)
+    {
+      IO (copy_id = H5Gcreate (dst, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT));
+      compressed_copy (id, copy_id, chunk, shuffle, fletcher32);
+      IO (H5Gclose (copy_id));
+      IO (H5Oclose (id));
+      continue;
+    }
+
+    IO (space_id = H5Dget_space (id));
+    IO (type_id = H5Dget_type (id));
+    if (H5Sget_simple_extent_ndims (space_id) != 1 || H5Tget_class (type_id) == H5T_STRING)
+    {
+      IO (H5Ocopy (src, name, dst, name, H5P_DEFAULT, H5P_DEFAULT));
+    }
+    else
+    {
+      IO (H5Sget_simple_extent_dims (space_id, &count, NULL));
+      IO (native_id = H5Tget_native_type (type_id, H5T_DIR_ASCEND));
+      MM (data = malloc (H5Tget_size (native_id) * count + 1));
+      IO (H5Dread (id, native_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, data));
+      dim = (count < chunk ? count : chunk);
+      IO (plist_id = H5Pcreate (H5P_DATASET_CREATE));
+      if (dim > 0)
+      {
+        IO (H5Pset_chunk (plist_id, 1, &dim));
+        if (shuffle) IO (H5Pset_shuffle (plist_id));
+        IO (H5Pset_deflate (plist_id, 6));
+        if (fletcher32) IO (H5Pset_fletcher32 (plist_id));
+      }
+      IO (copy_id = H5Dcreate (dst, name, type_id, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT));
+      IO (H5Dwrite (copy_id, native_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, data));
+      IO (H5Dclose (copy_id));
+      IO (H5Pclose (plist_id));
+      IO (H5Tclose (native_id));
+      free (data);
+    }
+    IO (H5Tclose (type_id));
+    IO (H5Sclose (space_id));
+    IO (H5Oclose (id));
+  }
+}
+
+/* the indices of H take less space index filtered then deflated than shuffled then deflated, HDF5
+ * reads them through the filter, which also keeps integers of any difference in either byte order */
+static void test_index_filter (struct fclib_matrix *H, const char *deflated, const char *filtered)
+{
+  int values [1000], back [1000], *i, k;
+  hsize_t size [2], count, chunk = 300;
+  hid_t file_id, dataset_id, plist_id, space_id;
+  const char *paths [2] = {deflated, filtered};
+  unsigned flags, config;
+  size_t nvalues = 0;
+
+  for (k = 0; k < 2; k ++)
+  {
+    IO (file_id = H5Fopen (paths [k], H5F_ACC_RDONLY, H5P_DEFAULT));
+    IO (dataset_id = H5Dopen (file_id, "/fclib_global/H/i", H5P_DEFAULT));
+    size [k] = H5Dget_storage_size (dataset_id);
+    if (k == 1)
+    {
+      IO (plist_id = H5Dget_create_plist (dataset_id));
+      ASSERT (H5Pget_nfilters (plist_id) == 2 &&
+              H5Pget_filter2 (plist_id, 0, &flags, &nvalues, NULL, 0, NULL, &config) == FCLIB_FILTER_INDEX,
+              "ERROR: the indices of H are not index filtered");
+      IO (H5Pclose (plist_id));
+      IO (space_id = H5Dget_space (dataset_id));
+      IO (H5Sget_simple_extent_dims (space_id, &count, NULL));
+      IO (H5Sclose (space_id));
+      MM (i = (int*)malloc (sizeof (int) * count));
+      IO (H5Dread (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, i));
+      ASSERT (memcmp (i, H->i, sizeof (int) * count) == 0, "ERROR: HDF5 reads different indices of H");
+      free (i);
+    }
+    IO (H5Dclose (dataset_id));
+    IO (H5Fclose (file_id));
+  }
+  ASSERT (size [1] < size [0], "ERROR: index filtered indices take %d bytes, deflated ones %d", (int) size [1], (int) size [0]);
+
+  count = 1000;
+  for (k = 0; k < 1000; k ++) values [k] = (k % 7 == 0 ? (k % 2 ? INT_MIN : INT_MAX) : k % 5 == 0 ? -k : rand ());
+  IO (file_id = H5Fopen (filtered, H5F_ACC_RDWR, H5P_DEFAULT));
+  IO (space_id = H5Screate_simple (1, &count, NULL));
+  IO (plist_id = H5Pcreate (H5P_DATASET_CREATE));
+  IO (H5Pset_chunk (plist_id, 1, &chunk));
+  IO (H5Pset_filter (plist_id, FCLIB_FILTER_INDEX, H5Z_FLAG_MANDATORY, 0, NULL));
+  IO (dataset_id = H5Dcreate (file_id, "values", H5T_STD_I32BE, space_id, H5P_DEFAULT, plist_id, H5P_DEFAULT));
+  IO (H5Dwrite (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, values));
+  IO (H5Dclose (dataset_id));
+  IO (dataset_id = H5Dopen (file_id, "values", H5P_DEFAULT));
+  IO (H5Dread (dataset_id, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, back));
+  ASSERT (memcmp (values, back, sizeof (values)) == 0, "ERROR: index filtered values differ");
+  IO (H5Dclose (dataset_id));
+  IO (H5Pclose (plist_id));
+  IO (H5Sclose (space_id));
+  IO (H5Fclose (file_id));
+}
+
+/* read problems whose datasets are compressed in chunks, and write them compressed */
+static void test_compressed (void)
+{
+  struct fclib_generator_options options = {FCLIB_SCENE_BOXES, 5000, 0.0, 0.0, 0.0, 3, 0};
+  struct fclib_local *problem, *p;
+  struct fclib_global *global, *g;
+  hsize_t chunks [3] = {1000, 777, 4096};
+  hid_t file_id, dataset_id, plist_id;
+  double *x;
+  int k;
+
+  printf ("Reading compressed datasets ...\n");
+
+  problem = random_local_problem (500 + rand () % 500, 10);
+  global = random_global_problem (2000 + rand () % 1000, 1000 + rand () % 1000, 10 + rand () % 100);
+  remove ("output_file.hdf5");
+  remove ("output_file2.hdf5");
+  ASSERT (fclib_write_local (problem, "output_file.hdf5") && fclib_write_global (global, "output_file.hdf5"),
+          "ERROR: writing the problems failed");
+
+  for (k = 0; k < 3; k ++) /* with shuffle, without, and with a checksum that fclib does not verify itself */
+  {
+    hid_t src, dst;
+
+    IO (src = H5Fopen ("output_file.hdf5", H5F_ACC_RDONLY, H5P_DEFAULT));
+    IO (dst = H5Fcreate ("output_file2.hdf5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT));
+    compressed_copy (src, dst, chunks [k], k != 1, k == 2);
+    IO (H5Fclose (dst));
+    IO (H5Fclose (src));
+
+    ASSERT ((p = fclib_read_local ("output_file2.hdf5")) && compare_local_problems (problem, p),
+            "ERROR: compressed local problem differs (chunks of %d)", (int) chunks [k]);
+    ASSERT ((g = fclib_read_global ("output_file2.hdf5")) && compare_global_problems (global, g),
+            "ERROR: compressed global problem differs (chunks of %d)", (int) chunks [k]);
+    ASSERT (open_objects () == 0, "ERROR: compressed reads left %d HDF5 objects open", (int)open_objects ());
+    fclib_delete_local (p);
+    free (p);
+    fclib_delete_global (g);
+    free (g);
+  }
+
+  fclib_delete_global (global);
+  free (global);
+  fclib_delete_local (problem);
+  free (problem);
+  remove ("output_file.hdf5");
+  remove ("output_file2.hdf5");
+
+  printf ("Writing compressed datasets ...\n");
+
+  global = fclib_generate_global (&options); /* H has several chunks, the last one partial */
+  problem = fclib_generate_local (&options);
+  ASSERT (global && problem && global->H->nzmax > FCLIB_WRITE_CHUNK && global->H->nzmax % FCLIB_WRITE_CHUNK,
+          "ERROR: generating the problems failed");
+  ASSERT (fclib_write_global_with_flags (global, "output_file.hdf5", FCLIB_WRITE_COMPRESS) &&
+          fclib_write_local_with_flags (problem, "output_file.hdf5", FCLIB_WRITE_COMPRESS), "ERROR: compressed writes failed");
+
+  /* the filters are declared, and HDF5 reads the chunks itself */
+  IO (file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDONLY, H5P_DEFAULT));
+  IO (dataset_id = H5Dopen (file_id, "/fclib_global/H/x", H5P_DEFAULT));
+  IO (plist_id = H5Dget_create_plist (dataset_id));
+  ASSERT (H5Pget_layout (plist_id) == H5D_CHUNKED && H5Pget_nfilters (plist_id) == 2, "ERROR: H is not compressed");
+  MM (x = (double*)malloc (sizeof (double) * global->H->nzmax));
+  IO (H5Dread (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, x));
+  ASSERT (memcmp (x, global->H->x, sizeof (double) * global->H->nzmax) == 0, "ERROR: HDF5 reads a different H");
+  free (x);
+  IO (H5Pclose (plist_id));
+  IO (H5Dclose (dataset_id));
+  IO (H5Fclose (file_id));
+
+  ASSERT ((g = fclib_read_global ("output_file.hdf5")) && compare_global_problems (global, g), "ERROR: compressed global problem differs");
+  ASSERT ((p = fclib_read_local ("output_file.hdf5")) && compare_local_problems (problem, p), "ERROR: compressed local problem differs");
+  ASSERT (open_objects () == 0, "ERROR: compressed writes left %d HDF5 objects open", (int)open_objects ());
+
+  fclib_delete_local (p);
+  free (p);
+  fclib_delete_global (g);
+  free (g);
+
+  printf ("Writing index filtered datasets ...\n");
+
+  remove ("output_file2.hdf5");
+  ASSERT (fclib_write_global_with_flags (global, "output_file2.hdf5", FCLIB_WRITE_COMPRESS|FCLIB_WRITE_INDEX_CODEC) &&
+          fclib_write_local_with_flags (problem, "output_file2.hdf5", FCLIB_WRITE_INDEX_CODEC), "ERROR: index filtered writes failed");
+  ASSERT ((g = fclib_read_global ("output_file2.hdf5")) && compare_global_problems (global, g), "ERROR: index filtered global problem differs");
+  ASSERT ((p = fclib_read_local ("output_file2.hdf5")) && compare_local_problems (problem, p), "ERROR: index filtered local problem differs");
+  ASSERT (open_objects () == 0, "ERROR: index filtered writes left %d HDF5 objects open", (int)open_objects ());
+  test_index_filter (global->H, "output_file.hdf5", "output_file2.hdf5");
+
+  fclib_delete_local (p);
+  free (p);
+  fclib_delete_global (g);
+  free (g);
+  fclib_delete_global (global);
+  free (global);
+  fclib_delete_local (problem);
+  free (problem);
+  remove ("output_file.hdf5");
+  remove ("output_file2.hdf5");
+}
+
+/* write matrices in every storage to MatrixMarket files and read them back */
+static void test_mtx (int m, int n)
+{
+  const char *text = "%%MatrixMarket Matrix Coordinate Real Skew-Symmetric\n"
+                     "% values in several notations, a blank line and windows line ends\n"
+                     "%\n"
+                     "  4 4 5\r\n"
+                     "2 1 1.5e0\r\n"
+                     "\n"
+                     "3 2 -2.5E-1\n"
+                     "4 1 0.1\n"
+                     "4 2\t12345678901234567890123\n"
+                     "4 3 -1e-300";
+  double expected [5] = {1.5, -0.25, 0.1, 12345678901234567890123.0, -1e-300}, *a;
+  int storages [3] = {0, -1, -2}, rows [5] = {1, 2, 3, 3, 3}, cols [5] = {0, 1, 0, 1, 2};
+  struct fclib_matrix *mat, *b, *c;
+  const char *message;
+  FILE *f;
+  int j, k;
+
+  printf ("Writing and reading a %d x %d matrix in MatrixMarket format ...\n", m, n);
+
+  mat = random_matrix (m, n);
+  ASSERT (fclib_matrix_write_mtx (mat, "output_file.mtx"), "ERROR: writing a MatrixMarket file failed");
+  for (j = 0; j < 3; j ++)
+  {
+    b = fclib_matrix_read_mtx ("output_file.mtx", storages [j]);
+    ASSERT (b && (storages [j] ? b->nz == storages [j] : b->nz >= 0) && compare_dense_matrices ("mtx", mat, b),
+            "ERROR: MatrixMarket matrix read in storage %d differs", storages [j]);
+    if (storages [j] == 0 && mat->nz >= 0) /* same order and exact values */
+      for (k = 0; k < mat->nz; k ++)
+        ASSERT (b->p [k] == mat->p [k] && b->i [k] == mat->i [k] && b->x [k] == mat->x [k], "ERROR: MatrixMarket entry %d differs", k);
+    fclib_delete_matrix (b);
+  }
+  fclib_delete_matrix (mat);
+
+  /* block and symmetric storage */
+  mat = random_spd_matrix (3 * (1 + rand () % 50), 0);
+  b = fclib_matrix_to_bsr (mat, 3);
+  ASSERT (fclib_matrix_write_mtx (b, "output_file.mtx") && (c = fclib_matrix_read_mtx ("output_file.mtx", -1)) &&
+          compare_dense_matrices ("bsr", b, c), "ERROR: MatrixMarket block matrix differs");
+  fclib_delete_matrix (b);
+  fclib_delete_matrix (c);
+  b = fclib_matrix_to_symmetric (mat);
+  ASSERT (fclib_matrix_write_mtx (b, "output_file.mtx") && (c = fclib_matrix_read_mtx ("output_file.mtx", -4)) && c->nz == -4 &&
+          c->p [c->n] == b->p [b->n], "ERROR: MatrixMarket symmetric matrix read back failed");
+  for (k = 0; k < b->p [b->n]; k ++)
+    ASSERT (c->i [k] == b->i [k] && c->x [k] == b->x [k], "ERROR: MatrixMarket symmetric entry %d differs", k);
+  fclib_delete_matrix (c);
+  ASSERT ((c = fclib_matrix_read_mtx ("output_file.mtx", -2)) && compare_dense_matrices ("sym", mat, c),
+          "ERROR: MatrixMarket symmetric matrix was not expanded");
+  fclib_delete_matrix (c);
+  ASSERT (fclib_matrix_write_mtx (mat, "output_file.mtx") && (c = fclib_matrix_read_mtx ("output_file.mtx", -4)) && c->nz == -4 &&
+          c->p [c->n] == b->p [b->n], "ERROR: MatrixMarket general symmetric matrix read as symmetric failed");
+  fclib_delete_matrix (c);
+  fclib_delete_matrix (b);
+  fclib_delete_matrix (mat);
+
+  /* hand-written file */
+  ASSERT ((f = fopen ("output_file.mtx", "wb")) && fputs (text, f) >= 0, "ERROR: writing a MatrixMarket file failed");
+  fclose (f);
+  ASSERT ((mat = fclib_matrix_read_mtx ("output_file.mtx", 0)) && mat->nz == 10, "ERROR: reading a skew-symmetric MatrixMarket file failed");
+  a = dense_matrix (mat);
+  for (k = 0; k < 5; k ++)
+  {
+    ASSERT (a [rows [k]*4+cols [k]] == expected [k] && a [cols [k]*4+rows [k]] == -expected [k],
+            "ERROR: MatrixMarket value %d differs => %.17g != %.17g", k, a [rows [k]*4+cols [k]], expected [k]);
+  }
+  free (a);
+  fclib_delete_matrix (mat);
+
+  /* invalid files */
+  ASSERT (!fclib_matrix_read_mtx ("output_file.mtx", -4) && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+          "ERROR: reading a skew-symmetric matrix as symmetric did not fail");
+  ASSERT ((f = fopen ("output_file.mtx", "wb")) && fputs ("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 2 1.0\n2 1 2.0\n", f) >= 0,
+          "ERROR: writing a MatrixMarket file failed");
+  fclose (f);
+  ASSERT (!fclib_matrix_read_mtx ("output_file.mtx", -4) && fclib_last_error (&message) == FCLIB_ERROR_INVALID && strstr (message, "not symmetric"),
+          "ERROR: reading a non-symmetric general matrix as symmetric did not fail");
+  ASSERT ((f = fopen ("output_file.mtx", "wb")) && fputs ("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n1 3 1.0\n", f) >= 0,
+          "ERROR: writing a MatrixMarket file failed");
+  fclose (f);
+  ASSERT (!fclib_matrix_read_mtx ("output_file.mtx", 0) && fclib_last_error (&message) == FCLIB_ERROR_INVALID && strstr (message, "line 4"),
+          "ERROR: reading an out of range entry did not fail");
+  ASSERT ((f = fopen ("output_file.mtx", "wb")) && fputs ("%%MatrixMarket matrix coordinate real general\n2 2 4294967298\n1 1 1.0\n", f) >= 0,
+          "ERROR: writing a MatrixMarket file failed");
+  fclose (f);
+  ASSERT (!fclib_matrix_read_mtx ("output_file.mtx", 0) && fclib_last_error (&message) == FCLIB_ERROR_INVALID && strstr (message, "4294967298"),
+          "ERROR: reading a count of entries beyond an int did not fail");
+  ASSERT (!fclib_matrix_read_mtx ("missing_file.mtx", 0) && fclib_last_error (NULL) == FCLIB_ERROR_FILE,
+          "ERROR: reading a missing MatrixMarket file did not fail");
+  fclib_clear_error ();
+
+  remove ("output_file.mtx");
+}
+
+/* generate the synthetic scenes in memory and streamed to a file, and check their structure */
+static void test_generator (int scene)
+{
+  struct fclib_generator_options options = {0, 200, 0.0, 0.0, 0.0, 0, 0};
+  struct fclib_global *problem, *p;
+  struct fclib_local *local;
+  struct fclib_block_diagonal *bd;
+  double *a;
+  int n, r, c;
+
+  printf ("Generating synthetic scene %d ...\n", scene);
+
+  options.scene = scene;
+  options.seed = (unsigned int) rand ();
+  problem = fclib_generate_global (&options);
+  ASSERT (problem && problem->spacedim == 3 && problem->H->n % 3 == 0 && problem->H->n > 0, "ERROR: generating scene %d failed", scene);
+  ASSERT (problem->M->m == problem->M->n && problem->H->m == problem->M->n, "ERROR: generated M and H do not match");
+  bd = fclib_matrix_analyze (problem->M, 0);
+  ASSERT (bd && bd->maxbs <= 6 && bd->inverse, "ERROR: generated M is not block-diagonal positive definite");
+  fclib_delete_block_diagonal (bd);
+
+  options.threads = 1; /* same problem for any number of threads */
+  p = fclib_generate_global (&options);
+  ASSERT (compare_global_problems (problem, p), "ERROR: generated problem depends on the number of threads");
+  fclib_delete_global (p);
+  free (p);
+
+  ASSERT (fclib_generate_write_global (&options, "output_file.hdf5"), "ERROR: streaming a generated problem failed");
+  p = fclib_read_global ("output_file.hdf5");
+  ASSERT (compare_global_problems (problem, p), "ERROR: streamed and generated problems differ");
+  fclib_delete_global (p);
+  free (p);
+  remove ("output_file.hdf5");
+
+  local = fclib_generate_local (&options);
+  ASSERT (local && local->W->m == problem->H->n, "ERROR: generating a local problem failed");
+  n = local->W->n;
+  a = dense_matrix (local->W);
+  for (r = 0; r < n; r ++)
+    for (c = 0; c < r; c ++)
+      ASSERT (fabs (a [r*n+c] - a [c*n+r]) <= 1e-12 * (1.0 + fabs (a [r*n+c])), "ERROR: generated W is not symmetric at (%d, %d)", r, c);
+  dense_spd_solve (a, n, NULL, 0);
+  for (r = 0; r < n; r ++) ASSERT (a [r*n+r] > 0.0, "ERROR: generated W is not positive definite");
+  free (a);
+
+  fclib_delete_local (local);
+  free (local);
+  fclib_delete_global (problem);
+  free (problem);
+}
+
 int main (int argc, char **argv)
 {
   int i;
@@ -414,9 +2021,9 @@ int main (int argc, char **argv)
   if (rand () % 2)
   {
     struct fclib_global *problem, *p;
-    struct fclib_solution *solution, *s;
-    struct fclib_solution *guesses, *g;
-    int numguess = rand () % 10, n;
+    struct fclib_solution *solution, *s, *s1;
+    struct fclib_solution *guesses, *g, *g1;
+    int numguess = rand () % 10, n, n1;
     short allfine = 0;
 
     problem = random_global_problem (10 + rand () % 900, 10 + rand () % 900, 10 + rand () % 900);
@@ -443,6 +2050,81 @@ int main (int argc, char **argv)
         ASSERT (compare_solutions (guesses+i, g+i, p->M->n, p->H->n, (p->G ? p->G->n : 0)), "ERROR: written/read guess comparison failed");
       }
 
+      printf ("Appending and reading back a single guess ...\n");
+
+      ASSERT (fclib_append_guess (solution, "output_file.hdf5"), "ERROR: appending a guess failed");
+      s1 = fclib_read_guess ("output_file.hdf5", numguess);
+      ASSERT (s1 && compare_solutions (solution, s1, p->M->n, p->H->n, (p->G ? p->G->n : 0)), "ERROR: appended/read guess comparison failed");
+      fclib_delete_solutions (s1, 1);
+
+      ASSERT (fclib_append_guesses (numguess, guesses, "output_file.hdf5"), "ERROR: appending guesses failed");
+      g1 = fclib_read_guesses ("output_file.hdf5", &n1);
+      ASSERT (n1 == 2*numguess+1, "ERROR: wrong number of guesses after appending");
+      for (i = 0; i < numguess; i ++)
+      {
+        ASSERT (compare_solutions (guesses+i, g1+numguess+1+i, p->M->n, p->H->n, (p->G ? p->G->n : 0)), "ERROR: appended/read guess comparison failed");
+      }
+      fclib_delete_solutions (g1, n1);
+
+      { /* a guess without r fails the append before any dataset grows, so that the next append lines up */
+        double *r = guesses [numguess-1].r;
+
+        guesses [numguess-1].r = NULL;
+        ASSERT (!fclib_append_guesses (numguess, guesses, "output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+                "ERROR: appending an incomplete guess did not fail");
+        fclib_clear_error ();
+        guesses [numguess-1].r = r;
+
+        ASSERT (fclib_append_guess (guesses, "output_file.hdf5"), "ERROR: appending a guess after a failed append failed");
+        s1 = fclib_read_guess ("output_file.hdf5", 2*numguess+1);
+        ASSERT (s1 && compare_solutions (guesses, s1, p->M->n, p->H->n, (p->G ? p->G->n : 0)), "ERROR: guess appended after a failed append differs");
+        fclib_delete_solutions (s1, 1);
+      }
+
+      printf ("Replacing the solution ...\n");
+
+      solution->r [0] += 1.0;
+      ASSERT (fclib_replace_solution (solution, "output_file.hdf5"), "ERROR: replacing the solution failed");
+      s1 = fclib_read_solution ("output_file.hdf5");
+      ASSERT (compare_solutions (solution, s1, p->M->n, p->H->n, (p->G ? p->G->n : 0)), "ERROR: replaced/read solution comparison failed");
+
+      { /* a solution without u fails the replacement */
+        double *u = solution->u;
+
+        solution->u = NULL;
+        ASSERT (!fclib_replace_solution (solution, "output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+                "ERROR: replacing with an incomplete solution did not fail");
+        fclib_clear_error ();
+        solution->u = u;
+      }
+
+      { /* a stored r of the wrong size fails the replacement before v is touched */
+        hid_t file_id, space_id, dataset_id;
+        hsize_t dim = (hsize_t) p->H->n + 1;
+        double *r, *v;
+
+        MM (r = (double*)calloc (p->H->n + 1, sizeof(double)));
+        MM (v = (double*)malloc (sizeof(double)*p->M->n));
+        ASSERT ((file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDWR, H5P_DEFAULT)) >= 0 &&
+                H5Ldelete (file_id, "/solution/r", H5P_DEFAULT) >= 0 && (space_id = H5Screate_simple (1, &dim, NULL)) >= 0 &&
+                (dataset_id = H5Dcreate (file_id, "/solution/r", H5T_NATIVE_DOUBLE, space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT)) >= 0 &&
+                H5Dwrite (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, r) >= 0 &&
+                H5Dclose (dataset_id) >= 0 && H5Sclose (space_id) >= 0 && H5Fclose (file_id) >= 0,
+                "ERROR: resizing the stored r failed");
+        solution->v [0] += 1.0;
+        ASSERT (!fclib_replace_solution (solution, "output_file.hdf5") && fclib_last_error (NULL) == FCLIB_ERROR_INVALID,
+                "ERROR: replacing a solution of another size did not fail");
+        fclib_clear_error ();
+        ASSERT ((file_id = H5Fopen ("output_file.hdf5", H5F_ACC_RDONLY, H5P_DEFAULT)) >= 0 &&
+                (dataset_id = H5Dopen (file_id, "/solution/v", H5P_DEFAULT)) >= 0 &&
+                H5Dread (dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, v) >= 0 &&
+                H5Dclose (dataset_id) >= 0 && H5Fclose (file_id) >= 0 &&
+                memcmp (v, s1->v, sizeof(double)*p->M->n) == 0, "ERROR: a failed replacement changed the stored v");
+        free (r);
+        free (v);
+      }
+      fclib_delete_solutions (s1, 1);
+
       printf ("All comparisons PASSED\n");
 
       fclib_delete_global (p);
@@ -459,9 +2141,9 @@ int main (int argc, char **argv)
   else
   {
     struct fclib_local *problem, *p;
-    struct fclib_solution *solution, *s;
-    struct fclib_solution *guesses, *g;
-    int numguess = rand () % 10, n;
+    struct fclib_solution *solution, *s, *s1;
+    struct fclib_solution *guesses, *g, *g1;
+    int numguess = rand () % 10, n, n1;
     short allfine = 0;
 
     problem = random_local_problem (10 + rand () % 900, 10 + rand () % 900);
@@ -498,6 +2180,30 @@ int main (int argc, char **argv)
         ASSERT (compare_solutions (guesses+i, g+i, 0, p->W->n, (p->R ? p->R->n : 0)), "ERROR: written/read guess comparison failed");
       }
 
+      printf ("Appending and reading back a single guess ...\n");
+
+      ASSERT (fclib_append_guess (solution, "output_file.hdf5"), "ERROR: appending a guess failed");
+      s1 = fclib_read_guess ("output_file.hdf5", numguess);
+      ASSERT (s1 && compare_solutions (solution, s1, 0, p->W->n, (p->R ? p->R->n : 0)), "ERROR: appended/read guess comparison failed");
+      fclib_delete_solutions (s1, 1);
+
+      ASSERT (fclib_append_guesses (numguess, guesses, "output_file.hdf5"), "ERROR: appending guesses failed");
+      g1 = fclib_read_guesses ("output_file.hdf5", &n1);
+      ASSERT (n1 == 2*numguess+1, "ERROR: wrong number of guesses after appending");
+      for (i = 0; i < numguess; i ++)
+      {
+        ASSERT (compare_solutions (guesses+i, g1+numguess+1+i, 0, p->W->n, (p->R ? p->R->n : 0)), "ERROR: appended/read guess comparison failed");
+      }
+      fclib_delete_solutions (g1, n1);
+
+      printf ("Replacing the solution ...\n");
+
+      solution->r [0] += 1.0;
+      ASSERT (fclib_replace_solution (solution, "output_file.hdf5"), "ERROR: replacing the solution failed");
+      s1 = fclib_read_solution ("output_file.hdf5");
+      ASSERT (compare_solutions (solution, s1, 0, p->W->n, (p->R ? p->R->n : 0)), "ERROR: replaced/read solution comparison failed");
+      fclib_delete_solutions (s1, 1);
+
       printf ("All comparions PASSED\n");
 
       fclib_delete_local (p);
@@ -514,5 +2220,51 @@ int main (int argc, char **argv)
 
    remove ("output_file.hdf5");
 
+  test_conversions (1 + rand () % 100, 1 + rand () % 100);
+  test_conversions (1000, 800);
+  test_block_diagonal ();
+  test_global_to_local (1);
+  test_global_to_local (0);
+  test_bsr_conversion (2);
+  test_bsr_conversion (3);
+  test_gaxpy (3 * (1 + rand () % 50));
+  test_symmetric_storage ();
+  test_contact_ordering (FCLIB_ORDERING_RCM);
+  test_contact_ordering (FCLIB_ORDERING_ND);
+  test_generator (FCLIB_SCENE_SPHERES);
+  test_generator (FCLIB_SCENE_BOXES);
+  test_generator (FCLIB_SCENE_COLUMN);
+  test_stats ();
+  test_errors ();
+  test_validate (10 + rand () % 50);
+  test_estimate ();
+  test_problem_stats ();
+  test_buffers ();
+  test_compressed ();
+  test_mtx (1 + rand () % 100, 1 + rand () % 100);
+  test_mtx (1000, 800);
+
+  {
+    struct fclib_local *p;
+    struct fclib_solution *g, *g1;
+    int n;
+
+    printf ("Reading guesses stored one group per guess ...\n");
+
+    p = fclib_read_local ("local_problem_test.hdf5");
+    g = fclib_read_guesses ("local_problem_test.hdf5", &n);
+    ASSERT (p && g && n > 0, "ERROR: reading guesses failed");
+    for (i = 0; i < n; i ++)
+    {
+      g1 = fclib_read_guess ("local_problem_test.hdf5", i);
+      ASSERT (g1 && compare_solutions (g+i, g1, 0, p->W->n, (p->R ? p->R->n : 0)), "ERROR: single/all guesses comparison failed");
+      fclib_delete_solutions (g1, 1);
+    }
+
+    fclib_delete_local (p);
+    free (p);
+    fclib_delete_solutions (g, n);
+  }
+
   return 0;
 }
@@ -0,0 +1,207 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fctst_hpp.cpp
+ * ----------------------------------------------
+ * C++ interface test
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "fclib.hpp"
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+static_assert (!std::is_copy_constructible_v<fclib::LocalProblem> && std::is_nothrow_move_constructible_v<fclib::LocalProblem>,
+               "LocalProblem must be move-only");
+static_assert (!std::is_copy_constructible_v<fclib::GlobalProblem> && std::is_nothrow_move_constructible_v<fclib::GlobalProblem>,
+               "GlobalProblem must be move-only");
+static_assert (!std::is_copy_constructible_v<fclib::Solution> && std::is_nothrow_move_constructible_v<fclib::Solution>,
+               "Solution must be move-only");
+
+/* relative difference of two vectors */
+static double difference (const std::vector<double> &a, const std::vector<double> &b)
+{
+  double d = 0.0, n = 1.0;
+
+  for (std::size_t k = 0; k < a.size (); k ++)
+  {
+    d = std::fmax (d, std::fabs (a [k] - b [k]));
+    n = std::fmax (n, std::fabs (a [k]));
+  }
+
+  return d / n;
+}
+
+/* compare the specialized products with fclib_matrix_gaxpy in every storage */
+static void test_gaxpy (fclib::LocalProblem &problem)
+{
+  fclib_matrix *csc = fclib_matrix_convert (problem.W ().get (), FCLIB_CSC);
+  int n = csc->n, storages [5] = {FCLIB_TRIPLET, FCLIB_CSC, FCLIB_CSR, FCLIB_BSR, FCLIB_SYMMETRIC};
+  std::vector<double> x (n), y (n), z (n), yt (n), zt (n);
+
+  printf ("Comparing the specialized products ...\n");
+
+  for (int k = 0; k < n; k ++) x [k] = std::rand () / (double) RAND_MAX - 0.5;
+
+  for (int s : storages)
+  {
+    fclib_matrix *A, *S = nullptr;
+
+    if (s == FCLIB_BSR) A = fclib_matrix_to_bsr (csc, problem.spacedim ());
+    else if (s == FCLIB_SYMMETRIC) /* symmetric part of W, compared with its expansion */
+    {
+      S = fclib_matrix_to_symmetric (csc);
+      A = fclib_matrix_expand_symmetric (S);
+    }
+    else A = fclib_matrix_convert (csc, s);
+    ASSERT (A, "ERROR: conversion to storage %d failed", s);
+
+    fclib::ConstMatrixView V (S ? S : A);
+    ASSERT (V.storage () == s && V.x ().size () >= (std::size_t) V.nnz () && V.p ().data () == V->p,
+            "ERROR: view of storage %d is wrong", s);
+
+    std::fill (y.begin (), y.end (), 1.0);
+    std::fill (z.begin (), z.end (), 1.0);
+    fclib_matrix_gaxpy (A, x.data (), y.data ());
+    fclib::gaxpy (V, x, z);
+    ASSERT (difference (y, z) < 1e-12, "ERROR: gaxpy differs for storage %d => %g", s, difference (y, z));
+
+    std::fill (yt.begin (), yt.end (), 0.0);
+    std::fill (zt.begin (), zt.end (), 0.0);
+    if (S) fclib_matrix_gaxpy (A, x.data (), yt.data ()); /* the expansion is symmetric */
+    else
+    {
+      fclib_matrix T = *csc; /* A^T x as the product of the transposed csc matrix stored by rows */
+      T.m = csc->n, T.n = csc->m, T.nz = FCLIB_CSR;
+      fclib::gaxpy<FCLIB_CSR> (fclib::ConstMatrixView (&T), x, yt);
+    }
+    fclib::gatxpy (V, x, zt);
+    ASSERT (difference (yt, zt) < 1e-12, "ERROR: gatxpy differs for storage %d => %g", s, difference (yt, zt));
+
+    fclib_delete_matrix (A);
+    if (S) fclib_delete_matrix (S);
+  }
+
+  fclib_delete_matrix (csc);
+}
+
+int main ()
+{
+  std::srand ((unsigned) 1);
+
+  printf ("Reading a local problem ...\n");
+
+  fclib::LocalProblem problem = fclib::LocalProblem::read ("local_problem_test.hdf5");
+  ASSERT (problem && problem.W ().rows () == problem.W ().cols () && (int) problem.q ().size () == problem.W ().rows () &&
+          (int) problem.mu ().size () == problem.contacts () && problem.q ().data () == problem.get ()->q,
+          "ERROR: views of the local problem are wrong");
+
+  fclib::LocalProblem moved (std::move (problem));
+  ASSERT (!problem && moved, "ERROR: moving the local problem failed");
+  problem = std::move (moved);
+
+  std::vector<fclib::Solution> guesses = fclib::read_guesses ("local_problem_test.hdf5", problem);
+  ASSERT (!guesses.empty () && guesses [0].r ().size () == (std::size_t) problem.W ().cols () && guesses [0].v ().empty (),
+          "ERROR: reading the guesses failed");
+  for (std::size_t k = 0; k < guesses.size (); k ++)
+  {
+    fclib::Solution g = fclib::Solution::read_guess ("local_problem_test.hdf5", (int) k, problem);
+    ASSERT (std::equal (g.r ().begin (), g.r ().end (), guesses [k].r ().begin ()), "ERROR: single/all guesses comparison failed");
+  }
+
+  test_gaxpy (problem);
+
+  printf ("Writing and reading a generated problem ...\n");
+
+  fclib_generator_options options = {FCLIB_SCENE_BOXES, 500, 0.0, 0.0, 0.0, 7, 0};
+  fclib::GlobalProblem global = fclib::GlobalProblem::generate (options);
+  fclib::LocalProblem local = global.to_local ();
+  remove ("output_file_hpp.hdf5");
+  local.write ("output_file_hpp.hdf5");
+  fclib::LocalProblem back = fclib::LocalProblem::read ("output_file_hpp.hdf5");
+  ASSERT (std::equal (back.q ().begin (), back.q ().end (), local.q ().begin ()) && back.W ().nnz () == local.W ().nnz (),
+          "ERROR: the written problem differs");
+
+  std::vector<unsigned char> image = global.write_buffer ();
+  fclib::GlobalProblem copy = fclib::GlobalProblem::read_buffer (image.data (), image.size ());
+  image = local.write_buffer ();
+  fclib::LocalProblem local_copy = fclib::LocalProblem::read_buffer (image.data (), image.size ());
+  ASSERT (copy.H ().nnz () == global.H ().nnz () && std::equal (local_copy.q ().begin (), local_copy.q ().end (), local.q ().begin ()),
+          "ERROR: problems serialized to file images differ");
+
+  try
+  {
+    local.write ("output_file_hpp.hdf5");
+    ASSERT (0, "ERROR: overwriting a problem did not throw");
+  }
+  catch (const fclib::error &e)
+  {
+    ASSERT (e.code () == FCLIB_ERROR_INVALID && std::strstr (e.what (), "already"), "ERROR: wrong error => %s", e.what ());
+  }
+
+  try
+  {
+    fclib::LocalProblem::read ("missing_file.hdf5");
+    ASSERT (0, "ERROR: reading a missing file did not throw");
+  }
+  catch (const fclib::error &e)
+  {
+    ASSERT (e.code () == FCLIB_ERROR_FILE, "ERROR: wrong error => %s", e.what ());
+  }
+
+  printf ("Evaluating the merit function ...\n");
+
+  fclib::Solution solution (local);
+  ASSERT (solution.r ().size () == (std::size_t) local.W ().cols () && solution.r () [0] == 0.0, "ERROR: solution not zeroed");
+  for (int c = 0; c < local.contacts (); c ++) /* r = 0 solves q = (1, 0, 0) exactly */
+  {
+    local.q () [3*c] = 1.0;
+    local.q () [3*c+1] = local.q () [3*c+2] = 0.0;
+  }
+  ASSERT (fclib::merit_local (local, solution) == 0.0, "ERROR: merit of an exact solution is not zero");
+  for (double &r : solution.r ()) r = std::rand () / (double) RAND_MAX;
+  double merit = fclib::merit_local<3, FCLIB_CSC> (local, solution);
+  ASSERT (merit > 0.0 && merit == fclib::merit_local (local, solution), "ERROR: merit dispatch differs");
+#ifdef FCLIB_WITH_MERIT_FUNCTIONS
+  double reference = fclib_merit_local (local.get (), MERIT_1, solution.get ());
+  ASSERT (std::fabs (merit - reference) <= 1e-12 * (1.0 + reference), "ERROR: merit differs from fclib_merit_local => %g != %g",
+          merit, reference);
+#endif
+
+  solution.write ("output_file_hpp.hdf5");
+  std::vector<fclib::Solution> many;
+  many.push_back (fclib::Solution (local));
+  many.push_back (std::move (solution));
+  fclib::write_guesses (many, "output_file_hpp.hdf5");
+  ASSERT (fclib::read_guesses ("output_file_hpp.hdf5", local).size () == 2, "ERROR: writing the guesses failed");
+  remove ("output_file_hpp.hdf5");
+
+  printf ("All tests passed\n");
+
+  return 0;
+}
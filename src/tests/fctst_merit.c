@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <math.h>
 #include "fclib.h"
 
 /* useful macros */
@@ -407,6 +408,155 @@ static int compare_solutions (struct fclib_solution *a, struct fclib_solution *b
   return 1;
 }
 
+/* solve a problem from zero and warm started from its guess and from the solution found */
+static void test_solve_local (struct fclib_local *problem, double tolerance, int mode, struct fclib_solution *guesses, int numguess)
+{
+  struct fclib_solver_options options = {0, tolerance, 0, mode, 0};
+  struct fclib_solver_info info;
+  struct fclib_solution solution;
+  int n = problem->W->n, iterations;
+
+  printf ("Solving local problem by %s projected Gauss-Seidel ...\n", mode == FCLIB_SOLVER_SERIAL ? "serial" : mode == FCLIB_SOLVER_COLORED ? "colored" : "asynchronous");
+
+  MM (solution.r = calloc (n, sizeof(double)));
+  MM (solution.u = calloc (n, sizeof(double)));
+  solution.v = solution.l = NULL;
+
+  ASSERT (fclib_solve_local (problem, &solution, &options, &info), "ERROR: solver did not converge => error = %g", info.error);
+  printf ("Cold start: %d sweeps, error = %12.8e, %d colors, %g s\n", info.iterations, info.error, info.colors, info.time);
+  ASSERT (fclib_merit_local (problem, MERIT_1, &solution) <= options.tolerance, "ERROR: merit function above tolerance");
+  ASSERT (info.checks == info.iterations && info.history_error [info.checks-1] == info.error &&
+          info.history_time [info.checks-1] <= info.time, "ERROR: wrong convergence history");
+  ASSERT ((mode == FCLIB_SOLVER_COLORED) == (info.colors > 0), "ERROR: wrong number of colors");
+  iterations = info.iterations;
+  free (info.history_error);
+  free (info.history_time);
+
+  ASSERT (fclib_solve_local (problem, &solution, &options, &info) && info.iterations == 1, "ERROR: warm start from a solution failed");
+  free (info.history_error);
+  free (info.history_time);
+
+  if (numguess > 0)
+  {
+    memcpy (solution.r, guesses [0].r, n * sizeof(double));
+    ASSERT (fclib_solve_local (problem, &solution, &options, &info), "ERROR: solver did not converge from the guess");
+    printf ("Warm start from guess: %d sweeps (cold start %d), error = %12.8e\n", info.iterations, iterations, info.error);
+    free (info.history_error);
+    free (info.history_time);
+  }
+
+  free (solution.r);
+  free (solution.u);
+}
+
+/* 3d local problem with a diagonally dominant W coupling random pairs of contacts */
+static struct fclib_local* dominant_local_problem (int contact_points)
+{
+  struct fclib_local *problem;
+  struct fclib_matrix *W;
+  int n = 3*contact_points, c, d, r, k;
+
+  MM (problem = malloc (sizeof (struct fclib_local)));
+  problem->spacedim = 3;
+  problem->V = problem->R = NULL;
+  problem->s = NULL;
+  problem->info = NULL;
+  problem->mu = random_vector (contact_points);
+  problem->q = random_vector (n);
+  for (k = 0; k < n; k += 3) problem->q [k] -= 0.5; /* some contacts close, some open */
+
+  MM (W = malloc (sizeof (struct fclib_matrix)));
+  W->m = W->n = n;
+  W->nzmax = 9*contact_points + 18*contact_points;
+  W->info = NULL;
+  MM (W->p = malloc (sizeof(int)*W->nzmax));
+  MM (W->i = malloc (sizeof(int)*W->nzmax));
+  MM (W->x = malloc (sizeof(double)*W->nzmax));
+  for (k = c = 0; c < contact_points; c ++)
+  {
+    for (r = 0; r < 3; r ++)
+      for (d = 0; d < 3; d ++, k ++)
+      {
+        W->p [k] = 3*c+r;
+        W->i [k] = 3*c+d;
+        W->x [k] = (r == d ? 2.0 : 0.1);
+      }
+    d = rand () % contact_points;
+    if (d == c) continue;
+    for (r = 0; r < 3; r ++, k += 2) /* symmetric coupling of c and d */
+    {
+      W->p [k] = W->i [k+1] = 3*c+r;
+      W->i [k] = W->p [k+1] = 3*d+r;
+      W->x [k] = W->x [k+1] = 0.05 * (double) rand () / (double) RAND_MAX;
+    }
+  }
+  W->nz = k;
+  problem->W = W;
+
+  return problem;
+}
+
+/* global problem with a block-diagonal M of 3x3 blocks */
+static struct fclib_global* block_diagonal_global_problem (int bodies, int contact_points)
+{
+  struct fclib_global *problem;
+  struct fclib_matrix *M;
+  int b, r, c, k;
+
+  problem = random_global_problem (3*bodies, contact_points, 0);
+  problem->spacedim = 3;
+  fclib_delete_matrix (problem->H);
+  problem->H = random_matrix (3*bodies, 3*contact_points);
+  free (problem->w);
+  problem->w = random_vector (3*contact_points);
+
+  MM (M = malloc (sizeof (struct fclib_matrix)));
+  M->m = M->n = 3*bodies;
+  M->nzmax = M->nz = 9*bodies;
+  M->info = NULL;
+  MM (M->p = malloc (sizeof(int)*M->nzmax));
+  MM (M->i = malloc (sizeof(int)*M->nzmax));
+  MM (M->x = malloc (sizeof(double)*M->nzmax));
+  for (k = b = 0; b < bodies; b ++)
+    for (r = 0; r < 3; r ++)
+      for (c = 0; c < 3; c ++, k ++)
+      {
+        M->p [k] = 3*b+r;
+        M->i [k] = 3*b+c;
+        M->x [k] = (r == c ? 4.0 : 1.0 / (1.0 + r + c + b % 5));
+      }
+  fclib_delete_matrix (problem->M);
+  problem->M = M;
+
+  return problem;
+}
+
+/* the merit function of a global problem is the same with and without the block kernels */
+static void test_global_merit (void)
+{
+  struct fclib_global *problem;
+  struct fclib_solution *solution;
+  struct fclib_block_diagonal *bd;
+  double error1, error2;
+
+  printf ("Computing merit function of a global problem with a block-diagonal M ...\n");
+
+  problem = block_diagonal_global_problem (10 + rand () % 100, 10 + rand () % 100);
+  solution = random_global_solutions (problem, 1);
+
+  error1 = fclib_merit_global (problem, MERIT_1, solution);
+  bd = fclib_matrix_analyze (problem->M, 0);
+  ASSERT (bd && bd->bs == 3 && bd->blocks, "ERROR: analysis of M failed");
+  error2 = fclib_merit_global_blocks (problem, bd, MERIT_1, solution);
+  printf ("Error for global problem = %12.8e (block kernels %12.8e)\n", error1, error2);
+  ASSERT (error1 > 0.0 && fabs (error1 - error2) <= 1e-12 * error1, "ERROR: merit functions differ");
+
+  fclib_delete_block_diagonal (bd);
+  fclib_delete_global (problem);
+  free (problem);
+  fclib_delete_solutions (solution, 1);
+}
+
 int main (int argc, char **argv)
 {
   int i;
@@ -448,11 +598,22 @@ int main (int argc, char **argv)
     double error1 = fclib_merit_local (problem, MERIT_1, solution);
     printf ("Error for local problem = %12.8e\n", error1);
 
+    test_solve_local (problem, 1e-4, FCLIB_SOLVER_SERIAL, guesses, numguess); /* NSGS converges slowly on this problem */
+
 
     fclib_delete_local (problem);
     free(problem);
     fclib_delete_solutions (solution, 1);
     fclib_delete_solutions (guesses, numguess);
+
+    problem = dominant_local_problem (100 + rand () % 1000);
+    test_solve_local (problem, 1e-10, FCLIB_SOLVER_SERIAL, NULL, 0);
+    test_solve_local (problem, 1e-10, FCLIB_SOLVER_COLORED, NULL, 0);
+    test_solve_local (problem, 1e-10, FCLIB_SOLVER_ASYNCHRONOUS, NULL, 0);
+    fclib_delete_local (problem);
+    free (problem);
+
+    test_global_merit ();
   }
 
   return 0;
@@ -0,0 +1,279 @@
+/* FCLIB Copyright (C) 2011--2020 FClib project
+ *
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact: fclib-project@lists.gforge.inria.fr
+*/
+/*
+ * fctst_threads.c
+ * ----------------------------------------------
+ * concurrent reading test: several threads read the same files and file image,
+ * compare the problems with a reference, fail on missing files and check their
+ * own last error; the read throughput of one and of all threads is printed
+ *
+ * usage: fctest_threads [threads] [rounds]
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <hdf5.h>
+#include "fclib.h"
+
+/* useful macros */
+#define ASSERT(Test, ...)\
+  do {\
+  if (! (Test)) { fprintf (stderr, "%s: %d => ", __FILE__, __LINE__);\
+    fprintf (stderr, __VA_ARGS__);\
+    fprintf (stderr, "\n"); exit (1); } } while (0)
+
+#ifdef FCLIB_HDF5_LOCK /* files of their own, for the tests to run in parallel */
+#define LOCAL_PATH "threads_lock_local.hdf5"
+#define GLOBAL_PATH "threads_lock_global.hdf5"
+#define TRACE_PATH "threads_lock_trace.json"
+#else
+#define LOCAL_PATH "threads_local.hdf5"
+#define GLOBAL_PATH "threads_global.hdf5"
+#define TRACE_PATH "threads_trace.json"
+#endif
+
+static struct fclib_local *local_reference;
+static struct fclib_global *global_reference;
+static void *image;
+static size_t image_size;
+static int rounds;
+
+/* wall clock time in seconds */
+static double now (void)
+{
+  struct timespec t;
+
+  timespec_get (&t, TIME_UTC);
+  return (double) t.tv_sec + 1e-9 * (double) t.tv_nsec;
+}
+
+static long file_size (const char *path)
+{
+  FILE *f = fopen (path, "rb");
+  long size;
+
+  ASSERT (f, "ERROR: opening %s failed", path);
+  fseek (f, 0, SEEK_END);
+  size = ftell (f);
+  fclose (f);
+
+  return size;
+}
+
+/* matrices with equal storage and arrays */
+static int same_matrix (struct fclib_matrix *a, struct fclib_matrix *b)
+{
+  int np, nnz, nx;
+
+  if (!a || !b) return a == b;
+  if (a->m != b->m || a->n != b->n || a->nz != b->nz || (a->nz == FCLIB_BSR && a->bs != b->bs)) return 0;
+  if (a->nz >= 0) np = nnz = nx = a->nz; /* triplet */
+  else
+  {
+    np = (a->nz == FCLIB_CSR ? a->m : a->nz == FCLIB_BSR ? a->m / a->bs : a->n) + 1;
+    nnz = a->p [np-1];
+    nx = (a->nz == FCLIB_BSR ? nnz * a->bs * a->bs : nnz);
+  }
+
+  return memcmp (a->p, b->p, sizeof (int) * np) == 0 && memcmp (a->i, b->i, sizeof (int) * nnz) == 0 &&
+         memcmp (a->x, b->x, sizeof (double) * nx) == 0;
+}
+
+static int same_vector (double *a, double *b, int n)
+{
+  if (!a || !b) return a == b;
+  return memcmp (a, b, sizeof (double) * n) == 0;
+}
+
+static int same_local (struct fclib_local *a, struct fclib_local *b)
+{
+  return a && b && a->spacedim == b->spacedim && same_matrix (a->W, b->W) && same_matrix (a->V, b->V) &&
+         same_matrix (a->R, b->R) && same_vector (a->q, b->q, a->W->m) && same_vector (a->mu, b->mu, a->W->m / a->spacedim);
+}
+
+static int same_global (struct fclib_global *a, struct fclib_global *b)
+{
+  return a && b && a->spacedim == b->spacedim && same_matrix (a->M, b->M) && same_matrix (a->H, b->H) &&
+         same_matrix (a->G, b->G) && same_vector (a->f, b->f, a->M->n) && same_vector (a->w, b->w, a->H->n) &&
+         same_vector (a->mu, b->mu, a->H->n / a->spacedim);
+}
+
+/* read the problems 'rounds' times, every fourth read failing on a missing file */
+static void* reader (void *arg)
+{
+  int id = *(int*) arg, k;
+  char missing [64];
+
+  snprintf (missing, sizeof (missing), "threads_missing_%d.hdf5", id);
+
+  for (k = 0; k < rounds; k ++)
+  {
+    const char *message;
+
+    switch ((k + id) % 4)
+    {
+    case 0:
+    {
+      struct fclib_local *problem = fclib_read_local (LOCAL_PATH);
+      ASSERT (same_local (problem, local_reference), "ERROR: thread %d read a wrong local problem", id);
+      fclib_delete_local (problem);
+      free (problem);
+      break;
+    }
+    case 1:
+    {
+      struct fclib_global *problem = fclib_read_global (GLOBAL_PATH);
+      ASSERT (same_global (problem, global_reference), "ERROR: thread %d read a wrong global problem", id);
+      fclib_delete_global (problem);
+      free (problem);
+      break;
+    }
+    case 2:
+    {
+      struct fclib_local *problem = fclib_read_local_from_buffer (image, image_size, 0);
+      ASSERT (same_local (problem, local_reference), "ERROR: thread %d read a wrong file image", id);
+      fclib_delete_local (problem);
+      free (problem);
+      break;
+    }
+    case 3:
+      ASSERT (!fclib_read_local (missing), "ERROR: thread %d read a missing file", id);
+      ASSERT (fclib_last_error (&message) == FCLIB_ERROR_FILE && strstr (message, missing),
+              "ERROR: thread %d got the error of another thread => %s", id, message);
+      fclib_clear_error ();
+      break;
+    }
+    ASSERT (fclib_last_error (NULL) == FCLIB_ERROR_NONE, "ERROR: thread %d got an error", id);
+  }
+
+  return NULL;
+}
+
+/* run 'count' readers and return the elapsed time */
+static double run (int count)
+{
+  pthread_t *threads;
+  int *ids, k;
+  double start;
+
+  ASSERT ((threads = (pthread_t*) malloc (sizeof (pthread_t) * count)) && (ids = (int*) malloc (sizeof (int) * count)),
+          "ERROR: out of memory");
+
+  start = now ();
+  for (k = 0; k < count; k ++)
+  {
+    ids [k] = k;
+    ASSERT (pthread_create (&threads [k], NULL, reader, &ids [k]) == 0, "ERROR: creating thread %d failed", k);
+  }
+  for (k = 0; k < count; k ++) pthread_join (threads [k], NULL);
+
+  free (threads);
+  free (ids);
+
+  return now () - start;
+}
+
+int main (int argc, char **argv)
+{
+  struct fclib_generator_options options = {FCLIB_SCENE_BOXES, 2000, 0.0, 0.0, 0.0, 7, 1};
+  int threads = (argc > 1 ? atoi (argv [1]) : 8);
+  struct fclib_stats stats_one, stats_all;
+  double bytes, one, all;
+  int traced, k;
+
+  rounds = (argc > 2 ? atoi (argv [2]) : 40);
+  ASSERT (threads > 0 && rounds > 0, "usage: fctest_threads [threads] [rounds]");
+
+  printf ("Writing the problems ...\n");
+
+  ASSERT (global_reference = fclib_generate_global (&options), "ERROR: generating a global problem failed");
+  ASSERT (local_reference = fclib_generate_local (&options), "ERROR: generating a local problem failed");
+  remove (LOCAL_PATH);
+  remove (GLOBAL_PATH);
+  ASSERT (fclib_write_local (local_reference, LOCAL_PATH) && fclib_write_global (global_reference, GLOBAL_PATH),
+          "ERROR: writing the problems failed");
+  ASSERT (fclib_write_local_to_buffer (local_reference, &image, &image_size), "ERROR: writing the file image failed");
+
+  /* compare with the problems as read back, stored the same way */
+  fclib_delete_local (local_reference);
+  free (local_reference);
+  fclib_delete_global (global_reference);
+  free (global_reference);
+  ASSERT ((local_reference = fclib_read_local (LOCAL_PATH)) && (global_reference = fclib_read_global (GLOBAL_PATH)),
+          "ERROR: reading the problems failed");
+
+  /* three reads out of four move data, in equal parts */
+  bytes = 0.25 * (double) rounds * (double) (file_size (LOCAL_PATH) + file_size (GLOBAL_PATH) + (long) image_size);
+
+  printf ("Reading with 1 thread ...\n");
+  fclib_stats_reset ();
+  one = run (1);
+  fclib_stats_get (&stats_one);
+  printf ("Reading with %d threads ...\n", threads);
+  fclib_stats_reset ();
+  traced = fclib_stats_trace (TRACE_PATH);
+  all = run (threads);
+
+  /* the statistics of all threads, finished or not, are summed, and each thread has its own track */
+  if (fclib_stats_get (&stats_all))
+  {
+    char line [512], *tid;
+    int first = -1, tracks = 0;
+    FILE *f;
+
+    for (k = 0; k < FCLIB_STATS_CLASSES && rounds % 4 == 0; k ++)
+      ASSERT (stats_all.bytes_read [k] == threads * stats_one.bytes_read [k], "ERROR: bytes read by %d threads were not all counted", threads);
+    ASSERT (traced && fclib_stats_trace (NULL) && (f = fopen (TRACE_PATH, "r")), "ERROR: writing the trace failed");
+    while (fgets (line, sizeof (line), f))
+    {
+      if ((tid = strstr (line, "\"tid\": ")) && first < 0) first = atoi (tid + 7);
+      else if (tid && atoi (tid + 7) != first) tracks = 1;
+    }
+    fclose (f);
+    remove (TRACE_PATH);
+    ASSERT (threads == 1 || tracks, "ERROR: the trace events of %d threads share one track", threads);
+  }
+
+  printf ("1 thread: %.1f MB/s, %d threads: %.1f MB/s (%s HDF5 calls)\n", 1e-6 * bytes / one, threads,
+          1e-6 * bytes * threads / all,
+#ifdef H5_HAVE_THREADSAFE
+#ifdef FCLIB_HDF5_LOCK
+          "serialized"
+#else
+          "concurrent"
+#endif
+#else
+          "serialized"
+#endif
+          );
+
+  fclib_delete_local (local_reference);
+  free (local_reference);
+  fclib_delete_global (global_reference);
+  free (global_reference);
+  free (image);
+  remove (LOCAL_PATH);
+  remove (GLOBAL_PATH);
+
+  printf ("All tests passed\n");
+
+  return 0;
+}